@@ -47,6 +47,11 @@
 #define STRUCT_ELEM_SAFE(s,e,v)    (TEST_OR2(NULL, (s), (s)->e) ? (v) : (s)->e)
 #define FD_CLOSE(a)                do { if ((a) >= 0) { (void)close(a); (a) = -1; } } while (0)
 
+/* Counters written by a single thread and read by the other threads. */
+#define STAT_ADD(v,n)              __atomic_store_n(&(v), (v) + (n), __ATOMIC_RELAXED)
+#define STAT_INC(v)                STAT_ADD((v), 1)
+#define STAT_GET(v)                __atomic_load_n(&(v), __ATOMIC_RELAXED)
+
 #define BUFFER_NEXT(n)             do { __n = (__n + 1) % TABLESIZE(n); } while (0)
 #define BUFFER_DEF(t,n,s)          static __THR t (n)[s]; static __THR size_t __n = 0; ONCE((void)memset((n), 0, sizeof(n))); BUFFER_NEXT(n)
 #define BUFFER2_DEF(t,n,S,s)       static __THR t (n)[S][s]; static __THR size_t __n = 0; ONCE((void)memset((n), 0, sizeof(n))); BUFFER_NEXT(n)
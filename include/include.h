@@ -77,9 +77,13 @@
 #ifdef HAVE_NETDB_H
 #  include <netdb.h>
 #endif
+#ifdef HAVE_LINUX_FILTER_H
+#  include <linux/filter.h>
+#endif
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <netinet/tcp.h>
@@ -92,6 +96,10 @@
 #  include <ev.h>
 #endif
 
+#ifdef HAVE_LIBURING
+#  include <liburing.h>
+#endif
+
 #include "common/debug.h"
 #include "common/define.h"
 #include "common/mini-clist.h"
@@ -99,8 +107,15 @@
 #include "common/version.h"
 
 #include "types/util.h"
+#include "types/stats.h"
+#ifdef HAVE_LIBURING
+#  include "types/uring.h"
+#endif
 #ifdef HAVE_LIBCURL
+#  include "types/mirror-log.h"
 #  include "types/curl.h"
+#  include "types/http1.h"
+#  include "types/sender.h"
 #endif
 #include "types/libev.h"
 #include "types/main.h"
@@ -114,6 +129,9 @@
 
 #ifdef HAVE_LIBCURL
 #  include "proto/curl.h"
+#  include "proto/http1.h"
+#  include "proto/mirror-log.h"
+#  include "proto/sender.h"
 #endif
 #include "proto/libev.h"
 #include "proto/spoa-message.h"
@@ -126,7 +144,11 @@
 #include "proto/spop-hello.h"
 #include "proto/spop-notify.h"
 #include "proto/spop-unset.h"
+#include "proto/stats.h"
 #include "proto/tcp.h"
+#ifdef HAVE_LIBURING
+#  include "proto/uring.h"
+#endif
 #include "proto/util.h"
 #include "proto/worker.h"
 
@@ -20,9 +20,12 @@
 #ifndef _PROTO_CURL_H
 #define _PROTO_CURL_H
 
-int mir_curl_init(struct ev_loop *loop, struct ev_async *ev, struct curl_data *curl);
+int mir_curl_init(struct ev_loop *loop, struct curl_data *curl);
 void mir_curl_close(struct curl_data *curl);
+void mir_curl_monitor(const struct worker *worker, struct curl_data *curl);
 int mir_curl_add(struct curl_data *curl, struct mirror *mir);
+int mir_curl_share_init(struct curl_share *share);
+void mir_curl_share_close(struct curl_share *share);
 
 #endif /* _PROTO_CURL_H */
 
@@ -0,0 +1,37 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _PROTO_HTTP1_H
+#define _PROTO_HTTP1_H
+
+int mir_http1_init(struct ev_loop *loop, struct http1_data *http1);
+void mir_http1_close(struct http1_data *http1);
+void mir_http1_monitor(const struct worker *worker, struct http1_data *http1);
+int mir_http1_add(struct http1_data *http1, struct mirror *mir);
+
+#endif /* _PROTO_HTTP1_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -0,0 +1,37 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _PROTO_MIRROR_LOG_H
+#define _PROTO_MIRROR_LOG_H
+
+void mir_log_init(struct mir_log *log, struct ev_loop *loop);
+bool_t mir_log_sample(struct mir_log *log);
+void mir_log_add(struct mir_log *log, const char *method, long code, uint8_t error, uint64_t up, uint64_t down, double time_ms);
+void mir_log_summary(const struct worker *worker, struct mir_log *log, struct ev_loop *loop);
+
+#endif /* _PROTO_MIRROR_LOG_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -0,0 +1,41 @@
+/***
+ * Copyright 2018-2020 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _PROTO_SENDER_H
+#define _PROTO_SENDER_H
+
+bool_t mir_queue_push(struct mir_queue *queue, struct mirror *mir);
+struct mirror *mir_queue_pop(struct mir_queue *queue);
+int mir_sender_start(void);
+void mir_sender_stop(void);
+void mir_sender_free(void);
+int mir_sender_add(const struct worker *worker, struct mirror *mir);
+void mir_sender_release(struct mirror **mir);
+void mir_sender_collect(struct worker *worker);
+
+#endif /* _PROTO_SENDER_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
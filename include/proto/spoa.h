@@ -23,6 +23,16 @@
 int acc_payload(struct spoe_frame *frame);
 void read_frame_cb(struct ev_loop *loop, ev_io *ev, int revents);
 void write_frame_cb(struct ev_loop *loop, ev_io *ev, int revents);
+int write_frame_done(struct client *client, struct spoe_frame *frame);
+void write_frame_resume(struct client *client);
+void frame_pool_init(struct worker *worker);
+void frame_pool_trim(struct worker *worker);
+void frame_pool_free(struct worker *worker);
+void release_frame(struct spoe_frame *frame);
+void frame_ref(struct spoe_frame *frame);
+void frame_unref(struct spoe_frame *frame);
+void frame_defer_init(struct worker *worker);
+void frame_defer_free(struct worker *worker);
 void release_client(struct client *c);
 
 #endif /* _PROTO_SPOA_H */
@@ -22,6 +22,7 @@
 
 int spoe_decode(struct spoe_frame *frame, const char **buf, const char *end, int type, ...);
 int spoe_decode_kv(struct spoe_frame *frame, const char **buf, const char *end, ...);
+int spoe_decode_hdr(struct spoe_frame *frame, const char **buf, const char *end, struct chunk *name, struct chunk *value);
 int spoe_decode_skip_msg(struct spoe_frame *frame, const char **buf, const char *end);
 int spoe_decode_frame(const char *msg, struct spoe_frame *frame, uint8_t spoe_type, int spoe_retval, int type, ...);
 
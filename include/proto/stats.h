@@ -0,0 +1,38 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _PROTO_STATS_H
+#define _PROTO_STATS_H
+
+uint64_t stats_hist_time(void);
+void stats_hist_add(struct stats_hist *hist, uint64_t value);
+uint64_t stats_hist_since(struct stats_hist *hist, uint64_t start);
+int stats_start(struct ev_loop *loop);
+void stats_stop(void);
+
+#endif /* _PROTO_STATS_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -20,8 +20,8 @@
 #ifndef _PROTO_TCP_H
 #define _PROTO_TCP_H
 
-ssize_t tcp_recv(struct spoe_frame *frame, size_t len, const char *msg);
-ssize_t tcp_send(const struct client *client, struct spoe_frame *frame, size_t len, const char *msg);
+ssize_t tcp_recv(struct client *client);
+ssize_t tcp_send(struct client *client, const struct iovec *iov, int iovcnt);
 
 #endif /* _PROTO_TCP_H */
 
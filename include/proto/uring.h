@@ -0,0 +1,40 @@
+/***
+ * Copyright 2018-2020 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _PROTO_URING_H
+#define _PROTO_URING_H
+
+int uring_init(struct worker *worker);
+void uring_close(struct worker *worker);
+int uring_client_init(struct client *client);
+bool_t uring_client_release(struct client *client);
+bool_t uring_recv_pending(const struct client *client);
+ssize_t uring_recv(struct client *client);
+int uring_send(struct client *client, struct spoe_frame **frames, const struct iovec *iov, int iovcnt);
+
+#endif /* _PROTO_URING_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -37,6 +37,9 @@ uint64_t parse_delay_us(const char *delay, uint64_t val_min, uint64_t val_max);
 int parse_hostname(const char *hostname);
 char *parse_url(const char *url);
 uint64_t time_elapsed(const struct timeval *tv);
+void log_thread_init(struct ev_loop *loop);
+int log_start(void);
+void log_stop(void);
 void c_log(const struct client *client, const char *format, ...)
 	__fmt(printf, 2, 3);
 void f_log(const struct spoe_frame *frame, const char *format, ...)
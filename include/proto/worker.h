@@ -20,6 +20,7 @@
 #ifndef _PROTO_WORKER_H
 #define _PROTO_WORKER_H
 
+int worker_cpus(int *cpus, int size);
 int worker_run(void);
 
 #endif /* _PROTO_WORKER_H */
@@ -23,6 +23,7 @@
 #define CURL_STR              "cURL: "
 #define CURL_ERR_EASY(a,b)    w_log(NULL, _E(CURL_STR a ": %s (%u)"), curl_easy_strerror(b), (b))
 #define CURL_ERR_MULTI(a,b)   w_log(NULL, _E(CURL_STR a ": %s (%d)"), curl_multi_strerror(b), (b))
+#define CURL_ERR_SHARE(a,b)   w_log(NULL, _E(CURL_STR a ": %s (%d)"), curl_share_strerror(b), (b))
 #define CURL_DBG(a, ...)      W_DBG(CURL, NULL, CURL_STR a, ##__VA_ARGS__)
 
 /* Time-out connect operations after this amount of milliseconds. */
@@ -45,6 +46,9 @@
 #define CURL_KEEPIDLE_TIME    10
 #define CURL_KEEPINTVL_TIME   10
 
+/* The maximum number of free easy handles kept by each worker. */
+#define CURL_CON_POOL_MAX     256
+
 /*
  * +---------+-------------------------------------------------+----------+
  * | Method  | Description                                     | RFC 7231 |
@@ -108,10 +112,19 @@ enum CURL_HTTP_METHOD_enum
 
 struct curl_data {
 	struct ev_loop  *ev_base;         /* */
-	struct ev_async *ev_async;        /* */
 	struct ev_timer  ev_timer;        /* */
 	CURLM           *multi;           /* cURL multi handle. */
 	int              running_handles; /* The number of running easy handles within the multi handle. */
+	struct list      cons;            /* Free preconfigured easy handles. */
+	uint             nbfree;          /* The number of free easy handles. */
+	struct list      active;          /* In-flight easy handles, the oldest first. */
+	uint             nbactive;        /* The number of in-flight easy handles. */
+	uint64_t         active_bytes;    /* Size of the in-flight mirrors. */
+	uint64_t         nbdropped;       /* The number of mirrors dropped due to the in-flight limits. */
+	uint64_t         dropped_bytes;   /* Size of the dropped mirrors. */
+	uint64_t         nbdropped_last;  /* Value of nbdropped at the last report. */
+	uint32_t         seed;            /* State of the sampling PRNG. */
+	struct mir_log   log;             /* Summary of the completed mirrors. */
 };
 
 struct curl_con {
@@ -120,6 +133,15 @@ struct curl_con {
 	char               error[CURL_ERROR_SIZE]; /* Buffer to receive error messages in. */
 	struct curl_data  *curl;                   /* */
 	struct mirror     *mir;                    /* */
+	struct list        list;                   /* Link to the list of free or in-flight easy handles. */
+	size_t             size;                   /* Size of the mirror, counted against the in-flight limits. */
+	bool_t             flag_active;            /* Whether the mirror is counted as in-flight. */
+};
+
+/* Data shared by the easy handles of all workers. */
+struct curl_share {
+	CURLSH          *share;                     /* cURL share handle. */
+	pthread_mutex_t  lock[CURL_LOCK_DATA_LAST]; /* A lock for each type of the shared data. */
 };
 
 /* Information associated with a specific socket. */
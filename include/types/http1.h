@@ -0,0 +1,114 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _TYPES_HTTP1_H
+#define _TYPES_HTTP1_H
+
+#define HTTP1_STR             "HTTP/1.1: "
+#define HTTP1_DBG(a, ...)     W_DBG(CURL, NULL, HTTP1_STR a, ##__VA_ARGS__)
+
+/* Time-out connect operations after this amount of seconds. */
+#define HTTP1_CON_TMOUT       20.0
+
+/* Time-out the connection if a response makes no progress for this amount of seconds. */
+#define HTTP1_TMOUT           10.0
+
+/* Connections per worker if not limited, and the default pipelining depth. */
+#define HTTP1_CONNS_MAX       256
+#define HTTP1_DEPTH           32
+
+/* Size of the response buffer, the response header section has to fit in it. */
+#define HTTP1_RBUF_SIZE       16384
+
+/* The maximum number of buffers written with one writev() call. */
+#define HTTP1_IOV_MAX         64
+
+enum HTTP1_RSP_enum {
+	HTTP1_RSP_HEAD = 0,   /* Status line and header section. */
+	HTTP1_RSP_BODY,       /* Body with a known length. */
+	HTTP1_RSP_CHUNK_SIZE, /* Chunk size line. */
+	HTTP1_RSP_CHUNK_DATA, /* Chunk data and the CRLF that follows it. */
+	HTTP1_RSP_TRAILERS,   /* Trailer section of a chunked body. */
+	HTTP1_RSP_EOF,        /* Body delimited by the connection close. */
+};
+
+struct http1_data {
+	struct ev_loop  *ev_base;         /* */
+	struct sockaddr_storage addr;     /* Address of the mirror server. */
+	socklen_t        addrlen;         /* */
+	struct sockaddr_storage local;    /* Local address of the outgoing connections. */
+	socklen_t        locallen;        /* Zero if the local address is not set. */
+	int              port_next;       /* The next local port tried within the port range. */
+	const char      *authority;       /* Host and port of the mirror URL, not terminated. */
+	size_t           authority_len;   /* */
+	struct list      cons;            /* Connections to the mirror server. */
+	uint             nbcons;          /* The number of connections. */
+	uint             nbactive;        /* The number of in-flight requests. */
+	uint64_t         active_bytes;    /* Size of the in-flight mirrors. */
+	uint64_t         nbdropped;       /* The number of mirrors dropped due to the in-flight limits. */
+	uint64_t         dropped_bytes;   /* Size of the dropped mirrors. */
+	uint64_t         nbdropped_last;  /* Value of nbdropped at the last report. */
+	uint32_t         seed;            /* State of the sampling PRNG. */
+	struct mir_log   log;             /* Summary of the completed mirrors. */
+	bool_t           flag_closing;    /* The requests of the closed connections are not retried. */
+};
+
+struct http1_con {
+	int                fd;            /* */
+	struct ev_io       ev_read;       /* */
+	struct ev_io       ev_write;      /* */
+	struct ev_timer    ev_timer;      /* Connect and response progress time-out. */
+	struct http1_data *http1;         /* */
+	struct list        list;          /* Link to the list of connections. */
+	struct list        queue;         /* Requests sent or waiting to be sent, the oldest first. */
+	struct http1_req  *wr;            /* The first request not completely written. */
+	uint               nbqueued;      /* The number of queued requests. */
+	uint64_t           nbdone;        /* The number of responses received. */
+	bool_t             flag_connected;
+	bool_t             flag_close;    /* Close the connection after the current response. */
+
+	uint8_t            rsp_state;     /* Response parser state. */
+	uint64_t           rsp_left;      /* Bytes left in the body or in the current chunk. */
+	long               rsp_code;      /* */
+	char               rbuf[HTTP1_RBUF_SIZE];
+	size_t             rlen;          /* */
+};
+
+struct http1_req {
+	struct mirror     *mir;           /* */
+	struct list        list;          /* Link to the connection queue. */
+	ev_tstamp          start;         /* */
+	size_t             size;          /* Size of the mirror, counted against the in-flight limits. */
+	size_t             sent;          /* Bytes of the head and the body written. */
+	uint64_t           down;          /* Bytes of the response received. */
+	bool_t             flag_retried;
+	size_t             head_len;      /* */
+	char               head[];        /* Request line and header section. */
+};
+
+#endif /* _TYPES_HTTP1_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
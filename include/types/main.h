@@ -29,6 +29,7 @@
 #define DEFAULT_PROCESSING_DELAY     0
 #define DEFAULT_CONNECTION_BACKLOG   10
 #define DEFAULT_RUNTIME              -1
+#define DEFAULT_STATS_ADDRESS        "127.0.0.1"
 
 #define MIN_FRAME_SIZE               512
 
@@ -50,10 +51,80 @@ enum FLAG_CAP_enum {
 };
 #undef CAP_DEF
 
+#define REUSEPORT_DEFINES            \
+	REUSEPORT_DEF(NONE, "none")  \
+	REUSEPORT_DEF(HASH, "hash")  \
+	REUSEPORT_DEF(CPU,  "cpu")
+
+#define REUSEPORT_DEF(a,b)   REUSEPORT_##a,
+enum REUSEPORT_enum {
+	REUSEPORT_DEFINES
+};
+#undef REUSEPORT_DEF
+
+#define ASSIGN_DEFINES                           \
+	ASSIGN_DEF(ROUND_ROBIN,  "round-robin")  \
+	ASSIGN_DEF(LEAST_CONN,   "least-conn")   \
+	ASSIGN_DEF(LEAST_FRAMES, "least-frames") \
+	ASSIGN_DEF(P2C,          "p2c")
+
+#define ASSIGN_DEF(a,b)   ASSIGN_##a,
+enum ASSIGN_enum {
+	ASSIGN_DEFINES
+};
+#undef ASSIGN_DEF
+
+#define MIR_OVERLOAD_DEFINES                           \
+	MIR_OVERLOAD_DEF(DROP_NEWEST, "drop-newest")   \
+	MIR_OVERLOAD_DEF(DROP_OLDEST, "drop-oldest")   \
+	MIR_OVERLOAD_DEF(SAMPLE,      "sample")
+
+#define MIR_OVERLOAD_DEF(a,b)   MIR_OVERLOAD_##a,
+enum MIR_OVERLOAD_enum {
+	MIR_OVERLOAD_DEFINES
+};
+#undef MIR_OVERLOAD_DEF
+
+#define MIR_HTTP_DEFINES                                         \
+	MIR_HTTP_DEF(AUTO,          "auto")                      \
+	MIR_HTTP_DEF(HTTP1_1,       "http1.1")                   \
+	MIR_HTTP_DEF(HTTP2,         "http2")                     \
+	MIR_HTTP_DEF(HTTP2_PRIOR,   "http2-prior-knowledge")
+
+#define MIR_HTTP_DEF(a,b)   MIR_HTTP_##a,
+enum MIR_HTTP_enum {
+	MIR_HTTP_DEFINES
+};
+#undef MIR_HTTP_DEF
+
+#define MIR_ENGINE_DEFINES                \
+	MIR_ENGINE_DEF(CURL,   "curl")    \
+	MIR_ENGINE_DEF(NATIVE, "native")
+
+#define MIR_ENGINE_DEF(a,b)   MIR_ENGINE_##a,
+enum MIR_ENGINE_enum {
+	MIR_ENGINE_DEFINES
+};
+#undef MIR_ENGINE_DEF
+
+#define MIR_LOG_DEFINES                  \
+	MIR_LOG_DEF(ALL,     "all")      \
+	MIR_LOG_DEF(SUMMARY, "summary")
+
+#define MIR_LOG_DEF(a,b)   MIR_LOG_##a,
+enum MIR_LOG_enum {
+	MIR_LOG_DEFINES
+};
+#undef MIR_LOG_DEF
+
 enum FLAG_OPT_enum {
 	FLAG_OPT_HELP      = 0x01,
 	FLAG_OPT_VERSION   = 0x02,
 	FLAG_OPT_DAEMONIZE = 0x04,
+	FLAG_OPT_IO_URING  = 0x08,
+	FLAG_OPT_MIR_SHARE = 0x10,
+	FLAG_OPT_ACK_FIRST = 0x20,
+	FLAG_OPT_LATENCY   = 0x40,
 };
 
 
@@ -67,6 +138,8 @@ struct config_data {
 	const char   *server_address;
 	int           server_port;
 	int           connection_backlog;
+	uint8_t       reuseport;           /* Per-worker SO_REUSEPORT listeners mode. */
+	uint8_t       assign_policy;       /* Client connection to worker assignment policy. */
 	uint64_t      processing_delay_us;
 	uint64_t      monitor_interval_us;
 	int64_t       runtime_us;
@@ -76,18 +149,38 @@ struct config_data {
 	const char   *pidfile;
 	int           pidfile_fd;
 	uint          ev_backend;
+	char         *stats_address;       /* Address of the statistics listener. */
+	int           stats_port;          /* Port of the statistics listener (0 = disabled). */
 #ifdef HAVE_LIBCURL
 	char         *mir_url;
 	const char   *mir_interface;       /* Outgoing connections interface (IP address). */
 	int           mir_port[2];         /* Outgoing connections port. */
+	uint          mir_max_cons[2];     /* Maximum number of in-flight mirrors per worker and in total (0 = unlimited). */
+	uint64_t      mir_max_bytes[2];    /* Maximum size of in-flight mirrors per worker and in total (0 = unlimited). */
+	uint8_t       mir_overload;        /* What to do with the mirrors that exceed the limits. */
+	uint8_t       mir_http;            /* HTTP version used for the mirrored requests. */
+	uint8_t       mir_engine;          /* Sender of the mirrored requests, cURL or the native HTTP/1.1 one. */
+	uint8_t       mir_log;             /* Log every completed mirror or only the periodic summaries. */
+	uint          mir_log_sample;      /* In the summary mode, log every N-th completed mirror (0 = none). */
+	int           mir_max_conns;       /* Maximum number of connections per worker (0 = unlimited). */
+	int           mir_max_streams;     /* Maximum number of HTTP/2 streams per connection (0 = libcurl default). */
+	int           mir_threads;         /* Number of mirror sender threads (0 = mirror from the workers). */
 #endif
 };
 
 struct program_data {
-	const char     *name;
-	struct timeval  start_time;
-	struct worker  *workers;
-	unsigned long   clicount;
+	const char        *name;
+	struct timeval     start_time;
+	struct worker     *workers;
+	unsigned long      clicount;
+	struct log_data    logger;      /* Asynchronous writer of the log messages. */
+	struct stats_data  stats;       /* Statistics listener. */
+#ifdef HAVE_LIBCURL
+	struct curl_share  curl_share;  /* DNS and TLS session cache shared by the workers. */
+	struct mir_sender *senders;     /* Mirror sender threads. */
+	uint               mir_cons;    /* In-flight mirrors of all workers, updated atomically. */
+	uint64_t           mir_bytes;   /* Size of the in-flight mirrors of all workers, updated atomically. */
+#endif
 };
 
 
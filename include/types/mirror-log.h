@@ -0,0 +1,101 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _TYPES_MIRROR_LOG_H
+#define _TYPES_MIRROR_LOG_H
+
+#define MIR_ERR_DEFINES                      \
+	MIR_ERR_DEF(OK,       "ok")          \
+	MIR_ERR_DEF(TIMEOUT,  "timeout")     \
+	MIR_ERR_DEF(CONNECT,  "connect")     \
+	MIR_ERR_DEF(IO,       "io")          \
+	MIR_ERR_DEF(PROTOCOL, "protocol")    \
+	MIR_ERR_DEF(ABORTED,  "aborted")     \
+	MIR_ERR_DEF(OTHER,    "other")
+
+#define MIR_ERR_DEF(a,b)   MIR_ERR_##a,
+enum MIR_ERR_enum {
+	MIR_ERR_DEFINES
+	MIR_ERR_MAX
+};
+#undef MIR_ERR_DEF
+
+/* GET, HEAD, POST, PUT, DELETE, OPTIONS, PATCH and the other methods. */
+#define MIR_LOG_METHODS      8
+
+/* Status classes 1xx to 5xx, the first one counts the mirrors without a response. */
+#define MIR_LOG_STATUSES     6
+
+/* Latency buckets, the upper bounds are in src/mirror-log.c; the last one is unbounded. */
+#define MIR_LOG_LATENCIES    13
+
+/*
+ * Latency histograms of the completed mirrors.  The cURL times are measured
+ * by libcurl from the start of the transfer to the end of each phase; the
+ * phases skipped on a reused connection are not counted.
+ */
+#define MIR_HIST_DEFINES                                                                                                        \
+	MIR_HIST_DEF(TOTAL,         "mirror",             "Time from the submission of a mirror to its completion.")            \
+	MIR_HIST_DEF(NAMELOOKUP,    "curl_namelookup",    "Time from the start of a transfer until the name is resolved.")      \
+	MIR_HIST_DEF(CONNECT,       "curl_connect",       "Time from the start of a transfer until the connection is up.")      \
+	MIR_HIST_DEF(APPCONNECT,    "curl_appconnect",    "Time from the start of a transfer until the TLS handshake is done.") \
+	MIR_HIST_DEF(STARTTRANSFER, "curl_starttransfer", "Time from the start of a transfer until the first response byte.")
+
+#define MIR_HIST_DEF(a,b,c)   MIR_HIST_##a,
+enum MIR_HIST_enum {
+	MIR_HIST_DEFINES
+	MIR_HIST_MAX
+};
+#undef MIR_HIST_DEF
+
+/* Counters of the completed mirrors, read by the main thread with STAT_GET(). */
+struct mir_stats {
+	uint64_t          completed;                     /* Mirrors that got a response. */
+	uint64_t          failed;                        /* */
+	uint64_t          bytes_up;                      /* */
+	uint64_t          bytes_down;                    /* */
+	struct stats_hist hist[MIR_HIST_MAX];            /* */
+};
+
+/* Completed mirrors of one worker or mirror sender since the last summary. */
+struct mir_log {
+	ev_tstamp        start;                          /* Start of the summary interval. */
+	uint64_t         seq;                            /* Sequence number of the completed mirror, used for sampling. */
+	uint64_t         nbdone;                         /* */
+	uint64_t         status[MIR_LOG_STATUSES];       /* */
+	uint64_t         method[MIR_LOG_METHODS];        /* */
+	uint64_t         error[MIR_ERR_MAX];             /* */
+	uint64_t         latency[MIR_LOG_LATENCIES];     /* */
+	uint64_t         bytes_up;                       /* */
+	uint64_t         bytes_down;                     /* */
+	double           time_sum;                       /* Total time of the mirrors in milliseconds. */
+	double           time_max;                       /* */
+	struct mir_stats stats;                          /* Totals since the start, not reset by the summaries. */
+};
+
+#endif /* _TYPES_MIRROR_LOG_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -0,0 +1,55 @@
+/***
+ * Copyright 2018-2020 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _TYPES_SENDER_H
+#define _TYPES_SENDER_H
+
+/*
+ * Lock-free multi-producer single-consumer queue of mirrors.  The producers
+ * push the mirrors onto a stack, and the consumer takes the whole stack at
+ * once and reverses it.
+ */
+struct mir_queue {
+	struct mirror *head; /* The last pushed mirror, updated atomically. */
+};
+
+/* A mirror sender thread, running its own event loop and curl multi handle or HTTP/1.1 connections. */
+struct mir_sender {
+	pthread_t         thread;
+	int               id;
+	struct ev_loop   *ev_base;
+	struct ev_async   ev_async;
+	struct ev_timer   ev_monitor;
+	bool_t            flag_running;
+	bool_t            flag_stop;   /* Set by the main thread to stop the sender. */
+	struct mir_queue  queue;       /* Mirrors handed off by the workers. */
+	struct curl_data  curl;
+	struct http1_data http1;
+};
+
+#endif /* _TYPES_SENDER_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -34,15 +34,20 @@
 #define SPOE_MSG_ARG_VER       "arg_ver"
 
 struct mirror {
-	char        *url;            /* */
-	char        *path;           /* */
-	char        *method;         /* */
-	int          request_method; /* */
-	char        *version;        /* */
-	struct list  hdrs;           /* */
-	char        *body;           /* */
-	size_t       body_head;      /* */
-	size_t       body_size;      /* */
+	char              *url;            /* URL, followed by the path, method and version strings. */
+	const char        *path;           /* */
+	const char        *method;         /* */
+	int                request_method; /* */
+	const char        *version;        /* */
+	char              *hdrs;           /* HTTP headers, 'name: value\0' strings back-to-back. */
+	size_t             hdrs_len;       /* Number of bytes used in the header arena. */
+	int                hdrs_cnt;       /* Number of HTTP headers in the arena. */
+	const char        *body;           /* Request body, points to the frame payload. */
+	size_t             body_head;      /* */
+	size_t             body_size;      /* */
+	struct spoe_frame *frame;          /* Referenced frame holding the request body. */
+	struct mirror     *next;           /* Link in the mirror sender queue. */
+	uint64_t           t_submit;       /* Time of the submission, see stats_hist_time(). */
 };
 
 #endif /* _TYPES_SPOA_MESSAGE_H */
@@ -23,6 +23,19 @@
 #define SPOA_FRM_LEN        sizeof(uint32_t)
 #define SPOA_FRM_READ_CNT   3
 
+/* The receive buffer can hold a frame of maximum size and the next one. */
+#define SPOA_RD_BUFSIZE(n)  (2 * ((n) + SPOA_FRM_LEN))
+
+/*
+ * Frames are allocated from per-worker pools of several size classes, each
+ * class being four times larger than the previous one; the last class always
+ * holds frames of the maximum frame size.
+ */
+#define SPOA_FRM_POOL_CLASSES    4
+#define SPOA_FRM_POOL_MIN_SIZE   256   /* Payload size of the smallest class. */
+#define SPOA_FRM_POOL_FREE_MAX   1024  /* Maximum number of free frames in a class. */
+#define SPOA_FRM_POOL_FREE_KEEP  16    /* Free frames per class not released by trimming. */
+
 #define FC_PTR              (frame->client)
 #define FW_PTR              (frame->worker)
 #define CW_PTR              (client->worker)
@@ -40,6 +53,12 @@ enum spoa_frame_type {
 };
 
 
+struct spoa_frame_pool {
+	struct list         frames;           /* Free frames, the most recently used first. */
+	unsigned int        nbfree;
+	unsigned int        nbfree_min;       /* The lowest nbfree since the last trimming. */
+};
+
 struct client {
 	int                 fd;
 	unsigned long       id;
@@ -48,6 +67,14 @@ struct client {
 	struct ev_io        ev_frame_rd;
 	struct ev_io        ev_frame_wr;
 
+	struct buffer       rd_buf;           /* Receive buffer. */
+	size_t              rd_head;          /* Start of the unprocessed data in rd_buf. */
+	unsigned int        rd_errors;
+	unsigned int        wr_errors;
+#ifdef HAVE_LIBURING
+	struct uring_conn   uring;
+#endif
+
 	struct spoe_frame  *incoming_frame;
 	struct spoe_frame  *outgoing_frame;
 
@@ -64,6 +91,7 @@ struct client {
 	bool                fragmentation;
 
 	struct worker      *worker;
+	struct client      *next;             /* Link in the list of the accepted clients. */
 	struct list         by_worker;
 	struct list         by_engine;
 };
@@ -20,6 +20,9 @@
 #ifndef _TYPES_SPOE_DECODE_H
 #define _TYPES_SPOE_DECODE_H
 
+/* The high bits of bytes 1 to 7 of a little-endian 64-bit word. */
+#define SPOE_VARINT_STOP_MASK   UINT64_C(0x8080808080808000)
+
 enum SPOE_DEC_type {
 	SPOE_DEC_UINT8 = 0,
 	SPOE_DEC_UINT32,
@@ -48,8 +48,6 @@ struct spoe_frame {
 	char                 *buf;
 	size_t                offset;
 	size_t                len;
-	int                   rd_errors;
-	int                   wr_errors;
 
 	unsigned int          stream_id;
 	unsigned int          frame_id;
@@ -64,7 +62,13 @@ struct spoe_frame {
 	struct list           list;
 
 	struct buffer         frag;       /* used to accumulate payload of a fragmented frame */
+	uint                  refcnt;     /* references to the frame payload, see frame_ref() */
 
+	uint64_t              t_recv;     /* reception time, see stats_hist_time() */
+	uint64_t              t_sched;    /* time the processing was scheduled */
+
+	uint8_t               pool_class; /* frame pool size class */
+	size_t                size;       /* size of the frame payload buffer */
 	char                  data[0];
 };
 
@@ -0,0 +1,117 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _TYPES_STATS_H
+#define _TYPES_STATS_H
+
+#define STATS_STR            "Stats: "
+#define STATS_PFX            "spoa_mirror_"
+
+/* Close the statistics connection if the request is not received in this amount of seconds. */
+#define STATS_TMOUT          5.0
+
+#define STATS_REQ_SIZE       2048   /* Size of the request buffer, the rest of a larger request is ignored. */
+#define STATS_BUF_CHUNK      4096   /* The response buffer grows by at least this amount of bytes. */
+#define STATS_CLIENTS_MAX    16     /* The maximum number of concurrent statistics connections. */
+
+/*
+ * Log-linear latency histograms: the values in nanoseconds are counted in
+ * STATS_HIST_SUB buckets per power of two, so that the bucket of a value is
+ * at most 1/STATS_HIST_SUB of it wide.  The values from 2^STATS_HIST_BITS
+ * nanoseconds (about 68.7 seconds) up are counted in the last bucket.
+ */
+#define STATS_HIST_SUB_BITS  3
+#define STATS_HIST_SUB       (1 << STATS_HIST_SUB_BITS)
+#define STATS_HIST_BITS      36
+#define STATS_HIST_BUCKETS   ((STATS_HIST_BITS - STATS_HIST_SUB_BITS + 1) * STATS_HIST_SUB)
+
+/* The Prometheus histogram buckets are every 2^STATS_HIST_LE_STEP times from 2^STATS_HIST_LE_MIN nanoseconds up. */
+#define STATS_HIST_LE_MIN    10
+#define STATS_HIST_LE_STEP   2
+
+#define STATS_HIST_DEFINES                                                                                           \
+	STATS_HIST_DEF(ACK,      "frame_ack",      "Time from the reception of a NOTIFY frame to its ACK frame sent.")  \
+	STATS_HIST_DEF(DECODE,   "frame_decode",   "Time to decode a NOTIFY frame.")                                    \
+	STATS_HIST_DEF(DELAY,    "frame_delay",    "Time from the decoding of a frame to the start of its processing.") \
+	STATS_HIST_DEF(MESSAGES, "frame_messages", "Time to process the messages of a frame.")
+
+#define STATS_HIST_DEF(a,b,c)   STATS_HIST_##a,
+enum STATS_HIST_enum {
+	STATS_HIST_DEFINES
+	STATS_HIST_MAX
+};
+#undef STATS_HIST_DEF
+
+/*
+ * A histogram is updated only by one thread, with stats_hist_add(), and
+ * merged with the histograms of the other threads when read.
+ */
+struct stats_hist {
+	uint64_t          sum;             /* Sum of the values in nanoseconds. */
+	uint64_t          bucket[STATS_HIST_BUCKETS];
+};
+
+/*
+ * Counters of a worker.  They are updated only by the worker thread, with
+ * STAT_ADD(), and read by the main thread, with STAT_GET().
+ */
+struct worker_stats {
+	uint64_t          frames_rcvd;     /* NOTIFY frames received. */
+	uint64_t          frames_acked;    /* ACK frames sent. */
+	uint64_t          decode_errors;   /* Frames that failed to decode. */
+	uint64_t          bytes_rcvd;      /* SPOP bytes received. */
+	uint64_t          bytes_sent;      /* SPOP bytes sent. */
+	uint64_t          mir_submitted;   /* Mirrors passed to the mirroring engine or a mirror thread. */
+	struct stats_hist hist[STATS_HIST_MAX];
+};
+
+struct stats_data {
+	int               fd;              /* Listener socket, -1 if the statistics are not served. */
+	struct ev_loop   *ev_base;         /* */
+	struct ev_io      ev_accept;       /* */
+	struct list       clients;         /* */
+	uint              nbclients;       /* */
+	struct ev_timer   ev_dump;         /* Periodic log of the latency percentiles. */
+	struct stats_hist *dump_last;      /* The merged histograms at the last dump. */
+	bool_t            flag_hist;       /* The latency histograms are updated. */
+};
+
+struct stats_client {
+	int               fd;              /* */
+	struct stats_data *stats;          /* */
+	struct list       list;            /* Link to the list of clients. */
+	struct ev_io      ev_read;         /* */
+	struct ev_io      ev_write;        /* */
+	struct ev_timer   ev_timer;        /* */
+	char              req[STATS_REQ_SIZE];
+	size_t            req_len;         /* */
+	struct buffer     rsp;             /* */
+	size_t            rsp_sent;        /* */
+};
+
+#endif /* _TYPES_STATS_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -22,6 +22,7 @@
 
 #define TCP_RECV_ERR_MAX   3
 #define TCP_SEND_ERR_MAX   3
+#define TCP_SEND_IOV_MAX   64   /* Maximum number of frames sent at once. */
 
 #endif /* _TYPES_TCP_H */
 
@@ -0,0 +1,83 @@
+/***
+ * Copyright 2018-2020 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _TYPES_URING_H
+#define _TYPES_URING_H
+
+#define URING_STR           "io_uring: "
+#define URING_SQ_ENTRIES    256
+#define URING_CQ_ENTRIES    4096
+
+/* Provided buffer ring used by the multishot receive operations. */
+#define URING_BUF_GROUP     0
+#define URING_BUF_COUNT     256    /* Must be a power of 2. */
+#define URING_BUF_SIZE      4096
+
+/* The operation type is stored in the low bits of the SQE user data. */
+#define URING_OP_MASK       0x03
+#define URING_OP_RECV       0x01
+#define URING_OP_SEND       0x02
+#define URING_OP_CANCEL     0x03
+
+#define URING_DATA(p,o)     ((uint64_t)(uintptr_t)(p) | (o))
+#define URING_DATA_PTR(d)   ((void *)(uintptr_t)((d) & ~(uint64_t)URING_OP_MASK))
+#define URING_DATA_OP(d)    ((int)((d) & URING_OP_MASK))
+
+struct uring_buf {
+	uint32_t                  len;        /* Number of bytes received in the buffer. */
+	uint32_t                  offset;     /* Number of bytes already copied from the buffer. */
+	int                       next;       /* Next received buffer of the same client. */
+};
+
+struct uring_data {
+	struct io_uring           ring;
+	struct io_uring_buf_ring *br;
+	uint8_t                  *bufs;
+	struct uring_buf         *bufs_info;
+	struct ev_loop           *ev_base;
+	struct ev_io              ev_cqe;     /* Completion queue readiness. */
+	struct ev_prepare         ev_submit;  /* Submits the queued SQEs once per loop iteration. */
+	struct list               closing;    /* Released clients with uncompleted operations. */
+	struct list               starved;    /* Clients waiting for a free receive buffer. */
+};
+
+struct uring_conn {
+	bool_t                    active;     /* The client uses the io_uring transport. */
+	bool_t                    rd_stopped; /* Reading of the frames is suspended. */
+	bool_t                    recv_armed; /* The multishot receive is armed. */
+	bool_t                    closing;
+	int                       error;      /* Receive error (errno), reported after the received data. */
+	unsigned int              ops;        /* Submitted and not yet completed operations. */
+	unsigned int              sends;      /* Send operations in progress. */
+	int                       bufs_head;  /* Received buffers not yet copied to the receive buffer. */
+	int                       bufs_tail;
+	struct list               sending;    /* Frames whose send operations are in progress. */
+	struct list               by_starved;
+};
+
+#endif /* _TYPES_URING_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
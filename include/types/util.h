@@ -44,6 +44,12 @@
 #define _W(s)                "(W) " s
 #define _I(s)                "(I) " s
 
+/* Size of the per-thread log ring buffer, has to be a power of two. */
+#define LOG_RING_SIZE        (1 << 20)
+
+/* The log flusher thread sleeps this amount of microseconds if there is nothing to write. */
+#define LOG_FLUSH_INTERVAL   10000
+
 #define PARSE_DELAY_US(t)    do { if (retval > (ULLONG_MAX / (t))) errno = ERANGE; else retval *= (t); } while (0)
 #define TIMEINT_S(t)         ((t) * 1000000ULL)
 
@@ -60,6 +66,28 @@ struct buffer {
 	size_t       size;
 };
 
+/*
+ * Every thread that logs gets its own ring buffer.  The thread is the only
+ * one that moves the head of the ring, the log flusher thread is the only
+ * one that moves the tail.  Both counters increase monotonically, their
+ * difference is the number of bytes not yet written.
+ */
+struct log_ring {
+	char            *buf;
+	uint64_t         head;          /* Written by the owner thread. */
+	uint64_t         tail;          /* Written by the log flusher thread. */
+	uint64_t         dropped;       /* The number of lines that did not fit in the ring. */
+	struct log_ring *next;
+};
+
+struct log_data {
+	pthread_t        thread;        /* Log flusher thread. */
+	bool_t           flag_running;  /* The lines are written to the rings. */
+	bool_t           flag_stop;     /* */
+	struct log_ring *rings;         /* All the rings, updated atomically. */
+	uint64_t         dropped_last;  /* The number of dropped lines at the last report. */
+};
+
 #endif /* _TYPES_UTIL_H */
 
 /*
@@ -20,24 +20,46 @@
 #ifndef _TYPES_WORKER_H
 #define _TYPES_WORKER_H
 
+/* The main thread checks whether the workers are initialized every this many microseconds. */
+#define WORKER_READY_INTERVAL   1000
+
 struct worker {
 	pthread_t         thread;
 	int               id;
 	int               fd;
+	int               cpu;             /* The CPU of the worker in the 'cpu' SO_REUSEPORT mode. */
+	struct ev_io      ev_accept;
 	struct ev_async   ev_async;
 	struct ev_loop   *ev_base;
 	struct ev_timer   ev_monitor;
+	bool_t            flag_stop;       /* Set by the main thread to stop the worker. */
+	bool_t            flag_ready;      /* The worker is initialized and can be handed over the clients. */
+	bool_t            flag_failed;     /* The worker failed to initialize and has stopped. */
 
 	struct list       engines;
 
-	unsigned int      nbclients;
+	unsigned int      nbclients;       /* Updated atomically, read by the main thread. */
 	struct list       clients;
+	struct client    *accepted;        /* Clients accepted by the main thread, not started yet. */
 
-	struct list       frames;
+	struct spoa_frame_pool frame_pool[SPOA_FRM_POOL_CLASSES];
 	unsigned int      nbframes;
+	unsigned int      nbinflight;      /* Frames in use, updated atomically. */
+
+	struct worker_stats stats;
+
+	struct list       deferred_frames; /* Acknowledged frames whose mirror messages are not processed yet. */
+	struct list       deferred_ready;  /* Deferred frames whose ACK had a chance to be sent. */
+	struct ev_check   ev_deferred;
+	struct ev_idle    ev_deferred_idle;
 
 #ifdef HAVE_LIBCURL
 	struct curl_data  curl;
+	struct http1_data http1;
+	struct mir_queue  mir_done;        /* Mirrors returned by the mirror senders. */
+#endif
+#ifdef HAVE_LIBURING
+	struct uring_data uring;
 #endif
 };
 
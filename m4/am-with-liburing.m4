@@ -0,0 +1,64 @@
+dnl am-with-liburing.m4 by Miroslav Zagorac <mzagorac@haproxy.com>
+dnl
+AC_DEFUN([AM_WITH_LIBURING], [
+	AC_ARG_WITH([liburing],
+		[AS_HELP_STRING([--with-liburing@<:@=DIR@:>@], [use LIBURING library for the io_uring transport @<:@default=no@:>@])],
+		[with_liburing="${withval}"],
+		[with_liburing=no]
+	)
+
+	if test "${with_liburing}" != "no"; then
+		HAVE_LIBURING=
+		LIBURING_CFLAGS=
+		LIBURING_CPPFLAGS=
+		LIBURING_LDFLAGS=
+		LIBURING_LIBS=
+
+		AM_PATH_PKGCONFIG([${with_liburing}])
+		if pkg-config --exists liburing; then
+			LIBURING_CPPFLAGS="`PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --cflags liburing`"
+			LIBURING_LDFLAGS="`PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --libs-only-L liburing`"
+			LIBURING_LDFLAGS="${LIBURING_LDFLAGS} `PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --libs-only-other liburing`"
+			LIBURING_LIBS="`PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --libs-only-l liburing`"
+		else
+			if test -d "${with_liburing}"; then
+				LIBURING_CPPFLAGS="-I${with_liburing}/include"
+
+				if test "${with_liburing}" != "/usr"; then
+					if test "`uname`" = "Linux"; then
+						LIBURING_LDFLAGS="-L${with_liburing}/lib -Wl,--rpath,${with_liburing}/lib"
+					else
+						LIBURING_LDFLAGS="-L${with_liburing}/lib -R${with_liburing}/lib"
+					fi
+				fi
+			fi
+
+			LIBURING_LIBS="-luring"
+		fi
+
+		AM_VARIABLES_STORE
+
+		LDFLAGS="${LDFLAGS} ${LIBURING_LDFLAGS}"
+		CPPFLAGS="${CPPFLAGS} ${LIBURING_CPPFLAGS}"
+
+		dnl Provided buffer rings (io_uring_setup_buf_ring) require liburing 2.4 or later.
+		dnl
+		AC_CHECK_LIB([uring], [io_uring_setup_buf_ring], [], [AC_MSG_ERROR([LIBURING library (>= 2.4) not found])])
+		AC_CHECK_HEADER([liburing.h], [], [AC_MSG_ERROR([LIBURING library headers not found])])
+
+		HAVE_LIBURING=yes
+
+		AM_VARIABLES_RESTORE
+
+		AC_MSG_NOTICE([LIBURING environment variables:])
+		AC_MSG_NOTICE([  LIBURING_CFLAGS=${LIBURING_CFLAGS}])
+		AC_MSG_NOTICE([  LIBURING_CPPFLAGS=${LIBURING_CPPFLAGS}])
+		AC_MSG_NOTICE([  LIBURING_LDFLAGS=${LIBURING_LDFLAGS}])
+		AC_MSG_NOTICE([  LIBURING_LIBS=${LIBURING_LIBS}])
+
+		AC_SUBST([LIBURING_CFLAGS])
+		AC_SUBST([LIBURING_CPPFLAGS])
+		AC_SUBST([LIBURING_LDFLAGS])
+		AC_SUBST([LIBURING_LIBS])
+	fi
+])
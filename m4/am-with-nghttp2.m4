@@ -0,0 +1,62 @@
+dnl am-with-nghttp2.m4 by Miroslav Zagorac <mzagorac@haproxy.com>
+dnl
+AC_DEFUN([AM_WITH_NGHTTP2], [
+	AC_ARG_WITH([nghttp2],
+		[AS_HELP_STRING([--with-nghttp2@<:@=DIR@:>@], [use NGHTTP2 library for the h2c support of the http-sink utility @<:@default=no@:>@])],
+		[with_nghttp2="${withval}"],
+		[with_nghttp2=no]
+	)
+
+	if test "${with_nghttp2}" != "no"; then
+		HAVE_NGHTTP2=
+		NGHTTP2_CFLAGS=
+		NGHTTP2_CPPFLAGS=
+		NGHTTP2_LDFLAGS=
+		NGHTTP2_LIBS=
+
+		AM_PATH_PKGCONFIG([${with_nghttp2}])
+		if pkg-config --exists nghttp2; then
+			NGHTTP2_CPPFLAGS="`PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --cflags nghttp2`"
+			NGHTTP2_LDFLAGS="`PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --libs-only-L nghttp2`"
+			NGHTTP2_LDFLAGS="${NGHTTP2_LDFLAGS} `PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --libs-only-other nghttp2`"
+			NGHTTP2_LIBS="`PKG_CONFIG_PATH=${PKG_CONFIG_PATH} pkg-config --libs-only-l nghttp2`"
+		else
+			if test -d "${with_nghttp2}"; then
+				NGHTTP2_CPPFLAGS="-I${with_nghttp2}/include"
+
+				if test "${with_nghttp2}" != "/usr"; then
+					if test "`uname`" = "Linux"; then
+						NGHTTP2_LDFLAGS="-L${with_nghttp2}/lib -Wl,--rpath,${with_nghttp2}/lib"
+					else
+						NGHTTP2_LDFLAGS="-L${with_nghttp2}/lib -R${with_nghttp2}/lib"
+					fi
+				fi
+			fi
+
+			NGHTTP2_LIBS="-lnghttp2"
+		fi
+
+		AM_VARIABLES_STORE
+
+		LDFLAGS="${LDFLAGS} ${NGHTTP2_LDFLAGS}"
+		CPPFLAGS="${CPPFLAGS} ${NGHTTP2_CPPFLAGS}"
+
+		AC_CHECK_LIB([nghttp2], [nghttp2_session_upgrade2], [], [AC_MSG_ERROR([NGHTTP2 library not found])])
+		AC_CHECK_HEADER([nghttp2/nghttp2.h], [], [AC_MSG_ERROR([NGHTTP2 library headers not found])])
+
+		HAVE_NGHTTP2=yes
+
+		AM_VARIABLES_RESTORE
+
+		AC_MSG_NOTICE([NGHTTP2 environment variables:])
+		AC_MSG_NOTICE([  NGHTTP2_CFLAGS=${NGHTTP2_CFLAGS}])
+		AC_MSG_NOTICE([  NGHTTP2_CPPFLAGS=${NGHTTP2_CPPFLAGS}])
+		AC_MSG_NOTICE([  NGHTTP2_LDFLAGS=${NGHTTP2_LDFLAGS}])
+		AC_MSG_NOTICE([  NGHTTP2_LIBS=${NGHTTP2_LIBS}])
+
+		AC_SUBST([NGHTTP2_CFLAGS])
+		AC_SUBST([NGHTTP2_CPPFLAGS])
+		AC_SUBST([NGHTTP2_LDFLAGS])
+		AC_SUBST([NGHTTP2_LIBS])
+	fi
+])
@@ -51,6 +51,115 @@ static int mir_curl_debug_cb(CURL *handle, curl_infotype type, char *data, size_
 #endif /* DEBUG */
 
 
+/***
+ * NAME
+ *   mir_curl_inflight_reserve -
+ *
+ * ARGUMENTS
+ *   curl -
+ *   size -
+ *
+ * DESCRIPTION
+ *   Counts a new mirror against the per-worker and the global in-flight
+ *   limits.  The global counters are shared by all workers, so they are
+ *   incremented first and rolled back if the limit is exceeded.
+ *
+ * RETURN VALUE
+ *   Returns true if the mirror fits within the limits, false otherwise.
+ */
+static bool_t mir_curl_inflight_reserve(struct curl_data *curl, size_t size)
+{
+	uint     cons;
+	uint64_t bytes;
+
+	DBG_FUNC(NULL, "%p, %zu", curl, size);
+
+	if ((cfg.mir_max_cons[0] > 0) && (curl->nbactive >= cfg.mir_max_cons[0]))
+		DBG_RETURN_INT(false);
+	else if ((cfg.mir_max_bytes[0] > 0) && (curl->active_bytes + size > cfg.mir_max_bytes[0]))
+		DBG_RETURN_INT(false);
+
+	if ((cfg.mir_max_cons[1] > 0) || (cfg.mir_max_bytes[1] > 0)) {
+		cons  = __atomic_add_fetch(&(prg.mir_cons), 1, __ATOMIC_RELAXED);
+		bytes = __atomic_add_fetch(&(prg.mir_bytes), size, __ATOMIC_RELAXED);
+
+		if (((cfg.mir_max_cons[1] > 0) && (cons > cfg.mir_max_cons[1])) ||
+		    ((cfg.mir_max_bytes[1] > 0) && (bytes > cfg.mir_max_bytes[1]))) {
+			(void)__atomic_sub_fetch(&(prg.mir_cons), 1, __ATOMIC_RELAXED);
+			(void)__atomic_sub_fetch(&(prg.mir_bytes), size, __ATOMIC_RELAXED);
+
+			DBG_RETURN_INT(false);
+		}
+	}
+
+	STAT_INC(curl->nbactive);
+	curl->active_bytes += size;
+
+	DBG_RETURN_INT(true);
+}
+
+
+/***
+ * NAME
+ *   mir_curl_inflight_release -
+ *
+ * ARGUMENTS
+ *   curl -
+ *   size -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_curl_inflight_release(struct curl_data *curl, size_t size)
+{
+	DBG_FUNC(NULL, "%p, %zu", curl, size);
+
+	STAT_ADD(curl->nbactive, -1);
+	curl->active_bytes -= size;
+
+	if ((cfg.mir_max_cons[1] > 0) || (cfg.mir_max_bytes[1] > 0)) {
+		(void)__atomic_sub_fetch(&(prg.mir_cons), 1, __ATOMIC_RELAXED);
+		(void)__atomic_sub_fetch(&(prg.mir_bytes), size, __ATOMIC_RELAXED);
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_curl_inflight_del -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   Removes the easy handle from the list of in-flight transfers, if it is
+ *   there.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_curl_inflight_del(struct curl_con *con)
+{
+	DBG_FUNC(NULL, "%p", con);
+
+	if (!con->flag_active)
+		DBG_RETURN();
+
+	LIST_DEL(&(con->list));
+	LIST_INIT(&(con->list));
+	mir_curl_inflight_release(con->curl, con->size);
+
+	con->flag_active = 0;
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   mir_curl_handle_close -
@@ -73,6 +182,8 @@ static void mir_curl_handle_close(struct curl_con *con)
 
 	CURL_DBG("Closing handle { %p %p \"%s\" %p }", con->easy, con->hdrs, con->error, con->curl);
 
+	mir_curl_inflight_del(con);
+
 	if (_nNULL(con->curl) && _nNULL(con->curl->multi))
 		(void)curl_multi_remove_handle(con->curl->multi, con->easy);
 
@@ -82,7 +193,7 @@ static void mir_curl_handle_close(struct curl_con *con)
 	if (_nNULL(con->easy))
 		curl_easy_cleanup(con->easy);
 
-	mir_ptr_free(&(con->mir));
+	mir_sender_release(&(con->mir));
 
 	PTR_FREE(con);
 
@@ -90,6 +201,58 @@ static void mir_curl_handle_close(struct curl_con *con)
 }
 
 
+/***
+ * NAME
+ *   mir_curl_handle_release -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   Releases the data of the completed transfer and returns the easy handle
+ *   to the worker pool, so that it can be used again without having to set
+ *   the options that are the same for all transfers.  If the pool is full,
+ *   the easy handle is closed.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_curl_handle_release(struct curl_con *con)
+{
+	struct curl_data *curl;
+
+	DBG_FUNC(NULL, "%p", con);
+
+	if (_NULL(con))
+		DBG_RETURN();
+
+	mir_curl_inflight_del(con);
+
+	curl = con->curl;
+	if (_NULL(curl) || (curl->nbfree >= CURL_CON_POOL_MAX)) {
+		mir_curl_handle_close(con);
+
+		DBG_RETURN();
+	}
+
+	CURL_DBG("Releasing handle { %p %p \"%s\" %p }", con->easy, con->hdrs, con->error, con->curl);
+
+	(void)curl_multi_remove_handle(curl->multi, con->easy);
+
+	if (_nNULL(con->hdrs)) {
+		curl_slist_free_all(con->hdrs);
+		con->hdrs = NULL;
+	}
+
+	mir_sender_release(&(con->mir));
+
+	LIST_ADD(&(curl->cons), &(con->list));
+	curl->nbfree++;
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   mir_curl_get_http_version -
@@ -129,6 +292,88 @@ static const char *mir_curl_get_http_version(long version)
 }
 
 
+/***
+ * NAME
+ *   mir_curl_error_class -
+ *
+ * ARGUMENTS
+ *   rc -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the error class of the transfer result, used in the summaries.
+ */
+static uint8_t mir_curl_error_class(CURLcode rc)
+{
+	uint8_t retval = MIR_ERR_OTHER;
+
+	if (rc == CURLE_OK)
+		retval = MIR_ERR_OK;
+	else if (rc == CURLE_OPERATION_TIMEDOUT)
+		retval = MIR_ERR_TIMEOUT;
+	else if ((rc == CURLE_COULDNT_RESOLVE_HOST) || (rc == CURLE_COULDNT_CONNECT) || (rc == CURLE_SSL_CONNECT_ERROR))
+		retval = MIR_ERR_CONNECT;
+	else if ((rc == CURLE_SEND_ERROR) || (rc == CURLE_RECV_ERROR) || (rc == CURLE_GOT_NOTHING) || (rc == CURLE_PARTIAL_FILE))
+		retval = MIR_ERR_IO;
+#if CURL_AT_LEAST_VERSION(7, 51, 0)
+	else if ((rc == CURLE_WEIRD_SERVER_REPLY) || (rc == CURLE_HTTP2))
+		retval = MIR_ERR_PROTOCOL;
+#endif
+	else if (rc == CURLE_ABORTED_BY_CALLBACK)
+		retval = MIR_ERR_ABORTED;
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   mir_curl_hist_add -
+ *
+ * ARGUMENTS
+ *   curl   -
+ *   handle -
+ *
+ * DESCRIPTION
+ *   Counts the phase times of the completed transfer in the latency
+ *   histograms.  The phases that did not take place, such as the connect
+ *   on a reused connection, are reported as zero by libcurl and are not
+ *   counted.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_curl_hist_add(struct curl_data *curl, CURL *handle)
+{
+	static const struct {
+		CURLINFO info;
+		int      hist;
+	} phases[] = {
+		{ CURL_v076100(CURLINFO_NAMELOOKUP_TIME_T,    CURLINFO_NAMELOOKUP_TIME),    MIR_HIST_NAMELOOKUP    },
+		{ CURL_v076100(CURLINFO_CONNECT_TIME_T,       CURLINFO_CONNECT_TIME),       MIR_HIST_CONNECT       },
+		{ CURL_v076100(CURLINFO_APPCONNECT_TIME_T,    CURLINFO_APPCONNECT_TIME),    MIR_HIST_APPCONNECT    },
+		{ CURL_v076100(CURLINFO_STARTTRANSFER_TIME_T, CURLINFO_STARTTRANSFER_TIME), MIR_HIST_STARTTRANSFER },
+	};
+	CURL_v076100(curl_off_t, double) value;
+	CURLcode rc;
+	int      i;
+
+	if (!prg.stats.flag_hist)
+		return;
+
+	for (i = 0; i < TABLESIZE(phases); i++) {
+		value = 0;
+
+		if ((rc = curl_easy_getinfo(handle, phases[i].info, &value)) != CURLE_OK)
+			CURL_ERR_EASY("Failed to get transfer phase time", rc);
+		else if (value > 0)
+			stats_hist_add(curl->log.stats.hist + phases[i].hist, CURL_v076100(value * 1000, value * 1e9));
+	}
+}
+
+
 /***
  * NAME
  *   mir_curl_check_multi_info -
@@ -166,13 +411,8 @@ static void mir_curl_check_multi_info(struct curl_data *curl)
 			CURL_v075500(curl_off_t, double) size_download = -1;
 			const char *url = NULL;
 			long        response_code = -1, version = CURL_HTTP_VERSION_NONE;
+			bool_t      flag_line = mir_log_sample(&(curl->log));
 
-			if ((rc = curl_easy_getinfo(msg->easy_handle, CURLINFO_EFFECTIVE_URL, &url)) != CURLE_OK)
-				CURL_ERR_EASY("Failed to get effective URL", rc);
-#if CURL_AT_LEAST_VERSION(7, 50, 0)
-			if ((rc = curl_easy_getinfo(msg->easy_handle, CURLINFO_HTTP_VERSION, &version)) != CURLE_OK)
-				CURL_ERR_EASY("Failed to get HTTP version", rc);
-#endif
 			if ((rc = curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &response_code)) != CURLE_OK)
 				CURL_ERR_EASY("Failed to get response code", rc);
 			if ((rc = curl_easy_getinfo(msg->easy_handle, CURL_v076100(CURLINFO_TOTAL_TIME_T, CURLINFO_TOTAL_TIME), &total_time)) != CURLE_OK)
@@ -182,15 +422,30 @@ static void mir_curl_check_multi_info(struct curl_data *curl)
 			if ((rc = curl_easy_getinfo(msg->easy_handle, CURL_v075500(CURLINFO_SIZE_DOWNLOAD_T, CURLINFO_SIZE_DOWNLOAD), &size_download)) != CURLE_OK)
 				CURL_ERR_EASY("Failed to get number of downloaded bytes", rc);
 
-			w_log(NULL, "\"%s %s %s\" %ld " CURL_v075500("%ld/%ld", "%.0f/%.0f") " %.3f %s",
-			      con->mir->method, url, mir_curl_get_http_version(version),
-			      response_code, size_upload, size_download,
-			      CURL_v076100(total_time / 1000.0, total_time * 1000.0),
-			      (msg->data.result != CURLE_OK) ? con->error : "ok");
+			/* The URL and the HTTP version are needed only for the log line. */
+			if (flag_line) {
+				if ((rc = curl_easy_getinfo(msg->easy_handle, CURLINFO_EFFECTIVE_URL, &url)) != CURLE_OK)
+					CURL_ERR_EASY("Failed to get effective URL", rc);
+#if CURL_AT_LEAST_VERSION(7, 50, 0)
+				if ((rc = curl_easy_getinfo(msg->easy_handle, CURLINFO_HTTP_VERSION, &version)) != CURLE_OK)
+					CURL_ERR_EASY("Failed to get HTTP version", rc);
+#endif
+
+				w_log(NULL, "\"%s %s %s\" %ld " CURL_v075500("%ld/%ld", "%.0f/%.0f") " %.3f %s",
+				      con->mir->method, url, mir_curl_get_http_version(version),
+				      response_code, size_upload, size_download,
+				      CURL_v076100(total_time / 1000.0, total_time * 1000.0),
+				      (msg->data.result != CURLE_OK) ? con->error : "ok");
+			}
+
+			mir_log_add(&(curl->log), con->mir->method, response_code, mir_curl_error_class(msg->data.result),
+			            MAX(size_upload, 0), MAX(size_download, 0), CURL_v076100(total_time / 1000.0, total_time * 1000.0));
+			(void)stats_hist_since(curl->log.stats.hist + MIR_HIST_TOTAL, con->mir->t_submit);
+			mir_curl_hist_add(curl, msg->easy_handle);
 
 			CURL_DBG("Done: %s => (%d) %s", url, msg->data.result, con->error);
 
-			mir_curl_handle_close(con);
+			mir_curl_handle_release(con);
 		}
 	}
 
@@ -232,7 +487,6 @@ static void mir_curl_ev_socket_cb(struct ev_loop *loop __maybe_unused, struct ev
 			CURL_DBG("last transfer done, kill timeout");
 
 			ev_timer_stop(curl->ev_base, &(curl->ev_timer));
-			ev_async_send(curl->ev_base, curl->ev_async);
 		}
 	}
 
@@ -277,7 +531,6 @@ static int mir_curl_socket_set(struct curl_sock *socket, CURL *easy, curl_socket
 	ev_io_init(&(socket->ev_io), mir_curl_ev_socket_cb, socket->fd, events);
 	socket->ev_io.data = curl;
 	ev_io_start(curl->ev_base, &(socket->ev_io));
-	ev_async_send(curl->ev_base, curl->ev_async);
 
 	DBG_RETURN_INT(0);
 }
@@ -346,7 +599,6 @@ static int mir_curl_socket_remove(struct curl_sock *socket, struct curl_data *cu
 
 	if (ev_is_active(&(socket->ev_io)) || ev_is_pending(&(socket->ev_io)))
 		ev_io_stop(curl->ev_base, &(socket->ev_io));
-	ev_async_send(curl->ev_base, curl->ev_async);
 
 	PTR_FREE(socket);
 
@@ -460,7 +712,6 @@ static int mir_curl_timer_cb(CURLM *multi __maybe_unused, long timeout_ms, void
 		ev_timer_start(curl->ev_base, &(curl->ev_timer));
 	}
 
-	ev_async_send(curl->ev_base, curl->ev_async);
 
 	DBG_RETURN_INT(CURLM_OK);
 }
@@ -482,17 +733,18 @@ static int mir_curl_timer_cb(CURLM *multi __maybe_unused, long timeout_ms, void
  */
 static CURLcode mir_curl_set_headers(struct curl_con *con, const struct mirror *mir)
 {
-	struct buffer     *hdr, *hdr_back;
 	struct curl_slist *slist;
+	const char        *hdr;
 	CURLcode           retval = CURLE_OK;
+	int                i;
 
 	DBG_FUNC(NULL, "%p, %p", con, mir);
 
 	if (_NULL(con) || _NULL(mir))
 		DBG_RETURN_INT(retval);
 
-	list_for_each_entry_safe(hdr, hdr_back, &(mir->hdrs), list) {
-		slist = curl_slist_append(con->hdrs, (const char *)hdr->ptr);
+	for (i = 0, hdr = mir->hdrs; i < mir->hdrs_cnt; i++, hdr += strlen(hdr) + 1) {
+		slist = curl_slist_append(con->hdrs, hdr);
 		if (_NULL(slist)) {
 			DBG_RETURN_INT(CURLE_OUT_OF_MEMORY);
 
@@ -513,13 +765,44 @@ static CURLcode mir_curl_set_headers(struct curl_con *con, const struct mirror *
 }
 
 
+/***
+ * NAME
+ *   mir_curl_http_version -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the HTTP version used by default for the mirrored requests.
+ */
+static long mir_curl_http_version(void)
+{
+	long retval = CURL_HTTP_VERSION_NONE;
+
+	if (cfg.mir_http == MIR_HTTP_HTTP1_1)
+		retval = CURL_HTTP_VERSION_1_1;
+#if CURL_AT_LEAST_VERSION(7, 33, 0)
+	else if (cfg.mir_http == MIR_HTTP_HTTP2)
+		retval = CURL_HTTP_VERSION_2_0;
+#endif
+#if CURL_AT_LEAST_VERSION(7, 49, 0)
+	else if (cfg.mir_http == MIR_HTTP_HTTP2_PRIOR)
+		retval = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+#endif
+
+	return retval;
+}
+
+
 /***
  * NAME
  *   mir_curl_init -
  *
  * ARGUMENTS
  *   loop -
- *   ev   -
  *   curl -
  *
  * DESCRIPTION
@@ -528,7 +811,7 @@ static CURLcode mir_curl_set_headers(struct curl_con *con, const struct mirror *
  * RETURN VALUE
  *   -
  */
-int mir_curl_init(struct ev_loop *loop, struct ev_async *ev, struct curl_data *curl)
+int mir_curl_init(struct ev_loop *loop, struct curl_data *curl)
 {
 #ifndef USE_THREADS
 	CURLcode  rc;
@@ -543,8 +826,11 @@ int mir_curl_init(struct ev_loop *loop, struct ev_async *ev, struct curl_data *c
 
 	(void)memset(curl, 0, sizeof(*curl));
 
-	curl->ev_base  = loop;
-	curl->ev_async = ev;
+	curl->ev_base = loop;
+	LIST_INIT(&(curl->cons));
+	LIST_INIT(&(curl->active));
+	curl->seed = (prg.start_time.tv_usec ^ (uintptr_t)curl) | 1;
+	mir_log_init(&(curl->log), loop);
 
 	ev_timer_init(&(curl->ev_timer), mir_curl_ev_timer_cb, 0.0, 0.0);
 	curl->ev_timer.data = curl;
@@ -564,6 +850,20 @@ int mir_curl_init(struct ev_loop *loop, struct ev_async *ev, struct curl_data *c
 		CURL_ERR_MULTI("Failed to add timer callback function", rcm);
 	else if ((rcm = curl_multi_setopt(curl->multi, CURLMOPT_TIMERDATA, curl)) != CURLM_OK)
 		CURL_ERR_MULTI("Failed to set timer callback function data", rcm);
+#if CURL_AT_LEAST_VERSION(7, 43, 0)
+	else if ((cfg.mir_http >= MIR_HTTP_HTTP2) && ((rcm = curl_multi_setopt(curl->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX)) != CURLM_OK))
+		CURL_ERR_MULTI("Failed to enable multiplexing", rcm);
+#endif
+#if CURL_AT_LEAST_VERSION(7, 30, 0)
+	else if ((cfg.mir_max_conns > 0) && ((rcm = curl_multi_setopt(curl->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)cfg.mir_max_conns)) != CURLM_OK))
+		CURL_ERR_MULTI("Failed to set maximum number of connections per host", rcm);
+	else if ((cfg.mir_max_conns > 0) && ((rcm = curl_multi_setopt(curl->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)cfg.mir_max_conns)) != CURLM_OK))
+		CURL_ERR_MULTI("Failed to set maximum number of connections", rcm);
+#endif
+#if CURL_AT_LEAST_VERSION(7, 67, 0)
+	else if ((cfg.mir_max_streams > 0) && ((rcm = curl_multi_setopt(curl->multi, CURLMOPT_MAX_CONCURRENT_STREAMS, (long)cfg.mir_max_streams)) != CURLM_OK))
+		CURL_ERR_MULTI("Failed to set maximum number of concurrent streams", rcm);
+#endif
 	else
 		DBG_RETURN_INT(FUNC_RET_OK);
 
@@ -589,17 +889,31 @@ int mir_curl_init(struct ev_loop *loop, struct ev_async *ev, struct curl_data *c
  */
 void mir_curl_close(struct curl_data *curl)
 {
+	struct curl_con *con, *con_back;
+
 	DBG_FUNC(NULL, "%p", curl);
 
 	if (_NULL(curl))
 		DBG_RETURN();
 
+	list_for_each_entry_safe(con, con_back, &(curl->cons), list) {
+		LIST_DEL(&(con->list));
+		mir_curl_handle_close(con);
+	}
+	curl->nbfree = 0;
+
+	/* The transfers still in flight are aborted, and their mirrors released. */
+	list_for_each_entry_safe(con, con_back, &(curl->active), list)
+		mir_curl_handle_close(con);
+
 	if (_nNULL(curl->multi))
 		(void)curl_multi_cleanup(curl->multi);
 
 	if (ev_is_active(&(curl->ev_timer)) || ev_is_pending(&(curl->ev_timer)))
 		ev_timer_stop(curl->ev_base, &(curl->ev_timer));
-	ev_async_send(curl->ev_base, curl->ev_async);
+
+	if (_nNULL(curl->ev_base))
+		mir_log_summary(NULL, &(curl->log), curl->ev_base);
 
 #ifndef USE_THREADS
 	curl_global_cleanup();
@@ -611,6 +925,38 @@ void mir_curl_close(struct curl_data *curl)
 }
 
 
+/***
+ * NAME
+ *   mir_curl_monitor -
+ *
+ * ARGUMENTS
+ *   worker -
+ *   curl   -
+ *
+ * DESCRIPTION
+ *   Reports the mirrors dropped due to the in-flight limits since the last
+ *   call of this function.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_curl_monitor(const struct worker *worker, struct curl_data *curl)
+{
+	DBG_FUNC(worker, "%p, %p", worker, curl);
+
+	if (curl->nbdropped > curl->nbdropped_last) {
+		w_log(worker, _W("%"PRIu64" mirrors dropped due to the in-flight limits (%"PRIu64" in total, %"PRIu64" bytes), %u in flight"),
+		      curl->nbdropped - curl->nbdropped_last, curl->nbdropped, curl->dropped_bytes, curl->nbactive);
+
+		curl->nbdropped_last = curl->nbdropped;
+	}
+
+	mir_log_summary(worker, &(curl->log), curl->ev_base);
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   mir_curl_read_cb - CURLOPT_READFUNCTION callback function
@@ -793,10 +1139,12 @@ static CURLcode mir_curl_add_post(struct curl_con *con, const struct mirror *mir
 		CURL_ERR_EASY("Failed to init HTTP POST data", retval);
 	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)mir->body_size)) != CURLE_OK)
 		CURL_ERR_EASY("Failed to set HTTP POST data size", retval);
-	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_READFUNCTION, mir_curl_read_cb)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set read callback function", retval);
-	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_READDATA, con)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set read callback function data", retval);
+	/*
+	 * The body is sent directly from the SPOE frame that is kept until the
+	 * transfer is completed, so there is no need to copy it.
+	 */
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_POSTFIELDS, _NULL(mir->body) ? "" : mir->body)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set HTTP POST data", retval);
 
 	DBG_RETURN_INT(retval);
 }
@@ -831,16 +1179,12 @@ static CURLcode mir_curl_add_put(struct curl_con *con, const struct mirror *mir)
 		CURL_ERR_EASY("Failed to set HTTP content decoding", retval);
 	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_HTTP_TRANSFER_DECODING, 0L)) != CURLE_OK)
 		CURL_ERR_EASY("Failed to set HTTP transfer decoding", retval);
-	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_READFUNCTION, mir_curl_read_cb)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set read callback function", retval);
 	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_UPLOAD, 1L)) != CURLE_OK)
 		CURL_ERR_EASY("Failed to enable uploading", retval);
 #if !CURL_AT_LEAST_VERSION(7, 12, 1)
 	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_PUT, 1L)) != CURLE_OK)
 		CURL_ERR_EASY("Failed to init HTTP PUT data", retval);
 #endif
-	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_READDATA, con)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set read callback function data", retval);
 	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_INFILESIZE_LARGE, (curl_off_t)mir->body_size)) != CURLE_OK)
 		CURL_ERR_EASY("Failed to set HTTP PUT data size", retval);
 
@@ -854,7 +1198,6 @@ static CURLcode mir_curl_add_put(struct curl_con *con, const struct mirror *mir)
  *
  * ARGUMENTS
  *   con -
- *   mir -
  *
  * DESCRIPTION
  *   -
@@ -862,13 +1205,13 @@ static CURLcode mir_curl_add_put(struct curl_con *con, const struct mirror *mir)
  * RETURN VALUE
  *   -
  */
-static CURLcode mir_curl_add_out(struct curl_con *con, const struct mirror *mir)
+static CURLcode mir_curl_add_out(struct curl_con *con)
 {
 	CURLcode retval = CURLE_OK;
 
-	DBG_FUNC(NULL, "%p, %p", con, mir);
+	DBG_FUNC(NULL, "%p", con);
 
-	if (_NULL(con) || _NULL(mir))
+	if (_NULL(con))
 		DBG_RETURN_INT(retval);
 
 	if (_nNULL(cfg.mir_interface))
@@ -892,24 +1235,24 @@ static CURLcode mir_curl_add_out(struct curl_con *con, const struct mirror *mir)
  *
  * ARGUMENTS
  *   con -
- *   mir -
  *
  * DESCRIPTION
- *   -
+ *   All mirrored requests are sent to the same URL scheme, so this is
+ *   decided by the mirror URL.
  *
  * RETURN VALUE
  *   -
  */
-static CURLcode mir_curl_add_cert(struct curl_con *con, const struct mirror *mir)
+static CURLcode mir_curl_add_cert(struct curl_con *con)
 {
 	CURLcode retval = CURLE_BAD_FUNCTION_ARGUMENT;
 
-	DBG_FUNC(NULL, "%p, %p", con, mir);
+	DBG_FUNC(NULL, "%p", con);
 
-	if (_NULL(con) || _NULL(mir))
+	if (_NULL(con))
 		DBG_RETURN_INT(retval);
 
-	if (strncasecmp(mir->url, STR_ADDRSIZE(STR_HTTPS_PFX)) != 0) {
+	if (strncasecmp(cfg.mir_url, STR_ADDRSIZE(STR_HTTPS_PFX)) != 0) {
 		retval = CURLE_OK;
 	} else {
 		CURL_DBG("disabling SSL peer/host verification");
@@ -948,7 +1291,7 @@ static CURLcode mir_curl_add_url(struct curl_con *con, const struct mirror *mir)
 		DBG_RETURN_INT(retval);
 
 #if CURL_AT_LEAST_VERSION(7, 33, 0)
-	if (_NULL(mir->version) || (strcasecmp(mir->version, "2.0") != 0))
+	if ((cfg.mir_http != MIR_HTTP_AUTO) || _NULL(mir->version) || (strcasecmp(mir->version, "2.0") != 0))
 		retval = CURLE_OK;
 	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2_0)) != CURLE_OK)
 		CURL_ERR_EASY("Failed to set HTTP version", retval);
@@ -973,6 +1316,289 @@ static CURLcode mir_curl_add_url(struct curl_con *con, const struct mirror *mir)
 }
 
 
+/***
+ * NAME
+ *   mir_curl_handle_setup -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   Sets the options of the new easy handle that are the same for all
+ *   mirrored requests.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static CURLcode mir_curl_handle_setup(struct curl_con *con)
+{
+	long     con_timeout_ms = CURL_CON_TMOUT, timeout_ms = CURL_TMOUT;
+	CURLcode retval;
+
+	DBG_FUNC(NULL, "%p", con);
+
+	con_timeout_ms = CLAMP_VALUE(con_timeout_ms, CURL_CON_TMOUT_MIN, CURL_CON_TMOUT_MAX);
+	timeout_ms     = CLAMP_VALUE(timeout_ms, CURL_TMOUT_MIN, CURL_TMOUT_MAX);
+
+	if ((retval = mir_curl_add_out(con)) != CURLE_OK)
+		/* Do nothing. */;
+	else if ((retval = mir_curl_add_cert(con)) != CURLE_OK)
+		/* Do nothing. */;
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_WRITEFUNCTION, mir_curl_write_cb)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set write callback function", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_WRITEDATA, con)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set write callback function data", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_READFUNCTION, mir_curl_read_cb)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set read callback function", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_READDATA, con)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set read callback function data", retval);
+#ifdef DEBUG
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_DEBUGFUNCTION, mir_curl_debug_cb)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set debug function", retval);
+#endif
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_VERBOSE, IFDEF_DBG(1L, 0L))) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set verbosity", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_ERRORBUFFER, con->error)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set error messages buffer", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_PRIVATE, con)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set private data pointer", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_NOPROGRESS, 0L)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to switch on the progress meter", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURL_v073200(CURLOPT_XFERINFOFUNCTION, CURLOPT_PROGRESSFUNCTION), mir_curl_xferinfo_cb)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set transfer callback function", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURL_v073200(CURLOPT_XFERINFODATA, CURLOPT_PROGRESSDATA), con)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set transfer callback function data", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_LOW_SPEED_LIMIT, CURL_LS_LIMIT)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set low speed limit", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_LOW_SPEED_TIME, CURL_LS_TIME)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set low speed time", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_NOSIGNAL, 1L)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to disable signals", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_CONNECTTIMEOUT_MS, con_timeout_ms)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set connect timeout", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_TIMEOUT_MS, timeout_ms)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set read timeout", retval);
+	else if (_nNULL(prg.curl_share.share) && ((retval = curl_easy_setopt(con->easy, CURLOPT_SHARE, prg.curl_share.share)) != CURLE_OK))
+		CURL_ERR_EASY("Failed to set share handle", retval);
+#if CURL_AT_LEAST_VERSION(7, 33, 0)
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_HTTP_VERSION, mir_curl_http_version())) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set HTTP version", retval);
+#endif
+#if CURL_AT_LEAST_VERSION(7, 43, 0)
+	/*
+	 * Wait for a connection that can be multiplexed rather than opening a
+	 * new one for each request.
+	 */
+	else if ((cfg.mir_http >= MIR_HTTP_HTTP2) && ((retval = curl_easy_setopt(con->easy, CURLOPT_PIPEWAIT, 1L)) != CURLE_OK))
+		CURL_ERR_EASY("Failed to set wait for multiplexing", retval);
+#endif
+	else
+		retval = mir_curl_add_keepalive(con, 1, CURL_KEEPIDLE_TIME, CURL_KEEPINTVL_TIME);
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   mir_curl_handle_reset -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   Restores the default values of the options that are changed only by
+ *   some of the mirrored requests, before the easy handle is used again.
+ *   The URL, the request method and the headers are set for each request.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static CURLcode mir_curl_handle_reset(struct curl_con *con)
+{
+	CURLcode retval;
+
+	DBG_FUNC(NULL, "%p", con);
+
+	con->error[0] = '\0';
+
+	if ((retval = curl_easy_setopt(con->easy, CURLOPT_HTTPGET, 1L)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to reset HTTP request", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_HTTP_CONTENT_DECODING, 1L)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set HTTP content decoding", retval);
+	else if ((retval = curl_easy_setopt(con->easy, CURLOPT_HTTP_TRANSFER_DECODING, 1L)) != CURLE_OK)
+		CURL_ERR_EASY("Failed to set HTTP transfer decoding", retval);
+#if CURL_AT_LEAST_VERSION(7, 33, 0)
+	else if ((cfg.mir_http == MIR_HTTP_AUTO) && ((retval = curl_easy_setopt(con->easy, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_NONE)) != CURLE_OK))
+		CURL_ERR_EASY("Failed to set HTTP version", retval);
+#endif
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   mir_curl_handle_get -
+ *
+ * ARGUMENTS
+ *   curl -
+ *
+ * DESCRIPTION
+ *   Takes a free easy handle from the worker pool, or creates a new one if
+ *   the pool is empty.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct curl_con *mir_curl_handle_get(struct curl_data *curl)
+{
+	struct curl_con *retptr;
+
+	DBG_FUNC(NULL, "%p", curl);
+
+	if (!LIST_ISEMPTY(&(curl->cons))) {
+		retptr = LIST_NEXT(&(curl->cons), typeof(retptr), list);
+		LIST_DEL(&(retptr->list));
+		curl->nbfree--;
+
+		if (mir_curl_handle_reset(retptr) != CURLE_OK) {
+			mir_curl_handle_close(retptr);
+			retptr = NULL;
+		}
+
+		DBG_RETURN_PTR(retptr);
+	}
+
+	if (_NULL(retptr = calloc(1, sizeof(*retptr)))) {
+		w_log(NULL, CURL_STR _E("Failed to allocate memory"));
+	}
+	else if (_NULL(retptr->easy = curl_easy_init())) {
+		w_log(NULL, CURL_STR _E("Failed to initialize easy handle"));
+
+		PTR_FREE(retptr);
+	}
+	else if (mir_curl_handle_setup(retptr) != CURLE_OK) {
+		mir_curl_handle_close(retptr);
+		retptr = NULL;
+	}
+	else {
+		retptr->curl = curl;
+	}
+
+	DBG_RETURN_PTR(retptr);
+}
+
+
+/***
+ * NAME
+ *   mir_curl_load -
+ *
+ * ARGUMENTS
+ *   value -
+ *   limit -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the used part of the limit in permille, or 0 if the limit is
+ *   not set.
+ */
+static inline uint mir_curl_load(uint64_t value, uint64_t limit)
+{
+	return (limit > 0) ? MIN(value * 1000 / limit, 1000) : 0;
+}
+
+
+/***
+ * NAME
+ *   mir_curl_sample -
+ *
+ * ARGUMENTS
+ *   curl -
+ *   size -
+ *
+ * DESCRIPTION
+ *   Decides whether the new mirror is sent when the sample overload policy
+ *   is used.  Up to half of the in-flight limits all mirrors are sent, and
+ *   above that the probability of sending the mirror falls linearly to zero
+ *   at the limit.
+ *
+ * RETURN VALUE
+ *   Returns true if the mirror should be sent, false otherwise.
+ */
+static bool_t mir_curl_sample(struct curl_data *curl, size_t size)
+{
+	uint load;
+
+	DBG_FUNC(NULL, "%p, %zu", curl, size);
+
+	load = MAX(mir_curl_load(curl->nbactive + 1, cfg.mir_max_cons[0]),
+	           mir_curl_load(curl->active_bytes + size, cfg.mir_max_bytes[0]));
+	load = MAX(load, mir_curl_load(__atomic_load_n(&(prg.mir_cons), __ATOMIC_RELAXED) + 1, cfg.mir_max_cons[1]));
+	load = MAX(load, mir_curl_load(__atomic_load_n(&(prg.mir_bytes), __ATOMIC_RELAXED) + size, cfg.mir_max_bytes[1]));
+
+	if (load <= 500)
+		DBG_RETURN_INT(true);
+
+	/* xorshift32 */
+	curl->seed ^= curl->seed << 13;
+	curl->seed ^= curl->seed >> 17;
+	curl->seed ^= curl->seed << 5;
+
+	DBG_RETURN_INT((curl->seed % 500) < (1000 - load));
+}
+
+
+/***
+ * NAME
+ *   mir_curl_admit -
+ *
+ * ARGUMENTS
+ *   curl -
+ *   size -
+ *
+ * DESCRIPTION
+ *   Applies the in-flight limits and the overload policy to the new mirror.
+ *   If the drop-oldest policy is used, the oldest in-flight transfers of the
+ *   worker are aborted until there is room for the new mirror.
+ *
+ * RETURN VALUE
+ *   Returns true if the mirror can be sent, false if it should be dropped.
+ */
+static bool_t mir_curl_admit(struct curl_data *curl, size_t size)
+{
+	struct curl_con *con;
+
+	DBG_FUNC(NULL, "%p, %zu", curl, size);
+
+	/* A mirror larger than the limit can never be sent. */
+	if (((cfg.mir_max_bytes[0] > 0) && (size > cfg.mir_max_bytes[0])) ||
+	    ((cfg.mir_max_bytes[1] > 0) && (size > cfg.mir_max_bytes[1])))
+		DBG_RETURN_INT(false);
+
+	if ((cfg.mir_overload == MIR_OVERLOAD_SAMPLE) && !mir_curl_sample(curl, size))
+		DBG_RETURN_INT(false);
+
+	while (!mir_curl_inflight_reserve(curl, size)) {
+		if ((cfg.mir_overload != MIR_OVERLOAD_DROP_OLDEST) || LIST_ISEMPTY(&(curl->active)))
+			DBG_RETURN_INT(false);
+
+		con = LIST_NEXT(&(curl->active), typeof(con), list);
+
+		CURL_DBG("Aborting mirror %p (%zu bytes) to make room", con->mir, con->size);
+
+		STAT_INC(curl->nbdropped);
+		curl->dropped_bytes += con->size;
+
+		mir_curl_handle_release(con);
+	}
+
+	DBG_RETURN_INT(true);
+}
+
+
 /***
  * NAME
  *   mir_curl_add -
@@ -982,7 +1608,9 @@ static CURLcode mir_curl_add_url(struct curl_con *con, const struct mirror *mir)
  *   mir  -
  *
  * DESCRIPTION
- *   Create a new easy handle, and add it to the global curl_multi.
+ *   Takes an easy handle from the worker pool, and adds it to the worker
+ *   curl_multi.  If the mirror does not fit within the in-flight limits, it
+ *   is dropped and released here, which is not considered an error.
  *
  * RETURN VALUE
  *   -
@@ -990,9 +1618,9 @@ static CURLcode mir_curl_add_url(struct curl_con *con, const struct mirror *mir)
 int mir_curl_add(struct curl_data *curl, struct mirror *mir)
 {
 	struct curl_con *con;
+	size_t           size;
 	CURLcode         rc;
 	CURLMcode        rcm;
-	long             con_timeout_ms = CURL_CON_TMOUT, timeout_ms = CURL_TMOUT;
 	int              retval = FUNC_RET_ERROR;
 
 	DBG_FUNC(NULL, "%p, %p", curl, mir);
@@ -1000,62 +1628,40 @@ int mir_curl_add(struct curl_data *curl, struct mirror *mir)
 	if (_NULL(curl) || _NULL(mir))
 		DBG_RETURN_INT(retval);
 
-	CURL_DBG("Adding mirror { \"%s\" \"%s\" \"%s\" %d \"%s\" { %p %p } %p %zu/%zu }", mir->url, mir->path, mir->method, mir->request_method, mir->version, mir->hdrs.p, mir->hdrs.n, mir->body, mir->body_head, mir->body_size);
+	CURL_DBG("Adding mirror { \"%s\" \"%s\" \"%s\" %d \"%s\" { %p %zu %d } %p %zu/%zu }", mir->url, mir->path, mir->method, mir->request_method, mir->version, mir->hdrs, mir->hdrs_len, mir->hdrs_cnt, mir->body, mir->body_head, mir->body_size);
 
-	con_timeout_ms = CLAMP_VALUE(con_timeout_ms, CURL_CON_TMOUT_MIN, CURL_CON_TMOUT_MAX);
-	timeout_ms     = CLAMP_VALUE(timeout_ms, CURL_TMOUT_MIN, CURL_TMOUT_MAX);
+	size = mir->hdrs_len + mir->body_size;
+	if (!mir_curl_admit(curl, size)) {
+		CURL_DBG("Dropping mirror %p (%zu bytes)", mir, size);
 
-	if (_NULL(con = calloc(1, sizeof(*con))))
-		w_log(NULL, CURL_STR _E("Failed to allocate memory"));
-	else if (_NULL(con->easy = curl_easy_init()))
-		w_log(NULL, CURL_STR _E("Failed to initialize easy handle"));
-	else if ((rc = mir_curl_add_out(con, mir)) != CURLE_OK)
-		/* Do nothing. */;
-	else if ((rc = mir_curl_add_cert(con, mir)) != CURLE_OK)
-		/* Do nothing. */;
-	else if ((rc = mir_curl_add_url(con, mir)) != CURLE_OK)
+		STAT_INC(curl->nbdropped);
+		curl->dropped_bytes += size;
+
+		mir_sender_release(&mir);
+
+		DBG_RETURN_INT(FUNC_RET_OK);
+	}
+
+	if (_NULL(con = mir_curl_handle_get(curl))) {
+		mir_curl_inflight_release(curl, size);
+
+		DBG_RETURN_INT(retval);
+	}
+
+	con->size        = size;
+	con->flag_active = 1;
+	LIST_ADDQ(&(curl->active), &(con->list));
+
+	if ((rc = mir_curl_add_url(con, mir)) != CURLE_OK)
 		/* Do nothing. */;
 	else if ((rc = mir_curl_set_headers(con, mir)) != CURLE_OK)
 		/* Do nothing. */;
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_WRITEFUNCTION, mir_curl_write_cb)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set write callback function", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_WRITEDATA, con)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set write callback function data", rc);
-#ifdef DEBUG
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_DEBUGFUNCTION, mir_curl_debug_cb)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set debug function", rc);
-#endif
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_VERBOSE, IFDEF_DBG(1L, 0L))) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set verbosity", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_ERRORBUFFER, con->error)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set error messages buffer", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_PRIVATE, con)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set private data pointer", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_NOPROGRESS, 0L)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to switch on the progress meter", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURL_v073200(CURLOPT_XFERINFOFUNCTION, CURLOPT_PROGRESSFUNCTION), mir_curl_xferinfo_cb)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set transfer callback function", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURL_v073200(CURLOPT_XFERINFODATA, CURLOPT_PROGRESSDATA), con)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set transfer callback function data", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_LOW_SPEED_LIMIT, CURL_LS_LIMIT)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set low speed limit", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_LOW_SPEED_TIME, CURL_LS_TIME)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set low speed time", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_NOSIGNAL, 1L)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to disable signals", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_CONNECTTIMEOUT_MS, con_timeout_ms)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set connect timeout", rc);
-	else if ((rc = curl_easy_setopt(con->easy, CURLOPT_TIMEOUT_MS, timeout_ms)) != CURLE_OK)
-		CURL_ERR_EASY("Failed to set read timeout", rc);
-	else if ((rc = mir_curl_add_keepalive(con, 1, CURL_KEEPIDLE_TIME, CURL_KEEPINTVL_TIME)) != CURLE_OK)
-		/* Do nothing. */;
 	else if ((rc = mir_curl_add_post(con, mir)) != CURLE_OK)
 		/* Do nothing. */;
 	else if ((rc = mir_curl_add_put(con, mir)) == CURLE_OK) {
 		CURL_DBG("Adding easy %p to multi %p (%s)", con->easy, curl->multi, mir->url);
 
-		con->curl = curl;
-		con->mir  = mir;
+		con->mir = mir;
 
 		if ((rcm = curl_multi_add_handle(curl->multi, con->easy)) != CURLM_OK)
 			CURL_ERR_MULTI("Failed to add easy handle", rcm);
@@ -1063,12 +1669,156 @@ int mir_curl_add(struct curl_data *curl, struct mirror *mir)
 			retval = FUNC_RET_OK;
 	}
 
+	/* The mirror is released by the caller in the case of an error. */
+	if (_ERROR(retval)) {
+		con->mir = NULL;
+		mir_curl_handle_release(con);
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+
+/***
+ * NAME
+ *   mir_curl_share_lock_cb - CURLSHOPT_LOCKFUNC callback function
+ *
+ * ARGUMENTS
+ *   handle -
+ *   data   -
+ *   access -
+ *   userp  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_curl_share_lock_cb(CURL *handle __maybe_unused, curl_lock_data data, curl_lock_access access __maybe_unused, void *userp)
+{
+	struct curl_share *share = (typeof(share))userp;
+
+	(void)pthread_mutex_lock(share->lock + data);
+}
+
+
+/***
+ * NAME
+ *   mir_curl_share_unlock_cb - CURLSHOPT_UNLOCKFUNC callback function
+ *
+ * ARGUMENTS
+ *   handle -
+ *   data   -
+ *   userp  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_curl_share_unlock_cb(CURL *handle __maybe_unused, curl_lock_data data, void *userp)
+{
+	struct curl_share *share = (typeof(share))userp;
+
+	(void)pthread_mutex_unlock(share->lock + data);
+}
+
+
+/***
+ * NAME
+ *   mir_curl_share_init -
+ *
+ * ARGUMENTS
+ *   share -
+ *
+ * DESCRIPTION
+ *   Creates the share handle through which the easy handles of all workers
+ *   use the same DNS cache and TLS session cache.  The connection cache is
+ *   not shared, because libcurl does not support using shared connections
+ *   from several threads at the same time.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int mir_curl_share_init(struct curl_share *share)
+{
+	CURLSHcode rcs;
+	int        i, retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(NULL, "%p", share);
+
+	if (_NULL(share))
+		DBG_RETURN_INT(retval);
+
+	if (_NULL(share->share = curl_share_init())) {
+		w_log(NULL, CURL_STR _E("Failed to initialize share handle"));
+
+		DBG_RETURN_INT(retval);
+	}
+
+	for (i = 0; i < CURL_LOCK_DATA_LAST; i++)
+		(void)pthread_mutex_init(share->lock + i, NULL);
+
+	if ((rcs = curl_share_setopt(share->share, CURLSHOPT_LOCKFUNC, mir_curl_share_lock_cb)) != CURLSHE_OK)
+		CURL_ERR_SHARE("Failed to set lock callback function", rcs);
+	else if ((rcs = curl_share_setopt(share->share, CURLSHOPT_UNLOCKFUNC, mir_curl_share_unlock_cb)) != CURLSHE_OK)
+		CURL_ERR_SHARE("Failed to set unlock callback function", rcs);
+	else if ((rcs = curl_share_setopt(share->share, CURLSHOPT_USERDATA, share)) != CURLSHE_OK)
+		CURL_ERR_SHARE("Failed to set lock callback function data", rcs);
+	else if ((rcs = curl_share_setopt(share->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS)) != CURLSHE_OK)
+		CURL_ERR_SHARE("Failed to share DNS cache", rcs);
+	else if ((rcs = curl_share_setopt(share->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION)) != CURLSHE_OK)
+		CURL_ERR_SHARE("Failed to share TLS session cache", rcs);
+	else
+		retval = FUNC_RET_OK;
+
 	if (_ERROR(retval))
-		mir_curl_handle_close(con);
+		mir_curl_share_close(share);
 
 	DBG_RETURN_INT(retval);
 }
 
+
+/***
+ * NAME
+ *   mir_curl_share_close -
+ *
+ * ARGUMENTS
+ *   share -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_curl_share_close(struct curl_share *share)
+{
+	int i;
+
+	DBG_FUNC(NULL, "%p", share);
+
+	if (_NULL(share) || _NULL(share->share))
+		DBG_RETURN();
+
+	/*
+	 * If the transfers that were in progress when the workers stopped still
+	 * use the share handle, it is left as it is.
+	 */
+	if (curl_share_cleanup(share->share) != CURLSHE_OK)
+		DBG_RETURN();
+
+	share->share = NULL;
+
+	for (i = 0; i < CURL_LOCK_DATA_LAST; i++)
+		(void)pthread_mutex_destroy(share->lock + i);
+
+	DBG_RETURN();
+}
+
 /*
  * Local variables:
  *  c-indent-level: 8
@@ -0,0 +1,1404 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+
+
+static int mir_http1_req_queue(struct http1_data *http1, struct http1_req *req);
+
+
+/***
+ * NAME
+ *   mir_http1_inflight_reserve -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   size  -
+ *
+ * DESCRIPTION
+ *   Counts a new mirror against the per-worker and the global in-flight
+ *   limits, the same way as it is done for the cURL mirrors.
+ *
+ * RETURN VALUE
+ *   Returns true if the mirror fits within the limits, false otherwise.
+ */
+static bool_t mir_http1_inflight_reserve(struct http1_data *http1, size_t size)
+{
+	uint     cons;
+	uint64_t bytes;
+
+	DBG_FUNC(NULL, "%p, %zu", http1, size);
+
+	if ((cfg.mir_max_cons[0] > 0) && (http1->nbactive >= cfg.mir_max_cons[0]))
+		DBG_RETURN_INT(false);
+	else if ((cfg.mir_max_bytes[0] > 0) && (http1->active_bytes + size > cfg.mir_max_bytes[0]))
+		DBG_RETURN_INT(false);
+
+	if ((cfg.mir_max_cons[1] > 0) || (cfg.mir_max_bytes[1] > 0)) {
+		cons  = __atomic_add_fetch(&(prg.mir_cons), 1, __ATOMIC_RELAXED);
+		bytes = __atomic_add_fetch(&(prg.mir_bytes), size, __ATOMIC_RELAXED);
+
+		if (((cfg.mir_max_cons[1] > 0) && (cons > cfg.mir_max_cons[1])) ||
+		    ((cfg.mir_max_bytes[1] > 0) && (bytes > cfg.mir_max_bytes[1]))) {
+			(void)__atomic_sub_fetch(&(prg.mir_cons), 1, __ATOMIC_RELAXED);
+			(void)__atomic_sub_fetch(&(prg.mir_bytes), size, __ATOMIC_RELAXED);
+
+			DBG_RETURN_INT(false);
+		}
+	}
+
+	STAT_INC(http1->nbactive);
+	http1->active_bytes += size;
+
+	DBG_RETURN_INT(true);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_inflight_release -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   size  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_inflight_release(struct http1_data *http1, size_t size)
+{
+	DBG_FUNC(NULL, "%p, %zu", http1, size);
+
+	STAT_ADD(http1->nbactive, -1);
+	http1->active_bytes -= size;
+
+	if ((cfg.mir_max_cons[1] > 0) || (cfg.mir_max_bytes[1] > 0)) {
+		(void)__atomic_sub_fetch(&(prg.mir_cons), 1, __ATOMIC_RELAXED);
+		(void)__atomic_sub_fetch(&(prg.mir_bytes), size, __ATOMIC_RELAXED);
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_load -
+ *
+ * ARGUMENTS
+ *   value -
+ *   limit -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the used part of the limit in permille, or 0 if the limit is
+ *   not set.
+ */
+static inline uint mir_http1_load(uint64_t value, uint64_t limit)
+{
+	return (limit > 0) ? MIN(value * 1000 / limit, 1000) : 0;
+}
+
+
+/***
+ * NAME
+ *   mir_http1_admit -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   size  -
+ *
+ * DESCRIPTION
+ *   Applies the in-flight limits and the overload policy to the new mirror.
+ *   The requests already written to a connection cannot be recalled without
+ *   losing the whole pipeline, so the drop-oldest policy behaves here as the
+ *   drop-newest one.
+ *
+ * RETURN VALUE
+ *   Returns true if the mirror can be sent, false if it should be dropped.
+ */
+static bool_t mir_http1_admit(struct http1_data *http1, size_t size)
+{
+	uint load;
+
+	DBG_FUNC(NULL, "%p, %zu", http1, size);
+
+	/* A mirror larger than the limit can never be sent. */
+	if (((cfg.mir_max_bytes[0] > 0) && (size > cfg.mir_max_bytes[0])) ||
+	    ((cfg.mir_max_bytes[1] > 0) && (size > cfg.mir_max_bytes[1])))
+		DBG_RETURN_INT(false);
+
+	if (cfg.mir_overload == MIR_OVERLOAD_SAMPLE) {
+		load = MAX(mir_http1_load(http1->nbactive + 1, cfg.mir_max_cons[0]),
+		           mir_http1_load(http1->active_bytes + size, cfg.mir_max_bytes[0]));
+		load = MAX(load, mir_http1_load(__atomic_load_n(&(prg.mir_cons), __ATOMIC_RELAXED) + 1, cfg.mir_max_cons[1]));
+		load = MAX(load, mir_http1_load(__atomic_load_n(&(prg.mir_bytes), __ATOMIC_RELAXED) + size, cfg.mir_max_bytes[1]));
+
+		if (load > 500) {
+			/* xorshift32 */
+			http1->seed ^= http1->seed << 13;
+			http1->seed ^= http1->seed >> 17;
+			http1->seed ^= http1->seed << 5;
+
+			if ((http1->seed % 500) >= (1000 - load))
+				DBG_RETURN_INT(false);
+		}
+	}
+
+	DBG_RETURN_INT(mir_http1_inflight_reserve(http1, size));
+}
+
+
+/***
+ * NAME
+ *   mir_http1_hdr_skip -
+ *
+ * ARGUMENTS
+ *   name      -
+ *   len       -
+ *   flag_host -
+ *
+ * DESCRIPTION
+ *   The hop-by-hop headers of the original request are not forwarded, and
+ *   the request body is always sent with its length, as it has already been
+ *   reassembled by HAProxy.
+ *
+ * RETURN VALUE
+ *   Returns true if the header is not sent to the mirror server.
+ */
+static bool_t mir_http1_hdr_skip(const char *name, size_t len, bool_t *flag_host)
+{
+	static const struct {
+		const char *name;
+		size_t      len;
+	} hdrs[] = {
+		{ STR_ADDRSIZE("connection")        },
+		{ STR_ADDRSIZE("content-length")    },
+		{ STR_ADDRSIZE("expect")            },
+		{ STR_ADDRSIZE("keep-alive")        },
+		{ STR_ADDRSIZE("proxy-connection")  },
+		{ STR_ADDRSIZE("te")                },
+		{ STR_ADDRSIZE("transfer-encoding") },
+		{ STR_ADDRSIZE("upgrade")           },
+	};
+	int i;
+
+	if ((len == STR_SIZE("host")) && (strncasecmp(name, STR_ADDRSIZE("host")) == 0)) {
+		*flag_host = 1;
+
+		return false;
+	}
+
+	for (i = 0; i < TABLESIZE(hdrs); i++)
+		if ((len == hdrs[i].len) && (strncasecmp(name, hdrs[i].name, len) == 0))
+			return true;
+
+	return false;
+}
+
+
+/***
+ * NAME
+ *   mir_http1_req_new -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   mir   -
+ *
+ * DESCRIPTION
+ *   Serializes the request line and the header section of the mirrored
+ *   request.  The headers are taken from the header arena as they are, only
+ *   the terminating null characters are replaced with CRLF.  The body is not
+ *   copied, it is written directly from the SPOE frame.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct http1_req *mir_http1_req_new(const struct http1_data *http1, struct mirror *mir)
+{
+	struct http1_req *retptr;
+	const char       *hdr, *path;
+	size_t            len, n, name_len;
+	bool_t            flag_host = 0;
+	char             *ptr;
+	int               i;
+
+	DBG_FUNC(NULL, "%p, %p", http1, mir);
+
+	path = (_NULL(mir->path) || (*(mir->path) == '\0')) ? "/" : mir->path;
+
+	/* Each header gets one byte longer, as '\0' is replaced with CRLF. */
+	len = strlen(mir->method) + 1 + strlen(path) + STR_SIZE(" HTTP/1.1\r\n") +
+	      mir->hdrs_len + mir->hdrs_cnt +
+	      STR_SIZE("Host: \r\n") + http1->authority_len +
+	      STR_SIZE("Content-Length: \r\n") + 20 + STR_SIZE("\r\n") + 1;
+
+	if (_NULL(retptr = malloc(sizeof(*retptr) + len))) {
+		w_log(NULL, HTTP1_STR _E("Failed to allocate memory"));
+
+		DBG_RETURN_PTR(retptr);
+	}
+
+	ptr = retptr->head;
+	ptr = stpcpy(ptr, mir->method);
+	*(ptr++) = ' ';
+	ptr = stpcpy(ptr, path);
+	ptr = stpcpy(ptr, " HTTP/1.1\r\n");
+
+	for (i = 0, hdr = mir->hdrs; i < mir->hdrs_cnt; i++, hdr += n + 1) {
+		n        = strlen(hdr);
+		name_len = strcspn(hdr, ":;");
+
+		if (mir_http1_hdr_skip(hdr, name_len, &flag_host))
+			continue;
+
+		(void)memcpy(ptr, hdr, n);
+
+		/* A header with an empty value is stored as 'name;'. */
+		if (hdr[name_len] == ';')
+			ptr[name_len] = ':';
+
+		ptr   += n;
+		*(ptr++) = '\r';
+		*(ptr++) = '\n';
+	}
+
+	if (!flag_host) {
+		ptr = stpcpy(ptr, "Host: ");
+		(void)memcpy(ptr, http1->authority, http1->authority_len);
+		ptr += http1->authority_len;
+		ptr = stpcpy(ptr, "\r\n");
+	}
+
+	if ((mir->body_size > 0) || (mir->request_method == CURL_HTTP_METHOD_POST) || (mir->request_method == CURL_HTTP_METHOD_PUT))
+		ptr += sprintf(ptr, "Content-Length: %zu\r\n", mir->body_size);
+
+	ptr = stpcpy(ptr, "\r\n");
+
+	retptr->mir          = mir;
+	retptr->sent         = 0;
+	retptr->down         = 0;
+	retptr->flag_retried = 0;
+	retptr->head_len     = ptr - retptr->head;
+
+	HTTP1_DBG("Request %p: <%s>", retptr, str_ctrl(retptr->head, retptr->head_len));
+
+	DBG_RETURN_PTR(retptr);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_req_done -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   req   -
+ *   code  -
+ *   err   - error class of the request
+ *   error -
+ *
+ * DESCRIPTION
+ *   Logs the completed or failed request in the same format as the cURL
+ *   mirrors, counts it in the summary, and releases it.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_req_done(struct http1_data *http1, struct http1_req *req, long code, uint8_t err, const char *error)
+{
+	double time_ms = (ev_now(http1->ev_base) - req->start) * 1000.0;
+
+	DBG_FUNC(NULL, "%p, %p, %ld, %hhu, \"%s\"", http1, req, code, err, error);
+
+	if (mir_log_sample(&(http1->log)))
+		w_log(NULL, "\"%s %s HTTP/1.1\" %ld %zu/%"PRIu64" %.3f %s",
+		      req->mir->method, req->mir->url, code, req->sent, req->down, time_ms, PTR_SAFE(error, "ok"));
+
+	mir_log_add(&(http1->log), req->mir->method, code, err, req->sent, req->down, time_ms);
+	(void)stats_hist_since(http1->log.stats.hist + MIR_HIST_TOTAL, req->mir->t_submit);
+
+	mir_http1_inflight_release(http1, req->size);
+	mir_sender_release(&(req->mir));
+
+	PTR_FREE(req);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_con_timer -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   Restarts the progress time-out of the connection while it has requests
+ *   waiting for a response.  Idle connections are not timed out, they are
+ *   closed when the mirror server closes them.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_con_timer(struct http1_con *con)
+{
+	DBG_FUNC(NULL, "%p", con);
+
+	if (!con->flag_connected)
+		/* The connect time-out is running. */;
+	else if (con->nbqueued > 0) {
+		con->ev_timer.repeat = HTTP1_TMOUT;
+		ev_timer_again(con->http1->ev_base, &(con->ev_timer));
+	}
+	else if (ev_is_active(&(con->ev_timer))) {
+		ev_timer_stop(con->http1->ev_base, &(con->ev_timer));
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_con_close -
+ *
+ * ARGUMENTS
+ *   con   -
+ *   err   - error class of the failed requests
+ *   error -
+ *
+ * DESCRIPTION
+ *   Closes the connection and fails its requests.  The requests that got no
+ *   response on a connection that was already reused are sent once more over
+ *   another connection, as the mirror server may have closed the idle
+ *   connection at the same time they were written.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_con_close(struct http1_con *con, uint8_t err, const char *error)
+{
+	struct http1_data *http1 = con->http1;
+	struct http1_req  *req, *req_back;
+	struct list        retry;
+
+	DBG_FUNC(NULL, "%p, %hhu, \"%s\"", con, err, error);
+
+	HTTP1_DBG("Closing connection %d (%u queued, %"PRIu64" done): %s", con->fd, con->nbqueued, con->nbdone, PTR_SAFE(error, "ok"));
+
+	ev_io_stop(http1->ev_base, &(con->ev_read));
+	ev_io_stop(http1->ev_base, &(con->ev_write));
+	ev_timer_stop(http1->ev_base, &(con->ev_timer));
+	FD_CLOSE(con->fd);
+
+	LIST_DEL(&(con->list));
+	STAT_ADD(http1->nbcons, -1);
+
+	LIST_INIT(&retry);
+	list_for_each_entry_safe(req, req_back, &(con->queue), list) {
+		LIST_DEL(&(req->list));
+
+		if (!http1->flag_closing && (con->nbdone > 0) && (req->down == 0) && !req->flag_retried) {
+			req->sent         = 0;
+			req->flag_retried = 1;
+			LIST_ADDQ(&retry, &(req->list));
+		} else {
+			mir_http1_req_done(http1, req, 0, err, PTR_SAFE(error, "Connection closed"));
+		}
+	}
+
+	PTR_FREE(con);
+
+	list_for_each_entry_safe(req, req_back, &retry, list) {
+		LIST_DEL(&(req->list));
+
+		if (_ERROR(mir_http1_req_queue(http1, req)))
+			mir_http1_req_done(http1, req, 0, err, PTR_SAFE(error, "Connection closed"));
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_con_send -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   Writes the queued requests, as many of them as possible with a single
+ *   writev() call.  If the socket buffer is full, the rest is written once
+ *   the socket becomes writable again.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int mir_http1_con_send(struct http1_con *con)
+{
+	struct iovec      iov[HTTP1_IOV_MAX];
+	struct http1_req *req;
+	size_t            len;
+	ssize_t           n;
+	int               cnt;
+
+	DBG_FUNC(NULL, "%p", con);
+
+	while (_nNULL(con->wr)) {
+		cnt = 0;
+		req = con->wr;
+		do {
+			if (req->sent < req->head_len) {
+				iov[cnt].iov_base = req->head + req->sent;
+				iov[cnt].iov_len  = req->head_len - req->sent;
+				cnt++;
+			}
+
+			if (req->mir->body_size > 0) {
+				len = (req->sent > req->head_len) ? (req->sent - req->head_len) : 0;
+
+				iov[cnt].iov_base = (char *)req->mir->body + len;
+				iov[cnt].iov_len  = req->mir->body_size - len;
+				cnt++;
+			}
+
+			req = LIST_NEXT(&(req->list), typeof(req), list);
+		} while ((&(req->list) != &(con->queue)) && (cnt < HTTP1_IOV_MAX - 1));
+
+		n = writev(con->fd, iov, cnt);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			else if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+				DBG_RETURN_INT(FUNC_RET_ERROR);
+
+			ev_io_start(con->http1->ev_base, &(con->ev_write));
+
+			DBG_RETURN_INT(FUNC_RET_OK);
+		}
+
+		HTTP1_DBG("Written %zd bytes to connection %d", n, con->fd);
+
+		for (req = con->wr; _nNULL(req) && (n > 0); ) {
+			len = MIN((size_t)n, req->head_len + req->mir->body_size - req->sent);
+
+			req->sent += len;
+			n         -= len;
+
+			if (req->sent < req->head_len + req->mir->body_size)
+				break;
+
+			req = LIST_NEXT(&(req->list), typeof(req), list);
+			if (&(req->list) == &(con->queue))
+				req = NULL;
+		}
+
+		con->wr = req;
+	}
+
+	ev_io_stop(con->http1->ev_base, &(con->ev_write));
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_rsp_done -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_rsp_done(struct http1_con *con)
+{
+	struct http1_req *req;
+
+	DBG_FUNC(NULL, "%p", con);
+
+	req = LIST_NEXT(&(con->queue), typeof(req), list);
+	LIST_DEL(&(req->list));
+	con->nbqueued--;
+	con->nbdone++;
+	con->rsp_state = HTTP1_RSP_HEAD;
+
+	/*
+	 * The mirror server responded before the request was completely
+	 * written, the rest of the pipeline cannot be used any more.
+	 */
+	if (con->wr == req) {
+		con->wr         = NULL;
+		con->flag_close = 1;
+	}
+
+	mir_http1_req_done(con->http1, req, con->rsp_code, MIR_ERR_OK, NULL);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_value_has -
+ *
+ * ARGUMENTS
+ *   value -
+ *   len   -
+ *   token -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns true if the header value contains the token, ignoring case.
+ */
+static bool_t mir_http1_value_has(const char *value, size_t len, const char *token)
+{
+	size_t i, n = strlen(token);
+
+	for (i = 0; i + n <= len; i++)
+		if (strncasecmp(value + i, token, n) == 0)
+			return true;
+
+	return false;
+}
+
+
+/***
+ * NAME
+ *   mir_http1_parse_head -
+ *
+ * ARGUMENTS
+ *   con       -
+ *   req       -
+ *   ptr       -
+ *   end       -
+ *   flag_done -
+ *
+ * DESCRIPTION
+ *   Parses the status line and the header section of the response, each
+ *   line terminated by CRLF.  Only the headers needed to find the end of
+ *   the response are looked at.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int mir_http1_parse_head(struct http1_con *con, const struct http1_req *req, const char *ptr, const char *end, bool_t *flag_done)
+{
+	const char *eol, *value;
+	int64_t     content_length = -1;
+	bool_t      flag_chunked = 0, flag_close;
+	size_t      len;
+
+	DBG_FUNC(NULL, "%p, %p, %p, %p, %p", con, req, ptr, end, flag_done);
+
+	if ((end - ptr < 14) || (strncmp(ptr, "HTTP/1.", 7) != 0) || (ptr[8] != ' ') ||
+	    !isdigit(ptr[9]) || !isdigit(ptr[10]) || !isdigit(ptr[11]))
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+
+	con->rsp_code = (ptr[9] - '0') * 100 + (ptr[10] - '0') * 10 + (ptr[11] - '0');
+	flag_close    = (ptr[7] == '0');
+
+	for (ptr = (const char *)memchr(ptr, '\n', end - ptr) + 1; ptr < end; ptr = eol + 1) {
+		eol = memchr(ptr, '\n', end - ptr);
+		len = strcspn(ptr, ":\r\n");
+
+		if ((ptr + len >= eol) || (ptr[len] != ':'))
+			continue;
+
+		for (value = ptr + len + 1; (value < eol) && ((*value == ' ') || (*value == '\t')); value++);
+
+		if ((len == STR_SIZE("content-length")) && (strncasecmp(ptr, STR_ADDRSIZE("content-length")) == 0)) {
+			for (content_length = 0; isdigit(*value) && (content_length < INT64_MAX / 10 - 10); value++)
+				content_length = content_length * 10 + (*value - '0');
+		}
+		else if ((len == STR_SIZE("transfer-encoding")) && (strncasecmp(ptr, STR_ADDRSIZE("transfer-encoding")) == 0)) {
+			flag_chunked = mir_http1_value_has(value, eol - value, "chunked");
+		}
+		else if ((len == STR_SIZE("connection")) && (strncasecmp(ptr, STR_ADDRSIZE("connection")) == 0)) {
+			if (mir_http1_value_has(value, eol - value, "close"))
+				flag_close = 1;
+			else if (mir_http1_value_has(value, eol - value, "keep-alive"))
+				flag_close = 0;
+		}
+	}
+
+	HTTP1_DBG("Response on connection %d: %ld, length %"PRId64"%s%s", con->fd, con->rsp_code, content_length, flag_chunked ? ", chunked" : "", flag_close ? ", close" : "");
+
+	*flag_done = 0;
+
+	/* An interim response, the final one follows. */
+	if (IN_RANGE(con->rsp_code, 100, 199) && (con->rsp_code != 101))
+		DBG_RETURN_INT(FUNC_RET_OK);
+	else if (con->rsp_code == 101)
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+
+	con->flag_close |= flag_close;
+
+	if ((req->mir->request_method == CURL_HTTP_METHOD_HEAD) || (con->rsp_code == 204) || (con->rsp_code == 304))
+		*flag_done = 1;
+	else if (flag_chunked)
+		con->rsp_state = HTTP1_RSP_CHUNK_SIZE;
+	else if (content_length == 0)
+		*flag_done = 1;
+	else if (content_length > 0) {
+		con->rsp_state = HTTP1_RSP_BODY;
+		con->rsp_left  = content_length;
+	}
+	else {
+		con->rsp_state  = HTTP1_RSP_EOF;
+		con->flag_close = 1;
+	}
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_parse -
+ *
+ * ARGUMENTS
+ *   con -
+ *
+ * DESCRIPTION
+ *   Consumes the received responses.  The response bodies are not kept, only
+ *   the incomplete header section or chunk size line stays in the buffer.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int mir_http1_parse(struct http1_con *con)
+{
+	struct http1_req *req;
+	const char       *ptr = con->rbuf, *end = con->rbuf + con->rlen, *start, *eol;
+	bool_t            flag_done, flag_more = 0;
+	uint64_t          size;
+	size_t            n;
+	int               retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "%p", con);
+
+	while (_OK(retval) && !flag_more && (ptr < end)) {
+		if (LIST_ISEMPTY(&(con->queue))) {
+			HTTP1_DBG("Unexpected data on connection %d", con->fd);
+
+			retval = FUNC_RET_ERROR;
+
+			break;
+		}
+
+		req       = LIST_NEXT(&(con->queue), typeof(req), list);
+		start     = ptr;
+		flag_done = 0;
+
+		if (con->rsp_state == HTTP1_RSP_HEAD) {
+			if (_NULL(eol = memmem(ptr, end - ptr, "\r\n\r\n", 4)))
+				flag_more = 1;
+			else if (_OK(retval = mir_http1_parse_head(con, req, ptr, eol + 2, &flag_done)))
+				ptr = eol + 4;
+		}
+		else if ((con->rsp_state == HTTP1_RSP_BODY) || (con->rsp_state == HTTP1_RSP_CHUNK_DATA)) {
+			n             = MIN((uint64_t)(end - ptr), con->rsp_left);
+			ptr          += n;
+			con->rsp_left -= n;
+
+			if (con->rsp_left > 0)
+				/* Do nothing. */;
+			else if (con->rsp_state == HTTP1_RSP_BODY)
+				flag_done = 1;
+			else
+				con->rsp_state = HTTP1_RSP_CHUNK_SIZE;
+		}
+		else if (con->rsp_state == HTTP1_RSP_CHUNK_SIZE) {
+			if (_NULL(eol = memmem(ptr, end - ptr, "\r\n", 2))) {
+				flag_more = 1;
+			}
+			else if (!isxdigit(*ptr)) {
+				retval = FUNC_RET_ERROR;
+			}
+			else {
+				for (size = 0; isxdigit(*ptr) && (size < (UINT64_MAX >> 8)); ptr++)
+					size = (size << 4) | (isdigit(*ptr) ? (*ptr - '0') : ((*ptr | 0x20) - 'a' + 10));
+
+				/* The chunk data is followed by CRLF. */
+				con->rsp_state = (size > 0) ? HTTP1_RSP_CHUNK_DATA : HTTP1_RSP_TRAILERS;
+				con->rsp_left  = size + 2;
+				ptr            = eol + 2;
+			}
+		}
+		else if (con->rsp_state == HTTP1_RSP_TRAILERS) {
+			if (_NULL(eol = memmem(ptr, end - ptr, "\r\n", 2)))
+				flag_more = 1;
+			else if (eol == ptr)
+				flag_done = 1;
+
+			if (_nNULL(eol))
+				ptr = eol + 2;
+		}
+		else {
+			ptr = end;
+		}
+
+		req->down += ptr - start;
+
+		if (flag_done)
+			mir_http1_rsp_done(con);
+	}
+
+	/* The incomplete header section has to fit in the buffer. */
+	if (flag_more && (ptr == con->rbuf) && (end == con->rbuf + sizeof(con->rbuf))) {
+		HTTP1_DBG("Response header section too large on connection %d", con->fd);
+
+		retval = FUNC_RET_ERROR;
+	}
+
+	con->rlen = end - ptr;
+	if ((con->rlen > 0) && (ptr > con->rbuf))
+		(void)memmove(con->rbuf, ptr, con->rlen);
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_ev_read_cb - libev read callback function
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_ev_read_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(http1_con, con, ev_read);
+	size_t  size;
+	ssize_t n;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	do {
+		size = sizeof(con->rbuf) - con->rlen;
+		n    = read(con->fd, con->rbuf + con->rlen, size);
+
+		if (n > 0) {
+			con->rlen += n;
+
+			if (_ERROR(mir_http1_parse(con))) {
+				mir_http1_con_close(con, MIR_ERR_PROTOCOL, "Invalid response");
+
+				DBG_RETURN();
+			}
+			else if (con->flag_close && (con->rsp_state == HTTP1_RSP_HEAD)) {
+				mir_http1_con_close(con, MIR_ERR_IO, NULL);
+
+				DBG_RETURN();
+			}
+		}
+		else if (n == 0) {
+			/* The response body delimited by the connection close. */
+			if (con->rsp_state == HTTP1_RSP_EOF)
+				mir_http1_rsp_done(con);
+
+			mir_http1_con_close(con, MIR_ERR_IO, "Connection closed by server");
+
+			DBG_RETURN();
+		}
+		else if (errno == EINTR) {
+			continue;
+		}
+		else if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+			/* A failed connect may be reported on the read side first. */
+			mir_http1_con_close(con, con->flag_connected ? MIR_ERR_IO : MIR_ERR_CONNECT, strerror(errno));
+
+			DBG_RETURN();
+		}
+	} while ((size_t)n == size);
+
+	mir_http1_con_timer(con);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_ev_write_cb - libev write callback function
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Completes the connect operation, and writes the requests that did not
+ *   fit into the socket buffer before.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_ev_write_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(http1_con, con, ev_write);
+	socklen_t len = sizeof(int);
+	int       error = 0;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	if (!con->flag_connected) {
+		if (_ERROR(getsockopt(con->fd, SOL_SOCKET, SO_ERROR, &error, &len)))
+			error = errno;
+
+		if (error != 0) {
+			mir_http1_con_close(con, MIR_ERR_CONNECT, strerror(error));
+
+			DBG_RETURN();
+		}
+
+		HTTP1_DBG("Connection %d established", con->fd);
+
+		con->flag_connected = 1;
+	}
+
+	if (_ERROR(mir_http1_con_send(con)))
+		mir_http1_con_close(con, MIR_ERR_IO, strerror(errno));
+	else
+		mir_http1_con_timer(con);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_ev_timer_cb - libev timer callback function
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_http1_ev_timer_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(http1_con, con, ev_timer);
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	mir_http1_con_close(con, MIR_ERR_TIMEOUT, con->flag_connected ? "Operation timed out" : "Connection timed out");
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_con_bind -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   fd    -
+ *
+ * DESCRIPTION
+ *   Binds the outgoing connection to the local address and port range, if
+ *   they are set.  The ports of the range are tried in turn, starting after
+ *   the one used last.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int mir_http1_con_bind(struct http1_data *http1, int fd)
+{
+	struct sockaddr_storage local;
+	socklen_t               len;
+	int                     i, port, retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "%p, %d", http1, fd);
+
+	if ((http1->locallen == 0) && (cfg.mir_port[0] == 0))
+		DBG_RETURN_INT(retval);
+
+	if (http1->locallen > 0) {
+		local = http1->local;
+		len   = http1->locallen;
+	} else {
+		(void)memset(&local, 0, sizeof(local));
+		local.ss_family = http1->addr.ss_family;
+		len             = http1->addrlen;
+	}
+
+	for (i = 0; i < MAX(cfg.mir_port[1], 1); i++) {
+		if (cfg.mir_port[0] > 0) {
+			port = cfg.mir_port[0] + (http1->port_next++ % cfg.mir_port[1]);
+
+			if (local.ss_family == AF_INET6)
+				((struct sockaddr_in6 *)&local)->sin6_port = htons(port);
+			else
+				((struct sockaddr_in *)&local)->sin_port = htons(port);
+		}
+
+		if (_OK(retval = bind(fd, (struct sockaddr *)&local, len)) || (errno != EADDRINUSE))
+			break;
+	}
+
+	if (_ERROR(retval))
+		w_log(NULL, HTTP1_STR _E("Failed to bind outgoing connection: %m"));
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_con_open -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *
+ * DESCRIPTION
+ *   Starts a new non-blocking connection to the mirror server.  The requests
+ *   can be queued on it right away, they are written once it is connected.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct http1_con *mir_http1_con_open(struct http1_data *http1)
+{
+	struct http1_con *retptr;
+	int               yes = 1;
+
+	DBG_FUNC(NULL, "%p", http1);
+
+	if (_NULL(retptr = malloc(sizeof(*retptr)))) {
+		w_log(NULL, HTTP1_STR _E("Failed to allocate memory"));
+
+		DBG_RETURN_PTR(retptr);
+	}
+
+	retptr->fd = socket(http1->addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+	if (_ERROR(retptr->fd))
+		w_log(NULL, HTTP1_STR _E("Failed to create socket: %m"));
+	else if (_ERROR(socket_set_nonblocking(retptr->fd)))
+		/* Do nothing. */;
+	else if (_ERROR(setsockopt(retptr->fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes))))
+		w_log(NULL, HTTP1_STR _E("Failed to set TCP_NODELAY: %m"));
+	else if (_ERROR(socket_set_keepalive(retptr->fd, 1, CURL_KEEPIDLE_TIME, CURL_KEEPINTVL_TIME, -1)))
+		w_log(NULL, HTTP1_STR _E("Failed to set TCP keepalive: %m"));
+	else if (_ERROR(mir_http1_con_bind(http1, retptr->fd)))
+		/* Do nothing. */;
+	else if (_ERROR(connect(retptr->fd, (struct sockaddr *)&(http1->addr), http1->addrlen)) && (errno != EINPROGRESS))
+		w_log(NULL, HTTP1_STR _E("Failed to connect: %m"));
+	else {
+		HTTP1_DBG("Connecting %d", retptr->fd);
+
+		retptr->http1          = http1;
+		retptr->wr             = NULL;
+		retptr->nbqueued       = 0;
+		retptr->nbdone         = 0;
+		retptr->flag_connected = 0;
+		retptr->flag_close     = 0;
+		retptr->rsp_state      = HTTP1_RSP_HEAD;
+		retptr->rsp_left       = 0;
+		retptr->rsp_code       = 0;
+		retptr->rlen           = 0;
+		LIST_INIT(&(retptr->queue));
+		LIST_ADDQ(&(http1->cons), &(retptr->list));
+		STAT_INC(http1->nbcons);
+
+		ev_io_init(&(retptr->ev_read), mir_http1_ev_read_cb, retptr->fd, EV_READ);
+		ev_io_start(http1->ev_base, &(retptr->ev_read));
+
+		/* The connection is writable once it is established. */
+		ev_io_init(&(retptr->ev_write), mir_http1_ev_write_cb, retptr->fd, EV_WRITE);
+		ev_io_start(http1->ev_base, &(retptr->ev_write));
+
+		ev_timer_init(&(retptr->ev_timer), mir_http1_ev_timer_cb, HTTP1_CON_TMOUT, 0.0);
+		ev_timer_start(http1->ev_base, &(retptr->ev_timer));
+
+		DBG_RETURN_PTR(retptr);
+	}
+
+	FD_CLOSE(retptr->fd);
+	PTR_FREE(retptr);
+
+	DBG_RETURN_PTR(retptr);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_con_get -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *
+ * DESCRIPTION
+ *   Picks the connection with the fewest queued requests.  A new connection
+ *   is opened if all of them have reached the pipelining depth and there are
+ *   not too many of them yet.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct http1_con *mir_http1_con_get(struct http1_data *http1)
+{
+	struct http1_con *con, *retptr = NULL;
+	uint              depth, max;
+
+	DBG_FUNC(NULL, "%p", http1);
+
+	depth = (cfg.mir_max_streams > 0) ? cfg.mir_max_streams : HTTP1_DEPTH;
+	max   = (cfg.mir_max_conns > 0) ? cfg.mir_max_conns : HTTP1_CONNS_MAX;
+
+	list_for_each_entry(con, &(http1->cons), list)
+		if (!con->flag_close && (_NULL(retptr) || (con->nbqueued < retptr->nbqueued)))
+			retptr = con;
+
+	if (_nNULL(retptr) && ((retptr->nbqueued < depth) || (http1->nbcons >= max)))
+		DBG_RETURN_PTR(retptr);
+	else if ((http1->nbcons < max) && _nNULL(con = mir_http1_con_open(http1)))
+		retptr = con;
+
+	DBG_RETURN_PTR(retptr);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_req_queue -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   req   -
+ *
+ * DESCRIPTION
+ *   Queues the request on a connection and writes it, if the connection is
+ *   established and has nothing else to write.  Once queued, the request is
+ *   released by the connection, even if writing it fails.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_ERROR if the request could not be queued.
+ */
+static int mir_http1_req_queue(struct http1_data *http1, struct http1_req *req)
+{
+	struct http1_con *con;
+
+	DBG_FUNC(NULL, "%p, %p", http1, req);
+
+	if (_NULL(con = mir_http1_con_get(http1)))
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+
+	LIST_ADDQ(&(con->queue), &(req->list));
+	con->nbqueued++;
+
+	if (_nNULL(con->wr))
+		/* The request is written after the preceding ones. */;
+	else if (!con->flag_connected)
+		con->wr = req;
+	else {
+		con->wr = req;
+
+		if (_ERROR(mir_http1_con_send(con))) {
+			mir_http1_con_close(con, MIR_ERR_IO, strerror(errno));
+
+			DBG_RETURN_INT(FUNC_RET_OK);
+		}
+	}
+
+	mir_http1_con_timer(con);
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_init -
+ *
+ * ARGUMENTS
+ *   loop  -
+ *   http1 -
+ *
+ * DESCRIPTION
+ *   Resolves the address of the mirror server.  The connections are opened
+ *   on demand and kept open for the following requests.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int mir_http1_init(struct ev_loop *loop, struct http1_data *http1)
+{
+	struct addrinfo  hints, *res = NULL;
+	char             host[NI_MAXHOST], port[8] = "80";
+	const char      *ptr, *end;
+	size_t           len;
+	int              rc, retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(NULL, "%p, %p", loop, http1);
+
+	if (_NULL(loop) || _NULL(http1) || _NULL(cfg.mir_url))
+		DBG_RETURN_INT(retval);
+
+	(void)memset(http1, 0, sizeof(*http1));
+
+	http1->ev_base       = loop;
+	http1->authority     = cfg.mir_url + STR_SIZE(STR_HTTP_PFX);
+	http1->authority_len = strcspn(http1->authority, "/?#");
+	http1->seed          = (prg.start_time.tv_usec ^ (uintptr_t)http1) | 1;
+	mir_log_init(&(http1->log), loop);
+	LIST_INIT(&(http1->cons));
+
+	/* The IPv6 address literal is enclosed in square brackets, e.g. [::1]:8080. */
+	end = http1->authority + http1->authority_len;
+	if ((http1->authority_len > 0) && (*(http1->authority) == '[')) {
+		if (_NULL(ptr = memchr(http1->authority, ']', http1->authority_len)) || (((ptr + 1) < end) && (ptr[1] != ':'))) {
+			w_log(NULL, HTTP1_STR _E("Invalid IPv6 address in the mirror URL '%s'"), cfg.mir_url);
+
+			http1->ev_base = NULL;
+
+			DBG_RETURN_INT(retval);
+		}
+
+		(void)snprintf(host, sizeof(host), "%.*s", (int)(ptr - http1->authority - 1), http1->authority + 1);
+		ptr = ((ptr + 1) < end) ? ptr + 1 : NULL;
+	}
+	else {
+		if (_NULL(ptr = memchr(http1->authority, ':', http1->authority_len)))
+			len = http1->authority_len;
+		else
+			len = ptr - http1->authority;
+
+		(void)snprintf(host, sizeof(host), "%.*s", (int)len, http1->authority);
+	}
+
+	if (_nNULL(ptr))
+		(void)snprintf(port, sizeof(port), "%.*s", (int)(end - ptr - 1), ptr + 1);
+
+	(void)memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if ((rc = getaddrinfo(host, port, &hints, &res)) != 0) {
+		w_log(NULL, HTTP1_STR _E("Failed to resolve '%s': %s"), host, gai_strerror(rc));
+	}
+	else if (res->ai_addrlen > sizeof(http1->addr)) {
+		w_log(NULL, HTTP1_STR _E("Unsupported address of '%s'"), host);
+	}
+	else {
+		(void)memcpy(&(http1->addr), res->ai_addr, res->ai_addrlen);
+		http1->addrlen = res->ai_addrlen;
+
+		retval = FUNC_RET_OK;
+	}
+
+	if (_nNULL(res))
+		freeaddrinfo(res);
+
+	/* The outgoing connections interface has to be an IP address. */
+	if (_ERROR(retval) || _NULL(cfg.mir_interface))
+		/* Do nothing. */;
+	else if (http1->addr.ss_family == AF_INET6) {
+		struct sockaddr_in6 *sin6 = (typeof(sin6))&(http1->local);
+
+		sin6->sin6_family = AF_INET6;
+		http1->locallen   = sizeof(*sin6);
+
+		if (inet_pton(AF_INET6, cfg.mir_interface, &(sin6->sin6_addr)) != 1)
+			retval = FUNC_RET_ERROR;
+	}
+	else {
+		struct sockaddr_in *sin = (typeof(sin))&(http1->local);
+
+		sin->sin_family = AF_INET;
+		http1->locallen = sizeof(*sin);
+
+		if (inet_pton(AF_INET, cfg.mir_interface, &(sin->sin_addr)) != 1)
+			retval = FUNC_RET_ERROR;
+	}
+
+	if (_ERROR(retval) && (http1->locallen > 0))
+		w_log(NULL, HTTP1_STR _E("Invalid outgoing connections address '%s'"), cfg.mir_interface);
+
+	if (_OK(retval))
+		HTTP1_DBG("Mirroring to %s port %s", host, port);
+	else
+		http1->ev_base = NULL;
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   mir_http1_close -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_http1_close(struct http1_data *http1)
+{
+	struct http1_con *con, *con_back;
+
+	DBG_FUNC(NULL, "%p", http1);
+
+	if (_NULL(http1) || _NULL(http1->ev_base))
+		DBG_RETURN();
+
+	http1->flag_closing = 1;
+
+	list_for_each_entry_safe(con, con_back, &(http1->cons), list)
+		mir_http1_con_close(con, MIR_ERR_ABORTED, "Mirroring stopped");
+
+	mir_log_summary(NULL, &(http1->log), http1->ev_base);
+
+	(void)memset(http1, 0, sizeof(*http1));
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_monitor -
+ *
+ * ARGUMENTS
+ *   worker -
+ *   http1  -
+ *
+ * DESCRIPTION
+ *   Reports the mirrors dropped due to the in-flight limits since the last
+ *   call of this function.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_http1_monitor(const struct worker *worker, struct http1_data *http1)
+{
+	DBG_FUNC(worker, "%p, %p", worker, http1);
+
+	if (http1->nbdropped > http1->nbdropped_last) {
+		w_log(worker, _W("%"PRIu64" mirrors dropped due to the in-flight limits (%"PRIu64" in total, %"PRIu64" bytes), %u in flight on %u connections"),
+		      http1->nbdropped - http1->nbdropped_last, http1->nbdropped, http1->dropped_bytes, http1->nbactive, http1->nbcons);
+
+		http1->nbdropped_last = http1->nbdropped;
+	}
+
+	mir_log_summary(worker, &(http1->log), http1->ev_base);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_http1_add -
+ *
+ * ARGUMENTS
+ *   http1 -
+ *   mir   -
+ *
+ * DESCRIPTION
+ *   Serializes the mirrored request and queues it on one of the worker
+ *   connections.  If the mirror does not fit within the in-flight limits,
+ *   it is dropped and released here, which is not considered an error.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int mir_http1_add(struct http1_data *http1, struct mirror *mir)
+{
+	struct http1_req *req;
+	size_t            size;
+
+	DBG_FUNC(NULL, "%p, %p", http1, mir);
+
+	if (_NULL(http1) || _NULL(mir))
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+
+	size = mir->hdrs_len + mir->body_size;
+	if (!mir_http1_admit(http1, size)) {
+		HTTP1_DBG("Dropping mirror %p (%zu bytes)", mir, size);
+
+		STAT_INC(http1->nbdropped);
+		http1->dropped_bytes += size;
+
+		mir_sender_release(&mir);
+
+		DBG_RETURN_INT(FUNC_RET_OK);
+	}
+
+	if (_NULL(req = mir_http1_req_new(http1, mir))) {
+		mir_http1_inflight_release(http1, size);
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	req->size  = size;
+	req->start = ev_now(http1->ev_base);
+
+	/* The mirror is released by the caller in the case of an error. */
+	if (_ERROR(mir_http1_req_queue(http1, req))) {
+		mir_http1_inflight_release(http1, size);
+		PTR_FREE(req);
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -65,6 +65,7 @@ static void usage(const char *program_name, bool_t flag_verbose)
 
 	if (flag_verbose) {
 		(void)printf("Options are:\n");
+		(void)printf("  -A, --assign-policy=NAME        Specify the worker assignment policy (default: round-robin).\n");
 		(void)printf("  -a, --address=NAME              Specify the address to listen on (default: \"%s\").\n", DEFAULT_SERVER_ADDRESS);
 		(void)printf("  -B, --libev-backend=TYPE        Specify the libev backend type (default: AUTO).\n");
 		(void)printf("  -b, --connection-backlog=VALUE  Specify the connection backlog size (default: %d).\n", DEFAULT_CONNECTION_BACKLOG);
@@ -76,24 +77,96 @@ static void usage(const char *program_name, bool_t flag_verbose)
 		(void)printf("  -F, --pidfile=FILE              Specifies a file to write the process-id to.\n");
 		(void)printf("  -h, --help                      Show this text.\n");
 		(void)printf("  -i, --monitor-interval=TIME     Set the monitor interval (default: %s).\n", str_delay(DEFAULT_MONITOR_INTERVAL));
+		(void)printf("  -K, --ack-first                 Acknowledge the frames before processing the mirror messages.\n");
 		(void)printf("  -l, --logfile=[MODE:]FILE       Log all messages to logfile (default: stdout/stderr).\n");
 		(void)printf("  -m, --max-frame-size=VALUE      Specify the maximum frame size (default: %d bytes).\n", DEFAULT_MAX_FRAME_SIZE);
 		(void)printf("  -n, --num-workers=VALUE         Specify the number of workers (default: %d).\n", DEFAULT_NUM_WORKERS);
 		(void)printf("  -p, --port=VALUE                Specify the port to listen on (default: %d).\n", DEFAULT_SERVER_PORT);
+		(void)printf("  -R, --reuseport=MODE            Use per-worker SO_REUSEPORT listeners (default: none).\n");
 		(void)printf("  -r, --runtime=TIME              Run this program for the specified time (0 = unlimited).\n");
+		(void)printf("  -s, --stats=[ADDRESS:]PORT      Serve the statistics over HTTP (default address: \"%s\").\n", DEFAULT_STATS_ADDRESS);
 		(void)printf("  -t, --processing-delay=TIME     Set a delay to process a message (default: %s).\n", str_delay(DEFAULT_PROCESSING_DELAY));
+#ifdef HAVE_LIBURING
+		(void)printf("  -U, --io-uring                  Use the io_uring transport for the SPOP connections.\n");
+#endif
 #ifdef HAVE_LIBCURL
 		(void)printf("  -u, --mirror-url=URL            Specify the URL for the HTTP mirroring.\n");
+		(void)printf("  -E, --mirror-engine=NAME        Specify the sender of the mirrored requests (default: curl).\n");
+		(void)printf("  -L, --mirror-log=MODE[:N]       Specify how the completed mirrors are logged (default: all).\n");
 		(void)printf("  -I, --mirror-interface=NAME     Specify the interface/address for outgoing connections.\n");
 		(void)printf("  -P, --mirror-local-port=VALUE   Specify the local port range for outgoing connections.\n");
+		(void)printf("  -S, --mirror-share              Share the DNS and TLS session caches between workers.\n");
+		(void)printf("  -M, --mirror-max=LIMIT          Limit the in-flight mirrors of each worker (default: unlimited).\n");
+		(void)printf("  -G, --mirror-max-global=LIMIT   Limit the in-flight mirrors of all workers (default: unlimited).\n");
+		(void)printf("  -O, --mirror-overload=POLICY    Specify what to do with the mirrors over the limit (default: drop-newest).\n");
+		(void)printf("  -H, --mirror-http=MODE          Specify the HTTP version of the mirrored requests (default: auto).\n");
+		(void)printf("  -C, --mirror-conns=VALUE        Limit the number of connections of each worker (default: unlimited).\n");
+		(void)printf("  -N, --mirror-streams=VALUE      Limit the number of HTTP/2 streams or pipelined requests per connection.\n");
+		(void)printf("  -T, --mirror-threads=VALUE      Send the mirrored requests from separate threads (default: 0).\n");
 #endif
-		(void)printf("  -V, --version                   Show program version.\n\n");
+		(void)printf("  -V, --version                   Show program version.\n");
+		(void)printf("  -Y, --latency-log               Log the latency percentiles every monitor interval.\n\n");
 		(void)printf("Supported libev backends: %s.\n\n", ev_backends_supported());
 		(void)printf("Supported capabilities: " STR_CAP_FRAGMENTATION ", " STR_CAP_PIPELINING ", " STR_CAP_ASYNC ".\n\n");
+		(void)printf("Supported worker assignment policies: round-robin, least-conn, least-frames, p2c.\n");
+		(void)printf("The assignment policy is not used in the SO_REUSEPORT mode.\n\n");
+		(void)printf("Supported SO_REUSEPORT modes: none, hash, cpu.  In the 'hash' mode the kernel\n");
+		(void)printf("distributes the incoming connections among the worker listeners, while in\n");
+		(void)printf("the 'cpu' mode the connection is accepted by the worker bound to the CPU\n");
+		(void)printf("that received it; it requires one worker per CPU in the affinity mask of\n");
+		(void)printf("the program.  The connections received by other CPUs are distributed as in\n");
+		(void)printf("the 'hash' mode.\n\n");
+#ifdef HAVE_LIBCURL
+		(void)printf("The in-flight mirror limit is specified as COUNT[:BYTES], where COUNT is the\n");
+		(void)printf("number of mirrored requests being sent and BYTES is their total size (headers\n");
+		(void)printf("and body).  A value of 0 means that the number or the size is not limited.\n\n");
+		(void)printf("Supported mirror overload policies: drop-newest, drop-oldest, sample.  The\n");
+		(void)printf("'drop-newest' policy does not mirror the requests while the limit is reached,\n");
+		(void)printf("the 'drop-oldest' policy aborts the oldest in-flight mirrors of the worker to\n");
+		(void)printf("make room for the new ones, and the 'sample' policy starts to drop more and\n");
+		(void)printf("more of the new requests once half of the limit is reached.\n\n");
+		(void)printf("Supported mirror HTTP modes: auto, http1.1, http2, http2-prior-knowledge.  In\n");
+		(void)printf("the 'auto' mode HTTP/2 is used only if the original request was HTTP/2.  In\n");
+		(void)printf("the 'http2' mode HTTP/2 is negotiated with ALPN (https) or with an upgrade\n");
+		(void)printf("from HTTP/1.1 (http), while in the 'http2-prior-knowledge' mode HTTP/2 is\n");
+		(void)printf("used without negotiation (h2c).  In both HTTP/2 modes all mirrored requests\n");
+		(void)printf("of a worker are multiplexed over as few connections as possible.\n\n");
+		(void)printf("Supported mirror engines: curl, native.  The 'native' engine sends the mirrored\n");
+		(void)printf("requests over persistent HTTP/1.1 connections without using libcurl, writing\n");
+		(void)printf("each request with a single system call and pipelining up to %d requests per\n", HTTP1_DEPTH);
+		(void)printf("connection (option -N).  It supports only the 'http' URL scheme, an IP address\n");
+		(void)printf("as the outgoing connections interface, and up to %d connections per worker\n", HTTP1_CONNS_MAX);
+		(void)printf("(option -C).  The 'drop-oldest' overload policy works as 'drop-newest' there,\n");
+		(void)printf("as the requests already written cannot be recalled.\n\n");
+		(void)printf("Supported mirror log modes: all, summary.  In the 'all' mode every completed\n");
+		(void)printf("mirror is logged on its own line.  In the 'summary' mode each worker (or mirror\n");
+		(void)printf("thread) logs one line per monitor interval with the number of the completed\n");
+		(void)printf("mirrors by status class, method and error class, their latency distribution\n");
+		(void)printf("and the bytes transferred; with ':N' every N-th mirror is also logged on its\n");
+		(void)printf("own line.\n\n");
+		(void)printf("By default the mirrored requests are sent by the workers that received them.\n");
+		(void)printf("If the mirror threads are used, the workers only hand off the requests to\n");
+		(void)printf("them, so that the mirror server load does not delay the SPOE responses.  The\n");
+		(void)printf("per-worker mirror options then apply to each mirror thread.\n\n");
+		(void)printf("In the ACK-first mode the SPOE frame is acknowledged as soon as the messages\n");
+		(void)printf("that affect the response are processed.  The mirror messages are processed\n");
+		(void)printf("later, once the acknowledgements of the current batch of frames are sent.\n\n");
+#endif
+		(void)printf("The statistics listener serves the per-worker counters in the Prometheus text\n");
+		(void)printf("format at the '/metrics' path.  It is served by the main thread, so it does\n");
+		(void)printf("not delay the workers.\n\n");
+		(void)printf("If the statistics listener or the latency log is enabled, the workers measure\n");
+		(void)printf("the time from the reception of each frame to its ACK, the decoding and the\n");
+		(void)printf("processing of the frames, and the time to complete the mirrored requests\n");
+		(void)printf("(with the cURL engine also the time of each transfer phase).  The latency\n");
+		(void)printf("histograms of all the workers are merged and the percentiles are logged for\n");
+		(void)printf("the values measured within the last monitor interval.\n\n");
 		(void)printf("Allowed logging file opening modes: a, w.  The 'a' mode allows openning or\n");
 		(void)printf("creating file for writing at end-of-file.  The 'w' mode allows truncating\n");
 		(void)printf("the file to zero length or creating a new file.  If a capital letter is used\n");
-		(void)printf("for the mode, then line buffering is used when writing to the log file.\n\n");
+		(void)printf("for the mode, then line buffering is used when writing to the log file.\n");
+		(void)printf("The messages are written to the log by a separate thread; if it cannot keep\n");
+		(void)printf("up, the messages are dropped and the number of dropped messages is logged.\n\n");
 		(void)printf("The time delay/interval is specified in milliseconds by default, but can be\n");
 		(void)printf("in any other unit if the number is suffixed by a unit (us, ms, s, m, h, d).\n\n");
 		(void)printf("Copyright 2018-2020 HAProxy Technologies\n");
@@ -186,6 +259,339 @@ static int getopt_set_ev_backend(const char *type)
 }
 
 
+/***
+ * NAME
+ *   getopt_set_assign_policy -
+ *
+ * ARGUMENTS
+ *   name -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_assign_policy(const char *name)
+{
+#define ASSIGN_DEF(a,b)   { b, ASSIGN_##a },
+	static const struct {
+		const char *str;
+		uint8_t     policy;
+	} policies[] = { ASSIGN_DEFINES };
+#undef ASSIGN_DEF
+	int i, retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "\"%s\"", name);
+
+	for (i = 0; i < TABLESIZE(policies); i++)
+		if (strcasecmp(policies[i].str, name) == 0)
+			break;
+
+	if (i < TABLESIZE(policies)) {
+		cfg.assign_policy = policies[i].policy;
+	} else {
+		(void)fprintf(stderr, "ERROR: invalid worker assignment policy '%s'\n", name);
+
+		retval = FUNC_RET_ERROR;
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   getopt_set_reuseport -
+ *
+ * ARGUMENTS
+ *   mode -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_reuseport(const char *mode)
+{
+#define REUSEPORT_DEF(a,b)   { b, REUSEPORT_##a },
+	static const struct {
+		const char *str;
+		uint8_t     mode;
+	} modes[] = { REUSEPORT_DEFINES };
+#undef REUSEPORT_DEF
+	int i, retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "\"%s\"", mode);
+
+	for (i = 0; i < TABLESIZE(modes); i++)
+		if (strcasecmp(modes[i].str, mode) == 0)
+			break;
+
+	if (i >= TABLESIZE(modes)) {
+		(void)fprintf(stderr, "ERROR: invalid SO_REUSEPORT mode '%s'\n", mode);
+
+		retval = FUNC_RET_ERROR;
+	}
+#ifndef SO_REUSEPORT
+	else if (modes[i].mode != REUSEPORT_NONE) {
+		(void)fprintf(stderr, "ERROR: SO_REUSEPORT is not supported on this system\n");
+
+		retval = FUNC_RET_ERROR;
+	}
+#endif
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+	else if (modes[i].mode == REUSEPORT_CPU) {
+		(void)fprintf(stderr, "ERROR: SO_REUSEPORT mode '%s' is not supported on this system\n", mode);
+
+		retval = FUNC_RET_ERROR;
+	}
+#endif
+	else {
+		cfg.reuseport = modes[i].mode;
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+#ifdef HAVE_LIBCURL
+
+/***
+ * NAME
+ *   getopt_set_mir_overload -
+ *
+ * ARGUMENTS
+ *   name -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_mir_overload(const char *name)
+{
+#define MIR_OVERLOAD_DEF(a,b)   { b, MIR_OVERLOAD_##a },
+	static const struct {
+		const char *str;
+		uint8_t     policy;
+	} policies[] = { MIR_OVERLOAD_DEFINES };
+#undef MIR_OVERLOAD_DEF
+	int i, retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "\"%s\"", name);
+
+	for (i = 0; i < TABLESIZE(policies); i++)
+		if (strcasecmp(policies[i].str, name) == 0)
+			break;
+
+	if (i < TABLESIZE(policies)) {
+		cfg.mir_overload = policies[i].policy;
+	} else {
+		(void)fprintf(stderr, "ERROR: invalid mirror overload policy '%s'\n", name);
+
+		retval = FUNC_RET_ERROR;
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   getopt_set_mir_max -
+ *
+ * ARGUMENTS
+ *   limit -
+ *   cons  -
+ *   bytes -
+ *
+ * DESCRIPTION
+ *   Parses the in-flight mirror limit, given as the number of mirrors
+ *   optionally followed by a colon and their total size in bytes.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_mir_max(const char *limit, uint *cons, uint64_t *bytes)
+{
+	char    *endptr = NULL;
+	int64_t  value[2] = { 0, 0 };
+	int      retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(NULL, "\"%s\", %p, %p", limit, cons, bytes);
+
+	if (TEST_OR3(NULL, limit, cons, bytes))
+		DBG_RETURN_INT(retval);
+
+	if (*limit == '\0')
+		(void)fprintf(stderr, "ERROR: mirror limit is not defined\n");
+	else if (!str_toll(limit, &endptr, 0, 10, value, 0, UINT_MAX))
+		(void)fprintf(stderr, "ERROR: invalid mirror limit: '%s'\n", limit);
+	else if (_NULL(endptr) || (endptr[0] == '\0'))
+		retval = FUNC_RET_OK;
+	else if (endptr[0] != ':')
+		(void)fprintf(stderr, "ERROR: invalid mirror limit: '%s'\n", limit);
+	else if (!str_toll(endptr + 1, &endptr, 1, 10, value + 1, 0, INT64_MAX))
+		(void)fprintf(stderr, "ERROR: invalid mirror limit: '%s'\n", limit);
+	else
+		retval = FUNC_RET_OK;
+
+	if (_OK(retval)) {
+		*cons  = value[0];
+		*bytes = value[1];
+
+		W_DBG(NOTICE, NULL, "mirror limit set to { %u, %"PRIu64" }", *cons, *bytes);
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+
+/***
+ * NAME
+ *   getopt_set_mir_http -
+ *
+ * ARGUMENTS
+ *   mode -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_mir_http(const char *mode)
+{
+#define MIR_HTTP_DEF(a,b)   { b, MIR_HTTP_##a },
+	static const struct {
+		const char *str;
+		uint8_t     mode;
+	} modes[] = { MIR_HTTP_DEFINES };
+#undef MIR_HTTP_DEF
+	int i, retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "\"%s\"", mode);
+
+	for (i = 0; i < TABLESIZE(modes); i++)
+		if (strcasecmp(modes[i].str, mode) == 0)
+			break;
+
+	if (i < TABLESIZE(modes)) {
+		cfg.mir_http = modes[i].mode;
+	} else {
+		(void)fprintf(stderr, "ERROR: invalid mirror HTTP mode '%s'\n", mode);
+
+		retval = FUNC_RET_ERROR;
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+
+/***
+ * NAME
+ *   getopt_set_mir_engine -
+ *
+ * ARGUMENTS
+ *   name -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_mir_engine(const char *name)
+{
+#define MIR_ENGINE_DEF(a,b)   { b, MIR_ENGINE_##a },
+	static const struct {
+		const char *str;
+		uint8_t     engine;
+	} engines[] = { MIR_ENGINE_DEFINES };
+#undef MIR_ENGINE_DEF
+	int i, retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "\"%s\"", name);
+
+	for (i = 0; i < TABLESIZE(engines); i++)
+		if (strcasecmp(engines[i].str, name) == 0)
+			break;
+
+	if (i < TABLESIZE(engines)) {
+		cfg.mir_engine = engines[i].engine;
+	} else {
+		(void)fprintf(stderr, "ERROR: invalid mirror engine '%s'\n", name);
+
+		retval = FUNC_RET_ERROR;
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   getopt_set_mir_log -
+ *
+ * ARGUMENTS
+ *   mode -
+ *
+ * DESCRIPTION
+ *   The mode is specified as NAME[:N], where N is the sampling rate of the
+ *   detailed log lines in the summary mode.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_mir_log(const char *mode)
+{
+#define MIR_LOG_DEF(a,b)   { b, MIR_LOG_##a },
+	static const struct {
+		const char *str;
+		uint8_t     mode;
+	} modes[] = { MIR_LOG_DEFINES };
+#undef MIR_LOG_DEF
+	char    *endptr = NULL;
+	int64_t  value = 0;
+	size_t   len;
+	int      i, retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(NULL, "\"%s\"", mode);
+
+	len = strcspn(mode, ":");
+	for (i = 0; i < TABLESIZE(modes); i++)
+		if ((strlen(modes[i].str) == len) && (strncasecmp(modes[i].str, mode, len) == 0))
+			break;
+
+	if (i >= TABLESIZE(modes))
+		(void)fprintf(stderr, "ERROR: invalid mirror log mode '%s'\n", mode);
+	else if (mode[len] == '\0')
+		retval = FUNC_RET_OK;
+	else if (modes[i].mode != MIR_LOG_SUMMARY)
+		(void)fprintf(stderr, "ERROR: sampling is supported only in the mirror log summary mode\n");
+	else if (!str_toll(mode + len + 1, &endptr, 1, 10, &value, 0, UINT_MAX))
+		(void)fprintf(stderr, "ERROR: invalid mirror log sampling rate: '%s'\n", mode + len + 1);
+	else
+		retval = FUNC_RET_OK;
+
+	if (_OK(retval)) {
+		cfg.mir_log        = modes[i].mode;
+		cfg.mir_log_sample = value;
+
+		W_DBG(NOTICE, NULL, "mirror log mode set to { %hhu, %u }", cfg.mir_log, cfg.mir_log_sample);
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+#endif /* HAVE_LIBCURL */
+
+
 #ifdef DEBUG
 
 /***
@@ -331,6 +737,60 @@ static int getopt_set_ports(const char *ports, int *range)
 }
 
 
+/***
+ * NAME
+ *   getopt_set_stats -
+ *
+ * ARGUMENTS
+ *   value -
+ *
+ * DESCRIPTION
+ *   The statistics listener is specified as [ADDRESS:]PORT, an IPv6 address
+ *   can be enclosed in square brackets.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_stats(const char *value)
+{
+	const char *port;
+	char       *endptr = NULL;
+	int64_t     num = 0;
+	size_t      len = 0;
+	int         retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(NULL, "\"%s\"", value);
+
+	if (_nNULL(port = strrchr(value, ':'))) {
+		len = port++ - value;
+
+		if ((len >= 2) && (value[0] == '[') && (value[len - 1] == ']')) {
+			value++;
+			len -= 2;
+		}
+	} else {
+		port = value;
+	}
+
+	if (!str_toll(port, &endptr, 1, 10, &num, 1, 65535))
+		(void)fprintf(stderr, "ERROR: invalid statistics port: '%s'\n", port);
+	else if (_NULL(endptr = (len > 0) ? strndup(value, len) : strdup(DEFAULT_STATS_ADDRESS)))
+		(void)fprintf(stderr, "ERROR: Failed to allocate memory\n");
+	else
+		retval = FUNC_RET_OK;
+
+	if (_OK(retval)) {
+		PTR_FREE(cfg.stats_address);
+		cfg.stats_address = endptr;
+		cfg.stats_port    = num;
+
+		W_DBG(NOTICE, NULL, "statistics listener set to { \"%s\", %d }", cfg.stats_address, cfg.stats_port);
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
 /***
  * NAME
  *   main -
@@ -349,6 +809,7 @@ static int getopt_set_ports(const char *ports, int *range)
 int main(int argc, char **argv, char **envp __maybe_unused)
 {
 	static const struct option longopts[] = {
+		{ "assign-policy",      required_argument, NULL, 'A' },
 		{ "address",            required_argument, NULL, 'a' },
 		{ "libev-backend",      required_argument, NULL, 'B' },
 		{ "connection-backlog", required_argument, NULL, 'b' },
@@ -358,18 +819,35 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 		{ "pidfile",            required_argument, NULL, 'F' },
 		{ "help",               no_argument,       NULL, 'h' },
 		{ "monitor-interval",   required_argument, NULL, 'i' },
+		{ "ack-first",          no_argument,       NULL, 'K' },
 		{ "logfile",            required_argument, NULL, 'l' },
 		{ "max-frame-size",     required_argument, NULL, 'm' },
 		{ "num-workers",        required_argument, NULL, 'n' },
 		{ "port",               required_argument, NULL, 'p' },
+		{ "reuseport",          required_argument, NULL, 'R' },
 		{ "runtime",            required_argument, NULL, 'r' },
+		{ "stats",              required_argument, NULL, 's' },
 		{ "processing-delay",   required_argument, NULL, 't' },
+#ifdef HAVE_LIBURING
+		{ "io-uring",           no_argument,       NULL, 'U' },
+#endif
 #ifdef HAVE_LIBCURL
 		{ "mirror-url",         required_argument, NULL, 'u' },
+		{ "mirror-engine",      required_argument, NULL, 'E' },
+		{ "mirror-log",         required_argument, NULL, 'L' },
 		{ "mirror-interface",   required_argument, NULL, 'I' },
 		{ "mirror-local-port",  required_argument, NULL, 'P' },
+		{ "mirror-share",       no_argument,       NULL, 'S' },
+		{ "mirror-max",         required_argument, NULL, 'M' },
+		{ "mirror-max-global",  required_argument, NULL, 'G' },
+		{ "mirror-overload",    required_argument, NULL, 'O' },
+		{ "mirror-http",        required_argument, NULL, 'H' },
+		{ "mirror-conns",       required_argument, NULL, 'C' },
+		{ "mirror-streams",     required_argument, NULL, 'N' },
+		{ "mirror-threads",     required_argument, NULL, 'T' },
 #endif
 		{ "version",            no_argument,       NULL, 'V' },
+		{ "latency-log",        no_argument,       NULL, 'Y' },
 		{ NULL,                 0,                 NULL, 0   }
 	};
 	char        shortopts[TABLESIZE(longopts) * 2 + 1];
@@ -391,7 +869,9 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 	(void)getopt_shortopts(longopts, shortopts, sizeof(shortopts), 0);
 
 	while ((c = getopt_long(argc, argv, shortopts, longopts, &longopts_idx)) != EOF) {
-		if (c == 'a')
+		if (c == 'A')
+			flag_error |= _OK(getopt_set_assign_policy(optarg)) ? 0 : 1;
+		else if (c == 'a')
 			cfg.server_address = optarg;
 		else if (c == 'B')
 			flag_error |= _OK(getopt_set_ev_backend(optarg)) ? 0 : 1;
@@ -414,6 +894,8 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 			cfg.opt_flags |= FLAG_OPT_HELP;
 		else if (c == 'i')
 			flag_error |= _OK(getopt_set_time(optarg, &(cfg.monitor_interval_us), TIMEINT_S(1), TIMEINT_S(3600))) ? 0 : 1;
+		else if (c == 'K')
+			cfg.opt_flags |= FLAG_OPT_ACK_FIRST;
 		else if (c == 'l')
 			cfg.logfile = optarg;
 		else if (c == 'm')
@@ -422,20 +904,50 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 			cfg.num_workers = atoi(optarg);
 		else if (c == 'p')
 			cfg.server_port = atoi(optarg);
+		else if (c == 'R')
+			flag_error |= _OK(getopt_set_reuseport(optarg)) ? 0 : 1;
 		else if (c == 'r')
 			flag_error |= _OK(getopt_set_time(optarg, (uint64_t *)&(cfg.runtime_us), 0, TIMEINT_S(86400 * 7))) ? 0 : 1;
+		else if (c == 's')
+			flag_error |= _OK(getopt_set_stats(optarg)) ? 0 : 1;
 		else if (c == 't')
 			flag_error |= _OK(getopt_set_time(optarg, &(cfg.processing_delay_us), 0, TIMEINT_S(1))) ? 0 : 1;
+#ifdef HAVE_LIBURING
+		else if (c == 'U')
+			cfg.opt_flags |= FLAG_OPT_IO_URING;
+#endif
 #ifdef HAVE_LIBCURL
 		else if (c == 'u')
 			mir_url = optarg;
+		else if (c == 'E')
+			flag_error |= _OK(getopt_set_mir_engine(optarg)) ? 0 : 1;
+		else if (c == 'L')
+			flag_error |= _OK(getopt_set_mir_log(optarg)) ? 0 : 1;
 		else if (c == 'I')
 			cfg.mir_interface = optarg;
 		else if (c == 'P')
 			flag_error |= _OK(getopt_set_ports(optarg, cfg.mir_port)) ? 0 : 1;
+		else if (c == 'S')
+			cfg.opt_flags |= FLAG_OPT_MIR_SHARE;
+		else if (c == 'M')
+			flag_error |= _OK(getopt_set_mir_max(optarg, cfg.mir_max_cons, cfg.mir_max_bytes)) ? 0 : 1;
+		else if (c == 'G')
+			flag_error |= _OK(getopt_set_mir_max(optarg, cfg.mir_max_cons + 1, cfg.mir_max_bytes + 1)) ? 0 : 1;
+		else if (c == 'O')
+			flag_error |= _OK(getopt_set_mir_overload(optarg)) ? 0 : 1;
+		else if (c == 'H')
+			flag_error |= _OK(getopt_set_mir_http(optarg)) ? 0 : 1;
+		else if (c == 'C')
+			cfg.mir_max_conns = atoi(optarg);
+		else if (c == 'N')
+			cfg.mir_max_streams = atoi(optarg);
+		else if (c == 'T')
+			cfg.mir_threads = atoi(optarg);
 #endif
 		else if (c == 'V')
 			cfg.opt_flags |= FLAG_OPT_VERSION;
+		else if (c == 'Y')
+			cfg.opt_flags |= FLAG_OPT_LATENCY;
 		else
 			flag_error = 1;
 	}
@@ -462,11 +974,49 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 			flag_error = 1;
 		}
 
+		/* Worker N is bound to the N-th allowed CPU and receives the connections of that CPU. */
+		if ((cfg.reuseport == REUSEPORT_CPU) && (cfg.num_workers != worker_cpus(NULL, 0))) {
+			(void)fprintf(stderr, "ERROR: SO_REUSEPORT mode 'cpu' requires one worker per allowed CPU (%d)\n", worker_cpus(NULL, 0));
+			flag_error = 1;
+		}
+
 		if (!IN_RANGE(cfg.server_port, 1, 65535)) {
 			(void)fprintf(stderr, "ERROR: invalid port '%d'\n", cfg.server_port);
 			flag_error = 1;
 		}
 
+#ifdef HAVE_LIBCURL
+		if (!IN_RANGE(cfg.mir_max_conns, 0, 65535)) {
+			(void)fprintf(stderr, "ERROR: invalid number of mirror connections '%d'\n", cfg.mir_max_conns);
+			flag_error = 1;
+		}
+
+		if (!IN_RANGE(cfg.mir_max_streams, 0, INT32_MAX)) {
+			(void)fprintf(stderr, "ERROR: invalid number of mirror streams '%d'\n", cfg.mir_max_streams);
+			flag_error = 1;
+		}
+
+		if (!IN_RANGE(cfg.mir_threads, 0, 1000)) {
+			(void)fprintf(stderr, "ERROR: invalid number of mirror threads '%d'\n", cfg.mir_threads);
+			flag_error = 1;
+		}
+
+		if (cfg.mir_engine != MIR_ENGINE_NATIVE)
+			/* Do nothing. */;
+		else if (cfg.mir_http >= MIR_HTTP_HTTP2) {
+			(void)fprintf(stderr, "ERROR: the native mirror engine supports only HTTP/1.1\n");
+			flag_error = 1;
+		}
+		else if (_nNULL(mir_url) && (strncasecmp(mir_url, STR_ADDRSIZE(STR_HTTP_PFX)) != 0)) {
+			(void)fprintf(stderr, "ERROR: the native mirror engine supports only the http URL scheme\n");
+			flag_error = 1;
+		}
+		else if (cfg.mir_max_conns > HTTP1_CONNS_MAX) {
+			(void)fprintf(stderr, "ERROR: the native mirror engine supports up to %d connections\n", HTTP1_CONNS_MAX);
+			flag_error = 1;
+		}
+#endif
+
 		if (flag_error)
 			usage(prg.name, 0);
 	}
@@ -485,6 +1035,9 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 		flag_error = 1;
 	}
 #  endif
+	else if ((cfg.opt_flags & FLAG_OPT_MIR_SHARE) && _ERROR(mir_curl_share_init(&(prg.curl_share)))) {
+		flag_error = 1;
+	}
 #endif
 
 	/* Opening the pidfile. */
@@ -507,10 +1060,18 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 		if (cfg.pidfile_fd >= 0)
 			retval = pidfile(NULL, &(cfg.pidfile_fd));
 
-	if (!flag_error && (retval == EX_OK))
-		retval = worker_run();
+	if (!flag_error && (retval == EX_OK)) {
+		if (_ERROR(log_start()))
+			retval = EX_SOFTWARE;
+		else
+			retval = worker_run();
+
+		log_stop();
+	}
 
 #ifdef HAVE_LIBCURL
+	mir_curl_share_close(&(prg.curl_share));
+
 #  ifdef USE_THREADS
 	if (rc == CURLE_OK)
 		curl_global_cleanup();
@@ -519,6 +1080,8 @@ int main(int argc, char **argv, char **envp __maybe_unused)
 	PTR_FREE(cfg.mir_url);
 #endif
 
+	PTR_FREE(cfg.stats_address);
+
 	/* Closing the pidfile. */
 	if (cfg.pidfile_fd >= 0)
 		retval = pidfile(cfg.pidfile, &(cfg.pidfile_fd));
@@ -0,0 +1,266 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+
+
+/* Upper bounds of the latency buckets in milliseconds. */
+static const double mir_log_bounds[MIR_LOG_LATENCIES - 1] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000 };
+
+static const char *mir_log_methods[MIR_LOG_METHODS] = { "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH", "other" };
+
+static const char *mir_log_statuses[MIR_LOG_STATUSES] = { "none", "1xx", "2xx", "3xx", "4xx", "5xx" };
+
+#define MIR_ERR_DEF(a,b)   b,
+static const char *mir_log_errors[MIR_ERR_MAX] = { MIR_ERR_DEFINES };
+#undef MIR_ERR_DEF
+
+
+/***
+ * NAME
+ *   mir_log_init -
+ *
+ * ARGUMENTS
+ *   log  -
+ *   loop -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_log_init(struct mir_log *log, struct ev_loop *loop)
+{
+	DBG_FUNC(NULL, "%p, %p", log, loop);
+
+	(void)memset(log, 0, sizeof(*log));
+
+	log->start = ev_now(loop);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_log_sample -
+ *
+ * ARGUMENTS
+ *   log -
+ *
+ * DESCRIPTION
+ *   Decides whether the completed mirror is logged on its own line.  In the
+ *   summary mode only every N-th mirror is, if sampling is enabled.
+ *
+ * RETURN VALUE
+ *   Returns true if the mirror is to be logged, false otherwise.
+ */
+bool_t mir_log_sample(struct mir_log *log)
+{
+	bool_t retval;
+
+	DBG_FUNC(NULL, "%p", log);
+
+	if (cfg.mir_log != MIR_LOG_SUMMARY)
+		retval = 1;
+	else if (cfg.mir_log_sample == 0)
+		retval = 0;
+	else
+		retval = ((log->seq++ % cfg.mir_log_sample) == 0);
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   mir_log_add -
+ *
+ * ARGUMENTS
+ *   log     -
+ *   method  -
+ *   code    - HTTP response status code, 0 if there is no response
+ *   error   - error class of the mirror
+ *   up      - bytes sent
+ *   down    - bytes received
+ *   time_ms - total time of the mirror in milliseconds
+ *
+ * DESCRIPTION
+ *   Counts the completed mirror in the totals and in the current summary
+ *   interval.  The interval is not counted if the summaries are not enabled.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_log_add(struct mir_log *log, const char *method, long code, uint8_t error, uint64_t up, uint64_t down, double time_ms)
+{
+	int i;
+
+	DBG_FUNC(NULL, "%p, \"%s\", %ld, %hhu, %"PRIu64", %"PRIu64", %.3f", log, PTR_SAFE(method, ""), code, error, up, down, time_ms);
+
+	if (error == MIR_ERR_OK)
+		STAT_INC(log->stats.completed);
+	else
+		STAT_INC(log->stats.failed);
+	STAT_ADD(log->stats.bytes_up, up);
+	STAT_ADD(log->stats.bytes_down, down);
+
+	if (cfg.mir_log != MIR_LOG_SUMMARY)
+		DBG_RETURN();
+
+	for (i = 0; (i < MIR_LOG_METHODS - 1) && _nNULL(method) && (strcmp(method, mir_log_methods[i]) != 0); i++);
+	log->method[_NULL(method) ? (MIR_LOG_METHODS - 1) : i]++;
+
+	log->status[((code >= 100) && (code < 600)) ? (code / 100) : 0]++;
+	log->error[MIN(error, MIR_ERR_OTHER)]++;
+
+	for (i = 0; (i < MIR_LOG_LATENCIES - 1) && (time_ms > mir_log_bounds[i]); i++);
+	log->latency[i]++;
+
+	log->nbdone++;
+	log->bytes_up   += up;
+	log->bytes_down += down;
+	log->time_sum   += time_ms;
+	log->time_max    = MAX(log->time_max, time_ms);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_log_counters -
+ *
+ * ARGUMENTS
+ *   buf    -
+ *   size   -
+ *   len    -
+ *   title  -
+ *   names  -
+ *   values -
+ *   n      -
+ *
+ * DESCRIPTION
+ *   Appends the non-zero counters to the summary line.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_log_counters(char *buf, size_t size, size_t *len, const char *title, const char **names, const uint64_t *values, int n)
+{
+	int i, rc;
+
+	rc = snprintf(buf + *len, size - *len, ", %s", title);
+	if (rc > 0)
+		*len = MIN(*len + rc, size - 1);
+
+	for (i = 0; i < n; i++) {
+		if (values[i] == 0)
+			continue;
+
+		rc = snprintf(buf + *len, size - *len, " %s=%"PRIu64, names[i], values[i]);
+		if (rc > 0)
+			*len = MIN(*len + rc, size - 1);
+	}
+}
+
+
+/***
+ * NAME
+ *   mir_log_summary -
+ *
+ * ARGUMENTS
+ *   worker -
+ *   log    -
+ *   loop   -
+ *
+ * DESCRIPTION
+ *   Logs the summary of the mirrors completed in the current interval and
+ *   starts a new interval.  Nothing is logged if no mirror was completed.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_log_summary(const struct worker *worker, struct mir_log *log, struct ev_loop *loop)
+{
+	char        buf[BUFSIZ], bounds[MIR_LOG_LATENCIES][8];
+	const char *names[MIR_LOG_LATENCIES];
+	ev_tstamp   now, interval;
+	size_t      len = 0;
+	int         i, rc;
+
+	DBG_FUNC(worker, "%p, %p, %p", worker, log, loop);
+
+	/* The mirroring may not be initialized, e.g. in the workers if the mirror threads are used. */
+	if (_NULL(loop))
+		DBG_RETURN();
+
+	now = ev_now(loop);
+	if ((cfg.mir_log != MIR_LOG_SUMMARY) || (log->nbdone == 0)) {
+		log->start = now;
+
+		DBG_RETURN();
+	}
+
+	for (i = 0; i < MIR_LOG_LATENCIES; i++) {
+		if (i < MIR_LOG_LATENCIES - 1)
+			(void)snprintf(bounds[i], sizeof(bounds[i]), "<=%.0f", mir_log_bounds[i]);
+		else
+			(void)snprintf(bounds[i], sizeof(bounds[i]), ">%.0f", mir_log_bounds[i - 1]);
+
+		names[i] = bounds[i];
+	}
+
+	interval = MAX(now - log->start, 0.001);
+
+	rc  = snprintf(buf, sizeof(buf), "%"PRIu64" mirrors in %.3f s (%.1f/s)", log->nbdone, interval, log->nbdone / interval);
+	len = (rc > 0) ? MIN((size_t)rc, sizeof(buf) - 1) : 0;
+
+	mir_log_counters(buf, sizeof(buf), &len, "status", mir_log_statuses, log->status, MIR_LOG_STATUSES);
+	mir_log_counters(buf, sizeof(buf), &len, "method", mir_log_methods, log->method, MIR_LOG_METHODS);
+	mir_log_counters(buf, sizeof(buf), &len, "error", mir_log_errors, log->error, MIR_ERR_MAX);
+	mir_log_counters(buf, sizeof(buf), &len, "latency(ms)", names, log->latency, MIR_LOG_LATENCIES);
+
+	w_log(worker, "mirror summary: %s, avg %.3f max %.3f ms, bytes %"PRIu64"/%"PRIu64,
+	      buf, log->time_sum / log->nbdone, log->time_max, log->bytes_up, log->bytes_down);
+
+	log->nbdone     = 0;
+	log->bytes_up   = 0;
+	log->bytes_down = 0;
+	log->time_sum   = 0;
+	log->time_max   = 0;
+	log->start      = now;
+	(void)memset(log->status, 0, sizeof(log->status));
+	(void)memset(log->method, 0, sizeof(log->method));
+	(void)memset(log->error, 0, sizeof(log->error));
+	(void)memset(log->latency, 0, sizeof(log->latency));
+
+	DBG_RETURN();
+}
+
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -0,0 +1,510 @@
+/***
+ * Copyright 2018-2020 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+
+
+/***
+ * NAME
+ *   mir_queue_push -
+ *
+ * ARGUMENTS
+ *   queue -
+ *   mir   -
+ *
+ * DESCRIPTION
+ *   Adds the mirror to the queue.  This function can be called from any
+ *   thread.
+ *
+ * RETURN VALUE
+ *   Returns true if the queue was empty, in which case the consumer has to
+ *   be woken up.
+ */
+bool_t mir_queue_push(struct mir_queue *queue, struct mirror *mir)
+{
+	mir->next = __atomic_load_n(&(queue->head), __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&(queue->head), &(mir->next), mir, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	return _NULL(mir->next);
+}
+
+
+/***
+ * NAME
+ *   mir_queue_pop -
+ *
+ * ARGUMENTS
+ *   queue -
+ *
+ * DESCRIPTION
+ *   Takes all the mirrors from the queue.  This function can only be called
+ *   from the thread that consumes the queue.
+ *
+ * RETURN VALUE
+ *   Returns the list of mirrors linked with the next pointer, in the order
+ *   in which they were added to the queue.
+ */
+struct mirror *mir_queue_pop(struct mir_queue *queue)
+{
+	struct mirror *mir, *next, *retptr = NULL;
+
+	mir = __atomic_exchange_n(&(queue->head), NULL, __ATOMIC_ACQUIRE);
+	for ( ; _nNULL(mir); mir = next) {
+		next      = mir->next;
+		mir->next = retptr;
+		retptr    = mir;
+	}
+
+	return retptr;
+}
+
+
+/***
+ * NAME
+ *   mir_sender_async_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Adds the mirrors handed off by the workers to the curl multi handle or
+ *   the HTTP/1.1 connections of the sender.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_sender_async_cb(struct ev_loop *loop, struct ev_async *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(mir_sender, s, ev_async);
+	struct mirror *mir, *next;
+	int            retval;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	if (__atomic_load_n(&(s->flag_stop), __ATOMIC_RELAXED)) {
+		ev_break(loop, EVBREAK_ONE);
+
+		DBG_RETURN();
+	}
+
+	for (mir = mir_queue_pop(&(s->queue)); _nNULL(mir); mir = next) {
+		next = mir->next;
+
+		if (cfg.mir_engine == MIR_ENGINE_NATIVE)
+			retval = mir_http1_add(&(s->http1), mir);
+		else
+			retval = mir_curl_add(&(s->curl), mir);
+
+		if (_ERROR(retval))
+			mir_sender_release(&mir);
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_sender_monitor_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void mir_sender_monitor_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(mir_sender, s, ev_monitor);
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	if (cfg.mir_engine == MIR_ENGINE_NATIVE)
+		mir_http1_monitor(NULL, &(s->http1));
+	else
+		mir_curl_monitor(NULL, &(s->curl));
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_sender_thread -
+ *
+ * ARGUMENTS
+ *   data -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static void *mir_sender_thread(void *data)
+{
+	char               name[16];
+	struct mir_sender *s = data;
+	struct mirror     *mir, *next;
+
+	DBG_FUNC(NULL, "%p", data);
+
+#ifdef __linux__
+	W_DBG(WORKER, NULL, "Mirror sender %02d started, thread id: %"PRI_PTHREADT, s->id, syscall(SYS_gettid));
+#else
+	W_DBG(WORKER, NULL, "Mirror sender %02d started, thread id: %"PRI_PTHREADT, s->id, pthread_self());
+#endif
+
+	(void)snprintf(name, sizeof(name), "sm/mir: %d", s->id);
+	(void)pthread_setname_np(pthread_self(), name);
+
+	log_thread_init(s->ev_base);
+
+	(void)ev_run(s->ev_base, 0);
+
+	if (ev_is_active(&(s->ev_monitor)) || ev_is_pending(&(s->ev_monitor)))
+		ev_timer_stop(s->ev_base, &(s->ev_monitor));
+
+	if (cfg.mir_engine == MIR_ENGINE_NATIVE)
+		mir_http1_close(&(s->http1));
+	else
+		mir_curl_close(&(s->curl));
+
+	/* The mirrors that were not sent are returned to the workers. */
+	for (mir = mir_queue_pop(&(s->queue)); _nNULL(mir); mir = next) {
+		next = mir->next;
+
+		mir_sender_release(&mir);
+	}
+
+	W_DBG(WORKER, NULL, "Mirror sender %02d is stopped", s->id);
+
+	DBG_FUNC_END("} = %p", NULL);
+
+	pthread_exit(NULL);
+}
+
+
+/***
+ * NAME
+ *   mir_sender_start -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Creates the mirror sender threads.  The event loops and the curl multi
+ *   handles of the senders are initialized here, before the workers are
+ *   started, so that the workers can hand off the mirrors at any time.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int mir_sender_start(void)
+{
+	int i, retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "");
+
+	prg.senders = calloc(cfg.mir_threads, sizeof(*(prg.senders)));
+	if (_NULL(prg.senders)) {
+		w_log(NULL, _F("Failed to allocate memory for mirror senders: %m"));
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	for (i = 0; _OK(retval) && (i < cfg.mir_threads); i++) {
+		struct mir_sender *s = prg.senders + i;
+
+		s->id = i + 1;
+
+		if (_NULL(s->ev_base = ev_loop_new(cfg.ev_backend))) {
+			w_log(NULL, _F("Failed to initialize libev for mirror sender %02d: %m"), s->id);
+
+			retval = FUNC_RET_ERROR;
+		}
+		else if ((cfg.mir_engine == MIR_ENGINE_NATIVE) && _ERROR(mir_http1_init(s->ev_base, &(s->http1)))) {
+			w_log(NULL, _F("Failed to initialize HTTP/1.1 mirroring for mirror sender %02d"), s->id);
+
+			retval = FUNC_RET_ERROR;
+		}
+		else if ((cfg.mir_engine != MIR_ENGINE_NATIVE) && _ERROR(mir_curl_init(s->ev_base, &(s->curl)))) {
+			w_log(NULL, _F("Failed to initialize cURL for mirror sender %02d"), s->id);
+
+			retval = FUNC_RET_ERROR;
+		}
+		else {
+			ev_async_init(&(s->ev_async), mir_sender_async_cb);
+			ev_async_start(s->ev_base, &(s->ev_async));
+
+			ev_timer_init(&(s->ev_monitor), mir_sender_monitor_cb, cfg.monitor_interval_us / 1e6, cfg.monitor_interval_us / 1e6);
+			ev_timer_start(s->ev_base, &(s->ev_monitor));
+		}
+	}
+
+	for (i = 0; _OK(retval) && (i < cfg.mir_threads); i++) {
+		struct mir_sender *s = prg.senders + i;
+
+		if (_nOK(pthread_create(&(s->thread), NULL, mir_sender_thread, s))) {
+			w_log(NULL, _F("Failed to start thread for mirror sender %02d: %m"), s->id);
+
+			retval = FUNC_RET_ERROR;
+		} else {
+			s->flag_running = 1;
+		}
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   mir_sender_stop -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Stops the mirror sender threads and waits for them to finish.  This has
+ *   to be done before the workers are stopped, because the senders return
+ *   the completed mirrors to the workers.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_sender_stop(void)
+{
+	int i, rc;
+
+	DBG_FUNC(NULL, "");
+
+	if (_NULL(prg.senders))
+		DBG_RETURN();
+
+	for (i = 0; i < cfg.mir_threads; i++) {
+		struct mir_sender *s = prg.senders + i;
+
+		if (!s->flag_running)
+			continue;
+
+		__atomic_store_n(&(s->flag_stop), 1, __ATOMIC_RELAXED);
+		ev_async_send(s->ev_base, &(s->ev_async));
+	}
+
+	for (i = 0; i < cfg.mir_threads; i++) {
+		struct mir_sender *s = prg.senders + i;
+
+		if (!s->flag_running)
+			continue;
+
+		rc = pthread_join(s->thread, NULL);
+		if (rc != 0)
+			w_log(NULL, _E("Failed to join mirror sender thread %02d: %s"), s->id, strerror(rc));
+
+		W_DBG(WORKER, NULL, "Mirror sender %02d: terminated (%d)", s->id, rc);
+
+		s->flag_running = 0;
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_sender_free -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Releases the event loops of the stopped mirror senders and the mirrors
+ *   left in their queues.  The workers can hand off the mirrors until they
+ *   are stopped, so this must not be done before that.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_sender_free(void)
+{
+	struct spoe_frame *frame;
+	struct mirror     *mir, *next;
+	int                i;
+
+	DBG_FUNC(NULL, "");
+
+	if (_NULL(prg.senders))
+		DBG_RETURN();
+
+	mir_sender_stop();
+
+	for (i = 0; i < cfg.mir_threads; i++) {
+		struct mir_sender *s = prg.senders + i;
+
+		if (_NULL(s->ev_base))
+			continue;
+
+		/* The senders that failed to start still have their curl handles. */
+		if (_nNULL(s->curl.multi))
+			mir_curl_close(&(s->curl));
+		else if (_nNULL(s->http1.ev_base))
+			mir_http1_close(&(s->http1));
+
+		ev_loop_destroy(s->ev_base);
+
+		/*
+		 * The workers can hand off the mirrors after the sender has
+		 * stopped.  The workers and their frame pools no longer exist,
+		 * so the last references to the frames are freed here.
+		 */
+		for (mir = mir_queue_pop(&(s->queue)); _nNULL(mir); mir = next) {
+			next  = mir->next;
+			frame = mir->frame;
+
+			mir->frame = NULL;
+			mir_ptr_free(&mir);
+
+			if (_nNULL(frame) && (--(frame->refcnt) == 0)) {
+				buffer_free(&(frame->frag));
+				free(frame);
+			}
+		}
+	}
+
+	PTR_FREE(prg.senders);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_sender_add -
+ *
+ * ARGUMENTS
+ *   worker -
+ *   mir    -
+ *
+ * DESCRIPTION
+ *   Hands off the mirror to the sender assigned to the worker.  The sender
+ *   is woken up only if its queue was empty.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int mir_sender_add(const struct worker *worker, struct mirror *mir)
+{
+	struct mir_sender *s;
+
+	DBG_FUNC(worker, "%p, %p", worker, mir);
+
+	if (_NULL(worker) || _NULL(mir))
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+
+	s = prg.senders + (worker->id - 1) % cfg.mir_threads;
+	if (mir_queue_push(&(s->queue), mir))
+		ev_async_send(s->ev_base, &(s->ev_async));
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   mir_sender_release -
+ *
+ * ARGUMENTS
+ *   mir -
+ *
+ * DESCRIPTION
+ *   Releases the mirror after it has been sent.  The frame referenced by the
+ *   mirror belongs to the worker that received it, so if the mirror is sent
+ *   by a sender thread, it is returned to that worker to be released there.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_sender_release(struct mirror **mir)
+{
+	struct worker *w;
+
+	DBG_FUNC(NULL, "%p:%p", DPTR_ARGS(mir));
+
+	if (_NULL(mir) || _NULL(*mir))
+		DBG_RETURN();
+
+	if ((cfg.mir_threads == 0) || _NULL((*mir)->frame)) {
+		mir_ptr_free(mir);
+
+		DBG_RETURN();
+	}
+
+	w = (*mir)->frame->worker;
+	if (mir_queue_push(&(w->mir_done), *mir))
+		ev_async_send(w->ev_base, &(w->ev_async));
+	*mir = NULL;
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   mir_sender_collect -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Releases the mirrors returned to the worker by the sender threads.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void mir_sender_collect(struct worker *worker)
+{
+	struct mirror *mir, *next;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	for (mir = mir_queue_pop(&(worker->mir_done)); _nNULL(mir); mir = next) {
+		next = mir->next;
+
+		mir_ptr_free(&mir);
+	}
+
+	DBG_RETURN();
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -22,7 +22,7 @@
 
 /***
  * NAME
- *   spoa_msg_arg_dup -
+ *   spoa_msg_arg_ref -
  *
  * ARGUMENTS
  *   frame  -
@@ -30,28 +30,29 @@
  *   arg    -
  *   arglen -
  *   data   -
- *   ptr    -
- *   len    -
- *   errmsg -
+ *   chk    -
  *
  * DESCRIPTION
- *   -
+ *   Saves the location of the argument value in the frame payload, the value
+ *   itself is not copied.
  *
  * RETURN VALUE
  *   -
  */
-static void *spoa_msg_arg_dup(const struct spoe_frame *frame, int i, const char *arg, size_t arglen, const union spoe_data *data, char **ptr, size_t *len, const char *errmsg)
+static int spoa_msg_arg_ref(const struct spoe_frame *frame, int i, const char *arg, size_t arglen, const union spoe_data *data, struct chunk *chk)
 {
-	DBG_FUNC(FW_PTR, "%p, %d, \"%.*s\", %zu, %p, %p:%p, %p, \"%s\"", frame, i, (int)arglen, arg, arglen, data, DPTR_ARGS(ptr), len, errmsg);
+	int retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(FW_PTR, "%p, %d, \"%.*s\", %zu, %p, %p", frame, i, (int)arglen, arg, arglen, data, chk);
 
-	if (_nNULL(*ptr))
+	if (_nNULL(chk->ptr)) {
 		f_log(frame, _E("arg[%d] '%.*s': Duplicated argument"), i, (int)arglen, arg);
-	else if (_NULL(*ptr = mem_dup(data->chk.ptr, data->chk.len)))
-		f_log(frame, _E("Failed to %s"), errmsg);
-	else if (_nNULL(len))
-		*len = data->chk.len;
+	} else {
+		*chk   = data->chk;
+		retval = FUNC_RET_OK;
+	}
 
-	DBG_RETURN_PTR(*ptr);
+	DBG_RETURN_INT(retval);
 }
 
 
@@ -247,45 +248,42 @@ int spoa_msg_test(struct spoe_frame *frame, const char **buf, const char *end)
  *   frame -
  *   buf   -
  *   end   -
- *   hdrs  -
+ *   mir   -
  *
  * DESCRIPTION
- *   -
+ *   Decodes the binary encoded HTTP headers into the header arena of <mir>.
+ *   Each header is stored as a 'name: value\0' string, one after another.
  *
  * RETURN VALUE
  *   -
  */
-static int spoa_msg_arg_hdrs_bin(struct spoe_frame *frame, const char *buf, const char *end, struct list *hdrs)
+static int spoa_msg_arg_hdrs_bin(struct spoe_frame *frame, const char *buf, const char *end, struct mirror *mir)
 {
-	struct buffer *hdr = NULL, *hdr_back;
-	const char    *str;
-	uint64_t       len;
-	int            i, retval = FUNC_RET_ERROR;
-
-	DBG_FUNC(FW_PTR, "%p, %p, %p, %p", frame, buf, end, hdrs);
+	struct chunk name, value;
+	size_t       n = 0;
+	int          retval = FUNC_RET_OK;
 
-	/* Build the HTTP headers. */
-	for (i = 0; buf < end; i++) {
-		retval = spoe_decode(frame, &buf, end, SPOE_DEC_STR0, &str, &len, SPOE_DEC_END);
-		if (_ERROR(retval))
-			break;
+	DBG_FUNC(FW_PTR, "%p, %p, %p, %p", frame, buf, end, mir);
 
-		F_DBG(SPOA, frame, "str[%d]: <%.*s>", i, (int)len, str);
+	/*
+	 * The name and the value of each HTTP header are preceded by their
+	 * lengths, each of which takes at least one byte.  Converted to the
+	 * 'name: value\0' form, the header can therefore be at most one byte
+	 * longer than its encoded form.
+	 */
+	if (_NULL(mir->hdrs = malloc((end - buf) + (end - buf) / 2 + 1))) {
+		f_log(frame, _E("Failed to allocate memory for headers"));
 
-		if (i & 1) {
-			if (_NULL(str)) {
-				/* HTTP header has no value. */
-				if (_ERROR(retval = buffer_grow(hdr, ";\0", 2)))
-					break;
-			}
-			else if (_ERROR(retval = buffer_grow_va(hdr, ": ", 2, str, len, "\0", 1, NULL))) {
-				break;
-			}
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
 
-			F_DBG(SPOA, frame, "header[%d]: <%.*s>", i / 2, (int)hdr->len, hdr->ptr);
-			LIST_ADDQ(hdrs, &(hdr->list));
+	/* Build the HTTP headers. */
+	while (buf < end) {
+		retval = spoe_decode_hdr(frame, &buf, end, &name, &value);
+		if (_ERROR(retval)) {
+			break;
 		}
-		else if (_NULL(str)) {
+		else if (_NULL(name.ptr)) {
 			if (buf != end) {
 				/* HTTP header has no name. */
 				f_log(frame, _E("HTTP header defined without a name"));
@@ -295,19 +293,31 @@ static int spoa_msg_arg_hdrs_bin(struct spoe_frame *frame, const char *buf, cons
 
 			break;
 		}
-		else if (_NULL(hdr = buffer_alloc(cfg.max_frame_size, str, len, NULL))) {
-			break;
+
+		(void)memcpy(mir->hdrs + n, name.ptr, name.len);
+		n += name.len;
+
+		if (_NULL(value.ptr)) {
+			/* HTTP header has no value. */
+			mir->hdrs[n++] = ';';
+		} else {
+			(void)memcpy(mir->hdrs + n, ": ", 2);
+			(void)memcpy(mir->hdrs + n + 2, value.ptr, value.len);
+			n += value.len + 2;
 		}
+		mir->hdrs[n++] = '\0';
+
+		F_DBG(SPOA, frame, "header[%d]: <%s>", mir->hdrs_cnt, mir->hdrs + mir->hdrs_len);
+
+		mir->hdrs_len = n;
+		mir->hdrs_cnt++;
 	}
 
 	/* In the case of a fault, the allocated memory is released. */
-	if (_ERROR(retval) || _NULL(hdr)) {
-		buffer_ptr_free(&hdr);
-
-		list_for_each_entry_safe(hdr, hdr_back, hdrs, list) {
-			LIST_DEL(&(hdr->list));
-			buffer_ptr_free(&hdr);
-		}
+	if (_ERROR(retval) || (mir->hdrs_cnt == 0)) {
+		PTR_FREE(mir->hdrs);
+		mir->hdrs_len = 0;
+		mir->hdrs_cnt = 0;
 
 		retval = FUNC_RET_ERROR;
 	}
@@ -324,21 +334,30 @@ static int spoa_msg_arg_hdrs_bin(struct spoe_frame *frame, const char *buf, cons
  *   frame -
  *   buf   -
  *   end   -
- *   hdrs  -
+ *   mir   -
  *
  * DESCRIPTION
- *   -
+ *   Splits the CRLF separated HTTP headers into the header arena of <mir>.
  *
  * RETURN VALUE
  *   -
  */
-static int spoa_msg_arg_hdrs(struct spoe_frame *frame, const char *buf, const char *end, struct list *hdrs)
+static int spoa_msg_arg_hdrs(struct spoe_frame *frame, const char *buf, const char *end, struct mirror *mir)
 {
-	struct buffer *hdr = NULL, *hdr_back;
-	const char    *ptr;
-	int            i, retval = FUNC_RET_OK;
+	const char *ptr;
+	int         i, retval = FUNC_RET_OK;
+
+	DBG_FUNC(FW_PTR, "%p, %p, %p, %p", frame, buf, end, mir);
+
+	/*
+	 * Every HTTP header except the last one is followed by at least one
+	 * byte of CRLF, which is replaced by the string terminator.
+	 */
+	if (_NULL(mir->hdrs = malloc((end - buf) + 1))) {
+		f_log(frame, _E("Failed to allocate memory for headers"));
 
-	DBG_FUNC(FW_PTR, "%p, %p, %p, %p", frame, buf, end, hdrs);
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
 
 	/* Build the HTTP headers. */
 	for (i = 0; buf < end; i++) {
@@ -352,12 +371,13 @@ static int spoa_msg_arg_hdrs(struct spoe_frame *frame, const char *buf, const ch
 		 * In that case, this block is skipped.
 		 */
 		if (ptr != buf) {
-			if (_NULL(hdr = buffer_alloc(cfg.max_frame_size, buf, ptr - buf, NULL)))
-				break;
+			(void)memcpy(mir->hdrs + mir->hdrs_len, buf, ptr - buf);
+			mir->hdrs[mir->hdrs_len + (ptr - buf)] = '\0';
 
-			F_DBG(SPOA, frame, "header[%d]: <%.*s>", i, (int)hdr->len, hdr->ptr);
+			F_DBG(SPOA, frame, "header[%d]: <%s>", i, mir->hdrs + mir->hdrs_len);
 
-			LIST_ADDQ(hdrs, &(hdr->list));
+			mir->hdrs_len += ptr - buf + 1;
+			mir->hdrs_cnt++;
 		}
 
 		/* Skip the end of the HTTP header (CRLF). */
@@ -366,17 +386,9 @@ static int spoa_msg_arg_hdrs(struct spoe_frame *frame, const char *buf, const ch
 				break;
 	}
 
-	/* In the case of a fault, the allocated memory is released. */
-	if (_ERROR(retval) || ((i > 0) && _NULL(hdr))) {
-		buffer_ptr_free(&hdr);
-
-		list_for_each_entry_safe(hdr, hdr_back, hdrs, list) {
-			LIST_DEL(&(hdr->list));
-			buffer_ptr_free(&hdr);
-		}
-
-		retval = FUNC_RET_ERROR;
-	}
+	/* Without any HTTP header, the arena is not needed. */
+	if (mir->hdrs_cnt == 0)
+		PTR_FREE(mir->hdrs);
 
 	DBG_RETURN_INT(retval);
 }
@@ -387,36 +399,39 @@ static int spoa_msg_arg_hdrs(struct spoe_frame *frame, const char *buf, const ch
  *   spoa_msg_url -
  *
  * ARGUMENTS
- *   frame -
- *   mir   -
+ *   frame   -
+ *   mir     -
+ *   path    -
+ *   method  -
+ *   version -
  *
  * DESCRIPTION
- *   -
+ *   Constructs the destination URL.  The URL is followed by the path, method
+ *   and version strings in the same allocated memory.
  *
  * RETURN VALUE
  *   -
  */
-static int spoa_msg_url(struct spoe_frame *frame, struct mirror *mir)
+static int spoa_msg_url(struct spoe_frame *frame, struct mirror *mir, const struct chunk *path, const struct chunk *method, const struct chunk *version)
 {
-	size_t n = 0, path_len;
-	int    rc, url_len, retval = FUNC_RET_ERROR;
-
-	DBG_FUNC(FW_PTR, "%p, %p", frame, mir);
+	size_t  n = 0, mir_url_len, url_len;
+	char   *ptr;
+	int     retval = FUNC_RET_ERROR;
 
-	path_len = strlen(mir->path);
+	DBG_FUNC(FW_PTR, "%p, %p, %p, %p, %p", frame, mir, path, method, version);
 
 	/*
 	 * First we need to see if the member path contains an absolute URL;
 	 * and if so, find the beginning of the relative part.
 	 */
-	if (strncasecmp(mir->path, STR_ADDRSIZE(STR_HTTP_PFX)) == 0)
+	if ((path->len >= STR_SIZE(STR_HTTP_PFX)) && (strncasecmp(path->ptr, STR_ADDRSIZE(STR_HTTP_PFX)) == 0))
 		n = STR_SIZE(STR_HTTP_PFX);
-	else if (strncasecmp(mir->path, STR_ADDRSIZE(STR_HTTPS_PFX)) == 0)
+	else if ((path->len >= STR_SIZE(STR_HTTPS_PFX)) && (strncasecmp(path->ptr, STR_ADDRSIZE(STR_HTTPS_PFX)) == 0))
 		n = STR_SIZE(STR_HTTPS_PFX);
 
 	if (n > 0) {
-		for ( ; n < path_len; n++)
-			if (mir->path[n] == '/')
+		for ( ; n < path->len; n++)
+			if (path->ptr[n] == '/')
 				break;
 	}
 
@@ -424,17 +439,34 @@ static int spoa_msg_url(struct spoe_frame *frame, struct mirror *mir)
 	 * The destination URL is constructed by adding the relative path part
 	 * to the mirror URL.
 	 */
-	if (n < path_len) {
-		url_len = strlen(cfg.mir_url) + path_len - n + 1;
+	if (n < path->len) {
+		mir_url_len = strlen(cfg.mir_url);
+		url_len     = mir_url_len + path->len - n + 1;
 
-		if (_NULL(mir->url = malloc(url_len)))
+		if (_NULL(mir->url = malloc(url_len + path->len + 1 + method->len + 1 + version->len + 1))) {
 			f_log(frame, _E("Failed to allocate memory"));
-		else if (((rc = snprintf(mir->url, url_len, "%s%s", cfg.mir_url, mir->path + n)) >= url_len) || (rc < 0))
-			f_log(frame, (rc < 0) ? _E("Failed to construct URL: %m") : _E("URL too long"));
-		else
+		} else {
+			ptr = mir->url;
+			(void)memcpy(ptr, cfg.mir_url, mir_url_len);
+			(void)memcpy(ptr + mir_url_len, path->ptr + n, path->len - n);
+			ptr[url_len - 1] = '\0';
+
+			mir->path = ptr += url_len;
+			(void)memcpy(ptr, path->ptr, path->len);
+			ptr[path->len] = '\0';
+
+			mir->method = ptr += path->len + 1;
+			(void)memcpy(ptr, method->ptr, method->len);
+			ptr[method->len] = '\0';
+
+			mir->version = ptr += method->len + 1;
+			(void)memcpy(ptr, version->ptr, version->len);
+			ptr[version->len] = '\0';
+
 			retval = FUNC_RET_OK;
+		}
 	} else {
-		f_log(frame, _E("Invalid path: '%s'"), mir->path);
+		f_log(frame, _E("Invalid path: '%.*s'"), (int)path->len, path->ptr);
 	}
 
 	DBG_RETURN_INT(retval);
@@ -461,6 +493,7 @@ int spoa_msg_mirror(struct spoe_frame *frame, const char **buf, const char *end)
 	union spoe_data      data;
 	enum spoe_data_type  type;
 	struct mirror       *mir;
+	struct chunk         path = { NULL, 0 }, method = { NULL, 0 }, version = { NULL, 0 }, body = { NULL, 0 };
 	const char          *ptr = *buf, *str;
 	uint64_t             len;
 	uint8_t              nbargs;
@@ -473,7 +506,6 @@ int spoa_msg_mirror(struct spoe_frame *frame, const char **buf, const char *end)
 
 		DBG_RETURN_INT(retval);
 	}
-	LIST_INIT(&(mir->hdrs));
 
 	retval = spoe_decode(frame, &ptr, end, SPOE_DEC_UINT8, &nbargs, SPOE_DEC_END);
 	if (_nERROR(retval))
@@ -488,24 +520,24 @@ int spoa_msg_mirror(struct spoe_frame *frame, const char **buf, const char *end)
 			break;
 		}
 		else if (type == SPOE_DATA_T_STR) {
-			char **mir_ptr;
+			struct chunk *chk;
 
 			F_DBG(SPOA, frame, "mirror[%d] name='%.*s' type=%hhu: \"%.*s\"", i, (int)len, str, type, (int)data.chk.len, data.chk.ptr);
 
 			if ((len == STR_SIZE(SPOE_MSG_ARG_METHOD)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_ARG_METHOD)) == 0))
-				mir_ptr = &(mir->method);
+				chk = &method;
 			else if ((len == STR_SIZE(SPOE_MSG_ARG_PATH)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_ARG_PATH)) == 0))
-				mir_ptr = &(mir->path);
+				chk = &path;
 			else if ((len == STR_SIZE(SPOE_MSG_ARG_VER)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_ARG_VER)) == 0))
-				mir_ptr = &(mir->version);
+				chk = &version;
 			else if ((len == STR_SIZE(SPOE_MSG_ARG_HDRS)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_ARG_HDRS)) == 0)) {
-				if (!LIST_ISEMPTY(&(mir->hdrs))) {
+				if (_nNULL(mir->hdrs)) {
 					f_log(frame, _E("arg[%d] '%.*s': Duplicated argument"), i, (int)len, str);
 
 					retval = FUNC_RET_ERROR;
 				}
 				else
-					retval = spoa_msg_arg_hdrs(frame, data.chk.ptr, data.chk.ptr + data.chk.len - 1, &(mir->hdrs));
+					retval = spoa_msg_arg_hdrs(frame, data.chk.ptr, data.chk.ptr + data.chk.len - 1, mir);
 
 				continue;
 			}
@@ -515,24 +547,22 @@ int spoa_msg_mirror(struct spoe_frame *frame, const char **buf, const char *end)
 				continue;
 			}
 
-			if (_NULL(spoa_msg_arg_dup(frame, i, str, len, &data, mir_ptr, NULL, "allocate memory for headers")))
-				retval = FUNC_RET_ERROR;
+			retval = spoa_msg_arg_ref(frame, i, str, len, &data, chk);
 		}
 		else if (type == SPOE_DATA_T_BIN) {
 			F_DBG(SPOA, frame, "mirror[%d] name='%.*s' type=%hhu: <%s> <%s>", i, (int)len, str, type, str_hex(data.chk.ptr, data.chk.len), str_ctrl(data.chk.ptr, data.chk.len));
 
 			if ((len == STR_SIZE(SPOE_MSG_ARG_HDRS)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_ARG_HDRS)) == 0)) {
-				if (!LIST_ISEMPTY(&(mir->hdrs))) {
+				if (_nNULL(mir->hdrs)) {
 					f_log(frame, _E("arg[%d] '%.*s': Duplicated argument"), i, (int)len, str);
 
 					retval = FUNC_RET_ERROR;
 				}
 				else
-					retval = spoa_msg_arg_hdrs_bin(frame, data.chk.ptr, data.chk.ptr + data.chk.len - 1, &(mir->hdrs));
+					retval = spoa_msg_arg_hdrs_bin(frame, data.chk.ptr, data.chk.ptr + data.chk.len - 1, mir);
 			}
 			else if ((len == STR_SIZE(SPOE_MSG_ARG_BODY)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_ARG_BODY)) == 0)) {
-				if (_NULL(spoa_msg_arg_dup(frame, i, str, len, &data, &(mir->body), &(mir->body_size), "allocate memory for body")))
-					retval = FUNC_RET_ERROR;
+				retval = spoa_msg_arg_ref(frame, i, str, len, &data, &body);
 			}
 			else {
 				f_log(frame, _W("Unknown argument, ignored: '%.*s'"), (int)len, str);
@@ -549,15 +579,15 @@ int spoa_msg_mirror(struct spoe_frame *frame, const char **buf, const char *end)
 	if (_nERROR(retval) && _nNULL(cfg.mir_url)) {
 		retval = FUNC_RET_ERROR;
 
-		if (_NULL(mir->path))
+		if (_NULL(path.ptr))
 			f_log(frame, _E("HTTP path not set"));
-		else if (_NULL(mir->method))
+		else if (_NULL(method.ptr))
 			f_log(frame, _E("HTTP request method not set"));
-		else if (_NULL(mir->version))
+		else if (_NULL(version.ptr))
 			f_log(frame, _E("HTTP version not set"));
-		else if (LIST_ISEMPTY(&(mir->hdrs)))
+		else if (mir->hdrs_cnt == 0)
 			f_log(frame, _E("HTTP headers not set"));
-		else if (spoa_msg_url(frame, mir) != FUNC_RET_OK)
+		else if (spoa_msg_url(frame, mir, &path, &method, &version) != FUNC_RET_OK)
 			/* Do nothing. */;
 		else {
 #define CURL_HTTP_METHOD_DEF(a)   { #a, TABLESIZE_1(#a) },
@@ -574,10 +604,30 @@ int spoa_msg_mirror(struct spoe_frame *frame, const char **buf, const char *end)
 					break;
 				}
 
-			if (i < TABLESIZE(http_method))
-				retval = mir_curl_add(&(FW_PTR->curl), mir);
-			else
+			/*
+			 * The request body is not copied, the frame is kept
+			 * until the mirrored request is completed.
+			 */
+			if (_nNULL(body.ptr)) {
+				mir->body      = body.ptr;
+				mir->body_size = body.len;
+				mir->frame     = frame;
+				frame_ref(frame);
+			}
+
+			mir->t_submit = stats_hist_time();
+
+			if (i >= TABLESIZE(http_method))
 				f_log(frame, _E("Invalid HTTP request method"));
+			else if (cfg.mir_threads > 0)
+				retval = mir_sender_add(FW_PTR, mir);
+			else if (cfg.mir_engine == MIR_ENGINE_NATIVE)
+				retval = mir_http1_add(&(FW_PTR->http1), mir);
+			else
+				retval = mir_curl_add(&(FW_PTR->curl), mir);
+
+			if (_OK(retval))
+				STAT_INC(FW_PTR->stats.mir_submitted);
 		}
 	}
 
@@ -610,26 +660,18 @@ int spoa_msg_mirror(struct spoe_frame *frame, const char **buf, const char *end)
  */
 void mir_ptr_free(struct mirror **data)
 {
-	struct buffer *hdr = NULL, *hdr_back;
-
 	DBG_FUNC(NULL, "%p:%p", DPTR_ARGS(data));
 
 	if (_NULL(data) || _NULL(*data))
 		DBG_RETURN();
 
-	W_DBG(NOTICE, NULL, "freeing mirror { \"%s\" \"%s\" \"%s\" %d \"%s\" { %p %p } %p %zu/%zu }", (*data)->url, (*data)->path, (*data)->method, (*data)->request_method, (*data)->version, (*data)->hdrs.p, (*data)->hdrs.n, (*data)->body, (*data)->body_head, (*data)->body_size);
+	W_DBG(NOTICE, NULL, "freeing mirror { \"%s\" \"%s\" \"%s\" %d \"%s\" { %p %zu %d } %p %zu/%zu }", (*data)->url, (*data)->path, (*data)->method, (*data)->request_method, (*data)->version, (*data)->hdrs, (*data)->hdrs_len, (*data)->hdrs_cnt, (*data)->body, (*data)->body_head, (*data)->body_size);
 
 	PTR_FREE((*data)->url);
-	PTR_FREE((*data)->path);
-	PTR_FREE((*data)->method);
-	PTR_FREE((*data)->version);
-
-	list_for_each_entry_safe(hdr, hdr_back, &((*data)->hdrs), list) {
-		LIST_DEL(&(hdr->list));
-		buffer_ptr_free(&hdr);
-	}
+	PTR_FREE((*data)->hdrs);
 
-	PTR_FREE((*data)->body);
+	if (_nNULL((*data)->frame))
+		frame_unref((*data)->frame);
 	PTR_FREE(*data);
 
 	DBG_RETURN();
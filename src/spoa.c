@@ -62,6 +62,161 @@ int acc_payload(struct spoe_frame *frame)
 }
 
 
+/***
+ * NAME
+ *   frame_pool_size -
+ *
+ * ARGUMENTS
+ *   idx - the frame pool size class
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the payload size of the frames of the given size class.
+ */
+static size_t frame_pool_size(uint idx)
+{
+	if (idx >= (SPOA_FRM_POOL_CLASSES - 1))
+		return cfg.max_frame_size;
+
+	return MIN((size_t)SPOA_FRM_POOL_MIN_SIZE << (2 * idx), cfg.max_frame_size);
+}
+
+
+/***
+ * NAME
+ *   frame_pool_class -
+ *
+ * ARGUMENTS
+ *   size -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the smallest frame pool size class that can hold a frame payload
+ *   of the given size.
+ */
+static uint frame_pool_class(size_t size)
+{
+	uint retval;
+
+	for (retval = 0; retval < (SPOA_FRM_POOL_CLASSES - 1); retval++)
+		if (size <= frame_pool_size(retval))
+			break;
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   frame_pool_init -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void frame_pool_init(struct worker *worker)
+{
+	int i;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	for (i = 0; i < SPOA_FRM_POOL_CLASSES; i++) {
+		LIST_INIT(&(worker->frame_pool[i].frames));
+		worker->frame_pool[i].nbfree     = 0;
+		worker->frame_pool[i].nbfree_min = 0;
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   frame_pool_trim -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Releases the free frames that have not been needed since the previous
+ *   trimming, so that the pools shrink again after a load spike.  The least
+ *   recently used frames are released first.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void frame_pool_trim(struct worker *worker)
+{
+	struct spoa_frame_pool *pool;
+	struct spoe_frame      *frame;
+	uint                    n;
+	int                     i;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	for (i = 0; i < SPOA_FRM_POOL_CLASSES; i++) {
+		pool = worker->frame_pool + i;
+
+		for (n = pool->nbfree_min; (n > SPOA_FRM_POOL_FREE_KEEP) && !LIST_ISEMPTY(&(pool->frames)); n--) {
+			frame = LIST_PREV(&(pool->frames), typeof(frame), list);
+			LIST_DEL(&(frame->list));
+			free(frame);
+			STAT_ADD(pool->nbfree, -1);
+		}
+
+		if (pool->nbfree_min > SPOA_FRM_POOL_FREE_KEEP)
+			W_DBG(WORKER, worker, "Frame pool %d (%zu bytes) trimmed to %u free frames", i, frame_pool_size(i), pool->nbfree);
+
+		pool->nbfree_min = pool->nbfree;
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   frame_pool_free -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void frame_pool_free(struct worker *worker)
+{
+	struct spoe_frame *frame, *fback;
+	int                i;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	for (i = 0; i < SPOA_FRM_POOL_CLASSES; i++) {
+		list_for_each_entry_safe(frame, fback, &(worker->frame_pool[i].frames), list) {
+			LIST_DEL(&(frame->list));
+			free(frame);
+		}
+
+		worker->frame_pool[i].nbfree     = 0;
+		worker->frame_pool[i].nbfree_min = 0;
+	}
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   release_frame -
@@ -75,25 +230,92 @@ int acc_payload(struct spoe_frame *frame)
  * RETURN VALUE
  *   This function does not return a value.
  */
-static void release_frame(struct spoe_frame *frame)
+void release_frame(struct spoe_frame *frame)
 {
-	struct worker *w;
+	struct spoa_frame_pool *pool;
+	struct worker          *w;
+	uint8_t                 pool_class;
+	size_t                  size;
 
 	DBG_FUNC(STRUCT_ELEM_SAFE(frame, worker, NULL), "%p", frame);
 
 	if (_NULL(frame))
 		DBG_RETURN();
 
-	if (ev_is_active(&(frame->ev_process_frame)) || ev_is_pending(&(frame->ev_process_frame))) {
+	if (ev_is_active(&(frame->ev_process_frame)) || ev_is_pending(&(frame->ev_process_frame)))
 		ev_timer_stop(FW_PTR->ev_base, &(frame->ev_process_frame));
-		ev_async_send(FW_PTR->ev_base, &(FW_PTR->ev_async));
-	}
 
 	w = FW_PTR;
+	(void)__atomic_sub_fetch(&(w->nbinflight), 1, __ATOMIC_RELAXED);
 	LIST_DEL(&(frame->list));
 	buffer_free(&(frame->frag));
-	(void)memset(frame, 0, sizeof(*frame) + cfg.max_frame_size + SPOA_FRM_LEN);
-	LIST_ADDQ(&(w->frames), &(frame->list));
+
+	pool = w->frame_pool + frame->pool_class;
+	if (pool->nbfree >= SPOA_FRM_POOL_FREE_MAX) {
+		free(frame);
+
+		DBG_RETURN();
+	}
+
+	/* Only the frame header is reset, the payload is always written first. */
+	pool_class = frame->pool_class;
+	size       = frame->size;
+	(void)memset(frame, 0, sizeof(*frame));
+	frame->pool_class = pool_class;
+	frame->size       = size;
+
+	LIST_ADD(&(pool->frames), &(frame->list));
+	STAT_INC(pool->nbfree);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   frame_ref -
+ *
+ * ARGUMENTS
+ *   frame -
+ *
+ * DESCRIPTION
+ *   Takes a reference to the payload of the frame, so that the data decoded
+ *   from it can be used without being copied.  While the frame is processed,
+ *   the processing itself holds one reference.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void frame_ref(struct spoe_frame *frame)
+{
+	DBG_FUNC(FW_PTR, "%p", frame);
+
+	frame->refcnt++;
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   frame_unref -
+ *
+ * ARGUMENTS
+ *   frame -
+ *
+ * DESCRIPTION
+ *   Drops a reference to the payload of the frame.  The frame is released
+ *   when its last reference is dropped.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void frame_unref(struct spoe_frame *frame)
+{
+	DBG_FUNC(FW_PTR, "%p", frame);
+
+	if (--(frame->refcnt) == 0)
+		release_frame(frame);
 
 	DBG_RETURN();
 }
@@ -158,7 +380,6 @@ static void unuse_spoe_engine(struct client *client)
 void release_client(struct client *client)
 {
 	struct spoe_frame *f, *fback;
-	bool_t             flag_ev_async_send = 0;
 
 	DBG_FUNC(CW_PTR, "%p", client);
 
@@ -168,21 +389,15 @@ void release_client(struct client *client)
 	C_DBG(SPOA, client, "Release client");
 
 	LIST_DEL(&(client->by_worker));
-	CW_PTR->nbclients--;
+	(void)__atomic_sub_fetch(&(CW_PTR->nbclients), 1, __ATOMIC_RELAXED);
 
 	unuse_spoe_engine(client);
 	PTR_FREE(client->engine_id);
 
-	if (ev_is_active(&(client->ev_frame_rd)) || ev_is_pending(&(client->ev_frame_rd))) {
+	if (ev_is_active(&(client->ev_frame_rd)) || ev_is_pending(&(client->ev_frame_rd)))
 		ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_rd));
-		flag_ev_async_send = 1;
-	}
-	if (ev_is_active(&(client->ev_frame_wr)) || ev_is_pending(&(client->ev_frame_wr))) {
+	if (ev_is_active(&(client->ev_frame_wr)) || ev_is_pending(&(client->ev_frame_wr)))
 		ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_wr));
-		flag_ev_async_send = 1;
-	}
-	if (flag_ev_async_send)
-		ev_async_send(CW_PTR->ev_base, &(CW_PTR->ev_async));
 
 	release_frame(client->incoming_frame);
 	release_frame(client->outgoing_frame);
@@ -191,6 +406,14 @@ void release_client(struct client *client)
 	list_for_each_entry_safe(f, fback, &(client->outgoing_frames), list)
 		release_frame(f);
 
+	buffer_free(&(client->rd_buf));
+
+#ifdef HAVE_LIBURING
+	/* The client is freed when its io_uring operations are completed. */
+	if (client->uring.active && uring_client_release(client))
+		DBG_RETURN();
+#endif
+
 	FD_CLOSE(client->fd);
 	PTR_FREE(client);
 
@@ -225,6 +448,7 @@ static void reset_frame(struct spoe_frame *frame)
 	frame->frame_id   = 0;
 	frame->hcheck     = false;
 	frame->fragmented = false;
+	frame->refcnt     = 0;
 	SPOE_FRAME_BUFFER_SET(frame, frame->data, 0, 0, 0);
 	LIST_INIT(&(frame->list));
 
@@ -232,6 +456,132 @@ static void reset_frame(struct spoe_frame *frame)
 }
 
 
+/***
+ * NAME
+ *   client_rd_start -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Resumes the reading of the client frames.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void client_rd_start(struct client *client)
+{
+#ifdef HAVE_LIBURING
+	if (client->uring.active) {
+		client->uring.rd_stopped = 0;
+
+		if (uring_recv_pending(client))
+			ev_feed_event(CW_PTR->ev_base, &(client->ev_frame_rd), EV_CUSTOM);
+
+		return;
+	}
+#endif
+
+	ev_io_start(CW_PTR->ev_base, &(client->ev_frame_rd));
+}
+
+
+/***
+ * NAME
+ *   client_rd_stop -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Suspends the reading of the client frames.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void client_rd_stop(struct client *client)
+{
+#ifdef HAVE_LIBURING
+	if (client->uring.active)
+		client->uring.rd_stopped = 1;
+#endif
+
+	ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_rd));
+}
+
+
+/***
+ * NAME
+ *   client_rd_active -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns true if the reading of the client frames is not suspended.
+ */
+static bool_t client_rd_active(const struct client *client)
+{
+#ifdef HAVE_LIBURING
+	if (client->uring.active)
+		return !client->uring.rd_stopped;
+#endif
+
+	return ev_is_active(&(client->ev_frame_rd));
+}
+
+
+/***
+ * NAME
+ *   client_wr_start -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Starts sending the outgoing client frames.  With the io_uring transport
+ *   there is no need to wait for the socket to become writable, so the write
+ *   callback function is only scheduled.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void client_wr_start(struct client *client)
+{
+#ifdef HAVE_LIBURING
+	if (client->uring.active) {
+		ev_feed_event(CW_PTR->ev_base, &(client->ev_frame_wr), EV_CUSTOM);
+
+		return;
+	}
+#endif
+
+	ev_io_start(CW_PTR->ev_base, &(client->ev_frame_wr));
+}
+
+
+/***
+ * NAME
+ *   client_wr_stop -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void client_wr_stop(struct client *client)
+{
+	ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_wr));
+}
+
+
 /***
  * NAME
  *   write_frame -
@@ -248,8 +598,6 @@ static void reset_frame(struct spoe_frame *frame)
  */
 static void write_frame(struct client *client, struct spoe_frame *frame)
 {
-	bool_t flag_ev_async_send = 0;
-
 	DBG_FUNC(STRUCT_ELEM_SAFE(client, worker, NULL), "%p, %p", client, frame);
 
 	LIST_DEL(&(frame->list));
@@ -260,7 +608,7 @@ static void write_frame(struct client *client, struct spoe_frame *frame)
 
 	if (_nNULL(client)) {
 		/* HELLO or DISCONNECT frames. */
-		ev_io_start(CW_PTR->ev_base, &(client->ev_frame_wr));
+		client_wr_start(client);
 
 		/*
 		 * Try to process the frame as soon as possible, and always
@@ -273,35 +621,353 @@ static void write_frame(struct client *client, struct spoe_frame *frame)
 				LIST_ADD(&(client->outgoing_frames), &(frame->list));
 		} else {
 			client->outgoing_frame = frame;
-			ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_rd));
+			client_rd_stop(client);
 		}
-
-		flag_ev_async_send = 1;
 	} else {
 		/* For all other frames. */
 		if (_NULL(FC_PTR)) {
 			/* async mode! */
 			LIST_ADDQ(&(frame->engine->outgoing_frames), &(frame->list));
-			list_for_each_entry(client, &(frame->engine->clients), by_engine) {
-				ev_io_start(CW_PTR->ev_base, &(client->ev_frame_wr));
-				flag_ev_async_send = 1;
-			}
+			list_for_each_entry(client, &(frame->engine->clients), by_engine)
+				client_wr_start(client);
 		}
 		else if (FC_PTR->pipelining) {
 			LIST_ADDQ(&(FC_PTR->outgoing_frames), &(frame->list));
-			ev_io_start(FC_PTR->worker->ev_base, &(FC_PTR->ev_frame_wr));
-			flag_ev_async_send = 1;
+			client_wr_start(FC_PTR);
 		}
 		else {
 			FC_PTR->outgoing_frame = frame;
-			ev_io_start(FC_PTR->worker->ev_base, &(FC_PTR->ev_frame_wr));
-			ev_io_stop(FC_PTR->worker->ev_base, &(FC_PTR->ev_frame_rd));
-			flag_ev_async_send = 1;
+			client_wr_start(FC_PTR);
+			client_rd_stop(FC_PTR);
 		}
 	}
 
-	if (flag_ev_async_send)
-		ev_async_send(FW_PTR->ev_base, &(FW_PTR->ev_async));
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   frame_pool_get -
+ *
+ * ARGUMENTS
+ *   worker -
+ *   size   - the required frame payload size
+ *
+ * DESCRIPTION
+ *   Takes a frame from the worker frame pool of the size class that can hold
+ *   the payload, or allocates a new one if the pool is empty.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct spoe_frame *frame_pool_get(struct worker *worker, size_t size)
+{
+	struct spoa_frame_pool *pool;
+	struct spoe_frame      *frame;
+	uint                    idx;
+
+	DBG_FUNC(worker, "%p, %zu", worker, size);
+
+	idx  = frame_pool_class(size);
+	pool = worker->frame_pool + idx;
+
+	if (LIST_ISEMPTY(&(pool->frames))) {
+		if (_NULL(frame = malloc(sizeof(*frame) + frame_pool_size(idx) + SPOA_FRM_LEN))) {
+			w_log(worker, _E("Failed to allocate new frame: %m"));
+
+			DBG_RETURN_PTR(NULL);
+		}
+
+		(void)memset(frame, 0, sizeof(*frame));
+		frame->pool_class = idx;
+		frame->size       = frame_pool_size(idx);
+	} else {
+		frame = LIST_NEXT(&(pool->frames), typeof(frame), list);
+		LIST_DEL(&(frame->list));
+
+		STAT_ADD(pool->nbfree, -1);
+		if (pool->nbfree < pool->nbfree_min)
+			pool->nbfree_min = pool->nbfree;
+	}
+
+	(void)__atomic_add_fetch(&(worker->nbinflight), 1, __ATOMIC_RELAXED);
+
+	reset_frame(frame);
+	FW_PTR = worker;
+
+	DBG_RETURN_PTR(frame);
+}
+
+
+/***
+ * NAME
+ *   frame_detach -
+ *
+ * ARGUMENTS
+ *   frame -
+ *
+ * DESCRIPTION
+ *   Replaces a processed frame whose payload is still referenced with a new
+ *   small frame, which takes its place in the frame lists and is used for
+ *   the reply.  The original frame is released when its last reference is
+ *   dropped.
+ *
+ * RETURN VALUE
+ *   Returns the new frame, or NULL in case of the error.
+ */
+static struct spoe_frame *frame_detach(struct spoe_frame *frame)
+{
+	struct spoe_frame *retval;
+
+	DBG_FUNC(FW_PTR, "%p", frame);
+
+	if (_NULL(retval = frame_pool_get(FW_PTR, 0)))
+		DBG_RETURN_PTR(retval);
+
+	retval->type      = frame->type;
+	retval->stream_id = frame->stream_id;
+	retval->frame_id  = frame->frame_id;
+	retval->t_recv    = frame->t_recv;
+	retval->engine    = frame->engine;
+	retval->client    = frame->client;
+
+	LIST_ADD(&(frame->list), &(retval->list));
+	LIST_DEL(&(frame->list));
+	LIST_INIT(&(frame->list));
+
+	DBG_RETURN_PTR(retval);
+}
+
+
+/***
+ * NAME
+ *   process_frame_msgs -
+ *
+ * ARGUMENTS
+ *   frame    -
+ *   ip_score -
+ *
+ * DESCRIPTION
+ *   Processes the messages of the frame.  If ip_score is NULL, only the
+ *   mirror messages of an already acknowledged frame are processed.
+ *   Otherwise, in the ACK-first mode the mirror messages are skipped, so
+ *   that they can be processed after the frame is acknowledged.
+ *
+ * RETURN VALUE
+ *   Returns true if there are mirror messages left to be processed later.
+ */
+static bool_t process_frame_msgs(struct spoe_frame *frame, int *ip_score)
+{
+	const char *ptr, *str, *end;
+	uint64_t    len;
+	int         rc = FUNC_RET_OK;
+	bool_t      retval = 0;
+
+	DBG_FUNC(FW_PTR, "%p, %p", frame, ip_score);
+
+	ptr = frame->buf + frame->offset;
+	end = frame->buf + frame->len;
+
+	/* Loop on messages. */
+	while (_nERROR(rc) && (ptr < end)) {
+		/* Decode the message name. */
+		rc = spoe_decode(frame, &ptr, end, SPOE_DEC_STR0, &str, &len, SPOE_DEC_END);
+		if (_ERROR(rc) || _NULL(str))
+			break;
+
+		F_DBG(SPOA, frame, "Process SPOE Message '%.*s'", (int)len, str);
+
+		if ((len == STR_SIZE(SPOE_MSG_MIRROR)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_MIRROR)) == 0)) {
+			if (_nNULL(ip_score) && (cfg.opt_flags & FLAG_OPT_ACK_FIRST)) {
+				retval = 1;
+				rc     = 0;
+			}
+			else {
+				rc = spoa_msg_mirror(frame, &ptr, end);
+			}
+		}
+		else if (_NULL(ip_score))
+			rc = 0;
+		else if ((len == STR_SIZE(SPOE_MSG_IPREP)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_IPREP)) == 0))
+			rc = spoa_msg_iprep(frame, &ptr, end, ip_score);
+		else if ((len == STR_SIZE(SPOE_MSG_TEST)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_TEST)) == 0))
+			rc = spoa_msg_test(frame, &ptr, end);
+		else
+			rc = 0;
+
+		if (rc == 0)
+			rc = spoe_decode_skip_msg(frame, &ptr, end);
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   frame_defer -
+ *
+ * ARGUMENTS
+ *   frame -
+ *
+ * DESCRIPTION
+ *   Queues the frame for the processing of its mirror messages.  The frame
+ *   keeps the reference taken by the caller until it is processed.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void frame_defer(struct spoe_frame *frame)
+{
+	DBG_FUNC(FW_PTR, "%p", frame);
+
+	/* The frame is already detached from the client, which may go away. */
+	FC_PTR = NULL;
+	LIST_ADDQ(&(FW_PTR->deferred_frames), &(frame->list));
+
+	if (!ev_is_active(&(FW_PTR->ev_deferred))) {
+		ev_check_start(FW_PTR->ev_base, &(FW_PTR->ev_deferred));
+		ev_idle_start(FW_PTR->ev_base, &(FW_PTR->ev_deferred_idle));
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   process_deferred_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Processes the mirror messages of the frames deferred in the previous
+ *   loop iteration.  The watcher has the lowest priority, so it is called
+ *   after the ACK frames of that iteration had the chance to be written.
+ *   While there are deferred frames the idle watcher keeps the loop from
+ *   blocking.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void process_deferred_cb(struct ev_loop *loop, struct ev_check *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(worker, w, ev_deferred);
+	struct spoe_frame *frame, *fback;
+
+	DBG_FUNC(w, "%p, %p, 0x%08x", loop, ev, revents);
+
+	list_for_each_entry_safe(frame, fback, &(w->deferred_ready), list) {
+		LIST_DEL(&(frame->list));
+		LIST_INIT(&(frame->list));
+
+		(void)process_frame_msgs(frame, NULL);
+		frame_unref(frame);
+	}
+
+	if (LIST_ISEMPTY(&(w->deferred_frames))) {
+		ev_check_stop(loop, &(w->ev_deferred));
+		ev_idle_stop(loop, &(w->ev_deferred_idle));
+	} else {
+		/* Move all deferred frames to the (now empty) ready list. */
+		LIST_ADD(&(w->deferred_frames), &(w->deferred_ready));
+		LIST_DEL(&(w->deferred_frames));
+		LIST_INIT(&(w->deferred_frames));
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   process_deferred_idle_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void process_deferred_idle_cb(struct ev_loop *loop __maybe_unused, struct ev_idle *ev __maybe_unused, int revents __maybe_unused)
+{
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   frame_defer_init -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void frame_defer_init(struct worker *worker)
+{
+	DBG_FUNC(worker, "%p", worker);
+
+	LIST_INIT(&(worker->deferred_frames));
+	LIST_INIT(&(worker->deferred_ready));
+
+	ev_check_init(&(worker->ev_deferred), process_deferred_cb);
+	ev_set_priority(&(worker->ev_deferred), EV_MINPRI);
+	ev_idle_init(&(worker->ev_deferred_idle), process_deferred_idle_cb);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   frame_defer_free -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Releases the deferred frames without processing them.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void frame_defer_free(struct worker *worker)
+{
+	struct spoe_frame *frame, *fback;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	list_for_each_entry_safe(frame, fback, &(worker->deferred_ready), list) {
+		LIST_DEL(&(frame->list));
+		LIST_INIT(&(frame->list));
+		frame_unref(frame);
+	}
+	list_for_each_entry_safe(frame, fback, &(worker->deferred_frames), list) {
+		LIST_DEL(&(frame->list));
+		LIST_INIT(&(frame->list));
+		frame_unref(frame);
+	}
+
+	if (_nNULL(worker->ev_base)) {
+		ev_check_stop(worker->ev_base, &(worker->ev_deferred));
+		ev_idle_stop(worker->ev_base, &(worker->ev_deferred_idle));
+	}
 
 	DBG_RETURN();
 }
@@ -325,42 +991,54 @@ static void write_frame(struct client *client, struct spoe_frame *frame)
 static void process_frame_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev, int revents __maybe_unused)
 {
 	STRUCT_ADDR(spoe_frame, frame, ev_process_frame);
-	const char *ptr, *str, *end;
-	char       *buf;
-	uint64_t    len;
-	int         rc = FUNC_RET_OK, ip_score = SPOE_MSG_IPREP_UNSET;
+	struct spoe_frame *ack;
+	char              *buf;
+	uint64_t           now;
+	int                rc, ip_score = SPOE_MSG_IPREP_UNSET;
+	bool_t             flag_defer;
 
 	DBG_FUNC(FW_PTR, "%p, %p, 0x%08x", loop, ev, revents);
 
 	FW_PTR->nbframes++;
+	now = stats_hist_since(FW_PTR->stats.hist + STATS_HIST_DELAY, frame->t_sched);
 
 	F_DBG(SPOA, frame,
 	      "Process frame messages: stream-id=%u - frame-id=%u - length=%zu bytes",
 	      frame->stream_id, frame->frame_id, frame->len - frame->offset);
 
-	ptr = frame->buf + frame->offset;
-	end = frame->buf + frame->len;
+	frame_ref(frame);
 
-	/* Loop on messages. */
-	while (_nERROR(rc) && (ptr < end)) {
-		/* Decode the message name. */
-		rc = spoe_decode(frame, &ptr, end, SPOE_DEC_STR0, &str, &len, SPOE_DEC_END);
-		if (_ERROR(rc) || _NULL(str))
-			break;
+	/* The deferred processing of the mirror messages holds a reference too. */
+	flag_defer = process_frame_msgs(frame, &ip_score);
+	if (flag_defer)
+		frame_ref(frame);
 
-		F_DBG(SPOA, frame, "Process SPOE Message '%.*s'", (int)len, str);
+	(void)stats_hist_since(FW_PTR->stats.hist + STATS_HIST_MESSAGES, now);
 
-		if ((len == STR_SIZE(SPOE_MSG_IPREP)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_IPREP)) == 0))
-			rc = spoa_msg_iprep(frame, &ptr, end, &ip_score);
-		else if ((len == STR_SIZE(SPOE_MSG_TEST)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_TEST)) == 0))
-			rc = spoa_msg_test(frame, &ptr, end);
-		else if ((len == STR_SIZE(SPOE_MSG_MIRROR)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_MIRROR)) == 0))
-			rc = spoa_msg_mirror(frame, &ptr, end);
-		else
-			rc = 0;
+	/*
+	 * If the mirrored requests still use the frame payload, the ACK frame
+	 * cannot overwrite it and a new frame is used instead.
+	 */
+	if (frame->refcnt == 1) {
+		frame->refcnt = 0;
+	}
+	else if (_NULL(ack = frame_detach(frame))) {
+		/* The stream will time out on the HAProxy side. */
+		LIST_DEL(&(frame->list));
+		LIST_INIT(&(frame->list));
+		if (_nNULL(FC_PTR) && !FC_PTR->pipelining)
+			client_rd_start(FC_PTR);
+		if (flag_defer)
+			frame_defer(frame);
+		frame_unref(frame);
 
-		if (rc == 0)
-			rc = spoe_decode_skip_msg(frame, &ptr, end);
+		DBG_RETURN();
+	}
+	else {
+		if (flag_defer)
+			frame_defer(frame);
+		frame_unref(frame);
+		frame = ack;
 	}
 
 	/* Prepare agent ACK frame. */
@@ -382,35 +1060,34 @@ static void process_frame_cb(struct ev_loop *loop __maybe_unused, struct ev_time
  *
  * ARGUMENTS
  *   client -
+ *   size   - the required frame payload size
  *
  * DESCRIPTION
- *   -
+ *   Returns the current incoming frame of the client, or a frame taken from
+ *   the worker frame pool of the size class that can hold the payload.  The
+ *   current incoming frame is replaced if it is too small, unless it holds
+ *   a partially received fragmented frame.
  *
  * RETURN VALUE
  *   -
  */
-static struct spoe_frame *acquire_incoming_frame(struct client *client)
+static struct spoe_frame *acquire_incoming_frame(struct client *client, size_t size)
 {
 	struct spoe_frame *frame;
 
-	DBG_FUNC(CW_PTR, "%p", client);
-
-	if (_nNULL(client->incoming_frame))
-		DBG_RETURN_PTR(client->incoming_frame);
+	DBG_FUNC(CW_PTR, "%p, %zu", client, size);
 
-	if (LIST_ISEMPTY(&(CW_PTR->frames))) {
-		if (_NULL(frame = calloc(1, sizeof(*frame) + cfg.max_frame_size + SPOA_FRM_LEN))) {
-			c_log(client, _E("Failed to allocate new frame: %m"));
+	if (_nNULL(client->incoming_frame)) {
+		if ((client->incoming_frame->size >= size) || client->incoming_frame->fragmented)
+			DBG_RETURN_PTR(client->incoming_frame);
 
-			DBG_RETURN_PTR(NULL);
-		}
-	} else {
-		frame = LIST_NEXT(&(CW_PTR->frames), typeof(frame), list);
-		LIST_DEL(&(frame->list));
+		release_frame(client->incoming_frame);
+		client->incoming_frame = NULL;
 	}
 
-	reset_frame(frame);
-	FW_PTR        = CW_PTR;
+	if (_NULL(frame = frame_pool_get(CW_PTR, size)))
+		DBG_RETURN_PTR(NULL);
+
 	frame->engine = client->engine;
 	FC_PTR        = client;
 
@@ -447,11 +1124,13 @@ static struct spoe_frame *acquire_outgoing_frame(struct client *client)
 	else if (!LIST_ISEMPTY(&(client->outgoing_frames))) {
 		frame = LIST_NEXT(&(client->outgoing_frames), typeof(frame), list);
 		LIST_DEL(&(frame->list));
+		LIST_INIT(&(frame->list));
 		client->outgoing_frame = frame;
 	}
 	else if (_nNULL(client->engine) && !LIST_ISEMPTY(&(client->engine->outgoing_frames))) {
 		frame = LIST_NEXT(&(client->engine->outgoing_frames), typeof(frame), list);
 		LIST_DEL(&(frame->list));
+		LIST_INIT(&(frame->list));
 		client->outgoing_frame = frame;
 	}
 
@@ -467,7 +1146,10 @@ static struct spoe_frame *acquire_outgoing_frame(struct client *client)
  *   frame -
  *
  * DESCRIPTION
- *   -
+ *   Schedules the processing of a decoded frame.  Without a processing delay
+ *   the frame timer is not armed; its callback is queued directly among the
+ *   pending watchers of the worker loop and is invoked in the same loop
+ *   iteration, without going through the timer heap.
  *
  * RETURN VALUE
  *   This function does not return a value.
@@ -476,7 +1158,10 @@ static void process_incoming_frame(struct spoe_frame *frame)
 {
 	DBG_FUNC(FW_PTR, "%p", frame);
 
-	ev_timer_start(FW_PTR->ev_base, &(frame->ev_process_frame));
+	if (cfg.processing_delay_us == 0)
+		ev_feed_event(FW_PTR->ev_base, &(frame->ev_process_frame), EV_TIMER);
+	else
+		ev_timer_start(FW_PTR->ev_base, &(frame->ev_process_frame));
 
 	if (FC_PTR->async) {
 		FC_PTR = NULL;
@@ -486,65 +1171,156 @@ static void process_incoming_frame(struct spoe_frame *frame)
 		LIST_ADDQ(&(FC_PTR->processing_frames), &(frame->list));
 	}
 	else {
-		ev_io_stop(FC_PTR->worker->ev_base, &(FC_PTR->ev_frame_rd));
+		client_rd_stop(FC_PTR);
 	}
 
-	ev_async_send(FW_PTR->ev_base, &(FW_PTR->ev_async));
-
 	DBG_RETURN();
 }
 
 
 /***
  * NAME
- *   frame_recv -
+ *   frame_recv_pending -
  *
  * ARGUMENTS
- *   frame -
+ *   client -
  *
  * DESCRIPTION
+ *   Checks whether there is a complete frame in the client receive buffer.
+ *
+ * RETURN VALUE
  *   -
+ */
+static __always_inline bool_t frame_recv_pending(const struct client *client)
+{
+	uint32_t len;
+
+	if ((client->rd_buf.len - client->rd_head) < SPOA_FRM_LEN)
+		return 0;
+
+	(void)memcpy(&len, client->rd_buf.ptr + client->rd_head, sizeof(len));
+
+	return (client->rd_buf.len - client->rd_head - SPOA_FRM_LEN) >= ntohl(len);
+}
+
+
+/***
+ * NAME
+ *   client_rd_pending -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Checks whether there is received data that the client has not processed
+ *   yet.
  *
  * RETURN VALUE
  *   -
  */
-static ssize_t frame_recv(struct spoe_frame *frame)
+static bool_t client_rd_pending(const struct client *client)
 {
-	ssize_t retval = FUNC_RET_ERROR;
+#ifdef HAVE_LIBURING
+	if (client->uring.active && uring_recv_pending(client))
+		return 1;
+#endif
 
-	DBG_FUNC(FW_PTR, "%p", frame);
+	return frame_recv_pending(client);
+}
 
-	if (_NULL(frame))
+
+/***
+ * NAME
+ *   frame_recv -
+ *
+ * ARGUMENTS
+ *   client -
+ *   frame  -
+ *
+ * DESCRIPTION
+ *   Takes the next complete frame from the client receive buffer.  The frame
+ *   payload is copied to a frame of its own: the frame outlives the receive
+ *   buffer contents (it waits for processing, the mirrors refer to its data
+ *   and the answer is encoded in it), while the buffer is compacted before
+ *   each receive.
+ *
+ * RETURN VALUE
+ *   Returns the number of bytes taken from the buffer, 0 if there is no
+ *   complete frame in the buffer, or FUNC_RET_ERROR (-1) in case of the
+ *   error.
+ */
+static ssize_t frame_recv(struct client *client, struct spoe_frame **frame)
+{
+	struct spoe_frame *f;
+	const uint8_t     *ptr;
+	size_t             avail, size;
+	uint32_t           len, flags;
+	ssize_t            retval = 0;
+
+	DBG_FUNC(CW_PTR, "%p, %p", client, frame);
+
+	avail = client->rd_buf.len - client->rd_head;
+	ptr   = client->rd_buf.ptr + client->rd_head;
+	if (avail < SPOA_FRM_LEN)
 		DBG_RETURN_SSIZE(retval);
 
-	C_DBG(SPOA, FC_PTR, "--> Receiving data");
+	(void)memcpy(&len, ptr, sizeof(len));
+	len = ntohl(len);
 
-	if (frame->buf == frame->data) {
-		frame->type = SPOA_FRM_T_HAPROXY;
+	if (len > client->max_frame_size) {
+		/* The rest of the data cannot be used anymore. */
+		c_log(client, _E("Frame of %u bytes exceeds the maximum frame size"), len);
 
-		/*
-		 * Receive the frame length:
-		 *   frame->buf points on length part (frame->data)
-		 */
-		retval = tcp_recv(frame, SPOA_FRM_LEN, " length");
-		if (retval == SPOA_FRM_LEN) {
-			frame->len  = ntohl(*(uint32_t *)frame->buf);
-			frame->buf += SPOA_FRM_LEN;
-		} else {
-			DBG_RETURN_SSIZE((retval > 0) ? 0 : retval);
-		}
+		client->status_code = SPOE_FRM_ERR_TOO_BIG;
+		len                 = 0;
+		avail               = client->rd_buf.len - client->rd_head;
+	}
+	else if ((avail - SPOA_FRM_LEN) < len) {
+		DBG_RETURN_SSIZE(retval);
+	}
+	else {
+		avail = SPOA_FRM_LEN + len;
 	}
 
 	/*
-	 * Receive the frame data:
-	 *   frame->buf points on frame part (frame->data + SPOA_FRM_LEN)
+	 * The first fragment of a fragmented frame is used to receive all the
+	 * following fragments as well, so it needs a frame of the maximum size.
 	 */
-	retval = tcp_recv(frame, frame->len, " data");
-	if (retval == (typeof(retval))frame->len)
-		C_DBG(SPOA, FC_PTR, "New frame of %zu bytes received: <%s> <%s>",
-		      frame->len, str_hex(frame->buf, frame->len), str_ctrl(frame->buf, frame->len));
-	else
-		retval = (retval > 0) ? 0 : retval;
+	size = len;
+	if ((len >= (1 + sizeof(flags))) && (ptr[SPOA_FRM_LEN] == SPOE_FRM_T_HAPROXY_NOTIFY)) {
+		(void)memcpy(&flags, ptr + SPOA_FRM_LEN + 1, sizeof(flags));
+		if (!(ntohl(flags) & SPOE_FRM_FL_FIN))
+			size = client->max_frame_size;
+	}
+
+	if (_NULL(f = acquire_incoming_frame(client, size)))
+		DBG_RETURN_SSIZE(FUNC_RET_ERROR);
+
+	if (len > f->size) {
+		c_log(client, _E("Frame of %u bytes exceeds the size of the fragmented frame"), len);
+
+		client->status_code = SPOE_FRM_ERR_TOO_BIG;
+		len                 = 0;
+	}
+
+	f->type   = SPOA_FRM_T_HAPROXY;
+	f->buf    = f->data + SPOA_FRM_LEN;
+	f->offset = 0;
+	f->len    = len;
+	(void)memcpy(f->buf, ptr + SPOA_FRM_LEN, len);
+
+	/* A fragmented frame is received when its first fragment is. */
+	if (!f->fragmented)
+		f->t_recv = stats_hist_time();
+
+	client->rd_head += avail;
+	*frame           = f;
+	retval           = avail;
+
+	STAT_ADD(CW_PTR->stats.bytes_rcvd, avail);
+
+	C_DBG(SPOA, client, "New frame of %zu bytes received: <%s> <%s>",
+	      f->len, str_hex(f->buf, f->len), str_ctrl(f->buf, f->len));
 
 	DBG_RETURN_SSIZE(retval);
 }
@@ -552,39 +1328,33 @@ static ssize_t frame_recv(struct spoe_frame *frame)
 
 /***
  * NAME
- *   read_frame_cb -
+ *   dispatch_frame -
  *
  * ARGUMENTS
- *   loop    -
- *   ev      -
- *   revents -
+ *   client -
+ *   f      -
  *
  * DESCRIPTION
  *   -
  *
  * RETURN VALUE
- *   This function does not return a value.
+ *   Returns FUNC_RET_ERROR (-1) if the client has been released,
+ *   otherwise FUNC_RET_OK (0).
  */
-void read_frame_cb(struct ev_loop *loop __maybe_unused, ev_io *ev, int revents __maybe_unused)
+static int dispatch_frame(struct client *client, struct spoe_frame *f)
 {
-	STRUCT_ADDR(client, client, ev_frame_rd);
-	struct spoe_frame *f;
-	ssize_t            n;
-
-	DBG_FUNC(CW_PTR, "%p, %p, 0x%08x", loop, ev, revents);
+	uint64_t now;
+	int      n;
 
-	f = acquire_incoming_frame(client);
-	n = frame_recv(f);
-	if (n <= 0) {
-		if (_ERROR(n))
-			release_client(client);
+	DBG_FUNC(CW_PTR, "%p, %p", client, f);
 
-		DBG_RETURN();
-	}
+	if (client->status_code == SPOE_FRM_ERR_TOO_BIG)
+		goto disconnect;
 
 	if (client->state == SPOA_ST_CONNECTING) {
 		if (handle_hahello(f) < 0) {
 			c_log(client, _E("Failed to decode HELLO frame"));
+			STAT_INC(CW_PTR->stats.decode_errors);
 
 			goto disconnect;
 		}
@@ -600,33 +1370,39 @@ void read_frame_cb(struct ev_loop *loop __maybe_unused, ev_io *ev, int revents _
 			goto disconnecting;
 		}
 
+		now = stats_hist_time();
 		if (f->buf[0] == SPOE_FRM_T_UNSET)
 			n = handle_hafrag(f);
 		else
 			n = handle_hanotify(f);
+		now = stats_hist_since(CW_PTR->stats.hist + STATS_HIST_DECODE, now);
 
 		if (n < 0) {
 			c_log(client, _E("Failed to decode frame: %s"),
 			      spoe_frm_err_reasons(client->status_code));
+			STAT_INC(CW_PTR->stats.decode_errors);
 
 			goto disconnect;
 		}
 		else if (n == 0) {
 			c_log(client, _W("Ignore invalid/unknown/aborted frame"));
+			STAT_INC(CW_PTR->stats.decode_errors);
 
 			reset_frame(f);
 
-			DBG_RETURN();
+			DBG_RETURN_INT(FUNC_RET_OK);
 		}
 		else if (n == 1) {
-			DBG_RETURN();
+			DBG_RETURN_INT(FUNC_RET_OK);
 		}
 		else {
 			/* Process frame. */
+			STAT_INC(CW_PTR->stats.frames_rcvd);
+			f->t_sched = now;
 			process_incoming_frame(f);
 			client->incoming_frame = NULL;
 
-			DBG_RETURN();
+			DBG_RETURN_INT(FUNC_RET_OK);
 		}
 	}
 	else if (client->state == SPOA_ST_DISCONNECTING) {
@@ -646,63 +1422,232 @@ void read_frame_cb(struct ev_loop *loop __maybe_unused, ev_io *ev, int revents _
 
 		release_client(client);
 
-		DBG_RETURN();
+		DBG_RETURN_INT(FUNC_RET_ERROR);
 	}
 
   write_frame:
 	write_frame(client, f);
 	client->incoming_frame = NULL;
 
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   read_frame_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Receives the available data and then processes all complete frames from
+ *   the client receive buffer, as long as the reading is not suspended.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void read_frame_cb(struct ev_loop *loop __maybe_unused, ev_io *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(client, client, ev_frame_rd);
+	struct spoe_frame *f;
+	ssize_t            n;
+
+	DBG_FUNC(CW_PTR, "%p, %p, 0x%08x", loop, ev, revents);
+
+	C_DBG(SPOA, client, "--> Receiving data");
+
+#ifdef HAVE_LIBURING
+	if (!client->uring.active && (cfg.opt_flags & FLAG_OPT_IO_URING)) {
+		/* The data already available is received by the io_uring. */
+		if (_ERROR(uring_client_init(client)))
+			release_client(client);
+
+		DBG_RETURN();
+	}
+
+	n = client->uring.active ? uring_recv(client) : tcp_recv(client);
+#else
+	n = tcp_recv(client);
+#endif
+
+	if (_ERROR(n)) {
+		release_client(client);
+
+		DBG_RETURN();
+	}
+
+	while (client_rd_active(client)) {
+		n = frame_recv(client, &f);
+		if (n == 0)
+			break;
+		else if (_ERROR(n) || _ERROR(dispatch_frame(client, f))) {
+			if (_ERROR(n))
+				release_client(client);
+
+			DBG_RETURN();
+		}
+
+		/* The HELLO and DISCONNECT frames have to be answered first. */
+		if (client->state != SPOA_ST_PROCESSING)
+			break;
+	}
+
 	DBG_RETURN();
 }
 
 
 /***
  * NAME
- *   frame_send -
+ *   frame_send_gather -
+ *
+ * ARGUMENTS
+ *   client -
+ *   frames -
+ *   iov    -
+ *
+ * DESCRIPTION
+ *   Collects the outgoing frames that can be sent in one go.  The current
+ *   frame is always the first one; in the pipelining and async modes it is
+ *   followed by the frames waiting in the client and engine queues.  The
+ *   queued frames are not removed from their lists here.
+ *
+ * RETURN VALUE
+ *   Returns the number of collected frames.
+ */
+static int frame_send_gather(struct client *client, struct spoe_frame **frames, struct iovec *iov)
+{
+	struct spoe_frame *f = client->outgoing_frame;
+	int                retval = 0;
+
+	DBG_FUNC(CW_PTR, "%p, %p, %p", client, frames, iov);
+
+	frames[retval]       = f;
+	iov[retval].iov_base = f->data + f->offset;
+	iov[retval].iov_len  = SPOA_FRM_LEN + f->len - f->offset;
+	retval++;
+
+	if ((client->state != SPOA_ST_PROCESSING) || (!client->async && !client->pipelining))
+		DBG_RETURN_INT(retval);
+
+	list_for_each_entry(f, &(client->outgoing_frames), list) {
+		if (retval >= TCP_SEND_IOV_MAX)
+			DBG_RETURN_INT(retval);
+
+		frames[retval]       = f;
+		iov[retval].iov_base = f->data;
+		iov[retval].iov_len  = SPOA_FRM_LEN + f->len;
+		retval++;
+	}
+
+	if (_nNULL(client->engine))
+		list_for_each_entry(f, &(client->engine->outgoing_frames), list) {
+			if (retval >= TCP_SEND_IOV_MAX)
+				DBG_RETURN_INT(retval);
+
+			frames[retval]       = f;
+			iov[retval].iov_base = f->data;
+			iov[retval].iov_len  = SPOA_FRM_LEN + f->len;
+			retval++;
+		}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   write_frame_done -
  *
  * ARGUMENTS
  *   client -
  *   frame  -
  *
  * DESCRIPTION
- *   -
+ *   Completes the sending of the frame; the frame must already be removed
+ *   from the client outgoing frame.
  *
  * RETURN VALUE
- *   -
+ *   Returns FUNC_RET_ERROR (-1) if the client has been released,
+ *   otherwise FUNC_RET_OK (0).
  */
-static ssize_t frame_send(const struct client *client, struct spoe_frame *frame)
+int write_frame_done(struct client *client, struct spoe_frame *frame)
 {
-	ssize_t retval = FUNC_RET_ERROR;
+	DBG_FUNC(CW_PTR, "%p, %p", client, frame);
 
-	DBG_FUNC(FW_PTR, "%p, %p", client, frame);
+	C_DBG(SPOA, client, "Frame of %zu bytes sent: <%s> <%s>",
+	      frame->len, str_hex(frame->data + SPOA_FRM_LEN, frame->len), str_ctrl(frame->data + SPOA_FRM_LEN, frame->len));
 
-	C_DBG(SPOA, client, "<-- Sending data");
+	STAT_ADD(CW_PTR->stats.bytes_sent, SPOA_FRM_LEN + frame->len);
 
-	if (frame->buf == frame->data) {
-		/*
-		 * Send the frame length:
-		 *   frame->buf points on length part (frame->data)
-		 */
-		retval = tcp_send(client, frame, SPOA_FRM_LEN, " length");
-		if (retval == SPOA_FRM_LEN)
-			frame->buf += SPOA_FRM_LEN;
-		else
-			DBG_RETURN_SSIZE((retval > 0) ? 0 : retval);
+	if (client->state == SPOA_ST_CONNECTING) {
+		if (frame->hcheck) {
+			C_DBG(SPOA, client, "Close client after healthcheck");
+
+			release_frame(frame);
+			release_client(client);
+
+			DBG_RETURN_INT(FUNC_RET_ERROR);
+		}
+
+		client->state = SPOA_ST_PROCESSING;
+	}
+	else if (client->state == SPOA_ST_PROCESSING) {
+		STAT_INC(CW_PTR->stats.frames_acked);
+		(void)stats_hist_since(CW_PTR->stats.hist + STATS_HIST_ACK, frame->t_recv);
+	}
+	else if (client->state == SPOA_ST_DISCONNECTING) {
+		release_frame(frame);
+		release_client(client);
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
 	}
 
-	/*
-	 * Send the frame data:
-	 *   frame->buf points on frame part (frame->data + SPOA_FRM_LEN)
-	 */
-	retval = tcp_send(client, frame, frame->len, " data");
-	if (retval == (typeof(retval))frame->len)
-		C_DBG(SPOA, client, "Frame of %zu bytes sent: <%s> <%s>",
-		      frame->len, str_hex(frame->buf, frame->len), str_ctrl(frame->buf, frame->len));
-	else
-		retval = (retval > 0) ? 0 : retval;
+	release_frame(frame);
 
-	DBG_RETURN_SSIZE(retval);
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   write_frame_resume -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Called once all the frames taken for sending have been sent.  Stops the
+ *   sending if there is nothing more to send and, if the client does not use
+ *   pipelining, resumes the reading of the frames.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void write_frame_resume(struct client *client)
+{
+	DBG_FUNC(CW_PTR, "%p", client);
+
+	/* Avoid a useless write event if all the frames have been sent. */
+	if (LIST_ISEMPTY(&(client->outgoing_frames)) && (_NULL(client->engine) || LIST_ISEMPTY(&(client->engine->outgoing_frames))))
+		client_wr_stop(client);
+#ifdef HAVE_LIBURING
+	else if (client->uring.active)
+		client_wr_start(client);
+#endif
+
+	if (!client->async && !client->pipelining) {
+		client_wr_stop(client);
+		client_rd_start(client);
+	}
+
+	/* The frames received while the reading was suspended. */
+	if (client_rd_active(client) && client_rd_pending(client))
+		ev_feed_event(CW_PTR->ev_base, &(client->ev_frame_rd), EV_READ);
+
+	DBG_RETURN();
 }
 
 
@@ -716,7 +1661,10 @@ static ssize_t frame_send(const struct client *client, struct spoe_frame *frame)
  *   revents -
  *
  * DESCRIPTION
- *   -
+ *   Sends all ready outgoing frames with a single system call.  The frames
+ *   sent in whole are released, while the partially sent frame becomes the
+ *   current outgoing frame of the client.  With the io_uring transport the
+ *   frames are only submitted here; they are released on completion.
  *
  * RETURN VALUE
  *   This function does not return a value.
@@ -724,19 +1672,39 @@ static ssize_t frame_send(const struct client *client, struct spoe_frame *frame)
 void write_frame_cb(struct ev_loop *loop __maybe_unused, ev_io *ev, int revents __maybe_unused)
 {
 	STRUCT_ADDR(client, client, ev_frame_wr);
-	struct spoe_frame *f;
-	int                n;
+	struct spoe_frame *frames[TCP_SEND_IOV_MAX], *f;
+	struct iovec       iov[TCP_SEND_IOV_MAX];
+	ssize_t            n;
+	int                i, cnt;
 
 	DBG_FUNC(CW_PTR, "%p, %p, 0x%08x", loop, ev, revents);
 
+#ifdef HAVE_LIBURING
+	/* The next frames are sent when the previous ones are completed. */
+	if (client->uring.active && (client->uring.sends > 0))
+		DBG_RETURN();
+#endif
+
 	if (_NULL(f = acquire_outgoing_frame(client))) {
-		ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_wr));
-		ev_async_send(CW_PTR->ev_base, &(CW_PTR->ev_async));
+		client_wr_stop(client);
+
+		DBG_RETURN();
+	}
+
+	C_DBG(SPOA, client, "<-- Sending data");
+
+	cnt = frame_send_gather(client, frames, iov);
+
+#ifdef HAVE_LIBURING
+	if (client->uring.active) {
+		if (_ERROR(uring_send(client, frames, iov, cnt)))
+			release_client(client);
 
 		DBG_RETURN();
 	}
+#endif
 
-	n = frame_send(client, f);
+	n = tcp_send(client, iov, cnt);
 	if (n <= 0) {
 		if (_ERROR(n))
 			release_client(client);
@@ -744,35 +1712,34 @@ void write_frame_cb(struct ev_loop *loop __maybe_unused, ev_io *ev, int revents
 		DBG_RETURN();
 	}
 
-	if (client->state == SPOA_ST_CONNECTING) {
-		if (f->hcheck) {
-			C_DBG(SPOA, client, "Close client after healthcheck");
+	for (i = 0; i < cnt; i++) {
+		f = frames[i];
 
-			release_client(client);
+		if ((size_t)n < iov[i].iov_len) {
+			/* Partially sent frame, the rest is sent next time. */
+			f->offset += n;
 
-			DBG_RETURN();
-		}
+			if (i > 0) {
+				LIST_DEL(&(f->list));
+				LIST_INIT(&(f->list));
+				client->outgoing_frame = f;
+			}
 
-		client->state = SPOA_ST_PROCESSING;
-	}
-	else if (client->state == SPOA_ST_PROCESSING) {
-		/* Do nothing. */
-	}
-	else if (client->state == SPOA_ST_DISCONNECTING) {
-		release_client(client);
+			break;
+		}
 
-		DBG_RETURN();
-	}
+		n -= iov[i].iov_len;
 
-	release_frame(f);
-	client->outgoing_frame = NULL;
+		if (i == 0)
+			client->outgoing_frame = NULL;
 
-	if (!client->async && !client->pipelining) {
-		ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_wr));
-		ev_io_start(CW_PTR->ev_base, &(client->ev_frame_rd));
-		ev_async_send(CW_PTR->ev_base, &(CW_PTR->ev_async));
+		if (_ERROR(write_frame_done(client, f)))
+			DBG_RETURN();
 	}
 
+	if (_NULL(client->outgoing_frame))
+		write_frame_resume(client);
+
 	DBG_RETURN();
 }
 
@@ -20,6 +20,65 @@
 #include "include.h"
 
 
+/***
+ * NAME
+ *   spoe_decode_varint_word -
+ *
+ * ARGUMENTS
+ *   ptr   -
+ *   value -
+ *
+ * DESCRIPTION
+ *   Decode a varint of at most 8 bytes, the same way as spoe_decode_varint()
+ *   does, but without a loop: all 8 bytes at <ptr> are read at once, the
+ *   varint length is found from the position of the first byte (after the
+ *   first one) whose high bit is cleared, and the 7-bit groups of the
+ *   following bytes are packed together with a few shifts and masks.
+ *
+ *   The caller must ensure that at least 8 bytes can be read at <ptr> and
+ *   that the first byte is not lower than 240.
+ *
+ * RETURN VALUE
+ *   Returns the number of read bytes, or FUNC_RET_ERROR (-1) if the varint
+ *   is longer than 8 bytes.
+ */
+static __always_inline int spoe_decode_varint_word(const uint8_t *ptr, uint64_t *value)
+{
+	uint64_t word, stop, bits;
+	int      n;
+
+	(void)memcpy(&word, ptr, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	word = __builtin_bswap64(word);
+#endif
+
+	/* Bytes 1 to 7 that end the varint, i.e. have the high bit cleared. */
+	stop = ~word & SPOE_VARINT_STOP_MASK;
+	if (stop == 0)
+		return FUNC_RET_ERROR;
+
+	/* The number of bytes following the first one. */
+	n    = __builtin_ctzll(stop) >> 3;
+	bits = (word >> 8) & (UINT64_MAX >> (64 - 8 * n));
+
+	/*
+	 * Every byte after the first one is added to the value as a whole,
+	 * shifted by 4 + 7 * (i - 1) bits.  The low 7 bits of the bytes are
+	 * packed together, and the high bits of all but the last byte, which
+	 * are always set, add 1 << 7 * i each (for i from 1 to n - 1).
+	 */
+	bits &= UINT64_C(0x7f7f7f7f7f7f7f7f);
+	bits  = (bits & UINT64_C(0x007f007f007f007f)) | ((bits & UINT64_C(0x7f007f007f007f00)) >> 1);
+	bits  = (bits & UINT64_C(0x00003fff00003fff)) | ((bits & UINT64_C(0x3fff00003fff0000)) >> 2);
+	bits  = (bits & UINT64_C(0x000000000fffffff)) | ((bits & UINT64_C(0x0fffffff00000000)) >> 4);
+	bits += ((UINT64_C(1) << (7 * n)) - 128) / 127;
+
+	*value = (word & 0xff) + (bits << 4);
+
+	return n + 1;
+}
+
+
 /***
  * NAME
  *   spoe_decode_varint -
@@ -33,6 +92,10 @@
  *   Decode a varint from <*buf> and save the decoded value in <*value>.
  *   See 'spoe_encode_varint' for details about varint.
  *
+ *   Single-byte varints are returned immediately; longer ones are decoded
+ *   with spoe_decode_varint_word() if at least 8 bytes are available, and
+ *   byte by byte otherwise.
+ *
  * RETURN VALUE
  *   On success, it returns the number of read bytes and <*buf> is moved after
  *   the varint.  Otherwise, it returns FUNC_RET_ERROR (-1).
@@ -40,13 +103,19 @@
 static __always_inline int spoe_decode_varint(const char **buf, const char *end, uint64_t *value)
 {
 	uint8_t *ptr = (uint8_t *)*buf;
-	int      shift = 4, retval = FUNC_RET_ERROR;
+	int      n, shift = 4, retval = FUNC_RET_ERROR;
 
 	if (*buf >= end)
 		return retval;
 
 	*value = *(ptr++);
-	if (*value >= 240) {
+	if (*value < 240) {
+		/* Do nothing. */
+	}
+	else if (((end - *buf) >= (ssize_t)sizeof(uint64_t)) && _nERROR(n = spoe_decode_varint_word((uint8_t *)*buf, value))) {
+		ptr = (uint8_t *)*buf + n;
+	}
+	else {
 		do {
 			if (ptr >= (uint8_t *)end)
 				return retval;
@@ -531,6 +600,66 @@ int spoe_decode_kv(struct spoe_frame *frame, const char **buf, const char *end,
 }
 
 
+/***
+ * NAME
+ *   spoe_decode_hdr -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   buf   -
+ *   end   -
+ *   name  -
+ *   value -
+ *
+ * DESCRIPTION
+ *   Decode one HTTP header in the req.hdrs_bin format: the header name and
+ *   the header value, each of them preceded by its length.  The list of the
+ *   headers ends with an empty name, in which case <name->ptr> is set to NULL
+ *   and the value is not decoded.  An empty value sets <value->ptr> to NULL.
+ *
+ *   Unlike spoe_decode(), the function is not variadic, so that it can be
+ *   called in a tight loop over all the request headers.
+ *
+ * RETURN VALUE
+ *   On success, it returns the number of read bytes and <*buf> is moved after
+ *   the header.  Otherwise, it returns FUNC_RET_ERROR (-1).
+ */
+int spoe_decode_hdr(struct spoe_frame *frame, const char **buf, const char *end, struct chunk *name, struct chunk *value)
+{
+	const char *ptr = *buf, *str;
+	uint64_t    len;
+	int         retval;
+
+	value->ptr = NULL;
+	value->len = 0;
+
+	retval = spoe_decode_buffer(&ptr, end, &str, &len);
+	if (_nERROR(retval)) {
+		name->ptr = (char *)str;
+		name->len = len;
+
+		if (_nNULL(str)) {
+			retval = spoe_decode_buffer(&ptr, end, &str, &len);
+			if (_nERROR(retval)) {
+				value->ptr = (char *)str;
+				value->len = len;
+			}
+		}
+	}
+
+	SPOE_BUFFER_ADVANCE(retval);
+
+	if (_ERROR(retval)) {
+		f_log(frame, _E("Failed to decode HTTP header, ptr=%p end=%p"), ptr, end);
+
+		if (_nNULL(FC_PTR))
+			FC_PTR->status_code = SPOE_FRM_ERR_INVALID;
+	}
+
+	return retval;
+}
+
+
 /***
  * NAME
  *   spoe_decode_skip_msg -
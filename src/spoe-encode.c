@@ -146,7 +146,7 @@ static int spoe_vencode(struct spoe_frame *frame, char **buf, int type, va_list
 
 	DBG_FUNC(FW_PTR, "%p, %p:%p, %d, %p", frame, DPTR_ARGS(buf), type, ap);
 
-	end = frame->buf + cfg.max_frame_size;
+	end = frame->data + SPOA_FRM_LEN + frame->size;
 
 	for ( ; _nERROR(retval) && (type != SPOE_ENC_END); type = va_arg(ap, typeof(type))) {
 		if (type == SPOE_ENC_UINT8) {
@@ -0,0 +1,1164 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+
+
+/* Offset of a counter within the snapshot of a worker or a mirroring engine. */
+#define STATS_OFFSET(a)      offsetof(struct stats_snapshot, a)
+
+#define STATS_ENGINE_ANY     0x03
+#define STATS_ENGINE_CURL    0x01
+#define STATS_ENGINE_NATIVE  0x02
+
+/*
+ * The values of a worker or of a mirroring engine, read at once before the
+ * metrics are written, so that all the metrics are read the same way.
+ */
+struct stats_snapshot {
+	uint64_t clients;
+	uint64_t frames_rcvd;
+	uint64_t frames_acked;
+	uint64_t decode_errors;
+	uint64_t bytes_rcvd;
+	uint64_t bytes_sent;
+	uint64_t frames_in_use;
+	uint64_t frame_pool_free;
+	uint64_t mir_submitted;
+	uint64_t mir_completed;
+	uint64_t mir_failed;
+	uint64_t mir_dropped;
+	uint64_t mir_bytes_up;
+	uint64_t mir_bytes_down;
+	uint64_t mir_in_flight;
+	uint64_t mir_conns;
+	uint64_t mir_running;
+};
+
+struct stats_metric {
+	const char *name;
+	const char *type;
+	const char *help;
+	size_t      offset;
+	uint8_t     engines;   /* The mirroring engines the metric applies to. */
+};
+
+static const struct stats_metric stats_worker_metrics[] = {
+	{ "clients",                  "gauge",   "Connected SPOP clients.",                         STATS_OFFSET(clients),         STATS_ENGINE_ANY },
+	{ "frames_received_total",    "counter", "NOTIFY frames received.",                         STATS_OFFSET(frames_rcvd),     STATS_ENGINE_ANY },
+	{ "frames_acked_total",       "counter", "ACK frames sent.",                                STATS_OFFSET(frames_acked),    STATS_ENGINE_ANY },
+	{ "decode_errors_total",      "counter", "Frames that could not be decoded.",               STATS_OFFSET(decode_errors),   STATS_ENGINE_ANY },
+	{ "received_bytes_total",     "counter", "SPOP bytes received.",                            STATS_OFFSET(bytes_rcvd),      STATS_ENGINE_ANY },
+	{ "sent_bytes_total",         "counter", "SPOP bytes sent.",                                STATS_OFFSET(bytes_sent),      STATS_ENGINE_ANY },
+	{ "frames_in_use",            "gauge",   "Frames taken from the frame pool.",               STATS_OFFSET(frames_in_use),   STATS_ENGINE_ANY },
+	{ "frame_pool_free",          "gauge",   "Free frames in the frame pool.",                  STATS_OFFSET(frame_pool_free), STATS_ENGINE_ANY },
+#ifdef HAVE_LIBCURL
+	{ "mirrors_submitted_total",  "counter", "Mirrors passed to the mirroring.",                STATS_OFFSET(mir_submitted),   STATS_ENGINE_ANY },
+#endif
+};
+
+#ifdef HAVE_LIBCURL
+static const struct stats_metric stats_mirror_metrics[] = {
+	{ "mirrors_completed_total",  "counter", "Mirrors that got a response.",                    STATS_OFFSET(mir_completed),   STATS_ENGINE_ANY },
+	{ "mirrors_failed_total",     "counter", "Mirrors that failed.",                            STATS_OFFSET(mir_failed),      STATS_ENGINE_ANY },
+	{ "mirrors_dropped_total",    "counter", "Mirrors dropped due to the in-flight limits.",    STATS_OFFSET(mir_dropped),     STATS_ENGINE_ANY },
+	{ "mirror_sent_bytes_total",  "counter", "Bytes of the mirrored requests sent.",            STATS_OFFSET(mir_bytes_up),    STATS_ENGINE_ANY },
+	{ "mirror_received_bytes_total", "counter", "Bytes of the mirror responses received.",      STATS_OFFSET(mir_bytes_down),  STATS_ENGINE_ANY },
+	{ "mirrors_in_flight",        "gauge",   "Mirrors being sent.",                             STATS_OFFSET(mir_in_flight),   STATS_ENGINE_ANY },
+	{ "mirror_connections",       "gauge",   "Connections to the mirror server.",               STATS_OFFSET(mir_conns),       STATS_ENGINE_NATIVE },
+	{ "curl_running_handles",     "gauge",   "Running easy handles of the cURL multi handle.",  STATS_OFFSET(mir_running),     STATS_ENGINE_CURL },
+};
+#endif
+
+static const struct {
+	const char *name;
+	const char *help;
+} stats_hists[] = {
+#define STATS_HIST_DEF(a,b,c)   { b, c },
+	STATS_HIST_DEFINES
+#undef STATS_HIST_DEF
+#ifdef HAVE_LIBCURL
+#  define MIR_HIST_DEF(a,b,c)   { b, c },
+	MIR_HIST_DEFINES
+#  undef MIR_HIST_DEF
+#endif
+};
+
+/* The worker histograms, followed by the mirror ones. */
+#define STATS_HISTS          TABLESIZE(stats_hists)
+
+
+static void stats_client_close(struct stats_client *client);
+
+
+/***
+ * NAME
+ *   stats_printf -
+ *
+ * ARGUMENTS
+ *   buf    -
+ *   format -
+ *
+ * DESCRIPTION
+ *   Appends the formatted string to the buffer.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int stats_printf(struct buffer *buf, const char *format, ...)
+	__fmt(printf, 2, 3);
+static int stats_printf(struct buffer *buf, const char *format, ...)
+{
+	va_list ap;
+	int     rc;
+
+	va_start(ap, format);
+	rc = vsnprintf(_NULL(buf->ptr) ? NULL : (char *)buf->ptr + buf->len, buf->size - buf->len, format, ap);
+	va_end(ap);
+
+	if (rc < 0)
+		return FUNC_RET_ERROR;
+	else if ((size_t)rc >= (buf->size - buf->len)) {
+		if (_ERROR(buffer_grow(buf, NULL, MAX((size_t)rc + 1, STATS_BUF_CHUNK))))
+			return FUNC_RET_ERROR;
+
+		va_start(ap, format);
+		rc = vsnprintf((char *)buf->ptr + buf->len, buf->size - buf->len, format, ap);
+		va_end(ap);
+	}
+
+	buf->len += rc;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   stats_snapshot_worker -
+ *
+ * ARGUMENTS
+ *   w    -
+ *   snap -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_snapshot_worker(struct worker *w, struct stats_snapshot *snap)
+{
+	int i;
+
+	(void)memset(snap, 0, sizeof(*snap));
+
+	snap->clients       = STAT_GET(w->nbclients);
+	snap->frames_rcvd   = STAT_GET(w->stats.frames_rcvd);
+	snap->frames_acked  = STAT_GET(w->stats.frames_acked);
+	snap->decode_errors = STAT_GET(w->stats.decode_errors);
+	snap->bytes_rcvd    = STAT_GET(w->stats.bytes_rcvd);
+	snap->bytes_sent    = STAT_GET(w->stats.bytes_sent);
+	snap->frames_in_use = STAT_GET(w->nbinflight);
+	snap->mir_submitted = STAT_GET(w->stats.mir_submitted);
+
+	for (i = 0; i < SPOA_FRM_POOL_CLASSES; i++)
+		snap->frame_pool_free += STAT_GET(w->frame_pool[i].nbfree);
+}
+
+
+#ifdef HAVE_LIBCURL
+
+/***
+ * NAME
+ *   stats_mirror_log -
+ *
+ * ARGUMENTS
+ *   curl  -
+ *   http1 -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the statistics of the mirroring engine in use, or NULL if the
+ *   engine is not initialized.
+ */
+static struct mir_log *stats_mirror_log(struct curl_data *curl, struct http1_data *http1)
+{
+	if (cfg.mir_engine == MIR_ENGINE_NATIVE)
+		return _NULL(__atomic_load_n(&(http1->ev_base), __ATOMIC_ACQUIRE)) ? NULL : &(http1->log);
+
+	return _NULL(__atomic_load_n(&(curl->ev_base), __ATOMIC_ACQUIRE)) ? NULL : &(curl->log);
+}
+
+
+/***
+ * NAME
+ *   stats_snapshot_mirror -
+ *
+ * ARGUMENTS
+ *   curl  -
+ *   http1 -
+ *   snap  -
+ *
+ * DESCRIPTION
+ *   Reads the values of the mirroring engine in use.
+ *
+ * RETURN VALUE
+ *   Returns true if the mirroring engine is initialized, false otherwise.
+ */
+static bool_t stats_snapshot_mirror(struct curl_data *curl, struct http1_data *http1, struct stats_snapshot *snap)
+{
+	struct mir_log *log;
+
+	(void)memset(snap, 0, sizeof(*snap));
+
+	if (_NULL(log = stats_mirror_log(curl, http1)))
+		return 0;
+
+	if (cfg.mir_engine == MIR_ENGINE_NATIVE) {
+		snap->mir_dropped   = STAT_GET(http1->nbdropped);
+		snap->mir_in_flight = STAT_GET(http1->nbactive);
+		snap->mir_conns     = STAT_GET(http1->nbcons);
+	}
+	else {
+		snap->mir_dropped   = STAT_GET(curl->nbdropped);
+		snap->mir_in_flight = STAT_GET(curl->nbactive);
+		snap->mir_running   = MAX(STAT_GET(curl->running_handles), 0);
+	}
+
+	snap->mir_completed  = STAT_GET(log->stats.completed);
+	snap->mir_failed     = STAT_GET(log->stats.failed);
+	snap->mir_bytes_up   = STAT_GET(log->stats.bytes_up);
+	snap->mir_bytes_down = STAT_GET(log->stats.bytes_down);
+
+	return 1;
+}
+
+#endif /* HAVE_LIBCURL */
+
+
+/***
+ * NAME
+ *   stats_hist_time -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Reads the monotonic clock for the latency histograms.  The clock is not
+ *   read if the histograms are not used.
+ *
+ * RETURN VALUE
+ *   Returns the time in nanoseconds, or 0 if the latency histograms are
+ *   not used.
+ */
+uint64_t stats_hist_time(void)
+{
+	struct timespec ts;
+
+	if (!prg.stats.flag_hist)
+		return 0;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/***
+ * NAME
+ *   stats_hist_index -
+ *
+ * ARGUMENTS
+ *   value -
+ *
+ * DESCRIPTION
+ *   The values below STATS_HIST_SUB have a bucket each, the higher ones
+ *   are counted in STATS_HIST_SUB buckets per power of two.
+ *
+ * RETURN VALUE
+ *   Returns the bucket of the value.
+ */
+static uint stats_hist_index(uint64_t value)
+{
+	uint shift;
+
+	if (value < STATS_HIST_SUB)
+		return value;
+	else if (value >= (1ULL << STATS_HIST_BITS))
+		return STATS_HIST_BUCKETS - 1;
+
+	shift = 63 - __builtin_clzll(value) - STATS_HIST_SUB_BITS;
+
+	return (shift + 1) * STATS_HIST_SUB + ((value >> shift) & (STATS_HIST_SUB - 1));
+}
+
+
+/***
+ * NAME
+ *   stats_hist_bound -
+ *
+ * ARGUMENTS
+ *   idx -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the smallest value above the bucket.
+ */
+static uint64_t stats_hist_bound(uint idx)
+{
+	if (idx < STATS_HIST_SUB)
+		return idx + 1;
+
+	return (uint64_t)(STATS_HIST_SUB + (idx % STATS_HIST_SUB) + 1) << (idx / STATS_HIST_SUB - 1);
+}
+
+
+/***
+ * NAME
+ *   stats_hist_add -
+ *
+ * ARGUMENTS
+ *   hist  -
+ *   value - the value in nanoseconds
+ *
+ * DESCRIPTION
+ *   Counts the value in the histogram.  Only the thread that owns the
+ *   histogram may call this function.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void stats_hist_add(struct stats_hist *hist, uint64_t value)
+{
+	STAT_ADD(hist->sum, value);
+	STAT_INC(hist->bucket[stats_hist_index(value)]);
+}
+
+
+/***
+ * NAME
+ *   stats_hist_since -
+ *
+ * ARGUMENTS
+ *   hist  -
+ *   start - the start time returned by stats_hist_time()
+ *
+ * DESCRIPTION
+ *   Counts the time elapsed since the start in the histogram.  Nothing is
+ *   counted if the start time is not set.
+ *
+ * RETURN VALUE
+ *   Returns the current time, as stats_hist_time() does.
+ */
+uint64_t stats_hist_since(struct stats_hist *hist, uint64_t start)
+{
+	uint64_t now = stats_hist_time();
+
+	if ((start > 0) && (now >= start))
+		stats_hist_add(hist, now - start);
+
+	return now;
+}
+
+
+/***
+ * NAME
+ *   stats_hist_merge -
+ *
+ * ARGUMENTS
+ *   dst -
+ *   src -
+ *
+ * DESCRIPTION
+ *   Adds the histogram of another thread to the histogram dst.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_hist_merge(struct stats_hist *dst, const struct stats_hist *src)
+{
+	int i;
+
+	dst->sum += STAT_GET(src->sum);
+
+	for (i = 0; i < STATS_HIST_BUCKETS; i++)
+		dst->bucket[i] += STAT_GET(src->bucket[i]);
+}
+
+
+/***
+ * NAME
+ *   stats_hist_count -
+ *
+ * ARGUMENTS
+ *   hist -
+ *   idx  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the number of the values counted in the buckets below idx.
+ */
+static uint64_t stats_hist_count(const struct stats_hist *hist, uint idx)
+{
+	uint64_t retval = 0;
+	uint     i;
+
+	for (i = 0; (i < idx) && (i < STATS_HIST_BUCKETS); i++)
+		retval += hist->bucket[i];
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   stats_hist_quantile -
+ *
+ * ARGUMENTS
+ *   hist  -
+ *   count - the number of the values in the histogram
+ *   q     - the quantile, from 0 to 1
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the highest value of the bucket that contains the quantile.
+ */
+static uint64_t stats_hist_quantile(const struct stats_hist *hist, uint64_t count, double q)
+{
+	uint64_t rank, n = 0;
+	uint     i;
+
+	rank = q * count;
+	if (rank < (q * count))
+		rank++;
+	rank = MAX(rank, 1);
+
+	for (i = 0; i < (STATS_HIST_BUCKETS - 1); i++)
+		if ((n += hist->bucket[i]) >= rank)
+			break;
+
+	return stats_hist_bound(i) - 1;
+}
+
+
+/***
+ * NAME
+ *   stats_hist_used -
+ *
+ * ARGUMENTS
+ *   idx -
+ *
+ * DESCRIPTION
+ *   The mirror histograms are used only if the mirroring is enabled, and
+ *   the cURL ones only with the cURL engine.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static bool_t stats_hist_used(int idx)
+{
+#ifdef HAVE_LIBCURL
+	if (idx < STATS_HIST_MAX)
+		return 1;
+	else if (_NULL(cfg.mir_url))
+		return 0;
+	else if (idx == (STATS_HIST_MAX + MIR_HIST_TOTAL))
+		return 1;
+
+	return cfg.mir_engine != MIR_ENGINE_NATIVE;
+#else
+	return 1;
+#endif
+}
+
+
+/***
+ * NAME
+ *   stats_hist_collect -
+ *
+ * ARGUMENTS
+ *   hists - STATS_HISTS histograms
+ *
+ * DESCRIPTION
+ *   Merges the histograms of all the workers, and of all the mirroring
+ *   engines that are initialized.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_hist_collect(struct stats_hist *hists)
+{
+#ifdef HAVE_LIBCURL
+	struct mir_log *log;
+	int             n;
+#endif
+	int             i, j;
+
+	(void)memset(hists, 0, STATS_HISTS * sizeof(*hists));
+
+	for (i = 0; i < cfg.num_workers; i++)
+		for (j = 0; j < STATS_HIST_MAX; j++)
+			stats_hist_merge(hists + j, prg.workers[i].stats.hist + j);
+
+#ifdef HAVE_LIBCURL
+	if (_NULL(cfg.mir_url))
+		n = 0;
+	else if (cfg.mir_threads > 0)
+		n = _NULL(prg.senders) ? 0 : cfg.mir_threads;
+	else
+		n = cfg.num_workers;
+
+	for (i = 0; i < n; i++) {
+		if (cfg.mir_threads > 0)
+			log = stats_mirror_log(&(prg.senders[i].curl), &(prg.senders[i].http1));
+		else
+			log = stats_mirror_log(&(prg.workers[i].curl), &(prg.workers[i].http1));
+
+		for (j = 0; _nNULL(log) && (j < MIR_HIST_MAX); j++)
+			stats_hist_merge(hists + STATS_HIST_MAX + j, log->stats.hist + j);
+	}
+#endif
+}
+
+
+/***
+ * NAME
+ *   stats_dump_metric -
+ *
+ * ARGUMENTS
+ *   buf    -
+ *   metric -
+ *   label  -
+ *   snaps  -
+ *   valid  -
+ *   n      -
+ *
+ * DESCRIPTION
+ *   Writes the metric of all the workers or mirror threads.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int stats_dump_metric(struct buffer *buf, const struct stats_metric *metric, const char *label, const struct stats_snapshot *snaps, const bool_t *valid, int n)
+{
+	int i, retval;
+
+	retval = stats_printf(buf, "# HELP " STATS_PFX "%s %s\n# TYPE " STATS_PFX "%s %s\n", metric->name, metric->help, metric->name, metric->type);
+
+	for (i = 0; _OK(retval) && (i < n); i++)
+		if (valid[i])
+			retval = stats_printf(buf, STATS_PFX "%s{%s=\"%d\"} %"PRIu64"\n", metric->name, label, i + 1,
+			                      *(const uint64_t *)((const uint8_t *)(snaps + i) + metric->offset));
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   stats_dump_hist -
+ *
+ * ARGUMENTS
+ *   buf  -
+ *   idx  -
+ *   hist -
+ *
+ * DESCRIPTION
+ *   Writes the histogram in seconds.  A histogram bucket starts at a power
+ *   of two nanoseconds, so the values below 2^i ns are exactly the values
+ *   in the buckets below that of 2^i.  The values are whole nanoseconds, so
+ *   these are the values less than or equal to 2^i - 1 ns, which is used as
+ *   the 'le' bound; the cumulative counts are exact.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int stats_dump_hist(struct buffer *buf, int idx, const struct stats_hist *hist)
+{
+	const char *name = stats_hists[idx].name;
+	uint64_t    count;
+	int         i, retval;
+
+	count  = stats_hist_count(hist, STATS_HIST_BUCKETS);
+	retval = stats_printf(buf, "# HELP " STATS_PFX "%s_seconds %s\n# TYPE " STATS_PFX "%s_seconds histogram\n", name, stats_hists[idx].help, name);
+
+	for (i = STATS_HIST_LE_MIN; _OK(retval) && (i < STATS_HIST_BITS); i += STATS_HIST_LE_STEP)
+		retval = stats_printf(buf, STATS_PFX "%s_seconds_bucket{le=\"%.9f\"} %"PRIu64"\n", name, ((1ULL << i) - 1) / 1e9,
+		                      stats_hist_count(hist, stats_hist_index(1ULL << i)));
+
+	if (_OK(retval))
+		retval = stats_printf(buf, STATS_PFX "%s_seconds_bucket{le=\"+Inf\"} %"PRIu64"\n" STATS_PFX "%s_seconds_sum %.9f\n"
+		                      STATS_PFX "%s_seconds_count %"PRIu64"\n", name, count, name, hist->sum / 1e9, name, count);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   stats_dump -
+ *
+ * ARGUMENTS
+ *   buf -
+ *
+ * DESCRIPTION
+ *   Writes the statistics in the Prometheus text exposition format.  The
+ *   mirror metrics are labelled by the mirror thread if the mirror threads
+ *   are used, and by the worker otherwise.  The latency histograms of all
+ *   the threads are merged.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int stats_dump(struct buffer *buf)
+{
+	struct stats_hist     *hists;
+	struct stats_snapshot *snaps;
+	bool_t                *valid;
+	int                    i, n, retval;
+
+	DBG_FUNC(NULL, "%p", buf);
+
+	n = cfg.num_workers;
+#ifdef HAVE_LIBCURL
+	n = MAX(n, cfg.mir_threads);
+#endif
+
+	snaps = calloc(n, sizeof(*snaps));
+	valid = calloc(n, sizeof(*valid));
+	if (_NULL(snaps) || _NULL(valid)) {
+		w_log(NULL, STATS_STR _E("Failed to allocate memory"));
+
+		PTR_FREE(snaps);
+		PTR_FREE(valid);
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	retval = stats_printf(buf, "# HELP " STATS_PFX "uptime_seconds Time since the start of the program.\n"
+	                      "# TYPE " STATS_PFX "uptime_seconds gauge\n" STATS_PFX "uptime_seconds %.3f\n",
+	                      time_elapsed(&(prg.start_time)) / 1e6);
+
+	for (i = 0; i < cfg.num_workers; i++) {
+		stats_snapshot_worker(prg.workers + i, snaps + i);
+		valid[i] = 1;
+	}
+
+	for (i = 0; _OK(retval) && (i < TABLESIZE(stats_worker_metrics)); i++)
+		retval = stats_dump_metric(buf, stats_worker_metrics + i, "worker", snaps, valid, cfg.num_workers);
+
+#ifdef HAVE_LIBCURL
+	if (_NULL(cfg.mir_url)) {
+		/* Do nothing. */;
+	}
+	else if (cfg.mir_threads > 0) {
+		for (i = 0; i < cfg.mir_threads; i++)
+			valid[i] = _nNULL(prg.senders) && stats_snapshot_mirror(&(prg.senders[i].curl), &(prg.senders[i].http1), snaps + i);
+
+		n = cfg.mir_threads;
+	}
+	else {
+		for (i = 0; i < cfg.num_workers; i++)
+			valid[i] = stats_snapshot_mirror(&(prg.workers[i].curl), &(prg.workers[i].http1), snaps + i);
+
+		n = cfg.num_workers;
+	}
+
+	for (i = 0; _OK(retval) && _nNULL(cfg.mir_url) && (i < TABLESIZE(stats_mirror_metrics)); i++)
+		if (stats_mirror_metrics[i].engines & ((cfg.mir_engine == MIR_ENGINE_NATIVE) ? STATS_ENGINE_NATIVE : STATS_ENGINE_CURL))
+			retval = stats_dump_metric(buf, stats_mirror_metrics + i, (cfg.mir_threads > 0) ? "sender" : "worker", snaps, valid, n);
+#endif
+
+	PTR_FREE(snaps);
+	PTR_FREE(valid);
+
+	if (_ERROR(retval) || _NULL(hists = malloc(STATS_HISTS * sizeof(*hists))))
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+
+	stats_hist_collect(hists);
+
+	for (i = 0; _OK(retval) && (i < STATS_HISTS); i++)
+		if (stats_hist_used(i))
+			retval = stats_dump_hist(buf, i, hists + i);
+
+	PTR_FREE(hists);
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   stats_client_respond -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Prepares the response to the received request.  Only the GET and HEAD
+ *   requests of the '/metrics' and '/' paths are served.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int stats_client_respond(struct stats_client *client)
+{
+	struct buffer body;
+	const char   *status = "200 OK";
+	bool_t        flag_head;
+	size_t        len;
+	int           retval = FUNC_RET_OK;
+
+	DBG_FUNC(NULL, "%p", client);
+
+	(void)memset(&body, 0, sizeof(body));
+
+	flag_head = (strncmp(client->req, "HEAD ", 5) == 0);
+	len       = strncmp(client->req, "GET ", 4) == 0 ? 4 : (flag_head ? 5 : 0);
+
+	if (len == 0)
+		status = "405 Method Not Allowed";
+	else if ((strncmp(client->req + len, "/metrics", 8) != 0 || !TEST_OR3(client->req[len + 8], ' ', '?', '\r')) &&
+	         (strncmp(client->req + len, "/ ", 2) != 0))
+		status = "404 Not Found";
+	else
+		retval = stats_dump(&body);
+
+	if (_ERROR(retval)) {
+		status = "500 Internal Server Error";
+		body.len = 0;
+	}
+
+	retval = stats_printf(&(client->rsp), "HTTP/1.1 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+	                      "Content-Length: %zu\r\nConnection: close\r\n\r\n", status, body.len);
+	if (_OK(retval) && !flag_head && (body.len > 0) && _ERROR(buffer_grow(&(client->rsp), body.ptr, body.len)))
+		retval = FUNC_RET_ERROR;
+
+	buffer_free(&body);
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   stats_write_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Writes the response, the connection is closed once it is written.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_write_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(stats_client, client, ev_write);
+	ssize_t n;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	do {
+		n = write(client->fd, client->rsp.ptr + client->rsp_sent, client->rsp.len - client->rsp_sent);
+		if (n > 0)
+			client->rsp_sent += n;
+	} while (((n > 0) && (client->rsp_sent < client->rsp.len)) || ((n < 0) && (errno == EINTR)));
+
+	if ((client->rsp_sent >= client->rsp.len) || ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)))
+		stats_client_close(client);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   stats_read_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Receives the request.  The response is prepared once the request header
+ *   section is received, or the request buffer is full.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_read_cb(struct ev_loop *loop, struct ev_io *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(stats_client, client, ev_read);
+	ssize_t n;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	do
+		n = read(client->fd, client->req + client->req_len, sizeof(client->req) - 1 - client->req_len);
+	while ((n < 0) && (errno == EINTR));
+
+	if (n > 0) {
+		client->req_len += n;
+		client->req[client->req_len] = '\0';
+	}
+	else if ((n == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+		stats_client_close(client);
+
+		DBG_RETURN();
+	}
+
+	if (_NULL(strstr(client->req, "\r\n\r\n")) && (client->req_len < (sizeof(client->req) - 1)))
+		DBG_RETURN();
+
+	ev_io_stop(loop, &(client->ev_read));
+
+	if (_ERROR(stats_client_respond(client)))
+		stats_client_close(client);
+	else
+		ev_io_start(loop, &(client->ev_write));
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   stats_timer_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_timer_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(stats_client, client, ev_timer);
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	stats_client_close(client);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   stats_client_close -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_client_close(struct stats_client *client)
+{
+	struct stats_data *stats = client->stats;
+
+	DBG_FUNC(NULL, "%p", client);
+
+	ev_io_stop(stats->ev_base, &(client->ev_read));
+	ev_io_stop(stats->ev_base, &(client->ev_write));
+	ev_timer_stop(stats->ev_base, &(client->ev_timer));
+	FD_CLOSE(client->fd);
+
+	LIST_DEL(&(client->list));
+	stats->nbclients--;
+
+	buffer_free(&(client->rsp));
+	PTR_FREE(client);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   stats_accept_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_accept_cb(struct ev_loop *loop, struct ev_io *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(stats_data, stats, ev_accept);
+	struct stats_client *client;
+	int                  fd;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	while ((fd = accept(stats->fd, NULL, NULL)) >= 0) {
+		if (stats->nbclients >= STATS_CLIENTS_MAX) {
+			w_log(NULL, STATS_STR _W("Too many connections"));
+
+			FD_CLOSE(fd);
+		}
+		else if (_ERROR(socket_set_nonblocking(fd))) {
+			FD_CLOSE(fd);
+		}
+		else if (_NULL(client = calloc(1, sizeof(*client)))) {
+			w_log(NULL, STATS_STR _E("Failed to allocate memory"));
+
+			FD_CLOSE(fd);
+		}
+		else {
+			client->fd    = fd;
+			client->stats = stats;
+			LIST_ADDQ(&(stats->clients), &(client->list));
+			stats->nbclients++;
+
+			ev_io_init(&(client->ev_read), stats_read_cb, fd, EV_READ);
+			ev_io_init(&(client->ev_write), stats_write_cb, fd, EV_WRITE);
+			ev_timer_init(&(client->ev_timer), stats_timer_cb, STATS_TMOUT, 0.0);
+			ev_io_start(loop, &(client->ev_read));
+			ev_timer_start(loop, &(client->ev_timer));
+		}
+	}
+
+	if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+		w_log(NULL, STATS_STR _E("Failed to accept connection: %m"));
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   stats_dump_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Logs the latency percentiles of the values counted since the previous
+ *   call, one line per histogram.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void stats_dump_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(stats_data, stats, ev_dump);
+	struct stats_hist *hists, *last, delta;
+	uint64_t           count;
+	int                i, j;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	if (_NULL(hists = malloc(STATS_HISTS * sizeof(*hists)))) {
+		w_log(NULL, STATS_STR _E("Failed to allocate memory"));
+
+		DBG_RETURN();
+	}
+
+	stats_hist_collect(hists);
+
+	for (i = 0; i < STATS_HISTS; i++) {
+		last      = stats->dump_last + i;
+		delta.sum = hists[i].sum - last->sum;
+		for (j = 0; j < STATS_HIST_BUCKETS; j++)
+			delta.bucket[j] = hists[i].bucket[j] - last->bucket[j];
+
+		if ((count = stats_hist_count(&delta, STATS_HIST_BUCKETS)) > 0)
+			w_log(NULL, STATS_STR "%s latency(us): %"PRIu64" values, avg %.1f, p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f",
+			      stats_hists[i].name, count, delta.sum / 1e3 / count,
+			      stats_hist_quantile(&delta, count, 0.5) / 1e3, stats_hist_quantile(&delta, count, 0.9) / 1e3,
+			      stats_hist_quantile(&delta, count, 0.99) / 1e3, stats_hist_quantile(&delta, count, 0.999) / 1e3,
+			      stats_hist_quantile(&delta, count, 1.0) / 1e3);
+	}
+
+	(void)memcpy(stats->dump_last, hists, STATS_HISTS * sizeof(*hists));
+	PTR_FREE(hists);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   stats_start -
+ *
+ * ARGUMENTS
+ *   loop -
+ *
+ * DESCRIPTION
+ *   Enables the latency histograms, starts their periodic log, and creates
+ *   the statistics listener which accepts the connections within the given
+ *   event loop.  Nothing is done if the statistics are not enabled.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int stats_start(struct ev_loop *loop)
+{
+	static const struct addrinfo hints = {
+		.ai_flags    = AI_PASSIVE,
+		.ai_family   = AF_UNSPEC,
+		.ai_socktype = SOCK_STREAM,
+	};
+	struct stats_data *stats = &(prg.stats);
+	struct addrinfo   *res = NULL, *ai;
+	char               servname[16];
+	int                rc, yes = 1, retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(NULL, "%p", loop);
+
+	stats->flag_hist = (cfg.stats_port > 0) || (cfg.opt_flags & FLAG_OPT_LATENCY);
+	if (!stats->flag_hist)
+		DBG_RETURN_INT(FUNC_RET_OK);
+
+	stats->fd      = -1;
+	stats->ev_base = loop;
+	LIST_INIT(&(stats->clients));
+
+	if (!(cfg.opt_flags & FLAG_OPT_LATENCY)) {
+		/* Do nothing. */;
+	}
+	else if (_NULL(stats->dump_last = calloc(STATS_HISTS, sizeof(*(stats->dump_last))))) {
+		w_log(NULL, STATS_STR _E("Failed to allocate memory"));
+
+		DBG_RETURN_INT(retval);
+	}
+	else {
+		ev_timer_init(&(stats->ev_dump), stats_dump_cb, cfg.monitor_interval_us / 1e6, cfg.monitor_interval_us / 1e6);
+		ev_timer_start(loop, &(stats->ev_dump));
+	}
+
+	if (cfg.stats_port == 0)
+		DBG_RETURN_INT(FUNC_RET_OK);
+
+	(void)snprintf(servname, sizeof(servname), "%d", cfg.stats_port);
+
+	if (_nOK(rc = getaddrinfo(cfg.stats_address, servname, &hints, &res))) {
+		w_log(NULL, STATS_STR _E("Failed to get address info for '%s': %s"), cfg.stats_address, gai_strerror(rc));
+
+		DBG_RETURN_INT(retval);
+	}
+
+	for (ai = res; _nNULL(ai) && _ERROR(retval); ai = ai->ai_next) {
+		stats->fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (_ERROR(stats->fd))
+			/* Do nothing. */;
+		else if (_ERROR(setsockopt(stats->fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes))) ||
+		         _ERROR(bind(stats->fd, ai->ai_addr, ai->ai_addrlen)) ||
+		         _ERROR(listen(stats->fd, cfg.connection_backlog)) ||
+		         _ERROR(socket_set_nonblocking(stats->fd)))
+			FD_CLOSE(stats->fd);
+		else
+			retval = FUNC_RET_OK;
+	}
+
+	freeaddrinfo(res);
+
+	if (_ERROR(retval)) {
+		w_log(NULL, STATS_STR _E("Failed to listen on %s:%d: %m"), cfg.stats_address, cfg.stats_port);
+	}
+	else {
+		ev_io_init(&(stats->ev_accept), stats_accept_cb, stats->fd, EV_READ);
+		ev_io_start(loop, &(stats->ev_accept));
+
+		W_DBG(WORKER, NULL, STATS_STR "listening on %s:%d", cfg.stats_address, cfg.stats_port);
+	}
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   stats_stop -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Closes the statistics listener and the connections, and stops the
+ *   periodic log of the latency percentiles.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void stats_stop(void)
+{
+	struct stats_data   *stats = &(prg.stats);
+	struct stats_client *client, *client_back;
+
+	DBG_FUNC(NULL, "");
+
+	if (_NULL(stats->ev_base))
+		DBG_RETURN();
+
+	if (ev_is_active(&(stats->ev_accept)) || ev_is_pending(&(stats->ev_accept)))
+		ev_io_stop(stats->ev_base, &(stats->ev_accept));
+	if (ev_is_active(&(stats->ev_dump)) || ev_is_pending(&(stats->ev_dump)))
+		ev_timer_stop(stats->ev_base, &(stats->ev_dump));
+
+	list_for_each_entry_safe(client, client_back, &(stats->clients), list)
+		stats_client_close(client);
+
+	FD_CLOSE(stats->fd);
+	PTR_FREE(stats->dump_last);
+	stats->ev_base   = NULL;
+	stats->flag_hist = 0;
+
+	DBG_RETURN();
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
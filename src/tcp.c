@@ -25,52 +25,57 @@
  *   tcp_recv -
  *
  * ARGUMENTS
- *   frame -
- *   len   -
- *   msg   -
+ *   client -
  *
  * DESCRIPTION
- *   -
+ *   Receives as much data as is available into the client receive buffer.
+ *   Before that, the remaining (unprocessed) part of the buffer is moved to
+ *   its beginning; that part can only be the tail of a partially received
+ *   frame.
  *
  * RETURN VALUE
- *   -
+ *   Returns the number of bytes received, 0 if there is no data available,
+ *   or FUNC_RET_ERROR (-1) in case of the error.
  */
-ssize_t tcp_recv(struct spoe_frame *frame, size_t len, const char *msg)
+ssize_t tcp_recv(struct client *client)
 {
-	ssize_t retval;
+	struct buffer *buf = &(client->rd_buf);
+	ssize_t        retval;
 
-	DBG_FUNC(NULL, "%p, %zu, \"%s\"", frame, len, msg);
+	DBG_FUNC(CW_PTR, "%p", client);
 
-	retval = recv(FC_PTR->fd, frame->buf + frame->offset, len - frame->offset, 0);
+	if (client->rd_head > 0) {
+		if (client->rd_head < buf->len)
+			(void)memmove(buf->ptr, buf->ptr + client->rd_head, buf->len - client->rd_head);
+
+		buf->len       -= client->rd_head;
+		client->rd_head = 0;
+	}
+
+	if (buf->len >= buf->size)
+		DBG_RETURN_SSIZE(0);
+
+	retval = recv(client->fd, buf->ptr + buf->len, buf->size - buf->len, 0);
 	if (retval == 0) {
-		if (++(frame->rd_errors) >= TCP_RECV_ERR_MAX) {
-			C_DBG(SPOA, FC_PTR, "socket zero receive limit reached");
+		if (++(client->rd_errors) >= TCP_RECV_ERR_MAX) {
+			C_DBG(SPOA, client, "socket zero receive limit reached");
 
 			errno  = ESTALE;
 			retval = FUNC_RET_ERROR;
 		}
 	}
 	else if (retval > 0) {
-		frame->offset += retval;
-
-		C_DBG(SPOA, FC_PTR, "%zu/%zu/%zu byte(s) received frame%s", retval, frame->offset, len, msg);
+		buf->len         += retval;
+		client->rd_errors = 0;
 
-		if (frame->offset == len) {
-			retval = frame->offset;
-
-			frame->offset    = 0;
-			frame->rd_errors = 0;
-		}
+		C_DBG(SPOA, client, "%zd/%zu/%zu byte(s) received", retval, buf->len, buf->size);
 	}
 	else if (TEST_OR3(errno, EAGAIN, EWOULDBLOCK, EINTR)) {
-		if (++(frame->rd_errors) >= TCP_RECV_ERR_MAX)
-			C_DBG(SPOA, FC_PTR, "socket error receive limit reached");
-		else
-			retval = 0;
+		retval = 0;
 	}
 
 	if (_ERROR(retval))
-		c_log(FC_PTR, _E("Failed to receive frame%s: %m"), msg);
+		c_log(client, _E("Failed to receive data: %m"));
 
 	DBG_RETURN_SSIZE(retval);
 }
@@ -82,25 +87,25 @@ ssize_t tcp_recv(struct spoe_frame *frame, size_t len, const char *msg)
  *
  * ARGUMENTS
  *   client -
- *   frame  -
- *   len    -
- *   msg    -
+ *   iov    -
+ *   iovcnt -
  *
  * DESCRIPTION
- *   -
+ *   Sends the data described by the iov array with a single system call.
  *
  * RETURN VALUE
- *   -
+ *   Returns the number of bytes sent, 0 if no data can be sent at the moment,
+ *   or FUNC_RET_ERROR (-1) in case of the error.
  */
-ssize_t tcp_send(const struct client *client, struct spoe_frame *frame, size_t len, const char *msg)
+ssize_t tcp_send(struct client *client, const struct iovec *iov, int iovcnt)
 {
 	ssize_t retval;
 
-	DBG_FUNC(NULL, "%p, %p, %zu, \"%s\"", client, frame, len, msg);
+	DBG_FUNC(CW_PTR, "%p, %p, %d", client, iov, iovcnt);
 
-	retval = send(client->fd, frame->buf + frame->offset, len - frame->offset, 0);
+	retval = writev(client->fd, iov, iovcnt);
 	if (retval == 0) {
-		if (++(frame->wr_errors) >= TCP_SEND_ERR_MAX) {
+		if (++(client->wr_errors) >= TCP_SEND_ERR_MAX) {
 			C_DBG(SPOA, client, "socket zero send limit reached");
 
 			errno  = ESTALE;
@@ -108,26 +113,19 @@ ssize_t tcp_send(const struct client *client, struct spoe_frame *frame, size_t l
 		}
 	}
 	else if (retval > 0) {
-		frame->offset += retval;
+		client->wr_errors = 0;
 
-		C_DBG(SPOA, client, "%zu/%zu/%zu byte(s) send frame%s", retval, frame->offset, len, msg);
-
-		if (frame->offset == len) {
-			retval = frame->offset;
-
-			frame->offset    = 0;
-			frame->wr_errors = 0;
-		}
+		C_DBG(SPOA, client, "%zd byte(s) sent in %d frame(s)", retval, iovcnt);
 	}
 	else if (TEST_OR3(errno, EAGAIN, EWOULDBLOCK, EINTR)) {
-		if (++(frame->wr_errors) >= TCP_SEND_ERR_MAX)
+		if (++(client->wr_errors) >= TCP_SEND_ERR_MAX)
 			C_DBG(SPOA, client, "socket error send limit reached");
 		else
 			retval = 0;
 	}
 
 	if (_ERROR(retval))
-		c_log(client, _E("Failed to send frame%s: %m"), msg);
+		c_log(client, _E("Failed to send data: %m"));
 
 	DBG_RETURN_SSIZE(retval);
 }
@@ -0,0 +1,731 @@
+/***
+ * Copyright 2018-2020 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+
+
+/***
+ * NAME
+ *   uring_get_sqe -
+ *
+ * ARGUMENTS
+ *   uring -
+ *   count - the number of required SQEs
+ *
+ * DESCRIPTION
+ *   Returns the next free submission queue entry.  If there are not enough
+ *   free entries for the required number of (linked) operations, the already
+ *   queued entries are submitted first.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct io_uring_sqe *uring_get_sqe(struct uring_data *uring, uint count)
+{
+	struct io_uring_sqe *retval;
+
+	DBG_FUNC(NULL, "%p, %u", uring, count);
+
+	if (io_uring_sq_space_left(&(uring->ring)) < count)
+		(void)io_uring_submit(&(uring->ring));
+
+	retval = io_uring_get_sqe(&(uring->ring));
+
+	DBG_RETURN_PTR(retval);
+}
+
+
+/***
+ * NAME
+ *   uring_recv_arm -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Arms the multishot receive operation of the client; the received data is
+ *   stored in the buffers selected from the provided buffer ring.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_OK (0) on success, or FUNC_RET_ERROR (-1) in case of
+ *   the error.
+ */
+static int uring_recv_arm(struct client *client)
+{
+	struct io_uring_sqe *sqe;
+
+	DBG_FUNC(CW_PTR, "%p", client);
+
+	if (_NULL(sqe = uring_get_sqe(&(CW_PTR->uring), 1))) {
+		c_log(client, _E(URING_STR "Failed to get submission queue entry"));
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	io_uring_prep_recv_multishot(sqe, client->fd, NULL, 0, 0);
+	io_uring_sqe_set_flags(sqe, IOSQE_BUFFER_SELECT);
+	sqe->buf_group = URING_BUF_GROUP;
+	io_uring_sqe_set_data64(sqe, URING_DATA(client, URING_OP_RECV));
+
+	client->uring.recv_armed = 1;
+	client->uring.ops++;
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   uring_buf_recycle -
+ *
+ * ARGUMENTS
+ *   uring -
+ *   bid   -
+ *
+ * DESCRIPTION
+ *   Returns the buffer to the provided buffer ring.  The clients waiting for
+ *   a free buffer can then receive the data again.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void uring_buf_recycle(struct uring_data *uring, int bid)
+{
+	struct client *c, *cback;
+
+	io_uring_buf_ring_add(uring->br, uring->bufs + (size_t)bid * URING_BUF_SIZE, URING_BUF_SIZE, bid, io_uring_buf_ring_mask(URING_BUF_COUNT), 0);
+	io_uring_buf_ring_advance(uring->br, 1);
+
+	list_for_each_entry_safe(c, cback, &(uring->starved), uring.by_starved) {
+		LIST_DEL(&(c->uring.by_starved));
+		LIST_INIT(&(c->uring.by_starved));
+
+		if (_ERROR(uring_recv_arm(c)))
+			c->uring.error = EIO;
+	}
+}
+
+
+/***
+ * NAME
+ *   uring_client_free -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Frees the released client after all its operations have been completed.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void uring_client_free(struct client *client)
+{
+	struct spoe_frame *f, *fback;
+
+	DBG_FUNC(CW_PTR, "%p", client);
+
+	C_DBG(SPOA, client, URING_STR "Free client");
+
+	LIST_DEL(&(client->by_worker));
+	list_for_each_entry_safe(f, fback, &(client->uring.sending), list)
+		release_frame(f);
+
+	FD_CLOSE(client->fd);
+	PTR_FREE(client);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   uring_recv_cqe -
+ *
+ * ARGUMENTS
+ *   client -
+ *   res    -
+ *   flags  -
+ *
+ * DESCRIPTION
+ *   Handles the completion of the receive operation.  The received buffer is
+ *   queued to the client and copied to its receive buffer when the client
+ *   reads the frames.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void uring_recv_cqe(struct client *client, int res, uint flags)
+{
+	struct uring_data *uring = &(CW_PTR->uring);
+	struct uring_buf  *buf;
+	int                bid = -1;
+
+	DBG_FUNC(CW_PTR, "%p, %d, 0x%08x", client, res, flags);
+
+	if (flags & IORING_CQE_F_BUFFER)
+		bid = flags >> IORING_CQE_BUFFER_SHIFT;
+
+	if (!(flags & IORING_CQE_F_MORE)) {
+		client->uring.recv_armed = 0;
+		client->uring.ops--;
+	}
+
+	if (client->uring.closing) {
+		if (bid >= 0)
+			uring_buf_recycle(uring, bid);
+	}
+	else if (res > 0) {
+		C_DBG(SPOA, client, URING_STR "%d byte(s) received in buffer %d", res, bid);
+
+		buf         = uring->bufs_info + bid;
+		buf->len    = res;
+		buf->offset = 0;
+		buf->next   = -1;
+
+		if (client->uring.bufs_tail >= 0)
+			uring->bufs_info[client->uring.bufs_tail].next = bid;
+		else
+			client->uring.bufs_head = bid;
+		client->uring.bufs_tail = bid;
+
+		if (!client->uring.recv_armed && _ERROR(uring_recv_arm(client)))
+			client->uring.error = EIO;
+	}
+	else if (res == -ENOBUFS) {
+		/* The multishot receive is armed again when a buffer is recycled. */
+		C_DBG(SPOA, client, URING_STR "No receive buffer available");
+
+		LIST_ADDQ(&(uring->starved), &(client->uring.by_starved));
+	}
+	else {
+		client->uring.error = (res == 0) ? ESTALE : -res;
+	}
+
+	if (client->uring.closing) {
+		if (client->uring.ops == 0)
+			uring_client_free(client);
+	}
+	else if (!client->uring.rd_stopped && uring_recv_pending(client)) {
+		ev_feed_event(CW_PTR->ev_base, &(client->ev_frame_rd), EV_CUSTOM);
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   uring_send_cqe -
+ *
+ * ARGUMENTS
+ *   client -
+ *   res    -
+ *
+ * DESCRIPTION
+ *   Handles the completion of the send operation.  The send operations of
+ *   the client are linked, so they are completed in the order in which the
+ *   frames have been submitted.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void uring_send_cqe(struct client *client, int res)
+{
+	struct spoe_frame *f;
+
+	DBG_FUNC(CW_PTR, "%p, %d", client, res);
+
+	client->uring.ops--;
+	client->uring.sends--;
+
+	if (client->uring.closing) {
+		if (client->uring.ops == 0)
+			uring_client_free(client);
+
+		DBG_RETURN();
+	}
+
+	f = LIST_NEXT(&(client->uring.sending), typeof(f), list);
+
+	if ((res < 0) || ((size_t)res != (SPOA_FRM_LEN + f->len - f->offset))) {
+		if (res < 0)
+			c_log(client, _E(URING_STR "Failed to send data: %s"), strerror(-res));
+		else
+			c_log(client, _E(URING_STR "Failed to send data: %d/%zu byte(s) sent"), res, SPOA_FRM_LEN + f->len - f->offset);
+
+		release_client(client);
+
+		DBG_RETURN();
+	}
+
+	C_DBG(SPOA, client, URING_STR "%d byte(s) sent", res);
+
+	if (_ERROR(write_frame_done(client, f)))
+		DBG_RETURN();
+
+	if (client->uring.sends == 0)
+		write_frame_resume(client);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   uring_cqe_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Handles all the available completion queue entries.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void uring_cqe_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	struct uring_data   *uring = ev->data;
+	struct io_uring_cqe *cqe;
+	struct client       *client;
+	uint64_t             data;
+	uint                 flags;
+	int                  res;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	while (io_uring_peek_cqe(&(uring->ring), &cqe) == 0) {
+		data  = io_uring_cqe_get_data64(cqe);
+		res   = cqe->res;
+		flags = cqe->flags;
+		io_uring_cqe_seen(&(uring->ring), cqe);
+
+		client = URING_DATA_PTR(data);
+
+		if (URING_DATA_OP(data) == URING_OP_RECV) {
+			uring_recv_cqe(client, res, flags);
+		}
+		else if (URING_DATA_OP(data) == URING_OP_SEND) {
+			uring_send_cqe(client, res);
+		}
+		else if (URING_DATA_OP(data) == URING_OP_CANCEL) {
+			if ((--(client->uring.ops) == 0) && client->uring.closing)
+				uring_client_free(client);
+		}
+	}
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   uring_submit_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Submits all the operations queued during the current loop iteration
+ *   with a single system call, before the event loop blocks.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void uring_submit_cb(struct ev_loop *loop __maybe_unused, struct ev_prepare *ev, int revents __maybe_unused)
+{
+	struct uring_data *uring = ev->data;
+	int                rc;
+
+	if (io_uring_sq_ready(&(uring->ring)) == 0)
+		return;
+
+	DBG_FUNC(NULL, "%p, %p, 0x%08x", loop, ev, revents);
+
+	if ((rc = io_uring_submit(&(uring->ring))) < 0)
+		w_log(NULL, _E(URING_STR "Failed to submit operations: %s"), strerror(-rc));
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   uring_init -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Initializes the io_uring instance of the worker together with its
+ *   provided buffer ring.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_OK (0) on success, or FUNC_RET_ERROR (-1) in case of
+ *   the error.
+ */
+int uring_init(struct worker *worker)
+{
+	struct uring_data      *uring = &(worker->uring);
+	struct io_uring_params  params;
+	int                     i, rc;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	(void)memset(uring, 0, sizeof(*uring));
+	(void)memset(&params, 0, sizeof(params));
+	uring->ring.ring_fd = -1;
+	LIST_INIT(&(uring->closing));
+	LIST_INIT(&(uring->starved));
+
+	params.flags      = IORING_SETUP_CQSIZE;
+	params.cq_entries = URING_CQ_ENTRIES;
+
+	if ((rc = io_uring_queue_init_params(URING_SQ_ENTRIES, &(uring->ring), &params)) < 0) {
+		w_log(worker, _E(URING_STR "Failed to initialize ring: %s"), strerror(-rc));
+
+		uring->ring.ring_fd = -1;
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+	else if (_NULL(uring->bufs = malloc((size_t)URING_BUF_COUNT * URING_BUF_SIZE))) {
+		w_log(worker, _E(URING_STR "Failed to allocate receive buffers: %m"));
+	}
+	else if (_NULL(uring->bufs_info = calloc(URING_BUF_COUNT, sizeof(*(uring->bufs_info))))) {
+		w_log(worker, _E(URING_STR "Failed to allocate receive buffers: %m"));
+	}
+	else if (_NULL(uring->br = io_uring_setup_buf_ring(&(uring->ring), URING_BUF_COUNT, URING_BUF_GROUP, 0, &rc))) {
+		w_log(worker, _E(URING_STR "Failed to register provided buffer ring: %s"), strerror(-rc));
+	}
+	else {
+		for (i = 0; i < URING_BUF_COUNT; i++)
+			io_uring_buf_ring_add(uring->br, uring->bufs + (size_t)i * URING_BUF_SIZE, URING_BUF_SIZE, i, io_uring_buf_ring_mask(URING_BUF_COUNT), i);
+		io_uring_buf_ring_advance(uring->br, URING_BUF_COUNT);
+
+		uring->ev_base = worker->ev_base;
+
+		ev_io_init(&(uring->ev_cqe), uring_cqe_cb, uring->ring.ring_fd, EV_READ);
+		uring->ev_cqe.data = uring;
+		ev_io_start(uring->ev_base, &(uring->ev_cqe));
+
+		ev_prepare_init(&(uring->ev_submit), uring_submit_cb);
+		uring->ev_submit.data = uring;
+		ev_prepare_start(uring->ev_base, &(uring->ev_submit));
+
+		W_DBG(WORKER, worker, URING_STR "ring initialized, %u/%u entries", params.sq_entries, params.cq_entries);
+
+		DBG_RETURN_INT(FUNC_RET_OK);
+	}
+
+	uring_close(worker);
+
+	DBG_RETURN_INT(FUNC_RET_ERROR);
+}
+
+
+/***
+ * NAME
+ *   uring_close -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Closes the io_uring instance of the worker.  The clients that are still
+ *   waiting for the completion of their operations are freed after that.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void uring_close(struct worker *worker)
+{
+	struct uring_data *uring = &(worker->uring);
+	struct client     *c, *cback;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	if (uring->ring.ring_fd < 0)
+		DBG_RETURN();
+
+	if (_nNULL(uring->ev_base)) {
+		if (ev_is_active(&(uring->ev_cqe)) || ev_is_pending(&(uring->ev_cqe)))
+			ev_io_stop(uring->ev_base, &(uring->ev_cqe));
+		if (ev_is_active(&(uring->ev_submit)) || ev_is_pending(&(uring->ev_submit)))
+			ev_prepare_stop(uring->ev_base, &(uring->ev_submit));
+	}
+
+	if (_nNULL(uring->br))
+		(void)io_uring_free_buf_ring(&(uring->ring), uring->br, URING_BUF_COUNT, URING_BUF_GROUP);
+	io_uring_queue_exit(&(uring->ring));
+
+	list_for_each_entry_safe(c, cback, &(uring->closing), by_worker)
+		uring_client_free(c);
+
+	PTR_FREE(uring->bufs_info);
+	PTR_FREE(uring->bufs);
+	(void)memset(uring, 0, sizeof(*uring));
+	uring->ring.ring_fd = -1;
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   uring_client_init -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Switches the client to the io_uring transport.  This is done in the
+ *   worker thread, on the first read event of the client connection; from
+ *   then on the readiness watchers of the client are no longer started.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_OK (0) on success, or FUNC_RET_ERROR (-1) in case of
+ *   the error.
+ */
+int uring_client_init(struct client *client)
+{
+	DBG_FUNC(CW_PTR, "%p", client);
+
+	C_DBG(SPOA, client, URING_STR "Switching to io_uring transport");
+
+	if (ev_is_active(&(client->ev_frame_rd)) || ev_is_pending(&(client->ev_frame_rd)))
+		ev_io_stop(CW_PTR->ev_base, &(client->ev_frame_rd));
+
+	client->uring.active     = 1;
+	client->uring.rd_stopped = 0;
+	client->uring.bufs_head  = -1;
+	client->uring.bufs_tail  = -1;
+	LIST_INIT(&(client->uring.sending));
+	LIST_INIT(&(client->uring.by_starved));
+
+	DBG_RETURN_INT(uring_recv_arm(client));
+}
+
+
+/***
+ * NAME
+ *   uring_client_release -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Releases the io_uring resources of the client.  If the client still has
+ *   uncompleted operations, they are canceled and the client is freed when
+ *   the last of them completes.
+ *
+ * RETURN VALUE
+ *   Returns 1 if the client will be freed later, otherwise 0.
+ */
+bool_t uring_client_release(struct client *client)
+{
+	struct uring_data   *uring = &(CW_PTR->uring);
+	struct io_uring_sqe *sqe;
+	int                  bid;
+
+	DBG_FUNC(CW_PTR, "%p", client);
+
+	LIST_DEL(&(client->uring.by_starved));
+	LIST_INIT(&(client->uring.by_starved));
+
+	for (bid = client->uring.bufs_head; bid >= 0; bid = uring->bufs_info[bid].next)
+		uring_buf_recycle(uring, bid);
+	client->uring.bufs_head = client->uring.bufs_tail = -1;
+
+	if (client->uring.ops == 0)
+		DBG_RETURN_INT(0);
+
+	C_DBG(SPOA, client, URING_STR "Canceling %u operation(s)", client->uring.ops);
+
+	client->uring.closing = 1;
+	(void)shutdown(client->fd, SHUT_RDWR);
+
+	if (_nNULL(sqe = uring_get_sqe(uring, 1))) {
+		io_uring_prep_cancel_fd(sqe, client->fd, IORING_ASYNC_CANCEL_ALL);
+		io_uring_sqe_set_data64(sqe, URING_DATA(client, URING_OP_CANCEL));
+		client->uring.ops++;
+	}
+
+	LIST_ADDQ(&(uring->closing), &(client->by_worker));
+
+	DBG_RETURN_INT(1);
+}
+
+
+/***
+ * NAME
+ *   uring_recv_pending -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Checks whether there is received data (or a receive error) that has not
+ *   yet been taken by the client.
+ *
+ * RETURN VALUE
+ *   -
+ */
+bool_t uring_recv_pending(const struct client *client)
+{
+	return (client->uring.bufs_head >= 0) || (client->uring.error != 0);
+}
+
+
+/***
+ * NAME
+ *   uring_recv -
+ *
+ * ARGUMENTS
+ *   client -
+ *
+ * DESCRIPTION
+ *   Copies the received data into the client receive buffer, the io_uring
+ *   counterpart of the tcp_recv() function.  The buffers copied in whole are
+ *   returned to the provided buffer ring.
+ *
+ *   The frames are not parsed from the provided buffers directly, since a
+ *   frame can span several of them, and the buffers are shared by all the
+ *   clients of the worker: holding them until the frame is complete could
+ *   starve the multishot receives of the other clients.
+ *
+ * RETURN VALUE
+ *   Returns the number of bytes copied, 0 if there is no data available,
+ *   or FUNC_RET_ERROR (-1) in case of the error.
+ */
+ssize_t uring_recv(struct client *client)
+{
+	struct uring_data *uring = &(CW_PTR->uring);
+	struct buffer     *buf = &(client->rd_buf);
+	struct uring_buf  *ub;
+	ssize_t            retval = 0;
+	size_t             n;
+
+	DBG_FUNC(CW_PTR, "%p", client);
+
+	if (client->rd_head > 0) {
+		if (client->rd_head < buf->len)
+			(void)memmove(buf->ptr, buf->ptr + client->rd_head, buf->len - client->rd_head);
+
+		buf->len       -= client->rd_head;
+		client->rd_head = 0;
+	}
+
+	while ((client->uring.bufs_head >= 0) && (buf->len < buf->size)) {
+		ub = uring->bufs_info + client->uring.bufs_head;
+		n  = MIN(buf->size - buf->len, ub->len - ub->offset);
+
+		(void)memcpy(buf->ptr + buf->len, uring->bufs + (size_t)client->uring.bufs_head * URING_BUF_SIZE + ub->offset, n);
+		buf->len   += n;
+		ub->offset += n;
+		retval     += n;
+
+		if (ub->offset < ub->len)
+			break;
+
+		uring_buf_recycle(uring, client->uring.bufs_head);
+
+		if ((client->uring.bufs_head = ub->next) < 0)
+			client->uring.bufs_tail = -1;
+	}
+
+	if (retval > 0) {
+		C_DBG(SPOA, client, "%zd/%zu/%zu byte(s) received", retval, buf->len, buf->size);
+	}
+	else if ((client->uring.bufs_head < 0) && (client->uring.error != 0)) {
+		errno  = client->uring.error;
+		retval = FUNC_RET_ERROR;
+
+		c_log(client, _E("Failed to receive data: %m"));
+	}
+
+	DBG_RETURN_SSIZE(retval);
+}
+
+
+/***
+ * NAME
+ *   uring_send -
+ *
+ * ARGUMENTS
+ *   client -
+ *   frames -
+ *   iov    -
+ *   iovcnt -
+ *
+ * DESCRIPTION
+ *   Submits one send operation per frame.  The operations are linked, so the
+ *   frames are sent one after another in the given order; MSG_WAITALL makes
+ *   sure that a short send breaks the chain instead of interleaving the data
+ *   of two frames.  The frames are moved to the list of the frames being
+ *   sent until their operations complete.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_OK (0) on success, or FUNC_RET_ERROR (-1) in case of
+ *   the error.
+ */
+int uring_send(struct client *client, struct spoe_frame **frames, const struct iovec *iov, int iovcnt)
+{
+	struct io_uring_sqe *sqe;
+	int                  i;
+
+	DBG_FUNC(CW_PTR, "%p, %p, %p, %d", client, frames, iov, iovcnt);
+
+	for (i = 0; i < iovcnt; i++) {
+		if (_NULL(sqe = uring_get_sqe(&(CW_PTR->uring), (i == 0) ? iovcnt : 1))) {
+			c_log(client, _E(URING_STR "Failed to get submission queue entry"));
+
+			DBG_RETURN_INT(FUNC_RET_ERROR);
+		}
+
+		io_uring_prep_send(sqe, client->fd, iov[i].iov_base, iov[i].iov_len, MSG_NOSIGNAL | MSG_WAITALL);
+		if (i < (iovcnt - 1))
+			io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+		io_uring_sqe_set_data64(sqe, URING_DATA(client, URING_OP_SEND));
+
+		LIST_DEL(&(frames[i]->list));
+		LIST_ADDQ(&(client->uring.sending), &(frames[i]->list));
+		client->uring.ops++;
+		client->uring.sends++;
+	}
+
+	client->outgoing_frame = NULL;
+
+	C_DBG(SPOA, client, URING_STR "%d frame(s) queued for sending", iovcnt);
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -19,6 +19,10 @@
  */
 #include "include.h"
 
+static __THR struct log_ring *log_ring_cur    = NULL;
+static __THR struct ev_loop  *log_loop        = NULL;
+static __THR bool_t           log_flag_direct = 0;
+
 
 /***
  * NAME
@@ -239,8 +243,6 @@ ssize_t buffer_grow(struct buffer *data, const void *src, size_t n)
 		if (_NULL(src)) {
 			/* Clearing allocated buffer. */
 			(void)memset(ptr + data->size, 0, size);
-
-			data->size += size;
 		} else {
 			/* Copying src data to buffer. */
 			(void)memcpy(ptr + data->len, src, n);
@@ -248,7 +250,8 @@ ssize_t buffer_grow(struct buffer *data, const void *src, size_t n)
 			data->len += n;
 		}
 
-		data->ptr = ptr;
+		data->ptr   = ptr;
+		data->size += size;
 
 		retval = data->len;
 	}
@@ -655,6 +658,7 @@ char *parse_url(const char *url)
 	uint64_t  rc;
 	size_t    len;
 	bool_t    flag_https = 0;
+	int       rc_host;
 
 	DBG_FUNC(NULL, "\"%s\"", url);
 
@@ -703,8 +707,17 @@ char *parse_url(const char *url)
 	/* Remove all the trailing '/' characters from the URL. */
 	for (ptr = retptr + len - 1; *ptr == '/'; *(ptr--) = '\0');
 
-	/* Find the port number if it is defined. */
-	for (ptr = host; TEST_NAND3(*ptr, '\0', ':', '/'); ptr++);
+	/*
+	 * Find the port number if it is defined.  The IPv6 address literal is
+	 * enclosed in square brackets, e.g. http://[::1]:8080/.
+	 */
+	ptr = host;
+	if (*ptr == '[') {
+		for (ptr++; TEST_NAND3(*ptr, '\0', ']', '/'); ptr++);
+		if (*ptr == ']')
+			ptr++;
+	}
+	for ( ; TEST_NAND3(*ptr, '\0', ':', '/'); ptr++);
 	if (*ptr == ':') {
 		*(ptr++) = '\0';
 		for (port = ptr; TEST_NAND2(*ptr, '\0', '/'); ptr++);
@@ -719,7 +732,20 @@ char *parse_url(const char *url)
 
 	W_DBG(UTIL, NULL, "host: \"%s\", port: \"%s\", path: '%c'", host, port, path);
 
-	if (_ERROR(parse_hostname(host))) {
+	/* The brackets are not a part of the IPv6 address. */
+	if (*host != '[') {
+		rc_host = parse_hostname(host);
+	}
+	else if (((len = strlen(host)) < 3) || (host[len - 1] != ']')) {
+		rc_host = FUNC_RET_ERROR;
+	}
+	else {
+		host[len - 1] = '\0';
+		rc_host       = parse_hostname(host + 1);
+		host[len - 1] = ']';
+	}
+
+	if (_ERROR(rc_host)) {
 		w_log(NULL, _E("Invalid hostname '%s'"), host);
 
 		PTR_FREE(retptr);
@@ -773,10 +799,55 @@ static __always_inline int thread_id(void)
 		if (pthread_equal((prg.workers + i)->thread, id))
 			retval = i + 1;
 
+#ifdef HAVE_LIBCURL
+	/* The mirror senders are numbered after the workers. */
+	for (i = 0; (retval == 0) && _nNULL(prg.senders) && (i < cfg.mir_threads); i++)
+		if (pthread_equal((prg.senders + i)->thread, id))
+			retval = cfg.num_workers + i + 1;
+#endif
+
 	return retval;
 }
 
 
+/***
+ * NAME
+ *   log_ring_get -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Returns the ring buffer of the calling thread, the ring is allocated and
+ *   added to the list of rings on the first use.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct log_ring *log_ring_get(void)
+{
+	struct log_ring *ring;
+
+	if (_nNULL(log_ring_cur) || log_flag_direct)
+		return log_ring_cur;
+
+	if (_NULL(ring = calloc(1, sizeof(*ring))))
+		return NULL;
+	else if (_NULL(ring->buf = malloc(LOG_RING_SIZE))) {
+		PTR_FREE(ring);
+
+		return NULL;
+	}
+
+	ring->next = __atomic_load_n(&(prg.logger.rings), __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&(prg.logger.rings), &(ring->next), ring, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	log_ring_cur = ring;
+
+	return ring;
+}
+
+
 /***
  * NAME
  *   time_elapsed -
@@ -800,6 +871,272 @@ uint64_t time_elapsed(const struct timeval *tv)
 }
 
 
+/***
+ * NAME
+ *   log_thread_init -
+ *
+ * ARGUMENTS
+ *   loop - event loop of the calling thread, or NULL
+ *
+ * DESCRIPTION
+ *   Sets the event loop whose cached time is used for the timestamps of the
+ *   log messages of the calling thread, so that logging does not have to
+ *   read the clock.  The loop has to be unset before it is destroyed.  The
+ *   ring buffer of the thread is allocated here, outside of the frame path.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void log_thread_init(struct ev_loop *loop)
+{
+	log_loop = loop;
+
+	if (_nNULL(loop))
+		(void)log_ring_get();
+}
+
+
+/***
+ * NAME
+ *   log_runtime -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the timestamp of the log message.
+ */
+static double log_runtime(void)
+{
+	uint64_t now, start = TIMEVAL_US(&(prg.start_time));
+
+	now = _NULL(log_loop) ? time_elapsed(NULL) : (uint64_t)(ev_now(log_loop) * 1e6);
+
+	return LOG_RUNTIME((now > start) ? (now - start) : 0, now);
+}
+
+
+/***
+ * NAME
+ *   log_vprintf -
+ *
+ * ARGUMENTS
+ *   format -
+ *   ap     -
+ *
+ * DESCRIPTION
+ *   Formats the log message into the ring buffer of the calling thread.  The
+ *   message is written directly to the stdout if the log flusher thread is
+ *   not running or if the ring cannot be allocated.  If the ring is full,
+ *   the message is dropped and counted.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void log_vprintf(const char *format, va_list ap)
+{
+	struct log_ring *ring;
+	char             line[BUFSIZ];
+	uint64_t         head, tail;
+	size_t           len, n, pos;
+	int              rc;
+
+	if (!__atomic_load_n(&(prg.logger.flag_running), __ATOMIC_ACQUIRE) || _NULL(ring = log_ring_get())) {
+		(void)vfprintf(stdout, format, ap);
+
+		return;
+	}
+
+	rc = vsnprintf(line, sizeof(line), format, ap);
+	if (rc <= 0)
+		return;
+
+	/* The truncated message keeps its terminating newline. */
+	len = MIN((size_t)rc, sizeof(line) - 1);
+	if ((size_t)rc > len)
+		line[len - 1] = '\n';
+
+	head = ring->head;
+	tail = __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE);
+	if ((LOG_RING_SIZE - (head - tail)) < len) {
+		(void)__atomic_add_fetch(&(ring->dropped), 1, __ATOMIC_RELAXED);
+
+		return;
+	}
+
+	pos = head & (LOG_RING_SIZE - 1);
+	n   = MIN(len, LOG_RING_SIZE - pos);
+	(void)memcpy(ring->buf + pos, line, n);
+	if (n < len)
+		(void)memcpy(ring->buf, line + n, len - n);
+
+	__atomic_store_n(&(ring->head), head + len, __ATOMIC_RELEASE);
+}
+
+
+/***
+ * NAME
+ *   log_flush -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Writes the contents of all the ring buffers to the stdout.  Only whole
+ *   messages are ever published in a ring, so the messages of different
+ *   threads are not mixed up within a line.
+ *
+ * RETURN VALUE
+ *   Returns the number of bytes written.
+ */
+static size_t log_flush(void)
+{
+	struct log_ring *ring;
+	uint64_t         head, tail, dropped = 0;
+	size_t           n, pos, retval = 0;
+
+	for (ring = __atomic_load_n(&(prg.logger.rings), __ATOMIC_ACQUIRE); _nNULL(ring); ring = ring->next) {
+		head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+		tail = ring->tail;
+
+		if (head != tail) {
+			pos = tail & (LOG_RING_SIZE - 1);
+			n   = MIN(head - tail, LOG_RING_SIZE - pos);
+			(void)fwrite(ring->buf + pos, 1, n, stdout);
+			if (n < (head - tail))
+				(void)fwrite(ring->buf, 1, head - tail - n, stdout);
+
+			__atomic_store_n(&(ring->tail), head, __ATOMIC_RELEASE);
+
+			retval += head - tail;
+		}
+
+		dropped += __atomic_load_n(&(ring->dropped), __ATOMIC_RELAXED);
+	}
+
+	if (dropped > prg.logger.dropped_last) {
+		w_log(NULL, _W("%"PRIu64" log messages dropped"), dropped - prg.logger.dropped_last);
+
+		prg.logger.dropped_last = dropped;
+		retval++;
+	}
+
+	if (retval > 0)
+		(void)fflush(stdout);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   log_thread -
+ *
+ * ARGUMENTS
+ *   data -
+ *
+ * DESCRIPTION
+ *   The log flusher thread, it periodically empties the ring buffers of the
+ *   other threads.  The messages of this thread are written directly.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static void *log_thread(void *data __maybe_unused)
+{
+	(void)pthread_setname_np(pthread_self(), "sm/log");
+
+	log_flag_direct = 1;
+
+	while (!__atomic_load_n(&(prg.logger.flag_stop), __ATOMIC_ACQUIRE))
+		if (log_flush() == 0)
+			(void)usleep(LOG_FLUSH_INTERVAL);
+
+	(void)log_flush();
+
+	return NULL;
+}
+
+
+/***
+ * NAME
+ *   log_start -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Starts the log flusher thread.  From then on, the log messages are
+ *   written asynchronously.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int log_start(void)
+{
+	int rc;
+
+	DBG_FUNC(NULL, "");
+
+	prg.logger.flag_stop = 0;
+
+	rc = pthread_create(&(prg.logger.thread), NULL, log_thread, NULL);
+	if (rc != 0) {
+		w_log(NULL, _E("Failed to start log thread: %s"), strerror(rc));
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	__atomic_store_n(&(prg.logger.flag_running), 1, __ATOMIC_RELEASE);
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   log_stop -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Stops the log flusher thread after it has written the remaining log
+ *   messages.  Has to be called after all the other threads are stopped.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void log_stop(void)
+{
+	struct log_ring *ring, *next;
+
+	DBG_FUNC(NULL, "");
+
+	if (__atomic_load_n(&(prg.logger.flag_running), __ATOMIC_ACQUIRE)) {
+		__atomic_store_n(&(prg.logger.flag_running), 0, __ATOMIC_RELEASE);
+		__atomic_store_n(&(prg.logger.flag_stop), 1, __ATOMIC_RELEASE);
+
+		(void)pthread_join(prg.logger.thread, NULL);
+	}
+
+	for (ring = __atomic_exchange_n(&(prg.logger.rings), NULL, __ATOMIC_ACQUIRE); _nNULL(ring); ring = next) {
+		next = ring->next;
+
+		PTR_FREE(ring->buf);
+		PTR_FREE(ring);
+	}
+
+	log_ring_cur = NULL;
+	log_loop     = NULL;
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   c_log -
@@ -820,7 +1157,7 @@ void c_log(const struct client *client, const char *format, ...)
 	char    fmt[BUFSIZ];
 	double  runtime;
 
-	runtime = LOG_RUNTIME(time_elapsed(&(prg.start_time)), time_elapsed(NULL));
+	runtime = log_runtime();
 
 	if (_NULL(client) || _NULL(CW_PTR))
 		(void)snprintf(fmt, sizeof(fmt), LOG_FMT LOG_FMT_INDENT "%s\n",
@@ -830,7 +1167,7 @@ void c_log(const struct client *client, const char *format, ...)
 		               CW_PTR->id, runtime, LOG_INDENT client->id, client->fd, format);
 
 	va_start(ap, format);
-	(void)vfprintf(stdout, fmt, ap);
+	log_vprintf(fmt, ap);
 	va_end(ap);
 }
 
@@ -855,7 +1192,7 @@ void f_log(const struct spoe_frame *frame, const char *format, ...)
 	char    fmt[BUFSIZ];
 	double  runtime;
 
-	runtime = LOG_RUNTIME(time_elapsed(&(prg.start_time)), time_elapsed(NULL));
+	runtime = log_runtime();
 
 	if (_NULL(frame) || _NULL(FC_PTR))
 		(void)snprintf(fmt, sizeof(fmt), LOG_FMT LOG_FMT_INDENT "%s\n",
@@ -866,7 +1203,7 @@ void f_log(const struct spoe_frame *frame, const char *format, ...)
 		               runtime, LOG_INDENT FC_PTR->id, format);
 
 	va_start(ap, format);
-	(void)vfprintf(stdout, fmt, ap);
+	log_vprintf(fmt, ap);
 	va_end(ap);
 }
 
@@ -892,11 +1229,11 @@ void w_log(const struct worker *worker, const char *format, ...)
 
 	(void)snprintf(fmt, sizeof(fmt), LOG_FMT LOG_FMT_INDENT "%s\n",
 	               STRUCT_ELEM(worker, id, thread_id()),
-		       LOG_RUNTIME(time_elapsed(&(prg.start_time)), time_elapsed(NULL)),
+	               log_runtime(),
 	               LOG_INDENT format);
 
 	va_start(ap, format);
-	(void)vfprintf(stdout, fmt, ap);
+	log_vprintf(fmt, ap);
 	va_end(ap);
 }
 
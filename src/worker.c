@@ -20,6 +20,101 @@
 #include "include.h"
 
 
+/***
+ * NAME
+ *   worker_client_start -
+ *
+ * ARGUMENTS
+ *   worker -
+ *   client -
+ *
+ * DESCRIPTION
+ *   Adds the client to the worker and starts reading its frames.  This
+ *   function can only be called from the thread of the worker.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void worker_client_start(struct worker *worker, struct client *client)
+{
+	DBG_FUNC(worker, "%p, %p", worker, client);
+
+	LIST_ADDQ(&(worker->clients), &(client->by_worker));
+	ev_io_start(worker->ev_base, &(client->ev_frame_rd));
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   worker_client_push -
+ *
+ * ARGUMENTS
+ *   worker -
+ *   client -
+ *
+ * DESCRIPTION
+ *   Hands the client accepted by the main thread over to the worker.  The
+ *   worker is only woken up if it has not been woken up yet for a previous
+ *   client, so the clients accepted in one pass of the main event loop cost
+ *   a single wakeup.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void worker_client_push(struct worker *worker, struct client *client)
+{
+	DBG_FUNC(worker, "%p, %p", worker, client);
+
+	client->next = __atomic_load_n(&(worker->accepted), __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&(worker->accepted), &(client->next), client, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+	if (_NULL(client->next))
+		ev_async_send(worker->ev_base, &(worker->ev_async));
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   worker_client_collect -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Starts the clients handed over to the worker by the main thread, in the
+ *   order in which they were accepted.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void worker_client_collect(struct worker *worker)
+{
+	struct client *c, *next, *clients = NULL;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	c = __atomic_exchange_n(&(worker->accepted), NULL, __ATOMIC_ACQUIRE);
+	for ( ; _nNULL(c); c = next) {
+		next    = c->next;
+		c->next = clients;
+		clients = c;
+	}
+
+	for (c = clients; _nNULL(c); c = next) {
+		next    = c->next;
+		c->next = NULL;
+
+		worker_client_start(worker, c);
+	}
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   worker_async_cb -
@@ -30,19 +125,28 @@
  *   revents -
  *
  * DESCRIPTION
- *   -
+ *   Handles the notifications sent to the worker by the other threads.  The
+ *   changes made by the worker to its own event watchers do not need it.
  *
  * RETURN VALUE
  *   This function does not return a value.
  */
-static void worker_async_cb(struct ev_loop *loop __maybe_unused, struct ev_async *ev __maybe_unused, int revents __maybe_unused)
+static void worker_async_cb(struct ev_loop *loop, struct ev_async *ev, int revents __maybe_unused)
 {
-#ifdef DEBUG
-	const STRUCT_ADDR(worker, w, ev_async);
+	STRUCT_ADDR(worker, w, ev_async);
 
 	DBG_FUNC(w, "%p, %p, 0x%08x", loop, ev, revents);
+
+	worker_client_collect(w);
+
+#ifdef HAVE_LIBCURL
+	if (cfg.mir_threads > 0)
+		mir_sender_collect(w);
 #endif
 
+	if (__atomic_load_n(&(w->flag_stop), __ATOMIC_RELAXED))
+		ev_break(loop, EVBREAK_ONE);
+
 	DBG_RETURN();
 }
 
@@ -96,6 +200,10 @@ static int bind_server_socket(struct addrinfo *ai)
 		w_log(NULL, _W("Failed to create server socket: %m"));
 	else if (_ERROR(setsockopt(retval, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes))))
 		w_log(NULL, _W("Failed to set SO_REUSEADDR on server socket: %m"));
+#ifdef SO_REUSEPORT
+	else if ((cfg.reuseport != REUSEPORT_NONE) && _ERROR(setsockopt(retval, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes))))
+		w_log(NULL, _W("Failed to set SO_REUSEPORT on server socket: %m"));
+#endif
 	else if (_ERROR(setsockopt(retval, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes))))
 		w_log(NULL, _W("Failed to set TCP_NODELAY on server socket: %m"));
 	else if (_ERROR(socket_set_keepalive(retval, -1, 4, 1, 3)))
@@ -179,6 +287,328 @@ static int create_server_socket(void)
 }
 
 
+/***
+ * NAME
+ *   worker_cpus -
+ *
+ * ARGUMENTS
+ *   cpus - the array for the CPU ids, can be NULL
+ *   size - the size of the array
+ *
+ * DESCRIPTION
+ *   Finds the CPUs the program is allowed to run on, in the ascending order
+ *   of their ids.  These are not necessarily the CPUs 0 to N-1: some CPUs
+ *   can be offline, or excluded by the cpuset or the affinity mask of the
+ *   program (e.g. in a container).
+ *
+ * RETURN VALUE
+ *   Returns the number of the allowed CPUs, or FUNC_RET_ERROR (-1) in case
+ *   of the error.
+ */
+int worker_cpus(int *cpus, int size)
+{
+#ifdef __linux__
+	cpu_set_t cpuset;
+#endif
+	int       i, retval = 0;
+
+	DBG_FUNC(NULL, "%p, %d", cpus, size);
+
+#ifdef __linux__
+	if (_ERROR(sched_getaffinity(0, sizeof(cpuset), &cpuset)))
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+
+	for (i = 0; i < CPU_SETSIZE; i++) {
+		if (!CPU_ISSET(i, &cpuset))
+			continue;
+
+		if (_nNULL(cpus) && (retval < size))
+			cpus[retval] = i;
+		retval++;
+	}
+#else
+	retval = sysconf(_SC_NPROCESSORS_ONLN);
+	for (i = 0; _nNULL(cpus) && (i < MIN(retval, size)); i++)
+		cpus[i] = i;
+#endif
+
+	DBG_RETURN_INT(retval);
+}
+
+
+/***
+ * NAME
+ *   worker_cpu_init -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Assigns the allowed CPUs to the workers, one CPU per worker in the
+ *   order of their ids.  Used in the 'cpu' SO_REUSEPORT mode only.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_OK (0) on success, or FUNC_RET_ERROR (-1) in case of
+ *   the error.
+ */
+static int worker_cpu_init(void)
+{
+	int *cpus, i, n, retval = FUNC_RET_ERROR;
+
+	DBG_FUNC(NULL, "");
+
+	if (_NULL(cpus = calloc(cfg.num_workers, sizeof(*cpus)))) {
+		w_log(NULL, _E("Failed to allocate memory for CPU list: %m"));
+
+		DBG_RETURN_INT(retval);
+	}
+
+	if (_ERROR(n = worker_cpus(cpus, cfg.num_workers))) {
+		w_log(NULL, _E("Failed to get CPU affinity: %m"));
+	}
+	else if (n != cfg.num_workers) {
+		w_log(NULL, _E("SO_REUSEPORT mode 'cpu' requires one worker per allowed CPU (%d)"), n);
+	}
+	else {
+		for (i = 0; i < cfg.num_workers; i++)
+			prg.workers[i].cpu = cpus[i];
+
+		retval = FUNC_RET_OK;
+	}
+
+	PTR_FREE(cpus);
+
+	DBG_RETURN_INT(retval);
+}
+
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+
+/***
+ * NAME
+ *   reuseport_attach_cbpf -
+ *
+ * ARGUMENTS
+ *   fd -
+ *
+ * DESCRIPTION
+ *   The classic BPF program attached to the SO_REUSEPORT group selects the
+ *   listener socket according to the CPU that handles the incoming packet.
+ *   It is enough to attach the program to one socket of the group, the
+ *   listener index corresponds to the order in which the sockets are bound.
+ *   The CPU ids are mapped to the workers one by one, as they need not be
+ *   contiguous.  For the packets handled by the other CPUs the program
+ *   returns an invalid index, so that the kernel selects the socket by the
+ *   hash of the connection.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int reuseport_attach_cbpf(int fd)
+{
+	struct sock_filter *code;
+	struct sock_fprog   prog;
+	int                 i, retval;
+
+	DBG_FUNC(NULL, "%d", fd);
+
+	prog.len = 2 * cfg.num_workers + 2;
+	if (_NULL(code = calloc(prog.len, sizeof(*code)))) {
+		w_log(NULL, _E("Failed to allocate SO_REUSEPORT CPU steering program: %m"));
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	/* A = CPU id */
+	code[0] = (struct sock_filter){ BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU };
+
+	/* if (A == CPU of the worker) return index of the worker */
+	for (i = 0; i < cfg.num_workers; i++) {
+		code[2 * i + 1] = (struct sock_filter){ BPF_JMP | BPF_JEQ | BPF_K, 0, 1, prg.workers[i].cpu };
+		code[2 * i + 2] = (struct sock_filter){ BPF_RET | BPF_K, 0, 0, i };
+	}
+
+	/* return invalid index */
+	code[prog.len - 1] = (struct sock_filter){ BPF_RET | BPF_K, 0, 0, cfg.num_workers };
+	prog.filter        = code;
+
+	retval = setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+	if (_ERROR(retval))
+		w_log(NULL, _E("Failed to attach SO_REUSEPORT CPU steering program: %m"));
+
+	PTR_FREE(code);
+
+	DBG_RETURN_INT(retval);
+}
+
+#endif /* SO_ATTACH_REUSEPORT_CBPF */
+
+
+/***
+ * NAME
+ *   worker_set_affinity -
+ *
+ * ARGUMENTS
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Binds the worker thread to the CPU whose connections are steered to its
+ *   listener socket.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_OK (0) on success, or FUNC_RET_ERROR (-1) in case of
+ *   the error.
+ */
+static int worker_set_affinity(struct worker *worker __maybe_unused)
+{
+#ifdef __linux__
+	cpu_set_t cpuset;
+	int       rc;
+
+	DBG_FUNC(worker, "%p", worker);
+
+	CPU_ZERO(&cpuset);
+	CPU_SET(worker->cpu, &cpuset);
+
+	rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+	if (rc != 0) {
+		w_log(worker, _E("Failed to bind worker %02d to CPU %d: %s"), worker->id, worker->cpu, strerror(rc));
+
+		DBG_RETURN_INT(FUNC_RET_ERROR);
+	}
+
+	W_DBG(WORKER, worker, "Worker bound to CPU %d", worker->cpu);
+#else
+	DBG_FUNC(worker, "%p", worker);
+#endif
+
+	DBG_RETURN_INT(FUNC_RET_OK);
+}
+
+
+/***
+ * NAME
+ *   worker_accept -
+ *
+ * ARGUMENTS
+ *   loop   -
+ *   worker -
+ *
+ * DESCRIPTION
+ *   Accepts the client connection on the listener socket of the worker and
+ *   adds the client to the worker.  If the function is not called from the
+ *   event loop of the worker, the client is handed over to the worker.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void worker_accept(struct ev_loop *loop, struct worker *w)
+{
+	struct client *c;
+	unsigned long  id;
+	int            fd;
+
+	DBG_FUNC(w, "%p, %p", loop, w);
+
+	fd = accept(w->fd, NULL, NULL);
+	if (_ERROR(fd)) {
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+			w_log(w, _E("Failed to accept client connection: %m"));
+
+		DBG_RETURN();
+	}
+
+	id = __atomic_add_fetch(&(prg.clicount), 1, __ATOMIC_RELAXED);
+
+	W_DBG(WORKER, NULL,
+	      "<%lu> New client connection accepted and assigned to worker %02d",
+	      id, w->id);
+
+	if (_ERROR(socket_set_nonblocking(fd))) {
+		w_log(NULL, _E("Failed to set client socket to non-blocking: %m"));
+		(void)close(fd);
+
+		DBG_RETURN();
+	}
+	else if (_ERROR(socket_set_keepalive(fd, 1, -1, -1, -1))) {
+		w_log(NULL, _E("Failed to set KEEPALIVE on server socket: %m"));
+		(void)close(fd);
+
+		DBG_RETURN();
+	}
+
+	c = calloc(1, sizeof(*c));
+	if (_NULL(c)) {
+		w_log(w, _E("Failed to allocate memory for client state: %m"));
+		(void)close(fd);
+
+		DBG_RETURN();
+	}
+	else if (_NULL(c->rd_buf.ptr = malloc(SPOA_RD_BUFSIZE(cfg.max_frame_size)))) {
+		w_log(w, _E("Failed to allocate memory for client receive buffer: %m"));
+		PTR_FREE(c);
+		(void)close(fd);
+
+		DBG_RETURN();
+	}
+
+	LIST_INIT(&(c->rd_buf.list));
+	c->rd_buf.size    = SPOA_RD_BUFSIZE(cfg.max_frame_size);
+	c->fd             = fd;
+	c->id             = id;
+	c->state          = SPOA_ST_CONNECTING;
+	c->max_frame_size = cfg.max_frame_size;
+	c->status_code    = SPOE_FRM_ERR_NONE;
+	c->worker         = w;
+
+	LIST_INIT(&(c->processing_frames));
+	LIST_INIT(&(c->outgoing_frames));
+
+	LIST_INIT(&(c->by_worker));
+	(void)__atomic_add_fetch(&(w->nbclients), 1, __ATOMIC_RELAXED);
+
+	ev_io_init(&(c->ev_frame_rd), read_frame_cb, fd, EV_READ);
+	ev_io_init(&(c->ev_frame_wr), write_frame_cb, fd, EV_WRITE);
+
+	/* The event loop of the worker can only be changed by the worker itself. */
+	if (loop == w->ev_base)
+		worker_client_start(w, c);
+	else
+		worker_client_push(w, c);
+
+	W_DBG(WORKER, NULL, "<%lu> New read event added to worker %02d", id, w->id);
+
+	DBG_RETURN();
+}
+
+
+/***
+ * NAME
+ *   worker_thread_accept_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   The accept callback function of the worker's own SO_REUSEPORT listener.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void worker_thread_accept_cb(struct ev_loop *loop, struct ev_io *ev, int revents __maybe_unused)
+{
+	STRUCT_ADDR(worker, w, ev_accept);
+
+	DBG_FUNC(w, "%p, %p, 0x%08x", loop, ev, revents);
+
+	worker_accept(loop, w);
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   worker_thread_monitor_cb -
@@ -194,18 +624,27 @@ static int create_server_socket(void)
  * RETURN VALUE
  *   This function does not return a value.
  */
-static void worker_thread_monitor_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev __maybe_unused, int revents __maybe_unused)
+static void worker_thread_monitor_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev, int revents __maybe_unused)
 {
-#ifdef DEBUG
-	const STRUCT_ADDR(worker, w, ev_monitor);
+	STRUCT_ADDR(worker, w, ev_monitor);
 
 	DBG_FUNC(w, "%p, %p, 0x%08x", loop, ev, revents);
 
+#ifdef DEBUG
 	if (w->nbclients || ev_async_pending(&(w->ev_async)))
 		W_DBG(WORKER, w, "%u clients connected (%u frames), async event %spending",
 		      w->nbclients, w->nbframes, ev_async_pending(&(w->ev_async)) ? "" : "not ");
 #endif
 
+	frame_pool_trim(w);
+
+#ifdef HAVE_LIBCURL
+	if (cfg.mir_engine == MIR_ENGINE_NATIVE)
+		mir_http1_monitor(w, &(w->http1));
+	else
+		mir_curl_monitor(w, &(w->curl));
+#endif
+
 	DBG_RETURN();
 }
 
@@ -229,13 +668,21 @@ __noreturn static void *worker_thread_exit(struct worker *worker)
 
 	if (ev_is_active(&(worker->ev_monitor)) || ev_is_pending(&(worker->ev_monitor)))
 		ev_timer_stop(worker->ev_base, &(worker->ev_monitor));
+	if (ev_is_active(&(worker->ev_accept)) || ev_is_pending(&(worker->ev_accept)))
+		ev_io_stop(worker->ev_base, &(worker->ev_accept));
+
+	log_thread_init(NULL);
 
 	if (_nNULL(worker->ev_base) && !ev_is_default_loop(worker->ev_base)) {
 		ev_loop_destroy(worker->ev_base);
 
-		worker->ev_base = NULL;
+		__atomic_store_n(&(worker->ev_base), NULL, __ATOMIC_RELEASE);
 	}
 
+	/* The worker that stops before it is ready has failed to initialize. */
+	if (!__atomic_load_n(&(worker->flag_ready), __ATOMIC_RELAXED))
+		__atomic_store_n(&(worker->flag_failed), 1, __ATOMIC_RELEASE);
+
 	W_DBG(WORKER, worker, "Worker is stopped");
 
 	DBG_FUNC_END("} = %p", NULL);
@@ -260,10 +707,9 @@ __noreturn static void *worker_thread_exit(struct worker *worker)
  */
 static void *worker_thread(void *data)
 {
-	char               name[16];
-	struct client     *c, *cback;
-	struct spoe_frame *f, *fback;
-	struct worker     *w = data;
+	char           name[16];
+	struct client *c, *cback;
+	struct worker *w = data;
 
 	DBG_FUNC(w, "%p", data);
 
@@ -277,10 +723,15 @@ static void *worker_thread(void *data)
 	(void)snprintf(name, sizeof(name), "sm/wrk: %d", w->id);
 	(void)pthread_setname_np(pthread_self(), name);
 
+	/* In the 'cpu' mode a worker on the wrong CPU gets connections of another CPU. */
+	if ((cfg.reuseport == REUSEPORT_CPU) && _ERROR(worker_set_affinity(w)))
+		DBG_RETURN_PTR(worker_thread_exit(w));
+
 	w->nbclients = 0;
 	LIST_INIT(&(w->engines));
 	LIST_INIT(&(w->clients));
-	LIST_INIT(&(w->frames));
+	frame_pool_init(w);
+	frame_defer_init(w);
 
 	w->ev_base = ev_loop_new(cfg.ev_backend);
 	if (_NULL(w->ev_base)) {
@@ -289,32 +740,79 @@ static void *worker_thread(void *data)
 		DBG_RETURN_PTR(worker_thread_exit(w));
 	}
 
+	log_thread_init(w->ev_base);
+
 	W_DBG(WORKER, w, "libev: using backend '%s'", ev_backend_type(w->ev_base));
 
 	worker_async_init(w);
 
 #ifdef HAVE_LIBCURL
-	if (_nNULL(cfg.mir_url) && _ERROR(mir_curl_init(w->ev_base, &(w->ev_async), &(w->curl)))) {
+	if (_NULL(cfg.mir_url) || (cfg.mir_threads > 0))
+		/* Do nothing. */;
+	else if (cfg.mir_engine == MIR_ENGINE_NATIVE) {
+		if (_ERROR(mir_http1_init(w->ev_base, &(w->http1)))) {
+			w_log(w, _E("Failed to initialize HTTP/1.1 mirroring"));
+
+			DBG_RETURN_PTR(worker_thread_exit(w));
+		}
+	}
+	else if (_ERROR(mir_curl_init(w->ev_base, &(w->curl)))) {
 		w_log(w, _E("Failed to initialize cURL mirroring"));
 
 		DBG_RETURN_PTR(worker_thread_exit(w));
 	}
 #endif
 
+#ifdef HAVE_LIBURING
+	if ((cfg.opt_flags & FLAG_OPT_IO_URING) && _ERROR(uring_init(w))) {
+		w_log(w, _E("Failed to initialize io_uring transport"));
+
+		DBG_RETURN_PTR(worker_thread_exit(w));
+	}
+#endif
+
 	ev_timer_init(&(w->ev_monitor), worker_thread_monitor_cb, cfg.monitor_interval_us / 1e6, cfg.monitor_interval_us / 1e6);
 	ev_timer_start(w->ev_base, &(w->ev_monitor));
 
+	/* Each worker accepts the connections on its own listener socket. */
+	if (cfg.reuseport != REUSEPORT_NONE) {
+		ev_io_init(&(w->ev_accept), worker_thread_accept_cb, w->fd, EV_READ);
+		ev_io_start(w->ev_base, &(w->ev_accept));
+	}
+
+	/*
+	 * The main thread hands over the clients only when all the workers are
+	 * ready, and aborts the startup if any of them has failed.
+	 */
+	__atomic_store_n(&(w->flag_ready), 1, __ATOMIC_RELEASE);
+
 	W_DBG(WORKER, w, "Worker ready to process client messages");
 
 	(void)ev_run(w->ev_base, 0);
 
+	/* The clients accepted after the worker was stopped are released too. */
+	worker_client_collect(w);
+
 	list_for_each_entry_safe(c, cback, &(w->clients), by_worker)
 		release_client(c);
 
-	list_for_each_entry_safe(f, fback, &(w->frames), list) {
-		LIST_DEL(&(f->list));
-		free(f);
-	}
+	frame_defer_free(w);
+
+#ifdef HAVE_LIBURING
+	if (cfg.opt_flags & FLAG_OPT_IO_URING)
+		uring_close(w);
+#endif
+
+#ifdef HAVE_LIBCURL
+	if (_nNULL(cfg.mir_url) && (cfg.mir_threads == 0) && (cfg.mir_engine == MIR_ENGINE_NATIVE))
+		mir_http1_close(&(w->http1));
+	else if (_nNULL(cfg.mir_url) && (cfg.mir_threads == 0))
+		mir_curl_close(&(w->curl));
+	else if (cfg.mir_threads > 0)
+		mir_sender_collect(w);
+#endif
+
+	frame_pool_free(w);
 
 	DBG_RETURN_PTR(worker_thread_exit(w));
 }
@@ -386,9 +884,20 @@ static void worker_stop(struct ev_loop *loop, const char *msg __maybe_unused)
 
 	W_DBG(WORKER, NULL, "Main event loop stopped");
 
+#ifdef HAVE_LIBCURL
+	/* The mirror senders return the mirrors to the workers, so they are stopped first. */
+	mir_sender_stop();
+#endif
+
 	for (i = 0; i < cfg.num_workers; i++) {
-		ev_once(prg.workers[i].ev_base, -1, 0, 0, worker_stop_ev, prg.workers[i].ev_base);
-		ev_async_send(prg.workers[i].ev_base, &(prg.workers[i].ev_async));
+		struct ev_loop *ev_base = __atomic_load_n(&(prg.workers[i].ev_base), __ATOMIC_ACQUIRE);
+
+		/* The worker that failed to start has no event loop. */
+		if (_NULL(ev_base))
+			continue;
+
+		__atomic_store_n(&(prg.workers[i].flag_stop), 1, __ATOMIC_RELAXED);
+		ev_async_send(ev_base, &(prg.workers[i].ev_async));
 
 		W_DBG(WORKER, NULL, "Worker %02d: event loop stopped", prg.workers[i].id);
 	}
@@ -488,81 +997,124 @@ static void worker_runtime_cb(struct ev_loop *loop __maybe_unused, struct ev_tim
 
 /***
  * NAME
- *   worker_accept_cb -
+ *   worker_load -
  *
  * ARGUMENTS
- *   loop    -
- *   ev      -
- *   revents -
+ *   worker -
+ *   policy -
  *
  * DESCRIPTION
- *   -
+ *   Returns the load of the worker as seen by the specified assignment
+ *   policy.  The counters are updated by the worker threads, so they are
+ *   read atomically here.
  *
  * RETURN VALUE
- *   This function does not return a value.
+ *   -
  */
-static void worker_accept_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev __maybe_unused, int revents __maybe_unused)
+static __always_inline uint64_t worker_load(struct worker *worker, int policy)
 {
-	struct worker *w;
-	struct client *c;
-	int            fd;
+	uint64_t nbclients, nbinflight;
 
-	w = prg.workers + (prg.clicount++ % cfg.num_workers);
+	nbclients  = __atomic_load_n(&(worker->nbclients), __ATOMIC_RELAXED);
+	nbinflight = __atomic_load_n(&(worker->nbinflight), __ATOMIC_RELAXED);
 
-	DBG_FUNC(w, "%p, %p, 0x%08x", loop, ev, revents);
+	/* The secondary counter is used to break the ties. */
+	if (policy == ASSIGN_LEAST_CONN)
+		return (nbclients << 32) | nbinflight;
 
-	fd = accept(w->fd, NULL, NULL);
-	if (_ERROR(fd)) {
-		if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
-			w_log(w, _E("Failed to accept client connection: %m"));
+	return (nbinflight << 32) | nbclients;
+}
 
-		DBG_RETURN();
-	}
 
-	W_DBG(WORKER, NULL,
-	      "<%lu> New client connection accepted and assigned to worker %02d",
-	      prg.clicount, w->id);
+/***
+ * NAME
+ *   worker_select -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Selects the worker to which the new client connection is assigned,
+ *   according to the configured assignment policy.  The function is called
+ *   from the main thread only.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct worker *worker_select(void)
+{
+	static uint32_t  seed = 0;
+	struct worker   *retval;
+	uint64_t         load, load_min;
+	int              i, n;
 
-	if (_ERROR(socket_set_nonblocking(fd))) {
-		w_log(NULL, _E("Failed to set client socket to non-blocking: %m"));
-		(void)close(fd);
+	DBG_FUNC(NULL, "");
 
-		DBG_RETURN();
-	}
-	else if (_ERROR(socket_set_keepalive(fd, 1, -1, -1, -1))) {
-		w_log(NULL, _E("Failed to set KEEPALIVE on server socket: %m"));
-		(void)close(fd);
+	/* The search starts from the next worker, like in the round-robin. */
+	n      = prg.clicount % cfg.num_workers;
+	retval = prg.workers + n;
 
-		DBG_RETURN();
+	if (TEST_OR2(cfg.assign_policy, ASSIGN_LEAST_CONN, ASSIGN_LEAST_FRAMES)) {
+		load_min = worker_load(retval, cfg.assign_policy);
+
+		for (i = 1; (i < cfg.num_workers) && (load_min > 0); i++) {
+			struct worker *w = prg.workers + (n + i) % cfg.num_workers;
+
+			if ((load = worker_load(w, cfg.assign_policy)) < load_min) {
+				load_min = load;
+				retval   = w;
+			}
+		}
 	}
+	else if ((cfg.assign_policy == ASSIGN_P2C) && (cfg.num_workers > 1)) {
+		struct worker *w;
 
-	c = calloc(1, sizeof(*c));
-	if (_NULL(c)) {
-		w_log(w, _E("Failed to allocate memory for client state: %m"));
-		(void)close(fd);
+		/* xorshift32 */
+		if (seed == 0)
+			seed = prg.start_time.tv_usec | 1;
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
 
-		DBG_RETURN();
+		retval = prg.workers + (seed % cfg.num_workers);
+		w      = prg.workers + ((retval - prg.workers) + 1 + (seed >> 16) % (cfg.num_workers - 1)) % cfg.num_workers;
+
+		if (worker_load(w, ASSIGN_LEAST_FRAMES) < worker_load(retval, ASSIGN_LEAST_FRAMES))
+			retval = w;
 	}
 
-	c->fd             = fd;
-	c->id             = prg.clicount;
-	c->state          = SPOA_ST_CONNECTING;
-	c->max_frame_size = cfg.max_frame_size;
-	c->status_code    = SPOE_FRM_ERR_NONE;
-	c->worker         = w;
+	W_DBG(WORKER, NULL, "Worker %02d selected: %u clients, %u frames in use",
+	      retval->id, __atomic_load_n(&(retval->nbclients), __ATOMIC_RELAXED),
+	      __atomic_load_n(&(retval->nbinflight), __ATOMIC_RELAXED));
 
-	LIST_INIT(&(c->processing_frames));
-	LIST_INIT(&(c->outgoing_frames));
+	DBG_RETURN_PTR(retval);
+}
 
-	LIST_ADDQ(&(w->clients), &(c->by_worker));
-	w->nbclients++;
 
-	ev_io_init(&(c->ev_frame_rd), read_frame_cb, fd, EV_READ);
-	ev_io_init(&(c->ev_frame_wr), write_frame_cb, fd, EV_WRITE);
-	ev_io_start(w->ev_base, &(c->ev_frame_rd));
-	ev_async_send(w->ev_base, &(w->ev_async));
+/***
+ * NAME
+ *   worker_accept_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void worker_accept_cb(struct ev_loop *loop, struct ev_io *ev __maybe_unused, int revents __maybe_unused)
+{
+	struct worker *w;
+
+	w = worker_select();
 
-	W_DBG(WORKER, NULL, "<%lu> New read event added to worker %02d", prg.clicount, w->id);
+	DBG_FUNC(w, "%p, %p, 0x%08x", loop, ev, revents);
+
+	worker_accept(loop, w);
 
 	DBG_RETURN();
 }
@@ -599,9 +1151,20 @@ static int worker_run_exit(int fd, struct ev_loop *ev_base, struct worker_signal
 		if (ev_is_active(&(ev_signals[i].signal)) || ev_is_pending(&(ev_signals[i].signal)))
 			ev_signal_stop(ev_base, &(ev_signals[i].signal));
 
+	stats_stop();
+	log_thread_init(NULL);
+
 	if (_nNULL(ev_base) && !ev_is_default_loop(ev_base))
 		ev_loop_destroy(ev_base);
 
+	if (_nNULL(prg.workers) && (cfg.reuseport != REUSEPORT_NONE))
+		for (i = 0; i < cfg.num_workers; i++)
+			FD_CLOSE(prg.workers[i].fd);
+
+#ifdef HAVE_LIBCURL
+	mir_sender_free();
+#endif
+
 	FD_CLOSE(fd);
 	PTR_FREE(prg.workers);
 
@@ -609,6 +1172,52 @@ static int worker_run_exit(int fd, struct ev_loop *ev_base, struct worker_signal
 }
 
 
+/***
+ * NAME
+ *   worker_run_join -
+ *
+ * ARGUMENTS
+ *   nbstarted  - the number of the started worker threads
+ *   flag_abort - the workers that are running are stopped first
+ *
+ * DESCRIPTION
+ *   Waits for the worker threads to finish.  If the startup is aborted, the
+ *   workers that are ready are stopped here; the failed ones stop on their
+ *   own and their event loops must not be used.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void worker_run_join(int nbstarted, bool_t flag_abort)
+{
+	int i, rc;
+
+	DBG_FUNC(NULL, "%d, %hhu", nbstarted, flag_abort);
+
+	for (i = 0; flag_abort && (i < nbstarted); i++) {
+		struct worker *w = prg.workers + i;
+
+		if (!__atomic_load_n(&(w->flag_ready), __ATOMIC_ACQUIRE))
+			continue;
+
+		__atomic_store_n(&(w->flag_stop), 1, __ATOMIC_RELAXED);
+		ev_async_send(w->ev_base, &(w->ev_async));
+	}
+
+	for (i = 0; i < nbstarted; i++) {
+		struct worker *w = prg.workers + i;
+
+		rc = pthread_join(w->thread, NULL);
+		if (rc != 0)
+			w_log(w, _E("Failed to join worker thread %02d: %s"), w->id, strerror(rc));
+
+		W_DBG(WORKER, NULL, "Worker %02d: terminated (%d)", w->id, rc);
+	}
+
+	DBG_RETURN();
+}
+
+
 /***
  * NAME
  *   worker_run -
@@ -635,7 +1244,7 @@ int worker_run(void)
 	struct ev_timer  ev_runtime;
 	struct ev_loop  *ev_base;
 	struct ev_io     ev_accept;
-	int              rc, i, fd = -1;
+	int              i, nbstarted, nbfailed = 0, fd = -1;
 
 	DBG_FUNC(NULL, "");
 
@@ -656,19 +1265,23 @@ int worker_run(void)
 		DBG_RETURN_INT(EX_SOFTWARE);
 	}
 
+	log_thread_init(ev_base);
+
 	W_DBG(WORKER, NULL, "libev: using backend '%s'", ev_backend_type(ev_base));
 
-	fd = create_server_socket();
-	if (_ERROR(fd)) {
-		w_log(NULL, _F("Failed to create server socket"));
+	if (cfg.reuseport == REUSEPORT_NONE) {
+		fd = create_server_socket();
+		if (_ERROR(fd)) {
+			w_log(NULL, _F("Failed to create server socket"));
 
-		DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
-	}
+			DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+		}
 
-	if (_ERROR(socket_set_nonblocking(fd))) {
-		w_log(NULL, _F("Failed to set client socket to non-blocking: %m"));
+		if (_ERROR(socket_set_nonblocking(fd))) {
+			w_log(NULL, _F("Failed to set client socket to non-blocking: %m"));
 
-		DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+			DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+		}
 	}
 
 	prg.workers = calloc(cfg.num_workers, sizeof(*(prg.workers)));
@@ -678,18 +1291,93 @@ int worker_run(void)
 		DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
 	}
 
-	for (i = 0; i < cfg.num_workers; i++) {
-		struct worker *w = prg.workers + i;
+	for (i = 0; i < cfg.num_workers; i++)
+		prg.workers[i].fd = fd;
+
+	if ((cfg.reuseport == REUSEPORT_CPU) && _ERROR(worker_cpu_init()))
+		DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
 
-		w->id = i + 1;
-		w->fd = fd;
+#ifdef HAVE_LIBCURL
+	if (_nNULL(cfg.mir_url) && (cfg.mir_threads > 0) && _ERROR(mir_sender_start()))
+		DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+#endif
+
+	/*
+	 * In the SO_REUSEPORT mode every worker gets its own listener socket.
+	 * The sockets are created here, in the order of the workers, so that
+	 * the index of the socket in the SO_REUSEPORT group matches the worker.
+	 */
+	if (cfg.reuseport != REUSEPORT_NONE) {
+		for (i = 0; i < cfg.num_workers; i++) {
+			struct worker *w = prg.workers + i;
+
+			w->fd = create_server_socket();
+			if (_ERROR(w->fd)) {
+				w_log(NULL, _F("Failed to create server socket for worker %02d"), i + 1);
+
+				DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+			}
+			else if (_ERROR(socket_set_nonblocking(w->fd))) {
+				w_log(NULL, _F("Failed to set server socket to non-blocking: %m"));
+
+				DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+			}
+		}
 
-		if (_nOK(pthread_create(&(w->thread), NULL, worker_thread, w)))
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+		if ((cfg.reuseport == REUSEPORT_CPU) && _ERROR(reuseport_attach_cbpf(prg.workers[0].fd)))
+			DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+#endif
+	}
+
+	if (_ERROR(stats_start(ev_base)))
+		DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+
+	for (nbstarted = 0; nbstarted < cfg.num_workers; nbstarted++) {
+		struct worker *w = prg.workers + nbstarted;
+
+		w->id = nbstarted + 1;
+
+		if (_nOK(pthread_create(&(w->thread), NULL, worker_thread, w))) {
 			w_log(NULL, _E("Failed to start thread for worker %02d: %m"), w->id);
+
+			break;
+		}
 	}
 
-	ev_io_init(&ev_accept, worker_accept_cb, fd, EV_READ);
-	ev_io_start(ev_base, &ev_accept);
+	/* The clients are accepted once all the workers are ready. */
+	for (i = 0; i < nbstarted; i++)
+		while (!__atomic_load_n(&(prg.workers[i].flag_ready), __ATOMIC_ACQUIRE)) {
+			if (__atomic_load_n(&(prg.workers[i].flag_failed), __ATOMIC_ACQUIRE)) {
+				nbfailed++;
+
+				break;
+			}
+
+			(void)usleep(WORKER_READY_INTERVAL);
+		}
+
+	if ((nbstarted < cfg.num_workers) || (nbfailed > 0)) {
+		w_log(NULL, _F("Failed to start %d of %d workers"), cfg.num_workers - nbstarted + nbfailed, cfg.num_workers);
+
+		/*
+		 * The kernel would keep steering the connections to the listener
+		 * socket of a failed worker, so all the listener sockets leave the
+		 * SO_REUSEPORT group before the workers are stopped.
+		 */
+		if (cfg.reuseport != REUSEPORT_NONE)
+			for (i = 0; i < cfg.num_workers; i++)
+				(void)shutdown(prg.workers[i].fd, SHUT_RDWR);
+
+		worker_run_join(nbstarted, 1);
+
+		DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_SOFTWARE));
+	}
+
+	if (cfg.reuseport == REUSEPORT_NONE) {
+		ev_io_init(&ev_accept, worker_accept_cb, fd, EV_READ);
+		ev_io_start(ev_base, &ev_accept);
+	}
 
 	for (i = 0; i < TABLESIZE(ev_signals); i++) {
 		ev_signal_init(&(ev_signals[i].signal), ev_signals[i].func, ev_signals[i].signum);
@@ -712,15 +1400,7 @@ int worker_run(void)
 
 	(void)ev_run(ev_base, 0);
 
-	for (i = 0; i < cfg.num_workers; i++) {
-		struct worker *w = prg.workers + i;
-
-		rc = pthread_join(w->thread, NULL);
-		if (rc != 0)
-			w_log(w, _E("Failed to join worker thread %02d: %s"), w->id, strerror(rc));
-
-		W_DBG(WORKER, NULL, "Worker %02d: terminated (%d)", w->id, rc);
-	}
+	worker_run_join(cfg.num_workers, 0);
 
 	DBG_RETURN_INT(worker_run_exit(fd, ev_base, ev_signals, TABLESIZE(ev_signals), &ev_accept, EX_OK));
 }
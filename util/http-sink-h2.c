@@ -0,0 +1,598 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+#include "http-sink.h"
+#include "util.h"
+
+
+#define SINK_H2_MAX_STREAMS   1000
+
+
+/***
+ * NAME
+ *   sink_h2_stream_free -
+ *
+ * ARGUMENTS
+ *   stream -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_h2_stream_free(struct sink_stream *stream)
+{
+	ev_timer_stop(_prg.ev_base, &(stream->ev_delay));
+	LIST_DEL(&(stream->list));
+
+	sink_request_free(&(stream->req));
+	PTR_FREE(stream->body.ptr);
+	PTR_FREE(stream);
+}
+
+
+/***
+ * NAME
+ *   sink_h2_read_cb -
+ *
+ * ARGUMENTS
+ *   session    -
+ *   stream_id  -
+ *   buf        -
+ *   length     -
+ *   data_flags -
+ *   source     -
+ *   user_data  -
+ *
+ * DESCRIPTION
+ *   Supplies the response body to nghttp2.
+ *
+ * RETURN VALUE
+ *   Returns the number of bytes copied to buf.
+ */
+static ssize_t sink_h2_read_cb(nghttp2_session *session __maybe_unused, int32_t stream_id __maybe_unused, uint8_t *buf, size_t length, uint32_t *data_flags, nghttp2_data_source *source, void *user_data __maybe_unused)
+{
+	struct sink_stream *stream = source->ptr;
+	size_t              n = MIN(length, stream->body.len - stream->body_head);
+
+	(void)memcpy(buf, stream->body.ptr + stream->body_head, n);
+	stream->body_head += n;
+
+	if (stream->body_head == stream->body.len)
+		*data_flags |= NGHTTP2_DATA_FLAG_EOF;
+
+	return n;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_respond -
+ *
+ * ARGUMENTS
+ *   stream -
+ *
+ * DESCRIPTION
+ *   Submits the response to the stream request.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h2_respond(struct sink_stream *stream)
+{
+	nghttp2_data_provider data_prd;
+	char                  status[8], length[24];
+	nghttp2_nv            nva[] = {
+		{ (uint8_t *)":status",        (uint8_t *)status, STR_SIZE(":status"),        0, NGHTTP2_NV_FLAG_NONE },
+		{ (uint8_t *)"content-length", (uint8_t *)length, STR_SIZE("content-length"), 0, NGHTTP2_NV_FLAG_NONE },
+		{ (uint8_t *)"content-type",   (uint8_t *)"text/plain", STR_SIZE("content-type"), STR_SIZE("text/plain"), NGHTTP2_NV_FLAG_NONE },
+	};
+
+	nva[0].valuelen = snprintf(status, sizeof(status), "%d", stream->status);
+	nva[1].valuelen = snprintf(length, sizeof(length), "%zu", stream->body.len);
+
+	data_prd.source.ptr    = stream;
+	data_prd.read_callback = sink_h2_read_cb;
+
+	if (nghttp2_submit_response(stream->conn->h2, stream->id, nva, (stream->body.len > 0) ? 3 : 2, (stream->body.len > 0) ? &data_prd : NULL) != 0)
+		return FUNC_RET_ERROR;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_delay_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Sends the delayed response.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_h2_delay_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev, int revents __maybe_unused)
+{
+	struct sink_stream *stream = ev->data;
+	struct sink_conn   *conn = stream->conn;
+	int                 rc;
+
+	rc = sink_h2_respond(stream);
+	if (_nERROR(rc))
+		rc = sink_h2_send(conn);
+	if (_nERROR(rc))
+		rc = sink_conn_flush(conn);
+
+	if (_ERROR(rc))
+		sink_conn_close(conn);
+}
+
+
+/***
+ * NAME
+ *   sink_h2_stream_new -
+ *
+ * ARGUMENTS
+ *   conn -
+ *   id   -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct sink_stream *sink_h2_stream_new(struct sink_conn *conn, int32_t id)
+{
+	struct sink_stream *stream;
+
+	if (_NULL(stream = calloc(1, sizeof(*stream))))
+		return NULL;
+
+	stream->conn      = conn;
+	stream->id        = id;
+	stream->req.proto = SINK_PROTO_HTTP2;
+	ev_init(&(stream->ev_delay), sink_h2_delay_cb);
+	stream->ev_delay.data = stream;
+	LIST_ADDQ(&(conn->h2_streams), &(stream->list));
+
+	return stream;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_stream_done -
+ *
+ * ARGUMENTS
+ *   stream -
+ *
+ * DESCRIPTION
+ *   Handles the complete request, the response is delayed if a delay is set.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h2_stream_done(struct sink_stream *stream)
+{
+	stream->status = sink_request_done(&(stream->req), &(stream->body));
+
+	if ((_prg.delay > 0) && (stream->body.len == 0)) {
+		ev_timer_set(&(stream->ev_delay), _prg.delay, 0.0);
+		ev_timer_start(_prg.ev_base, &(stream->ev_delay));
+
+		return FUNC_RET_OK;
+	}
+
+	return sink_h2_respond(stream);
+}
+
+
+/***
+ * NAME
+ *   sink_h2_on_begin_headers_cb -
+ *
+ * ARGUMENTS
+ *   session   -
+ *   frame     -
+ *   user_data -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h2_on_begin_headers_cb(nghttp2_session *session, const nghttp2_frame *frame, void *user_data)
+{
+	struct sink_stream *stream;
+
+	if ((frame->hd.type != NGHTTP2_HEADERS) || (frame->headers.cat != NGHTTP2_HCAT_REQUEST))
+		return 0;
+	else if (_NULL(stream = sink_h2_stream_new(user_data, frame->hd.stream_id)))
+		return NGHTTP2_ERR_CALLBACK_FAILURE;
+
+	(void)nghttp2_session_set_stream_user_data(session, frame->hd.stream_id, stream);
+
+	return 0;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_on_header_cb -
+ *
+ * ARGUMENTS
+ *   session   -
+ *   frame     -
+ *   name      -
+ *   namelen   -
+ *   value     -
+ *   valuelen  -
+ *   flags     -
+ *   user_data -
+ *
+ * DESCRIPTION
+ *   Takes the method and the path, without the query string, of the request.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h2_on_header_cb(nghttp2_session *session, const nghttp2_frame *frame, const uint8_t *name, size_t namelen, const uint8_t *value, size_t valuelen, uint8_t flags __maybe_unused, void *user_data __maybe_unused)
+{
+	struct sink_stream *stream;
+	const uint8_t      *ptr;
+
+	if ((frame->hd.type != NGHTTP2_HEADERS) || _NULL(stream = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id)))
+		return 0;
+
+	if ((namelen == STR_SIZE(":method")) && (memcmp(name, ":method", namelen) == 0)) {
+		(void)snprintf(stream->req.method, sizeof(stream->req.method), "%.*s", (int)valuelen, value);
+	}
+	else if ((namelen == STR_SIZE(":path")) && (memcmp(name, ":path", namelen) == 0) && _NULL(stream->req.path)) {
+		ptr = memchr(value, '?', valuelen);
+		if (_nNULL(ptr))
+			valuelen = ptr - value;
+
+		if (_NULL(stream->req.path = (valuelen == 0) ? strdup("/") : strndup((const char *)value, valuelen)))
+			return NGHTTP2_ERR_CALLBACK_FAILURE;
+	}
+
+	return 0;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_on_data_chunk_recv_cb -
+ *
+ * ARGUMENTS
+ *   session   -
+ *   flags     -
+ *   stream_id -
+ *   data      -
+ *   len       -
+ *   user_data -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h2_on_data_chunk_recv_cb(nghttp2_session *session, uint8_t flags __maybe_unused, int32_t stream_id, const uint8_t *data __maybe_unused, size_t len, void *user_data __maybe_unused)
+{
+	struct sink_stream *stream;
+
+	if (_nNULL(stream = nghttp2_session_get_stream_user_data(session, stream_id)))
+		stream->req.bytes += len;
+
+	return 0;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_on_frame_recv_cb -
+ *
+ * ARGUMENTS
+ *   session   -
+ *   frame     -
+ *   user_data -
+ *
+ * DESCRIPTION
+ *   The request is complete when its last frame is received.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h2_on_frame_recv_cb(nghttp2_session *session, const nghttp2_frame *frame, void *user_data __maybe_unused)
+{
+	struct sink_stream *stream;
+
+	if (((frame->hd.type != NGHTTP2_HEADERS) && (frame->hd.type != NGHTTP2_DATA)) || !(frame->hd.flags & NGHTTP2_FLAG_END_STREAM))
+		return 0;
+	else if (_NULL(stream = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id)))
+		return 0;
+
+	return _OK(sink_h2_stream_done(stream)) ? 0 : NGHTTP2_ERR_CALLBACK_FAILURE;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_on_stream_close_cb -
+ *
+ * ARGUMENTS
+ *   session    -
+ *   stream_id  -
+ *   error_code -
+ *   user_data  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h2_on_stream_close_cb(nghttp2_session *session, int32_t stream_id, uint32_t error_code __maybe_unused, void *user_data __maybe_unused)
+{
+	struct sink_stream *stream;
+
+	if (_nNULL(stream = nghttp2_session_get_stream_user_data(session, stream_id))) {
+		(void)nghttp2_session_set_stream_user_data(session, stream_id, NULL);
+
+		sink_h2_stream_free(stream);
+	}
+
+	return 0;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_base64url -
+ *
+ * ARGUMENTS
+ *   str -
+ *   buf -
+ *
+ * DESCRIPTION
+ *   Decodes the base64url encoded value of the HTTP2-Settings header.
+ *
+ * RETURN VALUE
+ *   Returns the length of the decoded data or FUNC_RET_ERROR.
+ */
+static ssize_t sink_h2_base64url(const char *str, uint8_t **buf)
+{
+	size_t   len = strlen(str), i;
+	uint32_t acc = 0;
+	ssize_t  retval = 0;
+	int      bits = 0, c;
+
+	if (_NULL(*buf = malloc(len * 3 / 4 + 1)))
+		return FUNC_RET_ERROR;
+
+	for (i = 0; i < len; i++) {
+		c = str[i];
+		if (IN_RANGE(c, 'A', 'Z'))
+			c -= 'A';
+		else if (IN_RANGE(c, 'a', 'z'))
+			c = c - 'a' + 26;
+		else if (IN_RANGE(c, '0', '9'))
+			c = c - '0' + 52;
+		else if (c == '-')
+			c = 62;
+		else if (c == '_')
+			c = 63;
+		else if (c == '=')
+			break;
+		else
+			return FUNC_RET_ERROR;
+
+		acc   = (acc << 6) | c;
+		bits += 6;
+		if (bits >= 8) {
+			bits -= 8;
+			(*buf)[retval++] = (acc >> bits) & 0xff;
+		}
+	}
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_init -
+ *
+ * ARGUMENTS
+ *   conn    -
+ *   upgrade -
+ *
+ * DESCRIPTION
+ *   Switches the connection to HTTP/2.  If the switch is the result of the
+ *   upgrade from HTTP/1.1, the upgrade request is moved to the stream 1.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int sink_h2_init(struct sink_conn *conn, struct sink_request *upgrade)
+{
+	static const nghttp2_settings_entry iv[] = { { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, SINK_H2_MAX_STREAMS } };
+	nghttp2_session_callbacks          *callbacks;
+	struct sink_stream                 *stream;
+	uint8_t                            *settings = NULL;
+	ssize_t                             len;
+	int                                 retval = FUNC_RET_ERROR;
+
+	if (nghttp2_session_callbacks_new(&callbacks) != 0)
+		return retval;
+
+	nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, sink_h2_on_begin_headers_cb);
+	nghttp2_session_callbacks_set_on_header_callback(callbacks, sink_h2_on_header_cb);
+	nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, sink_h2_on_data_chunk_recv_cb);
+	nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, sink_h2_on_frame_recv_cb);
+	nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, sink_h2_on_stream_close_cb);
+
+	if (nghttp2_session_server_new(&(conn->h2), callbacks, conn) != 0)
+		conn->h2 = NULL;
+
+	nghttp2_session_callbacks_del(callbacks);
+
+	if (_NULL(conn->h2))
+		return retval;
+
+	conn->proto = SINK_PROTO_HTTP2;
+	_prg.connections_h2++;
+
+	if (nghttp2_submit_settings(conn->h2, NGHTTP2_FLAG_NONE, iv, TABLESIZE(iv)) != 0) {
+		/* Do nothing. */
+	}
+	else if (_NULL(upgrade)) {
+		retval = FUNC_RET_OK;
+	}
+	else if (_ERROR(len = sink_h2_base64url(upgrade->h2_settings, &settings))) {
+		/* Do nothing. */
+	}
+	else if (_NULL(stream = sink_h2_stream_new(conn, 1))) {
+		/* Do nothing. */
+	}
+	else if (nghttp2_session_upgrade2(conn->h2, settings, len, strcmp(upgrade->method, "HEAD") == 0, stream) != 0) {
+		sink_h2_stream_free(stream);
+	}
+	else {
+		/* The stream takes over the request. */
+		stream->req       = *upgrade;
+		stream->req.proto = SINK_PROTO_HTTP2;
+		(void)memset(upgrade, 0, sizeof(*upgrade));
+
+		retval = sink_h2_stream_done(stream);
+	}
+
+	PTR_FREE(settings);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_send -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Moves the frames prepared by nghttp2 to the send buffer.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int sink_h2_send(struct sink_conn *conn)
+{
+	const uint8_t *data;
+	ssize_t        n;
+
+	while ((n = nghttp2_session_mem_send(conn->h2, &data)) > 0)
+		if (_ERROR(buffer_append(&(conn->wr_buf), data, n)))
+			return FUNC_RET_ERROR;
+
+	if (n < 0)
+		return FUNC_RET_ERROR;
+
+	if (!nghttp2_session_want_read(conn->h2) && !nghttp2_session_want_write(conn->h2))
+		conn->flag_close = 1;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   sink_h2_recv -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Passes the received data to nghttp2 and sends the frames it prepares in
+ *   return.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int sink_h2_recv(struct sink_conn *conn)
+{
+	ssize_t n;
+
+	n = nghttp2_session_mem_recv(conn->h2, conn->rd_buf.ptr, conn->rd_buf.len);
+	if (n < 0) {
+		_prg.bad_requests++;
+
+		return FUNC_RET_ERROR;
+	}
+
+	conn->rd_buf.len = 0;
+
+	return sink_h2_send(conn);
+}
+
+
+/***
+ * NAME
+ *   sink_h2_free -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void sink_h2_free(struct sink_conn *conn)
+{
+	struct sink_stream *stream, *stream_back;
+
+	if (_nNULL(conn->h2)) {
+		nghttp2_session_del(conn->h2);
+		conn->h2 = NULL;
+	}
+
+	list_for_each_entry_safe(stream, stream_back, &(conn->h2_streams), list)
+		sink_h2_stream_free(stream);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -0,0 +1,1259 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+#include "http-sink.h"
+#include "util.h"
+
+
+#define SINK_HDR_IS(n,l,s)   (((l) == STR_SIZE(s)) && (strncasecmp((n), (s), (l)) == 0))
+
+struct config_data cfg;
+struct program_data prg;
+struct _prg_data    _prg = {
+	.address      = SINK_DEFAULT_ADDRESS,
+	.port         = SINK_DEFAULT_PORT,
+	.backlog      = SINK_DEFAULT_BACKLOG,
+	.error_status = SINK_DEFAULT_ERROR_STATUS,
+	.stats_path   = SINK_DEFAULT_STATS_PATH,
+	.fd           = -1,
+};
+
+#ifdef DEBUG
+__THR const void *dbg_w_ptr  = NULL;
+__THR int         dbg_indent = 0;
+#endif
+
+
+/***
+ * NAME
+ *   usage -
+ *
+ * ARGUMENTS
+ *   program_name -
+ *   flag_verbose -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void usage(const char *program_name, bool_t flag_verbose)
+{
+	(void)printf("\nUsage: %s { -h --help }\n", program_name);
+	(void)printf("       %s { -V --version }\n", program_name);
+	(void)printf("       %s [OPTION]...\n\n", program_name);
+
+	if (flag_verbose) {
+		(void)printf("Options are:\n");
+		(void)printf("  -a, --address=NAME          Specify the address to listen on (default: \"%s\").\n", SINK_DEFAULT_ADDRESS);
+		(void)printf("  -b, --backlog=VALUE         Specify the connection backlog size (default: %d).\n", SINK_DEFAULT_BACKLOG);
+		(void)printf("  -d, --delay=TIME            Delay every response by the specified seconds.\n");
+		(void)printf("  -E, --error-status=VALUE    Set the status of the injected errors (default: %d).\n", SINK_DEFAULT_ERROR_STATUS);
+		(void)printf("  -e, --error-ratio=VALUE     Answer the specified share (0-1) of the requests with an error.\n");
+		(void)printf("  -h, --help                  Show this text.\n");
+		(void)printf("  -i, --interval=TIME         Show the request rate every specified seconds.\n");
+		(void)printf("  -p, --port=VALUE            Specify the port to listen on (default: %d).\n", SINK_DEFAULT_PORT);
+		(void)printf("  -s, --stats-path=PATH       Set the path returning the counters (default: \"%s\").\n", SINK_DEFAULT_STATS_PATH);
+		(void)printf("  -V, --version               Show program version.\n\n");
+		(void)printf("The requests are counted per method and path, the query string is not part\n");
+		(void)printf("of the path.  The counters are shown on exit, when the program receives the\n");
+		(void)printf("SIGUSR1 signal and as a response to the requests for the stats path.\n\n");
+#ifdef HAVE_LIBNGHTTP2
+		(void)printf("Both HTTP/1.1 and h2c (prior knowledge or upgrade) requests are accepted.\n\n");
+#else
+		(void)printf("Only HTTP/1.1 requests are accepted, the program is built without nghttp2.\n\n");
+#endif
+		(void)printf("Copyright 2026 HAProxy Technologies\n");
+		(void)printf("SPDX-License-Identifier: GPL-2.0-or-later\n\n");
+	} else {
+		(void)printf("For help type: %s -h\n\n", program_name);
+	}
+}
+
+
+/***
+ * NAME
+ *   sink_printf -
+ *
+ * ARGUMENTS
+ *   buf    -
+ *   format -
+ *
+ * DESCRIPTION
+ *   Appends the formatted text to the buffer.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_printf(struct buffer *buf, const char *format, ...) __fmt(printf, 2, 3);
+static int sink_printf(struct buffer *buf, const char *format, ...)
+{
+	va_list ap;
+	char    str[BUFSIZ];
+	int     n;
+
+	va_start(ap, format);
+	n = vsnprintf(str, sizeof(str), format, ap);
+	va_end(ap);
+
+	if (n < 0)
+		return FUNC_RET_ERROR;
+
+	return buffer_append(buf, str, MIN((size_t)n, sizeof(str) - 1));
+}
+
+
+/***
+ * NAME
+ *   sink_status_reason -
+ *
+ * ARGUMENTS
+ *   status -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static const char *sink_status_reason(int status)
+{
+	static const struct {
+		int         status;
+		const char *reason;
+	} reasons[] = {
+		{ 100, "Continue"              },
+		{ 101, "Switching Protocols"   },
+		{ 200, "OK"                    },
+		{ 204, "No Content"            },
+		{ 400, "Bad Request"           },
+		{ 403, "Forbidden"             },
+		{ 404, "Not Found"             },
+		{ 429, "Too Many Requests"     },
+		{ 500, "Internal Server Error" },
+		{ 502, "Bad Gateway"           },
+		{ 503, "Service Unavailable"   },
+		{ 504, "Gateway Timeout"       },
+	};
+	int i;
+
+	for (i = 0; i < TABLESIZE(reasons); i++)
+		if (reasons[i].status == status)
+			return reasons[i].reason;
+
+	return "Unknown";
+}
+
+
+/***
+ * NAME
+ *   sink_stats_get -
+ *
+ * ARGUMENTS
+ *   method -
+ *   path   -
+ *
+ * DESCRIPTION
+ *   Finds the counters of the method and path pair, creating them if they do
+ *   not exist.  After SINK_STATS_MAX pairs the other paths are counted
+ *   together.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct sink_stats *sink_stats_get(const char *method, const char *path)
+{
+	struct sink_stats *stats;
+	uint32_t           hash = 2166136261U;
+	const char        *ptr;
+
+	if (_prg.stats_cnt >= SINK_STATS_MAX)
+		path = SINK_STATS_OTHER;
+
+	for (ptr = method; *ptr != '\0'; ptr++)
+		hash = (hash ^ (uint8_t)*ptr) * 16777619U;
+	for (ptr = path; *ptr != '\0'; ptr++)
+		hash = (hash ^ (uint8_t)*ptr) * 16777619U;
+	hash %= SINK_STATS_BUCKETS;
+
+	for (stats = _prg.stats_bucket[hash]; _nNULL(stats); stats = stats->next)
+		if ((strcmp(stats->method, method) == 0) && (strcmp(stats->path, path) == 0))
+			return stats;
+
+	if (_NULL(stats = calloc(1, sizeof(*stats)))) {
+		return NULL;
+	}
+	else if (_NULL(stats->path = strdup(path))) {
+		PTR_FREE(stats);
+
+		return NULL;
+	}
+
+	(void)snprintf(stats->method, sizeof(stats->method), "%s", method);
+	stats->next = _prg.stats_bucket[hash];
+	_prg.stats_bucket[hash] = stats;
+	LIST_ADDQ(&(_prg.stats), &(stats->list));
+	_prg.stats_cnt++;
+
+	return stats;
+}
+
+
+/***
+ * NAME
+ *   sink_stats_format -
+ *
+ * ARGUMENTS
+ *   buf -
+ *
+ * DESCRIPTION
+ *   Appends the counters in the text form to the buffer.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_stats_format(struct buffer *buf)
+{
+	struct sink_stats *stats;
+	double             elapsed = ev_time() - _prg.start_time;
+	int                retval;
+
+	retval = sink_printf(buf, "uptime: %.3f s\n"
+	                     "connections: %"PRIu64" (HTTP/2: %"PRIu64")\n"
+	                     "requests: %"PRIu64" (HTTP/2: %"PRIu64"), %.1f requests/s\n"
+	                     "bytes: %"PRIu64"\n"
+	                     "errors: %"PRIu64" injected, %"PRIu64" bad request(s)\n",
+	                     elapsed, _prg.connections, _prg.connections_h2,
+	                     _prg.requests, _prg.requests_h2, (elapsed > 0) ? _prg.requests / elapsed : 0.0,
+	                     _prg.bytes, _prg.errors, _prg.bad_requests);
+
+	list_for_each_entry(stats, &(_prg.stats), list)
+		if (_nERROR(retval))
+			retval = sink_printf(buf, "%s %s: %"PRIu64" request(s), %"PRIu64" byte(s), %"PRIu64" error(s)\n",
+			                     stats->method, stats->path, stats->requests, stats->bytes, stats->errors);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sink_stats_show -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_stats_show(void)
+{
+	struct buffer buf = { .ptr = NULL };
+
+	if (_OK(sink_stats_format(&buf)))
+		(void)fwrite(buf.ptr, 1, buf.len, stdout);
+	(void)fflush(stdout);
+
+	PTR_FREE(buf.ptr);
+}
+
+
+/***
+ * NAME
+ *   sink_request_free -
+ *
+ * ARGUMENTS
+ *   req -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void sink_request_free(struct sink_request *req)
+{
+	PTR_FREE(req->path);
+	PTR_FREE(req->h2_settings);
+
+	(void)memset(req, 0, sizeof(*req));
+}
+
+
+/***
+ * NAME
+ *   sink_request_done -
+ *
+ * ARGUMENTS
+ *   req  -
+ *   body -
+ *
+ * DESCRIPTION
+ *   Counts the received request and decides on the status of the response.
+ *   The requests for the stats path are not counted, the counters are put
+ *   in the response body instead.
+ *
+ * RETURN VALUE
+ *   Returns the status of the response.
+ */
+int sink_request_done(struct sink_request *req, struct buffer *body)
+{
+	struct sink_stats *stats;
+	const char        *path = _NULL(req->path) ? "/" : req->path;
+	int                retval = 200;
+
+	if (strcmp(path, _prg.stats_path) == 0) {
+		if (_ERROR(sink_stats_format(body)))
+			retval = 500;
+
+		return retval;
+	}
+
+	_prg.requests++;
+	_prg.bytes += req->bytes;
+	if (req->proto == SINK_PROTO_HTTP2)
+		_prg.requests_h2++;
+
+	/* The errors are spread evenly, floor(requests * error_ratio) of them. */
+	if ((uint64_t)(_prg.requests * _prg.error_ratio) != (uint64_t)((_prg.requests - 1) * _prg.error_ratio)) {
+		_prg.errors++;
+
+		retval = _prg.error_status;
+	}
+
+	if (_nNULL(stats = sink_stats_get((req->method[0] == '\0') ? "-" : req->method, path))) {
+		stats->requests++;
+		stats->bytes += req->bytes;
+		if (retval != 200)
+			stats->errors++;
+	}
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sink_conn_close -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+void sink_conn_close(struct sink_conn *conn)
+{
+	ev_io_stop(_prg.ev_base, &(conn->ev_rd));
+	ev_io_stop(_prg.ev_base, &(conn->ev_wr));
+	ev_timer_stop(_prg.ev_base, &(conn->ev_delay));
+	(void)close(conn->fd);
+
+#ifdef HAVE_LIBNGHTTP2
+	sink_h2_free(conn);
+#endif
+
+	LIST_DEL(&(conn->list));
+	sink_request_free(&(conn->h1_req));
+	PTR_FREE(conn->rd_buf.ptr);
+	PTR_FREE(conn->wr_buf.ptr);
+	PTR_FREE(conn);
+}
+
+
+/***
+ * NAME
+ *   sink_conn_flush -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Sends as much of the send buffer as the socket accepts.  The write event
+ *   is only used while a part of the buffer could not be sent.
+ *
+ * RETURN VALUE
+ *   Returns FUNC_RET_ERROR if the connection is to be closed, either because
+ *   of an error or because the last response has been sent.
+ */
+int sink_conn_flush(struct sink_conn *conn)
+{
+	ssize_t n;
+
+	while (conn->wr_head < conn->wr_buf.len) {
+		n = send(conn->fd, conn->wr_buf.ptr + conn->wr_head, conn->wr_buf.len - conn->wr_head, MSG_NOSIGNAL);
+		if (n > 0) {
+			conn->wr_head += n;
+		}
+		else if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+			ev_io_start(_prg.ev_base, &(conn->ev_wr));
+
+			return FUNC_RET_OK;
+		}
+		else if ((n < 0) && (errno == EINTR)) {
+			/* Do nothing. */;
+		}
+		else {
+			return FUNC_RET_ERROR;
+		}
+	}
+
+	conn->wr_head    = 0;
+	conn->wr_buf.len = 0;
+	ev_io_stop(_prg.ev_base, &(conn->ev_wr));
+
+	return conn->flag_close ? FUNC_RET_ERROR : FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   sink_h1_find -
+ *
+ * ARGUMENTS
+ *   data       -
+ *   len        -
+ *   flag_empty -
+ *
+ * DESCRIPTION
+ *   Looks for the end of the line, or with flag_empty set for the empty line
+ *   that ends the request head.
+ *
+ * RETURN VALUE
+ *   Returns the length including the line end, or 0 if it is not found.
+ */
+static size_t sink_h1_find(const char *data, size_t len, bool_t flag_empty)
+{
+	size_t i, n = flag_empty ? 4 : 2;
+
+	for (i = 0; (i + n) <= len; i++)
+		if ((data[i] == '\r') && (data[i + 1] == '\n') && (!flag_empty || ((data[i + 2] == '\r') && (data[i + 3] == '\n'))))
+			return i + n;
+
+	return 0;
+}
+
+
+/***
+ * NAME
+ *   sink_h1_token -
+ *
+ * ARGUMENTS
+ *   value -
+ *   len   -
+ *   token -
+ *
+ * DESCRIPTION
+ *   Checks whether the comma-separated header value contains the token.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static bool_t sink_h1_token(const char *value, size_t len, const char *token)
+{
+	const char *end = value + len, *ptr;
+	size_t      n;
+
+	for ( ; value < end; value = ptr + 1) {
+		while ((value < end) && isspace(*value))
+			value++;
+
+		for (ptr = value; (ptr < end) && (*ptr != ','); ptr++);
+
+		for (n = ptr - value; (n > 0) && isspace(value[n - 1]); n--);
+
+		if ((n == strlen(token)) && (strncasecmp(value, token, n) == 0))
+			return 1;
+	}
+
+	return 0;
+}
+
+
+/***
+ * NAME
+ *   sink_h1_head -
+ *
+ * ARGUMENTS
+ *   conn -
+ *   data -
+ *   len  -
+ *
+ * DESCRIPTION
+ *   Parses the request line and the headers of an HTTP/1.1 request.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h1_head(struct sink_conn *conn, const char *data, size_t len)
+{
+	struct sink_request *req = &(conn->h1_req);
+	const char          *end = data + len, *eol, *sp1, *sp2, *path, *ptr, *value;
+	size_t               n, vlen;
+	bool_t               flag_cl = 0;
+
+	/* The request line. */
+	eol = data + sink_h1_find(data, len, 0) - 2;
+	if (_NULL(sp1 = memchr(data, ' ', eol - data)) || _NULL(sp2 = memchr(sp1 + 1, ' ', eol - sp1 - 1)))
+		return FUNC_RET_ERROR;
+	else if (((sp1 - data) >= SINK_METHOD_MAX) || ((eol - sp2 - 1) != STR_SIZE("HTTP/1.1")) || (strncmp(sp2 + 1, "HTTP/1.", 7) != 0))
+		return FUNC_RET_ERROR;
+
+	(void)memcpy(req->method, data, sp1 - data);
+	req->flag_close = (sp2[8] == '0');
+
+	/* The path of the absolute-form request target. */
+	path = sp1 + 1;
+	if (((sp2 - path) > 3) && _nNULL(ptr = memchr(path, ':', sp2 - path)) && (ptr[1] == '/') && (ptr[2] == '/')) {
+		if (_NULL(path = memchr(ptr + 3, '/', sp2 - ptr - 3)))
+			path = sp2;
+	}
+	for (ptr = path; (ptr < sp2) && (*ptr != '?'); ptr++);
+
+	if (_NULL(req->path = (ptr == path) ? strdup("/") : strndup(path, ptr - path)))
+		return FUNC_RET_ERROR;
+
+	/* The headers. */
+	for (data = eol + 2; (data + 2) < end; data = eol + 2) {
+		eol = data + sink_h1_find(data, end - data, 0) - 2;
+		if (_NULL(ptr = memchr(data, ':', eol - data)))
+			return FUNC_RET_ERROR;
+
+		n = ptr - data;
+		for (value = ptr + 1; (value < eol) && isspace(*value); value++);
+		for (vlen = eol - value; (vlen > 0) && isspace(value[vlen - 1]); vlen--);
+
+		if (SINK_HDR_IS(data, n, "content-length")) {
+			for (req->content_length = 0, ptr = value; ptr < (value + vlen); ptr++)
+				if (IN_RANGE(*ptr, '0', '9'))
+					req->content_length = req->content_length * 10 + (*ptr - '0');
+				else
+					return FUNC_RET_ERROR;
+
+			flag_cl = 1;
+		}
+		else if (SINK_HDR_IS(data, n, "transfer-encoding")) {
+			req->flag_chunked = sink_h1_token(value, vlen, "chunked");
+		}
+		else if (SINK_HDR_IS(data, n, "connection")) {
+			if (sink_h1_token(value, vlen, "close"))
+				req->flag_close = 1;
+			else if (sink_h1_token(value, vlen, "keep-alive"))
+				req->flag_close = 0;
+		}
+		else if (SINK_HDR_IS(data, n, "expect")) {
+			req->flag_continue = SINK_HDR_IS(value, vlen, "100-continue");
+		}
+		else if (SINK_HDR_IS(data, n, "upgrade")) {
+			req->flag_upgrade = sink_h1_token(value, vlen, "h2c");
+		}
+		else if (SINK_HDR_IS(data, n, "http2-settings")) {
+			PTR_FREE(req->h2_settings);
+			if (_NULL(req->h2_settings = strndup(value, vlen)))
+				return FUNC_RET_ERROR;
+		}
+	}
+
+	if (req->flag_chunked)
+		req->content_length = 0;
+	else if (!flag_cl)
+		req->content_length = 0;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   sink_h1_respond -
+ *
+ * ARGUMENTS
+ *   conn -
+ *   body -
+ *
+ * DESCRIPTION
+ *   Appends the response to the current request to the send buffer and
+ *   prepares the connection for the next request.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h1_respond(struct sink_conn *conn, struct buffer *body)
+{
+	size_t len = _NULL(body) ? 0 : body->len;
+	int    retval;
+
+	if (conn->h1_req.flag_close)
+		conn->flag_close = 1;
+
+	retval = sink_printf(&(conn->wr_buf), "HTTP/1.1 %d %s\r\nContent-Length: %zu\r\n%s%s\r\n",
+	                     conn->h1_status, sink_status_reason(conn->h1_status), len,
+	                     (len > 0) ? "Content-Type: text/plain\r\n" : "", conn->flag_close ? "Connection: close\r\n" : "");
+	if (_nERROR(retval) && (len > 0))
+		retval = buffer_append(&(conn->wr_buf), body->ptr, len);
+
+	sink_request_free(&(conn->h1_req));
+	conn->h1_state = SINK_H1_HEAD;
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sink_h1_done -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Handles the complete HTTP/1.1 request.  The response is either sent
+ *   right away or, if a delay is set, when the delay timer expires; in the
+ *   meantime no further requests are read from the connection.  A request
+ *   asking for the upgrade to h2c becomes the stream 1 of the HTTP/2
+ *   connection.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h1_done(struct sink_conn *conn)
+{
+	struct buffer body = { .ptr = NULL };
+	int           retval;
+
+#ifdef HAVE_LIBNGHTTP2
+	if (conn->h1_req.flag_upgrade && _nNULL(conn->h1_req.h2_settings)) {
+		retval = sink_printf(&(conn->wr_buf), "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n");
+		if (_nERROR(retval))
+			retval = sink_h2_init(conn, &(conn->h1_req));
+
+		sink_request_free(&(conn->h1_req));
+		conn->h1_state = SINK_H1_HEAD;
+
+		return retval;
+	}
+#endif
+
+	conn->h1_status = sink_request_done(&(conn->h1_req), &body);
+
+	if ((_prg.delay > 0) && (body.len == 0)) {
+		conn->h1_state = SINK_H1_DELAY;
+
+		ev_io_stop(_prg.ev_base, &(conn->ev_rd));
+		ev_timer_set(&(conn->ev_delay), _prg.delay, 0.0);
+		ev_timer_start(_prg.ev_base, &(conn->ev_delay));
+
+		retval = FUNC_RET_OK;
+	} else {
+		retval = sink_h1_respond(conn, &body);
+	}
+
+	PTR_FREE(body.ptr);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sink_h1_process -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Parses the HTTP/1.1 requests in the receive buffer.  The request bodies
+ *   are only counted, the unparsed rest of the data stays in the buffer.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_h1_process(struct sink_conn *conn)
+{
+	const char *data = (const char *)conn->rd_buf.ptr;
+	size_t      head = 0, len, n;
+	uint64_t    size;
+	int         retval = FUNC_RET_OK;
+
+	while (_nERROR(retval) && (conn->proto == SINK_PROTO_HTTP1) && (conn->h1_state != SINK_H1_DELAY) && !conn->flag_close) {
+		len = conn->rd_buf.len - head;
+
+		if (conn->h1_state == SINK_H1_HEAD) {
+			if ((len > 0) && (memcmp(data + head, SINK_H2_PREFACE, MIN(len, STR_SIZE(SINK_H2_PREFACE))) == 0)) {
+				if (len < STR_SIZE(SINK_H2_PREFACE))
+					break;
+
+#ifdef HAVE_LIBNGHTTP2
+				/* HTTP/2 with prior knowledge, nghttp2 consumes the preface. */
+				retval = sink_h2_init(conn, NULL);
+
+				break;
+#else
+				retval = FUNC_RET_ERROR;
+
+				break;
+#endif
+			}
+			else if ((n = sink_h1_find(data + head, len, 1)) == 0) {
+				if (len >= SINK_HDR_MAX) {
+					_prg.bad_requests++;
+					retval = FUNC_RET_ERROR;
+				}
+
+				break;
+			}
+			else if (_ERROR(sink_h1_head(conn, data + head, n))) {
+				_prg.bad_requests++;
+				sink_request_free(&(conn->h1_req));
+				conn->h1_req.flag_close = 1;
+				conn->h1_status         = 400;
+				retval = sink_h1_respond(conn, NULL);
+
+				break;
+			}
+
+			head += n;
+
+			if (conn->h1_req.flag_continue && (conn->h1_req.flag_chunked || (conn->h1_req.content_length > 0)))
+				retval = sink_printf(&(conn->wr_buf), "HTTP/1.1 100 Continue\r\n\r\n");
+
+			if (conn->h1_req.flag_chunked) {
+				conn->h1_state = SINK_H1_CHUNK_SIZE;
+			}
+			else if (conn->h1_req.content_length > 0) {
+				conn->h1_state  = SINK_H1_BODY;
+				conn->h1_remain = conn->h1_req.content_length;
+			}
+			else if (_nERROR(retval)) {
+				retval = sink_h1_done(conn);
+			}
+		}
+		else if ((conn->h1_state == SINK_H1_BODY) || (conn->h1_state == SINK_H1_CHUNK_DATA)) {
+			if (len == 0)
+				break;
+
+			n = MIN(len, conn->h1_remain);
+			head                 += n;
+			conn->h1_remain      -= n;
+			conn->h1_req.bytes   += n;
+
+			if (conn->h1_remain > 0)
+				/* Do nothing. */;
+			else if (conn->h1_state == SINK_H1_CHUNK_DATA)
+				conn->h1_state = SINK_H1_CHUNK_CRLF;
+			else
+				retval = sink_h1_done(conn);
+		}
+		else if (conn->h1_state == SINK_H1_CHUNK_SIZE) {
+			if ((n = sink_h1_find(data + head, len, 0)) == 0)
+				break;
+
+			for (size = 0, len = 0; isxdigit(data[head + len]); len++)
+				size = (size << 4) | (isdigit(data[head + len]) ? (data[head + len] - '0') : ((tolower(data[head + len]) - 'a') + 10));
+
+			if (len == 0) {
+				_prg.bad_requests++;
+				retval = FUNC_RET_ERROR;
+
+				break;
+			}
+
+			head += n;
+
+			if (size > 0) {
+				conn->h1_state  = SINK_H1_CHUNK_DATA;
+				conn->h1_remain = size;
+			} else {
+				conn->h1_state  = SINK_H1_TRAILER;
+			}
+		}
+		else if (conn->h1_state == SINK_H1_CHUNK_CRLF) {
+			if (len < 2)
+				break;
+
+			head += 2;
+			conn->h1_state = SINK_H1_CHUNK_SIZE;
+		}
+		else if (conn->h1_state == SINK_H1_TRAILER) {
+			if ((n = sink_h1_find(data + head, len, 0)) == 0)
+				break;
+
+			head += n;
+
+			if (n == 2)
+				retval = sink_h1_done(conn);
+		}
+	}
+
+	if (head > 0) {
+		conn->rd_buf.len -= head;
+		(void)memmove(conn->rd_buf.ptr, conn->rd_buf.ptr + head, conn->rd_buf.len);
+	}
+
+#ifdef HAVE_LIBNGHTTP2
+	/* The rest of the data after the switch to HTTP/2. */
+	if (_nERROR(retval) && (conn->proto == SINK_PROTO_HTTP2))
+		retval = (conn->rd_buf.len > 0) ? sink_h2_recv(conn) : sink_h2_send(conn);
+#endif
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sink_delay_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Sends the delayed HTTP/1.1 response and continues with the requests
+ *   received in the meantime.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_delay_cb(struct ev_loop *loop, struct ev_timer *ev, int revents __maybe_unused)
+{
+	struct sink_conn *conn = ev->data;
+	struct buffer     body = { .ptr = NULL };
+	int               rc;
+
+	rc = sink_h1_respond(conn, &body);
+	if (_nERROR(rc)) {
+		ev_io_start(loop, &(conn->ev_rd));
+
+		rc = sink_h1_process(conn);
+	}
+	if (_nERROR(rc))
+		rc = sink_conn_flush(conn);
+
+	if (_ERROR(rc))
+		sink_conn_close(conn);
+}
+
+
+/***
+ * NAME
+ *   sink_read_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_read_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	struct sink_conn *conn = ev->data;
+	uint8_t          *ptr;
+	ssize_t           n;
+	int               rc;
+
+	/* Only the request head is kept in the buffer, so it grows up to SINK_HDR_MAX. */
+	if (conn->rd_buf.len == conn->rd_buf.size) {
+		if (conn->rd_buf.size >= SINK_HDR_MAX) {
+			sink_conn_close(conn);
+
+			return;
+		}
+		else if (_NULL(ptr = realloc(conn->rd_buf.ptr, conn->rd_buf.size * 2))) {
+			sink_conn_close(conn);
+
+			return;
+		}
+
+		conn->rd_buf.ptr   = ptr;
+		conn->rd_buf.size *= 2;
+	}
+
+	n = recv(conn->fd, conn->rd_buf.ptr + conn->rd_buf.len, conn->rd_buf.size - conn->rd_buf.len, 0);
+	if (n == 0) {
+		sink_conn_close(conn);
+
+		return;
+	}
+	else if (n < 0) {
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+			sink_conn_close(conn);
+
+		return;
+	}
+
+	conn->rd_buf.len += n;
+
+#ifdef HAVE_LIBNGHTTP2
+	if (conn->proto == SINK_PROTO_HTTP2)
+		rc = sink_h2_recv(conn);
+	else
+#endif
+		rc = sink_h1_process(conn);
+
+	if (_nERROR(rc))
+		rc = sink_conn_flush(conn);
+
+	if (_ERROR(rc))
+		sink_conn_close(conn);
+}
+
+
+/***
+ * NAME
+ *   sink_write_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_write_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	struct sink_conn *conn = ev->data;
+
+	if (_ERROR(sink_conn_flush(conn)))
+		sink_conn_close(conn);
+}
+
+
+/***
+ * NAME
+ *   sink_accept_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_accept_cb(struct ev_loop *loop, struct ev_io *ev, int revents __maybe_unused)
+{
+	struct sink_conn *conn;
+	int               fd, flag = 1;
+
+	while ((fd = accept(ev->fd, NULL, NULL)) >= 0) {
+		if (_NULL(conn = calloc(1, sizeof(*conn))) || _NULL(conn->rd_buf.ptr = malloc(SINK_RD_BUFSIZE))) {
+			(void)fprintf(stderr, "ERROR: failed to allocate connection\n");
+			(void)close(fd);
+
+			if (_nNULL(conn))
+				PTR_FREE(conn);
+
+			continue;
+		}
+
+		(void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+		(void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+		conn->fd          = fd;
+		conn->rd_buf.size = SINK_RD_BUFSIZE;
+#ifdef HAVE_LIBNGHTTP2
+		LIST_INIT(&(conn->h2_streams));
+#endif
+
+		ev_io_init(&(conn->ev_rd), sink_read_cb, fd, EV_READ);
+		ev_io_init(&(conn->ev_wr), sink_write_cb, fd, EV_WRITE);
+		ev_init(&(conn->ev_delay), sink_delay_cb);
+		conn->ev_rd.data    = conn;
+		conn->ev_wr.data    = conn;
+		conn->ev_delay.data = conn;
+		ev_io_start(loop, &(conn->ev_rd));
+
+		LIST_ADDQ(&(_prg.conns), &(conn->list));
+		_prg.connections++;
+	}
+
+	if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR) && (errno != ECONNABORTED))
+		(void)fprintf(stderr, "ERROR: failed to accept connection: %m\n");
+}
+
+
+/***
+ * NAME
+ *   sink_signal_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   SIGUSR1 shows the counters, the other signals stop the program.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_signal_cb(struct ev_loop *loop, struct ev_signal *ev, int revents __maybe_unused)
+{
+	if (ev->signum == SIGUSR1)
+		sink_stats_show();
+	else
+		ev_break(loop, EVBREAK_ALL);
+}
+
+
+/***
+ * NAME
+ *   sink_interval_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sink_interval_cb(struct ev_loop *loop, struct ev_timer *ev __maybe_unused, int revents __maybe_unused)
+{
+	(void)printf("%.3f s: %.1f requests/s, %"PRIu64" request(s), %"PRIu64" error(s)\n",
+	             ev_now(loop) - _prg.start_time, (_prg.requests - _prg.requests_last) / _prg.interval, _prg.requests, _prg.errors);
+	(void)fflush(stdout);
+
+	_prg.requests_last = _prg.requests;
+}
+
+
+/***
+ * NAME
+ *   sink_listen -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sink_listen(void)
+{
+	struct addrinfo hints, *ai;
+	char            port[8];
+	int             rc, flag = 1;
+
+	(void)memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags    = AI_PASSIVE;
+	(void)snprintf(port, sizeof(port), "%d", _prg.port);
+
+	if ((rc = getaddrinfo(_prg.address, port, &hints, &ai)) != 0) {
+		(void)fprintf(stderr, "ERROR: failed to resolve '%s': %s\n", _prg.address, gai_strerror(rc));
+
+		return FUNC_RET_ERROR;
+	}
+
+	rc = FUNC_RET_ERROR;
+	if (_ERROR(_prg.fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)))
+		(void)fprintf(stderr, "ERROR: failed to create socket: %m\n");
+	else if (_ERROR(setsockopt(_prg.fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag))))
+		(void)fprintf(stderr, "ERROR: failed to set socket option: %m\n");
+	else if (_ERROR(bind(_prg.fd, ai->ai_addr, ai->ai_addrlen)))
+		(void)fprintf(stderr, "ERROR: failed to bind to %s:%d: %m\n", _prg.address, _prg.port);
+	else if (_ERROR(listen(_prg.fd, _prg.backlog)))
+		(void)fprintf(stderr, "ERROR: failed to listen on %s:%d: %m\n", _prg.address, _prg.port);
+	else if (_ERROR(fcntl(_prg.fd, F_SETFL, fcntl(_prg.fd, F_GETFL) | O_NONBLOCK)))
+		(void)fprintf(stderr, "ERROR: failed to set non-blocking socket: %m\n");
+	else
+		rc = FUNC_RET_OK;
+
+	freeaddrinfo(ai);
+
+	return rc;
+}
+
+
+/***
+ * NAME
+ *   main -
+ *
+ * ARGUMENTS
+ *   argv -
+ *   argc -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+int main(int argc, char **argv)
+{
+	static const struct option longopts[] = {
+		{ "address",      required_argument, NULL, 'a' },
+		{ "backlog",      required_argument, NULL, 'b' },
+		{ "delay",        required_argument, NULL, 'd' },
+		{ "error-status", required_argument, NULL, 'E' },
+		{ "error-ratio",  required_argument, NULL, 'e' },
+		{ "help",         no_argument,       NULL, 'h' },
+		{ "interval",     required_argument, NULL, 'i' },
+		{ "port",         required_argument, NULL, 'p' },
+		{ "stats-path",   required_argument, NULL, 's' },
+		{ "version",      no_argument,       NULL, 'V' },
+		{ NULL,           0,                 NULL, 0   }
+	};
+	struct sink_conn  *conn, *conn_back;
+	struct sink_stats *stats, *stats_back;
+	bool_t             flag_error = 0;
+	int                c, retval = EX_OK;
+
+	_prg.name = basename(argv[0]);
+
+	while ((c = getopt_long(argc, argv, ":a:b:d:E:e:hi:p:s:V", longopts, NULL)) != EOF) {
+		if (c == 'a')
+			_prg.address = optarg;
+		else if (c == 'b')
+			_prg.backlog = atoi(optarg);
+		else if (c == 'd')
+			flag_error |= _OK(getopt_set_double("delay", optarg, &(_prg.delay), 0, 3600)) ? 0 : 1;
+		else if (c == 'E')
+			_prg.error_status = atoi(optarg);
+		else if (c == 'e')
+			flag_error |= _OK(getopt_set_double("error ratio", optarg, &(_prg.error_ratio), 0, 1)) ? 0 : 1;
+		else if (c == 'h')
+			_prg.opt_flags |= FLAG_OPT_HELP;
+		else if (c == 'i')
+			flag_error |= _OK(getopt_set_double("interval", optarg, &(_prg.interval), 0, 3600)) ? 0 : 1;
+		else if (c == 'p')
+			_prg.port = atoi(optarg);
+		else if (c == 's')
+			_prg.stats_path = optarg;
+		else if (c == 'V')
+			_prg.opt_flags |= FLAG_OPT_VERSION;
+		else
+			flag_error = 1;
+	}
+
+	if (_prg.opt_flags & FLAG_OPT_HELP) {
+		usage(_prg.name, 1);
+	}
+	else if (_prg.opt_flags & FLAG_OPT_VERSION) {
+		(void)printf("\n%s v%s [build %d] by %s, %s\n\n", _prg.name, PACKAGE_VERSION, PACKAGE_BUILD, PACKAGE_AUTHOR, __DATE__);
+	}
+	else if (flag_error) {
+		usage(_prg.name, 0);
+	}
+	else if (!IN_RANGE(_prg.port, 1, 65535)) {
+		(void)fprintf(stderr, "ERROR: invalid port: %d\n", _prg.port);
+
+		flag_error = 1;
+	}
+	else if (!IN_RANGE(_prg.error_status, 200, 599)) {
+		(void)fprintf(stderr, "ERROR: invalid error status: %d\n", _prg.error_status);
+
+		flag_error = 1;
+	}
+	else if (_prg.backlog < 1) {
+		(void)fprintf(stderr, "ERROR: invalid backlog: %d\n", _prg.backlog);
+
+		flag_error = 1;
+	}
+
+	if (flag_error || (_prg.opt_flags & (FLAG_OPT_HELP | FLAG_OPT_VERSION)))
+		return flag_error ? EX_USAGE : EX_OK;
+
+	LIST_INIT(&(_prg.conns));
+	LIST_INIT(&(_prg.stats));
+
+	if (_ERROR(sink_listen())) {
+		retval = EX_UNAVAILABLE;
+	}
+	else if (_NULL(_prg.ev_base = ev_default_loop(EVFLAG_AUTO))) {
+		(void)fprintf(stderr, "ERROR: failed to initialize libev\n");
+
+		retval = EX_SOFTWARE;
+	}
+	else {
+		_prg.start_time = ev_time();
+
+		ev_io_init(&(_prg.ev_accept), sink_accept_cb, _prg.fd, EV_READ);
+		ev_signal_init(&(_prg.ev_sigint), sink_signal_cb, SIGINT);
+		ev_signal_init(&(_prg.ev_sigterm), sink_signal_cb, SIGTERM);
+		ev_signal_init(&(_prg.ev_sigusr1), sink_signal_cb, SIGUSR1);
+		ev_io_start(_prg.ev_base, &(_prg.ev_accept));
+		ev_signal_start(_prg.ev_base, &(_prg.ev_sigint));
+		ev_signal_start(_prg.ev_base, &(_prg.ev_sigterm));
+		ev_signal_start(_prg.ev_base, &(_prg.ev_sigusr1));
+
+		if (_prg.interval > 0) {
+			ev_timer_init(&(_prg.ev_interval), sink_interval_cb, _prg.interval, _prg.interval);
+			ev_timer_start(_prg.ev_base, &(_prg.ev_interval));
+		}
+
+		(void)printf("%s: listening on %s:%d\n", _prg.name, _prg.address, _prg.port);
+		(void)fflush(stdout);
+
+		(void)ev_run(_prg.ev_base, 0);
+
+		sink_stats_show();
+
+		list_for_each_entry_safe(conn, conn_back, &(_prg.conns), list)
+			sink_conn_close(conn);
+	}
+
+	list_for_each_entry_safe(stats, stats_back, &(_prg.stats), list) {
+		PTR_FREE(stats->path);
+		PTR_FREE(stats);
+	}
+
+	if (_prg.fd >= 0)
+		(void)close(_prg.fd);
+
+	return retval;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
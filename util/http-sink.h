@@ -0,0 +1,175 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _HTTP_SINK_H
+#define _HTTP_SINK_H
+
+#ifdef HAVE_LIBNGHTTP2
+#  include <nghttp2/nghttp2.h>
+#endif
+
+#define SINK_DEFAULT_ADDRESS       "127.0.0.1"
+#define SINK_DEFAULT_PORT          10080
+#define SINK_DEFAULT_BACKLOG       1024
+#define SINK_DEFAULT_ERROR_STATUS  503
+#define SINK_DEFAULT_STATS_PATH    "/sink-stats"
+
+#define SINK_RD_BUFSIZE            16384  /* Initial size of the receive buffer. */
+#define SINK_HDR_MAX               65536  /* Maximum size of the HTTP/1.1 request head. */
+#define SINK_METHOD_MAX            16
+#define SINK_STATS_MAX             1024   /* Number of counted method/path pairs. */
+#define SINK_STATS_BUCKETS         256
+#define SINK_STATS_OTHER           "(other)"
+#define SINK_H2_PREFACE            "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+
+enum sink_proto {
+	SINK_PROTO_HTTP1 = 0,
+	SINK_PROTO_HTTP2,
+};
+
+enum sink_h1_state {
+	SINK_H1_HEAD = 0,       /* Request line and headers. */
+	SINK_H1_BODY,           /* Body with the Content-Length. */
+	SINK_H1_CHUNK_SIZE,
+	SINK_H1_CHUNK_DATA,
+	SINK_H1_CHUNK_CRLF,
+	SINK_H1_TRAILER,
+	SINK_H1_DELAY,          /* Complete request, the response is delayed. */
+};
+
+struct sink_stats {
+	struct list        list;
+	struct sink_stats *next;          /* Link in the hash bucket. */
+	char               method[SINK_METHOD_MAX];
+	char              *path;
+	uint64_t           requests;
+	uint64_t           bytes;           /* Received request body bytes. */
+	uint64_t           errors;          /* Injected error responses. */
+};
+
+struct sink_request {
+	enum sink_proto    proto;
+	char               method[SINK_METHOD_MAX];
+	char              *path;
+	uint64_t           bytes;
+	uint64_t           content_length;
+	bool_t             flag_chunked;
+	bool_t             flag_close;
+	bool_t             flag_continue;   /* Expect: 100-continue */
+	bool_t             flag_upgrade;    /* Upgrade: h2c */
+	char              *h2_settings;     /* HTTP2-Settings header value. */
+};
+
+struct sink_conn {
+	struct list           list;
+	int                   fd;
+	enum sink_proto       proto;
+	struct ev_io          ev_rd;
+	struct ev_io          ev_wr;
+	struct ev_timer       ev_delay;
+	struct buffer         rd_buf;
+	struct buffer         wr_buf;
+	size_t                wr_head;      /* Start of the unsent data in wr_buf. */
+	bool_t                flag_close;   /* Close after the send buffer is flushed. */
+
+	enum sink_h1_state    h1_state;
+	uint64_t              h1_remain;    /* Body or chunk bytes still to be received. */
+	struct sink_request   h1_req;
+	int                   h1_status;
+
+#ifdef HAVE_LIBNGHTTP2
+	nghttp2_session      *h2;
+	struct list           h2_streams;
+#endif
+};
+
+struct sink_stream {
+	struct list           list;
+	struct sink_conn     *conn;
+	int32_t               id;
+	struct sink_request   req;
+	struct ev_timer       ev_delay;
+	int                   status;
+	struct buffer         body;         /* Response body. */
+	size_t                body_head;
+};
+
+struct _prg_data {
+	const char         *name;
+	uint8_t             opt_flags;
+
+	const char         *address;
+	int                 port;
+	int                 backlog;
+	double              delay;           /* Response delay in seconds. */
+	double              error_ratio;     /* Share of the requests answered with error_status. */
+	int                 error_status;
+	double              interval;        /* Request rate report interval. */
+	const char         *stats_path;
+
+	struct ev_loop     *ev_base;
+	struct ev_io        ev_accept;
+	struct ev_signal    ev_sigint;
+	struct ev_signal    ev_sigterm;
+	struct ev_signal    ev_sigusr1;
+	struct ev_timer     ev_interval;
+	int                 fd;
+	struct list         conns;
+
+	struct list         stats;
+	struct sink_stats  *stats_bucket[SINK_STATS_BUCKETS];
+	int                 stats_cnt;
+
+	double              start_time;
+	uint64_t            connections;
+	uint64_t            connections_h2;
+	uint64_t            requests;
+	uint64_t            requests_h2;
+	uint64_t            requests_last;   /* Requests at the previous rate report. */
+	uint64_t            bytes;
+	uint64_t            errors;
+	uint64_t            bad_requests;
+};
+
+/* http-sink.c */
+int  sink_request_done(struct sink_request *req, struct buffer *body);
+void sink_request_free(struct sink_request *req);
+int  sink_conn_flush(struct sink_conn *conn);
+void sink_conn_close(struct sink_conn *conn);
+
+#ifdef HAVE_LIBNGHTTP2
+/* http-sink-h2.c */
+int  sink_h2_init(struct sink_conn *conn, struct sink_request *upgrade);
+int  sink_h2_recv(struct sink_conn *conn);
+int  sink_h2_send(struct sink_conn *conn);
+void sink_h2_free(struct sink_conn *conn);
+#endif
+
+extern struct _prg_data _prg;
+
+#endif /* _HTTP_SINK_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
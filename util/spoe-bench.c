@@ -0,0 +1,994 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+#include "spoe-bench.h"
+#include "util.h"
+
+
+/* The debug output is left disabled, it would be measured as well. */
+struct config_data  cfg;
+struct program_data prg;
+struct _prg_data    _prg = {
+	.corpus = SB_DEFAULT_CORPUS,
+	.runs   = SB_DEFAULT_RUNS,
+	.time   = SB_DEFAULT_TIME,
+};
+
+#ifdef DEBUG
+__THR const void *dbg_w_ptr  = NULL;
+__THR int         dbg_indent = 0;
+#endif
+
+/*
+ * The program is linked with the '-Wl,--wrap=' options for the memory
+ * allocation functions, so that the allocations made by the benchmarked
+ * code can be counted.
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t nmemb, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+
+
+/***
+ * NAME
+ *   usage -
+ *
+ * ARGUMENTS
+ *   program_name -
+ *   flag_verbose -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void usage(const char *program_name, bool_t flag_verbose)
+{
+	(void)printf("\nUsage: %s { -h --help }\n", program_name);
+	(void)printf("       %s { -V --version }\n", program_name);
+	(void)printf("       %s [OPTION]...\n\n", program_name);
+
+	if (flag_verbose) {
+		(void)printf("Options are:\n");
+		(void)printf("  -c, --corpus=FILE    Specifies the file with the test frames (default: %s).\n", SB_DEFAULT_CORPUS);
+		(void)printf("  -f, --filter=NAME    Runs only the cases whose benchmark or frame name contains NAME.\n");
+		(void)printf("  -r, --runs=VALUE     Sets the number of measured runs of each case (default: %d).\n", SB_DEFAULT_RUNS);
+		(void)printf("  -t, --time=TIME      Sets the minimum duration of one run in seconds (default: %.1f).\n", SB_DEFAULT_TIME);
+		(void)printf("  -h, --help           Shows this text.\n");
+		(void)printf("  -V, --version        Shows program version.\n\n");
+		(void)printf("Copyright 2026 HAProxy Technologies\n");
+		(void)printf("SPDX-License-Identifier: GPL-2.0-or-later\n\n");
+	} else {
+		(void)printf("For help type: %s -h\n\n", program_name);
+	}
+}
+
+
+/***
+ * NAME
+ *   __wrap_malloc -
+ *
+ * ARGUMENTS
+ *   size -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+void *__wrap_malloc(size_t size)
+{
+	if (_prg.flag_count)
+		_prg.allocs++;
+
+	return __real_malloc(size);
+}
+
+
+/***
+ * NAME
+ *   __wrap_calloc -
+ *
+ * ARGUMENTS
+ *   nmemb -
+ *   size  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+	if (_prg.flag_count)
+		_prg.allocs++;
+
+	return __real_calloc(nmemb, size);
+}
+
+
+/***
+ * NAME
+ *   __wrap_realloc -
+ *
+ * ARGUMENTS
+ *   ptr  -
+ *   size -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	if (_prg.flag_count)
+		_prg.allocs++;
+
+	return __real_realloc(ptr, size);
+}
+
+
+/***
+ * NAME
+ *   sb_time -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the monotonic time in seconds.
+ */
+static double sb_time(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/***
+ * NAME
+ *   sb_frame_alloc -
+ *
+ * ARGUMENTS
+ *   size -
+ *
+ * DESCRIPTION
+ *   Allocates a frame that can be used by the SPOE encoder.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct spoe_frame *sb_frame_alloc(size_t size)
+{
+	struct spoe_frame *frame;
+
+	if (_NULL(frame = calloc(1, sizeof(*frame) + SPOA_FRM_LEN + size)))
+		return NULL;
+
+	SPOE_FRAME_BUFFER_SET(frame, frame->data + SPOA_FRM_LEN, 0, 0, 0);
+	LIST_INIT(&(frame->list));
+	frame->client = &(_prg.client);
+	frame->size   = size;
+
+	return frame;
+}
+
+
+/***
+ * NAME
+ *   sb_frame_init -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   bc    -
+ *
+ * DESCRIPTION
+ *   Prepares the frame for decoding of the case data, the same way the
+ *   agent does it with a received frame.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void sb_frame_init(struct spoe_frame *frame, const struct sb_case *bc)
+{
+	(void)memset(frame, 0, sizeof(*frame));
+	SPOE_FRAME_BUFFER_SET(frame, (typeof(frame->buf))bc->data, 0, bc->len, 0);
+	frame->client = &(_prg.client);
+}
+
+
+/***
+ * NAME
+ *   cb_sb_dec_str -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   arg1  -
+ *   arg2  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int cb_sb_dec_str(struct spoe_frame *frame __maybe_unused, void *arg1 __maybe_unused, void *arg2)
+{
+	_prg.sink += *(uint64_t *)arg2;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   cb_sb_dec_uint8 -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   arg1  -
+ *   arg2  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int cb_sb_dec_uint8(struct spoe_frame *frame __maybe_unused, void *arg1, void *arg2 __maybe_unused)
+{
+	_prg.sink += *(uint8_t *)arg1;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   cb_sb_dec_varint -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   arg1  -
+ *   arg2  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int cb_sb_dec_varint(struct spoe_frame *frame __maybe_unused, void *arg1, void *arg2 __maybe_unused)
+{
+	_prg.sink += *(uint64_t *)arg1;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   sb_decode_hdrs_bin -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   buf   -
+ *   end   -
+ *
+ * DESCRIPTION
+ *   Walks the HTTP headers in the req.hdrs_bin format with the same decoder
+ *   as spoa_msg_arg_hdrs_bin() uses, but without building the headers.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_decode_hdrs_bin(struct spoe_frame *frame, const char *buf, const char *end)
+{
+	struct chunk name, value;
+	int          retval = FUNC_RET_OK;
+
+	while (buf < end) {
+		retval = spoe_decode_hdr(frame, &buf, end, &name, &value);
+		if (_ERROR(retval) || _NULL(name.ptr))
+			break;
+
+		_prg.sink += name.len + value.len;
+	}
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sb_decode_notify -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   buf   -
+ *   end   -
+ *
+ * DESCRIPTION
+ *   Decodes all messages of the NOTIFY frame as the agent does it: the
+ *   message name, the number of arguments and the arguments themselves.
+ *   The binary headers of the 'mirror' message are also walked through.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_decode_notify(struct spoe_frame *frame, const char *buf, const char *end)
+{
+	union spoe_data      data;
+	enum spoe_data_type  type;
+	const char          *str;
+	uint64_t             len;
+	uint8_t              nbargs;
+	int                  i, retval = FUNC_RET_OK;
+
+	while (_nERROR(retval) && (buf < end)) {
+		retval = spoe_decode(frame, &buf, end,
+		                     SPOE_DEC_STR0, &str, &len,   /* message name */
+		                     SPOE_DEC_UINT8, &nbargs,     /* number of arguments */
+		                     SPOE_DEC_END);
+
+		for (i = 0; _nERROR(retval) && (i < nbargs); i++) {
+			retval = spoe_decode(frame, &buf, end,
+			                     SPOE_DEC_STR0, &str, &len,   /* arg name */
+			                     SPOE_DEC_DATA, &data, &type, /* arg value */
+			                     SPOE_DEC_END);
+			if (_ERROR(retval))
+				break;
+			else if ((type == SPOE_DATA_T_BIN) && (len == STR_SIZE(SPOE_MSG_ARG_HDRS)) && (memcmp(str, STR_ADDRSIZE(SPOE_MSG_ARG_HDRS)) == 0))
+				retval = sb_decode_hdrs_bin(frame, data.chk.ptr, data.chk.ptr + data.chk.len);
+			else if (TEST_OR2(type, SPOE_DATA_T_STR, SPOE_DATA_T_BIN))
+				_prg.sink += data.chk.len;
+			else
+				_prg.sink += type;
+		}
+	}
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sb_decode_frame -
+ *
+ * ARGUMENTS
+ *   bc -
+ *
+ * DESCRIPTION
+ *   Decodes the frame header and the payload of the frame, depending on its
+ *   type.  The payload of the ACK frames is not decoded, the agent does not
+ *   receive them.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_decode_frame(const struct sb_case *bc)
+{
+	struct spoe_frame  frame;
+	const char        *ptr, *end;
+	uint8_t            stype;
+	int                rc;
+
+	sb_frame_init(&frame, bc);
+
+	stype = *(bc->data);
+	rc    = spoe_decode_frame("BENCH", &frame, stype, FUNC_RET_ERROR, SPOE_DEC_END);
+	if (_ERROR(rc))
+		return rc;
+
+	ptr = frame.buf + rc;
+	end = frame.buf + frame.len;
+
+	if (stype == SPOE_FRM_T_HAPROXY_HELLO)
+		rc = spoe_decode_kv(&frame, &ptr, end,
+		                    SPOE_DEC_STR, STR_ADDRSIZE("supported-versions"), cb_sb_dec_str,
+		                    SPOE_DEC_VARINT, STR_ADDRSIZE("max-frame-size"), cb_sb_dec_varint,
+		                    SPOE_DEC_UINT8, STR_ADDRSIZE("healthcheck"), cb_sb_dec_uint8,
+		                    SPOE_DEC_STR, STR_ADDRSIZE("capabilities"), cb_sb_dec_str,
+		                    SPOE_DEC_STR, STR_ADDRSIZE("engine-id"), cb_sb_dec_str,
+		                    SPOE_DEC_END);
+	else if (TEST_OR2(stype, SPOE_FRM_T_HAPROXY_DISCON, SPOE_FRM_T_AGENT_DISCON))
+		rc = spoe_decode_kv(&frame, &ptr, end,
+		                    SPOE_DEC_VARINT, STR_ADDRSIZE("status-code"), cb_sb_dec_varint,
+		                    SPOE_DEC_STR, STR_ADDRSIZE("message"), cb_sb_dec_str,
+		                    SPOE_DEC_END);
+	else if (stype == SPOE_FRM_T_HAPROXY_NOTIFY)
+		rc = sb_decode_notify(&frame, ptr, end);
+	else if (stype == SPOE_FRM_T_AGENT_HELLO)
+		rc = spoe_decode_kv(&frame, &ptr, end,
+		                    SPOE_DEC_STR, STR_ADDRSIZE("version"), cb_sb_dec_str,
+		                    SPOE_DEC_VARINT, STR_ADDRSIZE("max-frame-size"), cb_sb_dec_varint,
+		                    SPOE_DEC_STR, STR_ADDRSIZE("capabilities"), cb_sb_dec_str,
+		                    SPOE_DEC_END);
+
+	return rc;
+}
+
+
+/***
+ * NAME
+ *   sb_decode_varint -
+ *
+ * ARGUMENTS
+ *   bc -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_decode_varint(const struct sb_case *bc)
+{
+	struct spoe_frame  frame;
+	const char        *ptr = (const char *)bc->data, *end = ptr + bc->len;
+	uint64_t           value;
+	int                rc = FUNC_RET_OK;
+
+	sb_frame_init(&frame, bc);
+
+	while (_nERROR(rc) && (ptr < end)) {
+		rc = spoe_decode(&frame, &ptr, end, SPOE_DEC_VARINT0, &value, SPOE_DEC_END);
+
+		_prg.sink += value;
+	}
+
+	return rc;
+}
+
+
+/***
+ * NAME
+ *   sb_encode_varint -
+ *
+ * ARGUMENTS
+ *   bc -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_encode_varint(const struct sb_case *bc __maybe_unused)
+{
+	char *buf = _prg.enc->buf;
+	int   i, rc = FUNC_RET_OK;
+
+	for (i = 0; _nERROR(rc) && (i < SB_VARINT_CNT); i++)
+		rc = spoe_encode(_prg.enc, &buf, SPOE_ENC_VARINT, (uint)_prg.varints[i], SPOE_ENC_END);
+
+	_prg.sink += _prg.enc->len;
+
+	return rc;
+}
+
+
+/***
+ * NAME
+ *   sb_encode_ack -
+ *
+ * ARGUMENTS
+ *   bc -
+ *
+ * DESCRIPTION
+ *   Encodes the ACK frame the same way as prepare_agentack() does it.  The
+ *   stream-id and the frame-id are taken from the varint data set.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_encode_ack(const struct sb_case *bc __maybe_unused)
+{
+	static uint i = 0;
+	int         rc;
+
+	i = (i + 1) % (SB_VARINT_CNT - 1);
+
+	SPOE_FRAME_BUFFER_SET(_prg.enc, _prg.enc->data + SPOA_FRM_LEN, 0, 0, 0);
+
+	rc = spoe_encode_frame("ACK", _prg.enc,
+	                       SPOA_FRM_T_AGENT, SPOE_FRM_T_AGENT_ACK, SPOE_FRM_FL_FIN,
+	                       SPOE_ENC_VARINT, (uint)_prg.varints[i],
+	                       SPOE_ENC_VARINT, (uint)_prg.varints[i + 1],
+	                       SPOE_ENC_END);
+
+	_prg.sink += rc;
+
+	return rc;
+}
+
+
+/***
+ * NAME
+ *   sb_case_add -
+ *
+ * ARGUMENTS
+ *   bench -
+ *   name  -
+ *   data  -
+ *   len   -
+ *   fn    -
+ *   ops   -
+ *
+ * DESCRIPTION
+ *   Adds a benchmark case.  The data is owned by the case from now on,
+ *   even if the case is filtered out or cannot be added.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_case_add(const char *bench, const char *name, uint8_t *data, size_t len, sb_fn_t fn, int ops)
+{
+	struct sb_case *bc;
+
+	if (_nNULL(_prg.filter) && _NULL(strstr(bench, _prg.filter)) && _NULL(strstr(name, _prg.filter))) {
+		PTR_FREE(data);
+
+		return FUNC_RET_OK;
+	}
+	else if (_prg.nbcases >= SB_MAX_CASES) {
+		(void)fprintf(stderr, "ERROR: too many benchmark cases, at most %d are allowed\n", SB_MAX_CASES);
+		PTR_FREE(data);
+
+		return FUNC_RET_ERROR;
+	}
+
+	bc        = _prg.cases + _prg.nbcases;
+	bc->bench = bench;
+	bc->data  = data;
+	bc->len   = len;
+	bc->fn    = fn;
+	bc->ops   = ops;
+
+	if (_NULL(bc->name = strdup(name))) {
+		PTR_FREE(data);
+
+		return FUNC_RET_ERROR;
+	}
+
+	_prg.nbcases++;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   sb_hex_decode -
+ *
+ * ARGUMENTS
+ *   hex  -
+ *   len  -
+ *   data -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   Returns the number of decoded bytes, or FUNC_RET_ERROR (-1) if <hex>
+ *   is not a valid hexadecimal string.
+ */
+static ssize_t sb_hex_decode(const char *hex, size_t len, uint8_t **data)
+{
+	static const char digits[] = "0123456789abcdef";
+	const char       *hi, *lo;
+	size_t            i;
+
+	if ((len == 0) || (len & 1) || _NULL(*data = malloc(len / 2)))
+		return FUNC_RET_ERROR;
+
+	for (i = 0; i < len; i += 2) {
+		hi = strchr(digits, tolower((unsigned char)hex[i]));
+		lo = strchr(digits, tolower((unsigned char)hex[i + 1]));
+		if (_NULL(hi) || _NULL(lo) || (hex[i] == '\0') || (hex[i + 1] == '\0')) {
+			PTR_FREE(*data);
+
+			return FUNC_RET_ERROR;
+		}
+
+		(*data)[i / 2] = ((hi - digits) << 4) | (lo - digits);
+	}
+
+	return len / 2;
+}
+
+
+/***
+ * NAME
+ *   sb_corpus_load -
+ *
+ * ARGUMENTS
+ *   path -
+ *
+ * DESCRIPTION
+ *   Loads the test frames from the file, which is shared with the test.sh
+ *   script.  Each line holds the frame name and the frame data written in
+ *   hexadecimal form.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_corpus_load(const char *path)
+{
+	FILE    *fp;
+	char    *line = NULL, *name, *hex, *save;
+	size_t   size = 0;
+	uint8_t *data;
+	ssize_t  len;
+	int      n = 0, retval = FUNC_RET_OK;
+
+	if (_NULL(fp = fopen(path, "r"))) {
+		(void)fprintf(stderr, "ERROR: failed to open '%s': %s\n", path, strerror(errno));
+
+		return FUNC_RET_ERROR;
+	}
+
+	while (_OK(retval) && (getline(&line, &size, fp) != -1)) {
+		n++;
+
+		if (_NULL(name = strtok_r(line, " \t\r\n", &save)) || (*name == '#'))
+			continue;
+
+		if (_NULL(hex = strtok_r(NULL, " \t\r\n", &save)) || _ERROR(len = sb_hex_decode(hex, strlen(hex), &data))) {
+			(void)fprintf(stderr, "ERROR: %s:%d: invalid frame '%s'\n", path, n, name);
+
+			retval = FUNC_RET_ERROR;
+		}
+		else {
+			retval = sb_case_add("decode", name, data, len, sb_decode_frame, 1);
+		}
+	}
+
+	PTR_FREE(line);
+	(void)fclose(fp);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sb_gen_notify -
+ *
+ * ARGUMENTS
+ *   name      -
+ *   nbhdrs    -
+ *   body_size -
+ *
+ * DESCRIPTION
+ *   Encodes a NOTIFY frame with the 'mirror' message, which carries the
+ *   request with <nbhdrs> HTTP headers and a body of <body_size> bytes.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_gen_notify(const char *name, int nbhdrs, size_t body_size)
+{
+	const char        *method = (body_size > 0) ? "POST" : "GET";
+	struct spoe_frame *hdrs = NULL, *frame = NULL;
+	char               hname[32], hvalue[64], *body = NULL, *buf;
+	uint8_t           *data;
+	size_t             i;
+	int                rc = FUNC_RET_OK, retval = FUNC_RET_ERROR;
+
+	if (_NULL(hdrs = sb_frame_alloc(SB_ENC_SIZE + nbhdrs * (sizeof(hname) + sizeof(hvalue))))) {
+		/* Do nothing. */
+	}
+	else if (_NULL(frame = sb_frame_alloc(SB_ENC_SIZE + hdrs->size + body_size))) {
+		/* Do nothing. */
+	}
+	else if (_NULL(body = malloc(body_size + 1))) {
+		/* Do nothing. */
+	}
+	else {
+		for (i = 0; i < body_size; i++)
+			body[i] = 'a' + (i % 26);
+
+		/* The headers in the req.hdrs_bin format, ended with an empty name and value. */
+		buf = hdrs->buf;
+		for (i = 0; _nERROR(rc) && (i < (size_t)nbhdrs); i++) {
+			(void)snprintf(hname, sizeof(hname), "x-bench-header-%zu", i);
+			(void)snprintf(hvalue, sizeof(hvalue), "value-%zu-abcdefghijklmnopqrstuvwxyz", i);
+
+			rc = spoe_encode(hdrs, &buf,
+			                 SPOE_ENC_STR, hname, (uint)strlen(hname),
+			                 SPOE_ENC_STR, hvalue, (uint)strlen(hvalue),
+			                 SPOE_ENC_END);
+		}
+		if (_nERROR(rc))
+			rc = spoe_encode(hdrs, &buf, SPOE_ENC_UINT8, 0, SPOE_ENC_UINT8, 0, SPOE_ENC_END);
+
+		if (_nERROR(rc))
+			rc = spoe_encode_frame("NOTIFY", frame, SPOA_FRM_T_HAPROXY, SPOE_FRM_T_HAPROXY_NOTIFY, SPOE_FRM_FL_FIN,
+			                       SPOE_ENC_VARINT, 1, SPOE_ENC_VARINT, 1,
+			                       SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_MIRROR), SPOE_ENC_UINT8, 5,
+			                       SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_METHOD), SPOE_ENC_UINT8, SPOE_DATA_T_STR, SPOE_ENC_STR, method, (uint)strlen(method),
+			                       SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_PATH), SPOE_ENC_UINT8, SPOE_DATA_T_STR, SPOE_ENC_STR, STR_ADDRSIZE("/index.html"),
+			                       SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_VER), SPOE_ENC_UINT8, SPOE_DATA_T_STR, SPOE_ENC_STR, STR_ADDRSIZE("1.1"),
+			                       SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_HDRS), SPOE_ENC_UINT8, SPOE_DATA_T_BIN, SPOE_ENC_STR, hdrs->buf, (uint)hdrs->len,
+			                       SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_BODY), SPOE_ENC_UINT8, SPOE_DATA_T_BIN, SPOE_ENC_STR, body, (uint)body_size,
+			                       SPOE_ENC_END);
+
+		if (_ERROR(rc))
+			(void)fprintf(stderr, "ERROR: failed to encode the '%s' frame\n", name);
+		else if (_nNULL(data = malloc(frame->len))) {
+			(void)memcpy(data, frame->buf, frame->len);
+
+			retval = sb_case_add("decode", name, data, frame->len, sb_decode_frame, 1);
+		}
+	}
+
+	PTR_FREE(body);
+	PTR_FREE(frame);
+	PTR_FREE(hdrs);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   sb_gen_varint -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Generates the varint data set, in which the encoded lengths of 1 to 5
+ *   bytes are evenly represented, and adds the varint and the ACK frame
+ *   benchmark cases.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_gen_varint(void)
+{
+	static const uint64_t limits[] = { 240, 2288, 264432, 33818864, UINT32_MAX };
+	uint64_t              seed = 1, min = 0;
+	uint8_t              *data;
+	char                 *buf;
+	int                   i, rc = FUNC_RET_OK;
+
+	for (i = 0; i < SB_VARINT_CNT; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		min  = ((i % TABLESIZE(limits)) == 0) ? 0 : limits[(i % TABLESIZE(limits)) - 1];
+
+		_prg.varints[i] = min + (seed >> 33) % (limits[i % TABLESIZE(limits)] - min);
+	}
+
+	buf = _prg.enc->buf;
+	for (i = 0; _nERROR(rc) && (i < SB_VARINT_CNT); i++)
+		rc = spoe_encode(_prg.enc, &buf, SPOE_ENC_VARINT, (uint)_prg.varints[i], SPOE_ENC_END);
+
+	if (_ERROR(rc) || _NULL(data = malloc(_prg.enc->len)))
+		return FUNC_RET_ERROR;
+
+	(void)memcpy(data, _prg.enc->buf, _prg.enc->len);
+
+	if (_ERROR(sb_case_add("decode-varint", "mixed-1-5-bytes", data, _prg.enc->len, sb_decode_varint, SB_VARINT_CNT)))
+		return FUNC_RET_ERROR;
+	else if (_ERROR(sb_case_add("encode-varint", "mixed-1-5-bytes", NULL, 0, sb_encode_varint, SB_VARINT_CNT)))
+		return FUNC_RET_ERROR;
+
+	return sb_case_add("encode", "agent-ack", NULL, 0, sb_encode_ack, 1);
+}
+
+
+/***
+ * NAME
+ *   sb_cmp_double -
+ *
+ * ARGUMENTS
+ *   a -
+ *   b -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_cmp_double(const void *a, const void *b)
+{
+	const double *x = a, *y = b;
+
+	return (*x > *y) - (*x < *y);
+}
+
+
+/***
+ * NAME
+ *   sb_run -
+ *
+ * ARGUMENTS
+ *   bc     -
+ *   result -
+ *
+ * DESCRIPTION
+ *   The number of iterations is first doubled until one run takes at least
+ *   the specified time, then the case is measured the specified number of
+ *   times.  The allocations are counted in all measured runs.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int sb_run(const struct sb_case *bc, struct sb_result *result)
+{
+	double   t[SB_MAX_RUNS], start, elapsed;
+	uint64_t n, iter = 1;
+	int      i;
+
+	/* Checks that the case works before it is measured. */
+	if (_ERROR(bc->fn(bc))) {
+		(void)fprintf(stderr, "ERROR: %s %s: the operation failed\n", bc->bench, bc->name);
+
+		return FUNC_RET_ERROR;
+	}
+
+	do {
+		iter *= 2;
+
+		start = sb_time();
+		for (n = 0; n < iter; n++)
+			(void)bc->fn(bc);
+		elapsed = sb_time() - start;
+	} while (elapsed < _prg.time);
+
+	_prg.allocs     = 0;
+	_prg.flag_count = 1;
+
+	for (i = 0; i < _prg.runs; i++) {
+		start = sb_time();
+		for (n = 0; n < iter; n++)
+			(void)bc->fn(bc);
+		t[i] = (sb_time() - start) * 1e9 / ((double)iter * bc->ops);
+	}
+
+	_prg.flag_count = 0;
+
+	qsort(t, _prg.runs, sizeof(*t), sb_cmp_double);
+
+	result->ns_min     = t[0];
+	result->ns_median  = t[_prg.runs / 2];
+	result->allocs     = (double)_prg.allocs / ((double)iter * bc->ops * _prg.runs);
+	result->iterations = iter;
+
+	return FUNC_RET_OK;
+}
+
+
+int main(int argc, char **argv)
+{
+	static const struct option longopts[] = {
+		{ "corpus",  required_argument, NULL, 'c' },
+		{ "filter",  required_argument, NULL, 'f' },
+		{ "help",    no_argument,       NULL, 'h' },
+		{ "runs",    required_argument, NULL, 'r' },
+		{ "time",    required_argument, NULL, 't' },
+		{ "version", no_argument,       NULL, 'V' },
+		{ NULL,      0,                 NULL, 0   }
+	};
+	struct sb_result result;
+	bool_t           flag_error = 0;
+	int              c, i, retval = EX_OK;
+
+	_prg.name = basename(argv[0]);
+
+	while ((c = getopt_long(argc, argv, ":c:f:hr:t:V", longopts, NULL)) != EOF) {
+		if (c == 'c')
+			_prg.corpus = optarg;
+		else if (c == 'f')
+			_prg.filter = optarg;
+		else if (c == 'h')
+			_prg.opt_flags |= FLAG_OPT_HELP;
+		else if (c == 'r')
+			_prg.runs = atoi(optarg);
+		else if (c == 't')
+			flag_error |= _OK(getopt_set_double("time", optarg, &(_prg.time), 0.001, 60)) ? 0 : 1;
+		else if (c == 'V')
+			_prg.opt_flags |= FLAG_OPT_VERSION;
+		else
+			flag_error = 1;
+	}
+
+	if (_prg.opt_flags & FLAG_OPT_HELP) {
+		usage(_prg.name, 1);
+	}
+	else if (_prg.opt_flags & FLAG_OPT_VERSION) {
+		(void)printf("\n%s v%s [build %d] by %s, %s\n\n", _prg.name, PACKAGE_VERSION, PACKAGE_BUILD, PACKAGE_AUTHOR, __DATE__);
+	}
+	else if (flag_error) {
+		usage(_prg.name, 0);
+	}
+	else if (!IN_RANGE(_prg.runs, 1, SB_MAX_RUNS)) {
+		(void)fprintf(stderr, "ERROR: invalid number of runs: %d\n", _prg.runs);
+
+		flag_error = 1;
+	}
+
+	if (flag_error || (_prg.opt_flags & (FLAG_OPT_HELP | FLAG_OPT_VERSION)))
+		return flag_error ? EX_USAGE : EX_OK;
+
+	if (_NULL(_prg.enc = sb_frame_alloc(SB_ENC_SIZE + SB_VARINT_CNT * 5))) {
+		retval = EX_OSERR;
+	}
+	else if (_ERROR(sb_corpus_load(_prg.corpus))) {
+		retval = EX_DATAERR;
+	}
+	else if (_ERROR(sb_gen_notify("gen-notify-mirror-64-hdrs", SB_GEN_HDRS, 0))) {
+		retval = EX_SOFTWARE;
+	}
+	else if (_ERROR(sb_gen_notify("gen-notify-mirror-64k-body", 3, SB_GEN_BODY))) {
+		retval = EX_SOFTWARE;
+	}
+	else if (_ERROR(sb_gen_varint())) {
+		retval = EX_SOFTWARE;
+	}
+	else {
+		(void)printf("%-14s %-30s %7s %12s %12s %10s %12s\n", "benchmark", "case", "bytes", "ns/op min", "ns/op median", "allocs/op", "iterations");
+
+		for (i = 0; (retval == EX_OK) && (i < _prg.nbcases); i++) {
+			if (_ERROR(sb_run(_prg.cases + i, &result)))
+				retval = EX_SOFTWARE;
+			else
+				(void)printf("%-14s %-30s %7zu %12.1f %12.1f %10.2f %12"PRIu64"\n",
+				             _prg.cases[i].bench, _prg.cases[i].name, _prg.cases[i].len,
+				             result.ns_min, result.ns_median, result.allocs, result.iterations);
+
+			(void)fflush(stdout);
+		}
+	}
+
+	for (i = 0; i < _prg.nbcases; i++) {
+		PTR_FREE(_prg.cases[i].name);
+		PTR_FREE(_prg.cases[i].data);
+	}
+	PTR_FREE(_prg.enc);
+
+	return retval;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
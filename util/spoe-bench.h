@@ -0,0 +1,81 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _SPOE_BENCH_H
+#define _SPOE_BENCH_H
+
+#define SB_DEFAULT_CORPUS      "test-frames.txt"
+#define SB_DEFAULT_RUNS        5
+#define SB_DEFAULT_TIME        0.2     /* Minimum duration of one run in seconds. */
+#define SB_MAX_RUNS            101
+#define SB_MAX_CASES           64
+#define SB_ENC_SIZE            1024    /* Size of the frame encoding buffer beyond the body. */
+#define SB_VARINT_CNT          1024    /* Number of values in the varint benchmarks. */
+#define SB_GEN_HDRS            64      /* Headers of the generated many-headers frame. */
+#define SB_GEN_BODY            65536   /* Body size of the generated large-body frame. */
+
+struct sb_case;
+typedef int (*sb_fn_t)(const struct sb_case *bc);
+
+struct sb_case {
+	const char *bench;             /* Benchmark name. */
+	char       *name;              /* Frame or data set name. */
+	uint8_t    *data;
+	size_t      len;
+	sb_fn_t     fn;                /* Performs one operation on the case data. */
+	int         ops;               /* Number of reported units in one operation. */
+};
+
+struct sb_result {
+	double      ns_min;            /* Nanoseconds per unit, the fastest run. */
+	double      ns_median;         /* Nanoseconds per unit, the median run. */
+	double      allocs;            /* Allocations per unit. */
+	uint64_t    iterations;        /* Operations in one run. */
+};
+
+struct _prg_data {
+	const char         *name;
+	uint8_t             opt_flags;
+
+	const char         *corpus;
+	const char         *filter;
+	int                 runs;
+	double              time;
+
+	struct client       client;          /* Receives the decoder status codes. */
+	struct sb_case      cases[SB_MAX_CASES];
+	int                 nbcases;
+	uint64_t            varints[SB_VARINT_CNT];
+	struct spoe_frame  *enc;             /* Frame of the encoder benchmarks. */
+
+	bool_t              flag_count;      /* Count the allocations. */
+	uint64_t            allocs;
+	volatile uint64_t   sink;            /* Keeps the results of the benchmarked code alive. */
+};
+
+#endif /* _SPOE_BENCH_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -0,0 +1,1507 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include "include.h"
+#include "spop-bench.h"
+#include "util.h"
+
+
+struct config_data cfg;
+struct program_data prg;
+struct _prg_data    _prg = {
+	.address        = BENCH_DEFAULT_ADDRESS,
+	.port           = DEFAULT_SERVER_PORT,
+	.connections    = BENCH_DEFAULT_CONNECTIONS,
+	.window         = BENCH_DEFAULT_WINDOW,
+	.duration       = BENCH_DEFAULT_DURATION,
+	.max_frame_size = DEFAULT_MAX_FRAME_SIZE,
+	.host           = BENCH_DEFAULT_HOST,
+	.path           = BENCH_DEFAULT_PATH,
+};
+
+#ifdef DEBUG
+__THR const void *dbg_w_ptr  = NULL;
+__THR int         dbg_indent = 0;
+#endif
+
+
+/***
+ * NAME
+ *   usage -
+ *
+ * ARGUMENTS
+ *   program_name -
+ *   flag_verbose -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void usage(const char *program_name, bool_t flag_verbose)
+{
+	(void)printf("\nUsage: %s { -h --help }\n", program_name);
+	(void)printf("       %s { -V --version }\n", program_name);
+	(void)printf("       %s [OPTION]...\n\n", program_name);
+
+	if (flag_verbose) {
+		(void)printf("Options are:\n");
+		(void)printf("  -a, --address=NAME          Specify the agent address (default: \"%s\").\n", BENCH_DEFAULT_ADDRESS);
+		(void)printf("  -b, --body-size=VALUE       Set the size of the mirrored request body (default: 0).\n");
+		(void)printf("  -c, --capability=NAME       Request the specified capability from the agent.\n");
+		(void)printf("  -d, --duration=TIME         Run the benchmark for the specified seconds (default: %g).\n", BENCH_DEFAULT_DURATION);
+		(void)printf("  -f, --frames=VALUE          Stop after sending the specified number of frames.\n");
+		(void)printf("  -H, --host=NAME             Set the Host header of the mirrored request (default: \"%s\").\n", BENCH_DEFAULT_HOST);
+		(void)printf("  -h, --help                  Show this text.\n");
+		(void)printf("  -m, --max-frame-size=VALUE  Specify the maximum frame size (default: %d bytes).\n", DEFAULT_MAX_FRAME_SIZE);
+		(void)printf("  -n, --connections=VALUE     Specify the number of SPOP connections (default: %d).\n", BENCH_DEFAULT_CONNECTIONS);
+		(void)printf("  -p, --port=VALUE            Specify the agent port (default: %d).\n", DEFAULT_SERVER_PORT);
+		(void)printf("  -r, --rate=VALUE            Send the specified number of frames per second (default: 0).\n");
+		(void)printf("  -u, --path=PATH             Set the path of the mirrored request (default: \"%s\").\n", BENCH_DEFAULT_PATH);
+		(void)printf("  -V, --version               Show program version.\n");
+		(void)printf("  -w, --window=VALUE          Set the number of frames in flight per connection (default: %d).\n\n", BENCH_DEFAULT_WINDOW);
+		(void)printf("Supported capabilities: pipelining, async, fragmentation.\n\n");
+		(void)printf("Without a rate the benchmark runs in the closed-loop mode: every connection\n");
+		(void)printf("keeps its window full.  With a rate, the frames are released on schedule and\n");
+		(void)printf("the ACK latency is measured from the scheduled time of the frame, so the time\n");
+		(void)printf("a frame waits for room in the window is part of its latency.\n\n");
+		(void)printf("Copyright 2026 HAProxy Technologies\n");
+		(void)printf("SPDX-License-Identifier: GPL-2.0-or-later\n\n");
+	} else {
+		(void)printf("For help type: %s -h\n\n", program_name);
+	}
+}
+
+
+/***
+ * NAME
+ *   getopt_set_capability -
+ *
+ * ARGUMENTS
+ *   name -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int getopt_set_capability(const char *name)
+{
+#define BENCH_CAP_DEF(a,b,c)   { b, BENCH_CAP_##a },
+	static const struct {
+		const char *str;
+		uint8_t     cap;
+	} caps[] = { BENCH_CAP_DEFINES };
+#undef BENCH_CAP_DEF
+	int i;
+
+	for (i = 0; i < TABLESIZE(caps); i++)
+		if (strcasecmp(caps[i].str, name) == 0)
+			break;
+
+	if (i >= TABLESIZE(caps)) {
+		(void)fprintf(stderr, "ERROR: unsupported capability '%s'\n", name);
+
+		return FUNC_RET_ERROR;
+	}
+
+	_prg.caps |= caps[i].cap;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   bench_frame_alloc -
+ *
+ * ARGUMENTS
+ *   size -
+ *
+ * DESCRIPTION
+ *   Allocates a frame that can be used by the SPOE encoder.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static struct spoe_frame *bench_frame_alloc(size_t size)
+{
+	struct spoe_frame *frame;
+
+	if (_NULL(frame = calloc(1, sizeof(*frame) + SPOA_FRM_LEN + size)))
+		return NULL;
+
+	SPOE_FRAME_BUFFER_SET(frame, frame->data + SPOA_FRM_LEN, 0, 0, 0);
+	LIST_INIT(&(frame->list));
+	frame->client = &(_prg.client);
+	frame->size   = size;
+
+	return frame;
+}
+
+
+/***
+ * NAME
+ *   bench_msg_init -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Encodes the 'mirror' message sent in every NOTIFY frame, with the same
+ *   arguments as used in the test/spoe.cfg configuration.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_msg_init(void)
+{
+	const char        *method = (_prg.body_size > 0) ? "POST" : "GET";
+	struct spoe_frame *hdrs = NULL, *msg = NULL;
+	char               clen[24], *body = NULL, *buf;
+	size_t             i;
+	int                rc, retval = FUNC_RET_ERROR;
+
+	(void)snprintf(clen, sizeof(clen), "%zu", _prg.body_size);
+
+	if (_NULL(hdrs = bench_frame_alloc(BENCH_ENC_SIZE + strlen(_prg.host)))) {
+		/* Do nothing. */
+	}
+	else if (_NULL(msg = bench_frame_alloc(BENCH_ENC_SIZE + strlen(_prg.host) + strlen(_prg.path) + _prg.body_size))) {
+		/* Do nothing. */
+	}
+	else if (_NULL(body = malloc(_prg.body_size + 1))) {
+		/* Do nothing. */
+	}
+	else {
+		for (i = 0; i < _prg.body_size; i++)
+			body[i] = 'a' + (i % 26);
+
+		/* The headers in the req.hdrs_bin format, ended with an empty name and value. */
+		buf = hdrs->buf;
+		rc  = spoe_encode(hdrs, &buf,
+		                  SPOE_ENC_STR, STR_ADDRSIZE("host"), SPOE_ENC_STR, _prg.host, (uint)strlen(_prg.host),
+		                  SPOE_ENC_STR, STR_ADDRSIZE("user-agent"), SPOE_ENC_STR, STR_ADDRSIZE("spop-bench/" PACKAGE_VERSION),
+		                  SPOE_ENC_STR, STR_ADDRSIZE("accept"), SPOE_ENC_STR, STR_ADDRSIZE("*/*"),
+		                  SPOE_ENC_END);
+		if (_nERROR(rc) && (_prg.body_size > 0))
+			rc = spoe_encode(hdrs, &buf,
+			                 SPOE_ENC_STR, STR_ADDRSIZE("content-type"), SPOE_ENC_STR, STR_ADDRSIZE("application/octet-stream"),
+			                 SPOE_ENC_STR, STR_ADDRSIZE("content-length"), SPOE_ENC_STR, clen, (uint)strlen(clen),
+			                 SPOE_ENC_END);
+		if (_nERROR(rc))
+			rc = spoe_encode(hdrs, &buf, SPOE_ENC_UINT8, 0, SPOE_ENC_UINT8, 0, SPOE_ENC_END);
+
+		/* The message name, the number of arguments and the arguments. */
+		buf = msg->buf;
+		if (_nERROR(rc))
+			rc = spoe_encode(msg, &buf,
+			                 SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_MIRROR), SPOE_ENC_UINT8, 5,
+			                 SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_METHOD), SPOE_ENC_UINT8, SPOE_DATA_T_STR, SPOE_ENC_STR, method, (uint)strlen(method),
+			                 SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_PATH), SPOE_ENC_UINT8, SPOE_DATA_T_STR, SPOE_ENC_STR, _prg.path, (uint)strlen(_prg.path),
+			                 SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_VER), SPOE_ENC_UINT8, SPOE_DATA_T_STR, SPOE_ENC_STR, STR_ADDRSIZE("1.1"),
+			                 SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_HDRS), SPOE_ENC_UINT8, SPOE_DATA_T_BIN, SPOE_ENC_STR, hdrs->buf, (uint)hdrs->len,
+			                 SPOE_ENC_STR, STR_ADDRSIZE(SPOE_MSG_ARG_BODY), SPOE_ENC_UINT8, SPOE_DATA_T_BIN, SPOE_ENC_STR, body, (uint)_prg.body_size,
+			                 SPOE_ENC_END);
+
+		if (_ERROR(rc)) {
+			(void)fprintf(stderr, "ERROR: failed to encode the '%s' message\n", SPOE_MSG_MIRROR);
+		}
+		else if (_nNULL(_prg.msg = malloc(msg->len))) {
+			(void)memcpy(_prg.msg, msg->buf, msg->len);
+			_prg.msg_len = msg->len;
+
+			retval = FUNC_RET_OK;
+		}
+	}
+
+	PTR_FREE(body);
+	PTR_FREE(msg);
+	PTR_FREE(hdrs);
+
+	return retval;
+}
+
+
+/***
+ * NAME
+ *   bench_frame_append -
+ *
+ * ARGUMENTS
+ *   conn  -
+ *   type  -
+ *   flags -
+ *   sid   -
+ *   fid   -
+ *   data  -
+ *   len   -
+ *
+ * DESCRIPTION
+ *   Appends a frame made of the encoded frame header and the data to the
+ *   send buffer of the connection.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_frame_append(struct bench_conn *conn, uint8_t type, uint32_t flags, uint sid, uint fid, const void *data, size_t len)
+{
+	struct spoe_frame *frame = _prg.enc;
+	uint32_t           frame_len;
+	int                rc;
+
+	SPOE_FRAME_BUFFER_SET(frame, frame->data + SPOA_FRM_LEN, 0, 0, 0);
+
+	rc = spoe_encode_frame("NOTIFY", frame, SPOA_FRM_T_HAPROXY, type, flags,
+	                       SPOE_ENC_VARINT, sid,
+	                       SPOE_ENC_VARINT, fid,
+	                       SPOE_ENC_END);
+	if (_ERROR(rc))
+		return FUNC_RET_ERROR;
+
+	frame_len = htonl(frame->len + len);
+	(void)memcpy(frame->data, &frame_len, SPOA_FRM_LEN);
+
+	if (_ERROR(buffer_append(&(conn->wr_buf), frame->data, SPOA_FRM_LEN + frame->len)))
+		return FUNC_RET_ERROR;
+
+	return (len > 0) ? buffer_append(&(conn->wr_buf), data, len) : FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   bench_hello -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Appends the HAPROXY-HELLO frame to the send buffer of the connection.
+ *   Every connection uses its own engine-id, so that in the async mode the
+ *   agent sends the ACK frames back over the connection the NOTIFY frames
+ *   were received on.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_hello(struct bench_conn *conn)
+{
+#define BENCH_CAP_DEF(a,b,c)   { b, BENCH_CAP_##a },
+	static const struct {
+		const char *str;
+		uint8_t     cap;
+	} caps[] = { BENCH_CAP_DEFINES };
+#undef BENCH_CAP_DEF
+	struct spoe_frame *frame = _prg.enc;
+	char               capabilities[64] = "", engine_id[64];
+	uint32_t           frame_len;
+	int                i, rc;
+
+	for (i = 0; i < TABLESIZE(caps); i++)
+		if (_prg.caps & caps[i].cap)
+			(void)snprintf(capabilities + strlen(capabilities), sizeof(capabilities) - strlen(capabilities), "%s%s", (capabilities[0] == '\0') ? "" : ",", caps[i].str);
+
+	(void)snprintf(engine_id, sizeof(engine_id), "spop-bench-%d-%d", (int)getpid(), conn->id);
+
+	SPOE_FRAME_BUFFER_SET(frame, frame->data + SPOA_FRM_LEN, 0, 0, 0);
+
+	rc = spoe_encode_frame("HELLO", frame, SPOA_FRM_T_HAPROXY, SPOE_FRM_T_HAPROXY_HELLO, SPOE_FRM_FL_FIN,
+	                       SPOE_ENC_VARINT, 0,
+	                       SPOE_ENC_VARINT, 0,
+	                       SPOE_ENC_KV, STR_ADDRSIZE("supported-versions"), SPOE_DATA_T_STR, STR_ADDRSIZE(SPOP_VERSION),
+	                       SPOE_ENC_KV, STR_ADDRSIZE("max-frame-size"), SPOE_DATA_T_UINT32, _prg.max_frame_size,
+	                       SPOE_ENC_KV, STR_ADDRSIZE("capabilities"), SPOE_DATA_T_STR, capabilities, (uint)strlen(capabilities),
+	                       SPOE_ENC_KV, STR_ADDRSIZE("engine-id"), SPOE_DATA_T_STR, engine_id, (uint)strlen(engine_id),
+	                       SPOE_ENC_END);
+	if (_ERROR(rc))
+		return FUNC_RET_ERROR;
+
+	frame_len = htonl(frame->len);
+	(void)memcpy(frame->data, &frame_len, SPOA_FRM_LEN);
+
+	return buffer_append(&(conn->wr_buf), frame->data, SPOA_FRM_LEN + frame->len);
+}
+
+
+/***
+ * NAME
+ *   bench_disconnect -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Appends the HAPROXY-DISCONNECT frame to the send buffer of the connection.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_disconnect(struct bench_conn *conn)
+{
+	struct spoe_frame *frame = _prg.enc;
+	uint32_t           frame_len;
+	int                rc;
+
+	SPOE_FRAME_BUFFER_SET(frame, frame->data + SPOA_FRM_LEN, 0, 0, 0);
+
+	rc = spoe_encode_frame("DISCONNECT", frame, SPOA_FRM_T_HAPROXY, SPOE_FRM_T_HAPROXY_DISCON, SPOE_FRM_FL_FIN,
+	                       SPOE_ENC_VARINT, 0,
+	                       SPOE_ENC_VARINT, 0,
+	                       SPOE_ENC_KV, STR_ADDRSIZE("status-code"), SPOE_DATA_T_UINT32, SPOE_FRM_ERR_NONE,
+	                       SPOE_ENC_KV, STR_ADDRSIZE("message"), SPOE_DATA_T_STR, STR_ADDRSIZE("normal"),
+	                       SPOE_ENC_END);
+	if (_ERROR(rc))
+		return FUNC_RET_ERROR;
+
+	frame_len = htonl(frame->len);
+	(void)memcpy(frame->data, &frame_len, SPOA_FRM_LEN);
+
+	return buffer_append(&(conn->wr_buf), frame->data, SPOA_FRM_LEN + frame->len);
+}
+
+
+/***
+ * NAME
+ *   bench_conn_close -
+ *
+ * ARGUMENTS
+ *   conn   -
+ *   reason -
+ *
+ * DESCRIPTION
+ *   Closes the connection.  If a reason is given, the connection failed and
+ *   its frames in flight are counted as lost.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_conn_close(struct bench_conn *conn, const char *reason)
+{
+	if (conn->state == BENCH_ST_CLOSED)
+		return;
+
+	if (_nNULL(reason)) {
+		(void)fprintf(stderr, "ERROR: connection %d: %s\n", conn->id, reason);
+
+		_prg.lost += conn->inflight;
+		_prg.errors++;
+	}
+
+	if (conn->state == BENCH_ST_READY)
+		_prg.nbready--;
+
+	_prg.nbclosed++;
+
+	ev_io_stop(_prg.ev_base, &(conn->ev_rd));
+	ev_io_stop(_prg.ev_base, &(conn->ev_wr));
+	(void)close(conn->fd);
+
+	conn->state    = BENCH_ST_CLOSED;
+	conn->fd       = -1;
+	conn->inflight = 0;
+
+	if (_prg.nbclosed == _prg.connections)
+		ev_break(_prg.ev_base, EVBREAK_ONE);
+}
+
+
+/***
+ * NAME
+ *   bench_conn_flush -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Sends as much of the send buffer as the socket accepts.  The write event
+ *   is only used while a part of the buffer could not be sent.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_conn_flush(struct bench_conn *conn)
+{
+	ssize_t n;
+
+	while (conn->wr_head < conn->wr_buf.len) {
+		n = send(conn->fd, conn->wr_buf.ptr + conn->wr_head, conn->wr_buf.len - conn->wr_head, MSG_NOSIGNAL);
+		if (n > 0) {
+			conn->wr_head += n;
+		}
+		else if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+			ev_io_start(_prg.ev_base, &(conn->ev_wr));
+
+			return;
+		}
+		else if ((n < 0) && (errno == EINTR)) {
+			/* Do nothing. */;
+		}
+		else {
+			bench_conn_close(conn, strerror(errno));
+
+			return;
+		}
+	}
+
+	conn->wr_head    = 0;
+	conn->wr_buf.len = 0;
+	ev_io_stop(_prg.ev_base, &(conn->ev_wr));
+}
+
+
+/***
+ * NAME
+ *   bench_notify -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Appends a NOTIFY frame with the 'mirror' message to the send buffer of
+ *   the connection, fragmented if it does not fit in the maximum frame size.
+ *   The frame-id identifies the slot holding the send time of the frame.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_notify(struct bench_conn *conn)
+{
+	size_t   chunk = conn->max_frame_size - BENCH_HDR_SIZE, offset = 0, len;
+	uint     slot, sid;
+	uint32_t flags;
+	uint8_t  type = SPOE_FRM_T_HAPROXY_NOTIFY;
+
+	slot = conn->slots_free[--conn->nbfree];
+	sid  = ++conn->stream_id;
+
+	/*
+	 * In the open-loop mode the latency is measured from the scheduled time.
+	 * The cached event loop time is not used, it can be late by the time
+	 * spent in the callbacks of the current loop iteration.
+	 */
+	if (_prg.rate > 0)
+		conn->slots_time[slot] = _prg.start_time + _prg.sent / _prg.rate;
+	else
+		conn->slots_time[slot] = ev_time();
+
+	do {
+		len   = MIN(chunk, _prg.msg_len - offset);
+		flags = ((offset + len) == _prg.msg_len) ? SPOE_FRM_FL_FIN : 0;
+
+		if (_ERROR(bench_frame_append(conn, type, flags, sid, slot + 1, _prg.msg + offset, len)))
+			return FUNC_RET_ERROR;
+
+		offset += len;
+		type    = SPOE_FRM_T_UNSET;
+	} while (offset < _prg.msg_len);
+
+	conn->inflight++;
+	_prg.sent++;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   bench_conn_fill -
+ *
+ * ARGUMENTS
+ *   conn -
+ *
+ * DESCRIPTION
+ *   Sends NOTIFY frames over the connection while there is room in its
+ *   window and, in the open-loop mode, released frames wait to be sent.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_conn_fill(struct bench_conn *conn)
+{
+	if (conn->state != BENCH_ST_READY)
+		return;
+
+	while (!_prg.flag_stop && (conn->inflight < conn->window)) {
+		if ((_prg.frames > 0) && (_prg.sent >= _prg.frames))
+			break;
+		else if ((_prg.rate > 0) && (_prg.sent >= _prg.released))
+			break;
+		else if (_ERROR(bench_notify(conn))) {
+			bench_conn_close(conn, "failed to encode NOTIFY frame");
+
+			return;
+		}
+	}
+
+	bench_conn_flush(conn);
+}
+
+
+/***
+ * NAME
+ *   bench_check_done -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Disconnects from the agent once no more frames are to be sent and all
+ *   the frames in flight are acknowledged.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_check_done(void)
+{
+	int i;
+
+	if (!_prg.flag_stop && (_prg.frames > 0) && (_prg.sent >= _prg.frames))
+		_prg.flag_stop = 1;
+
+	if (_prg.flag_disconnect || !_prg.flag_stop || ((_prg.sent - _prg.acked - _prg.lost) > 0))
+		return;
+
+	_prg.flag_disconnect = 1;
+
+	ev_timer_stop(_prg.ev_base, &(_prg.ev_rate));
+	ev_timer_stop(_prg.ev_base, &(_prg.ev_stop));
+	ev_timer_set(&(_prg.ev_stop), BENCH_DRAIN_TIMEOUT, 0.0);
+	ev_timer_start(_prg.ev_base, &(_prg.ev_stop));
+
+	for (i = 0; i < _prg.connections; i++) {
+		struct bench_conn *conn = _prg.conns + i;
+
+		if (conn->state != BENCH_ST_READY) {
+			bench_conn_close(conn, NULL);
+		}
+		else if (_ERROR(bench_disconnect(conn))) {
+			bench_conn_close(conn, "failed to encode DISCONNECT frame");
+		}
+		else {
+			conn->state = BENCH_ST_DISCONNECTING;
+			_prg.nbready--;
+
+			bench_conn_flush(conn);
+		}
+	}
+}
+
+
+/***
+ * NAME
+ *   bench_release -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Hands the frames to be sent to the connections, starting with the one
+ *   after the connection that got the previous frames.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_release(void)
+{
+	int i;
+
+	for (i = 0; i < _prg.connections; i++) {
+		bench_conn_fill(_prg.conns + _prg.rr);
+
+		_prg.rr = (_prg.rr + 1) % _prg.connections;
+	}
+}
+
+
+/***
+ * NAME
+ *   bench_lat_add -
+ *
+ * ARGUMENTS
+ *   lat -
+ *
+ * DESCRIPTION
+ *   Records the ACK latency given in seconds.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_lat_add(double lat)
+{
+	if (_prg.lat_cnt >= _prg.lat_size) {
+		size_t    size = MAX(_prg.lat_size * 2, 65536);
+		uint32_t *ptr;
+
+		if (_NULL(ptr = realloc(_prg.lat, size * sizeof(*ptr))))
+			return;
+
+		_prg.lat      = ptr;
+		_prg.lat_size = size;
+	}
+
+	lat *= 1e6;
+	_prg.lat[_prg.lat_cnt++] = (lat <= 0) ? 0 : ((lat >= UINT32_MAX) ? UINT32_MAX : (uint32_t)lat);
+}
+
+
+/***
+ * NAME
+ *   cb_agent_max_frame_size -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   arg1  -
+ *   arg2  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int cb_agent_max_frame_size(struct spoe_frame *frame __maybe_unused, void *arg1, void *arg2 __maybe_unused)
+{
+	uint64_t value = *(uint64_t *)arg1;
+
+	_prg.dec_conn->max_frame_size = MIN(value, _prg.max_frame_size);
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   cb_agent_capabilities -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   arg1  -
+ *   arg2  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int cb_agent_capabilities(struct spoe_frame *frame __maybe_unused, void *arg1, void *arg2)
+{
+#define BENCH_CAP_DEF(a,b,c)   { b, BENCH_CAP_##a },
+	static const struct {
+		const char *str;
+		uint8_t     cap;
+	} caps[] = { BENCH_CAP_DEFINES };
+#undef BENCH_CAP_DEF
+	const char *str = arg1, *end = str + *(uint64_t *)arg2, *ptr;
+	size_t      len;
+	int         i;
+
+	for ( ; str < end; str = ptr + 1) {
+		while ((str < end) && isspace(*str))
+			str++;
+
+		for (ptr = str; (ptr < end) && (*ptr != ','); ptr++);
+
+		for (len = ptr - str; (len > 0) && isspace(str[len - 1]); len--);
+
+		for (i = 0; i < TABLESIZE(caps); i++)
+			if ((len == strlen(caps[i].str)) && (strncasecmp(str, caps[i].str, len) == 0))
+				_prg.dec_conn->caps |= caps[i].cap;
+	}
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   cb_agent_status_code -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   arg1  -
+ *   arg2  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int cb_agent_status_code(struct spoe_frame *frame __maybe_unused, void *arg1, void *arg2 __maybe_unused)
+{
+	_prg.client.status_code = *(uint64_t *)arg1;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   cb_agent_message -
+ *
+ * ARGUMENTS
+ *   frame -
+ *   arg1  -
+ *   arg2  -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int cb_agent_message(struct spoe_frame *frame __maybe_unused, void *arg1, void *arg2)
+{
+	if (_prg.client.status_code != SPOE_FRM_ERR_NONE)
+		(void)fprintf(stderr, "ERROR: connection %d: agent disconnected: %.*s (%d)\n",
+		              _prg.dec_conn->id, (int)*(uint64_t *)arg2, (const char *)arg1, _prg.client.status_code);
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   bench_agent_hello -
+ *
+ * ARGUMENTS
+ *   conn -
+ *   ptr  -
+ *   end  -
+ *
+ * DESCRIPTION
+ *   Handles the AGENT-HELLO frame.  Without the pipelining or the async
+ *   capability only one frame can be in flight on the connection.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_agent_hello(struct bench_conn *conn, const char *ptr, const char *end)
+{
+	if (conn->state != BENCH_ST_HELLO) {
+		bench_conn_close(conn, "unexpected AGENT-HELLO frame");
+
+		return FUNC_RET_ERROR;
+	}
+
+	conn->max_frame_size = _prg.max_frame_size;
+
+	if (_ERROR(spoe_decode_kv(_prg.enc, &ptr, end,
+	                          SPOE_DEC_VARINT, STR_ADDRSIZE("max-frame-size"), cb_agent_max_frame_size,
+	                          SPOE_DEC_STR, STR_ADDRSIZE("capabilities"), cb_agent_capabilities,
+	                          SPOE_DEC_END))) {
+		bench_conn_close(conn, "failed to decode AGENT-HELLO frame");
+
+		return FUNC_RET_ERROR;
+	}
+
+	conn->window = (conn->caps & (BENCH_CAP_PIPELINING | BENCH_CAP_ASYNC)) ? _prg.window : 1;
+	if (conn->window < _prg.window)
+		(void)fprintf(stderr, "WARNING: connection %d: the agent supports neither pipelining nor async, window set to 1\n", conn->id);
+
+	if (((BENCH_HDR_SIZE + _prg.msg_len) > conn->max_frame_size) && !(conn->caps & BENCH_CAP_FRAGMENTATION)) {
+		bench_conn_close(conn, "the message does not fit in a frame and fragmentation is not supported");
+
+		return FUNC_RET_ERROR;
+	}
+	else if (conn->max_frame_size <= BENCH_HDR_SIZE) {
+		bench_conn_close(conn, "maximum frame size too small");
+
+		return FUNC_RET_ERROR;
+	}
+
+	conn->state = BENCH_ST_READY;
+	_prg.nbready++;
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   bench_agent_ack -
+ *
+ * ARGUMENTS
+ *   conn -
+ *   fid  -
+ *
+ * DESCRIPTION
+ *   Handles the ACK frame, the frame-id gives the slot of the acknowledged
+ *   frame.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_agent_ack(struct bench_conn *conn, uint64_t fid)
+{
+	double now = ev_time();
+	uint   slot;
+
+	if ((fid == 0) || (fid > _prg.window) || (conn->slots_time[fid - 1] < 0)) {
+		(void)fprintf(stderr, "ERROR: connection %d: unexpected ACK frame, frame-id %"PRIu64"\n", conn->id, fid);
+		_prg.errors++;
+
+		return;
+	}
+
+	slot = fid - 1;
+	bench_lat_add(now - conn->slots_time[slot]);
+
+	conn->slots_time[slot]            = -1;
+	conn->slots_free[conn->nbfree++]  = slot;
+	conn->inflight--;
+
+	_prg.acked++;
+	_prg.last_ack = now;
+}
+
+
+/***
+ * NAME
+ *   bench_frame_recv -
+ *
+ * ARGUMENTS
+ *   conn -
+ *   data -
+ *   len  -
+ *
+ * DESCRIPTION
+ *   Handles a frame received from the agent.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_frame_recv(struct bench_conn *conn, const char *data, size_t len)
+{
+	const char *ptr = data, *end = data + len;
+	uint64_t    sid, fid;
+	uint32_t    flags;
+	uint8_t     type;
+
+	_prg.dec_conn = conn;
+
+	if (_ERROR(spoe_decode(_prg.enc, &ptr, end,
+	                       SPOE_DEC_UINT8, &type,
+	                       SPOE_DEC_UINT32, &flags,
+	                       SPOE_DEC_VARINT0, &sid,
+	                       SPOE_DEC_VARINT0, &fid,
+	                       SPOE_DEC_END))) {
+		bench_conn_close(conn, "failed to decode frame header");
+
+		return FUNC_RET_ERROR;
+	}
+
+	if (type == SPOE_FRM_T_AGENT_ACK) {
+		bench_agent_ack(conn, fid);
+	}
+	else if (type == SPOE_FRM_T_AGENT_HELLO) {
+		return bench_agent_hello(conn, ptr, end);
+	}
+	else if (type == SPOE_FRM_T_AGENT_DISCON) {
+		_prg.client.status_code = SPOE_FRM_ERR_NONE;
+
+		(void)spoe_decode_kv(_prg.enc, &ptr, end,
+		                     SPOE_DEC_VARINT, STR_ADDRSIZE("status-code"), cb_agent_status_code,
+		                     SPOE_DEC_STR, STR_ADDRSIZE("message"), cb_agent_message,
+		                     SPOE_DEC_END);
+
+		bench_conn_close(conn, (conn->state == BENCH_ST_DISCONNECTING) ? NULL : "unexpected AGENT-DISCONNECT frame");
+
+		return FUNC_RET_ERROR;
+	}
+	else {
+		bench_conn_close(conn, "unexpected frame type");
+
+		return FUNC_RET_ERROR;
+	}
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   bench_start -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Starts the benchmark once all the connections have completed the HELLO
+ *   handshake.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_start(void)
+{
+	if ((_prg.start_time > 0) || ((_prg.nbready + _prg.nbclosed) < _prg.connections) || (_prg.nbready == 0))
+		return;
+
+	ev_now_update(_prg.ev_base);
+	_prg.start_time = ev_time();
+
+	if (_prg.duration > 0) {
+		ev_timer_set(&(_prg.ev_stop), _prg.duration, 0.0);
+		ev_timer_start(_prg.ev_base, &(_prg.ev_stop));
+	}
+
+	if (_prg.rate > 0) {
+		ev_timer_set(&(_prg.ev_rate), 0.0, BENCH_RATE_TICK);
+		ev_timer_start(_prg.ev_base, &(_prg.ev_rate));
+	}
+	else {
+		bench_release();
+	}
+}
+
+
+/***
+ * NAME
+ *   bench_read_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Receives the frames sent by the agent and refills the window of the
+ *   connection.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_read_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	struct bench_conn *conn = ev->data;
+	size_t             head = 0;
+	uint32_t           len;
+	ssize_t            n;
+
+	n = recv(conn->fd, conn->rd_buf.ptr + conn->rd_buf.len, conn->rd_buf.size - conn->rd_buf.len, 0);
+	if (n == 0) {
+		bench_conn_close(conn, (conn->state == BENCH_ST_DISCONNECTING) ? NULL : "connection closed by the agent");
+		bench_check_done();
+
+		return;
+	}
+	else if (n < 0) {
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+			bench_conn_close(conn, strerror(errno));
+			bench_check_done();
+		}
+
+		return;
+	}
+
+	conn->rd_buf.len += n;
+
+	while ((conn->rd_buf.len - head) >= SPOA_FRM_LEN) {
+		(void)memcpy(&len, conn->rd_buf.ptr + head, sizeof(len));
+		len = ntohl(len);
+
+		if (len > (conn->rd_buf.size - SPOA_FRM_LEN)) {
+			bench_conn_close(conn, "frame too big");
+			bench_check_done();
+
+			return;
+		}
+		else if ((conn->rd_buf.len - head - SPOA_FRM_LEN) < len) {
+			break;
+		}
+		else if (_ERROR(bench_frame_recv(conn, (const char *)conn->rd_buf.ptr + head + SPOA_FRM_LEN, len))) {
+			if (conn->state == BENCH_ST_CLOSED) {
+				bench_start();
+				bench_check_done();
+
+				return;
+			}
+		}
+
+		head += SPOA_FRM_LEN + len;
+	}
+
+	if (head > 0) {
+		conn->rd_buf.len -= head;
+		(void)memmove(conn->rd_buf.ptr, conn->rd_buf.ptr + head, conn->rd_buf.len);
+	}
+
+	if (_prg.start_time > 0) {
+		bench_conn_fill(conn);
+
+		/* In the open-loop mode the released frames may wait for any connection. */
+		if ((_prg.rate > 0) && (_prg.sent < _prg.released))
+			bench_release();
+
+		bench_check_done();
+	}
+	else {
+		bench_start();
+	}
+}
+
+
+/***
+ * NAME
+ *   bench_write_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_write_cb(struct ev_loop *loop __maybe_unused, struct ev_io *ev, int revents __maybe_unused)
+{
+	bench_conn_flush(ev->data);
+}
+
+
+/***
+ * NAME
+ *   bench_rate_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Releases the frames scheduled up to now in the open-loop mode.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_rate_cb(struct ev_loop *loop __maybe_unused, struct ev_timer *ev __maybe_unused, int revents __maybe_unused)
+{
+	_prg.released = (ev_time() - _prg.start_time) * _prg.rate + 1;
+	if ((_prg.frames > 0) && (_prg.released > _prg.frames))
+		_prg.released = _prg.frames;
+
+	bench_release();
+	bench_check_done();
+}
+
+
+/***
+ * NAME
+ *   bench_stop_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Stops sending frames at the end of the benchmark.  If it fires again,
+ *   the frames in flight or the agent disconnection took too long.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_stop_cb(struct ev_loop *loop, struct ev_timer *ev, int revents __maybe_unused)
+{
+	if (_prg.flag_disconnect) {
+		(void)fprintf(stderr, "ERROR: timeout waiting for the agent to disconnect\n");
+		ev_break(loop, EVBREAK_ONE);
+	}
+	else if (_prg.flag_stop) {
+		(void)fprintf(stderr, "ERROR: timeout waiting for %"PRIu64" ACK frame(s)\n", _prg.sent - _prg.acked - _prg.lost);
+		_prg.lost = _prg.sent - _prg.acked;
+		bench_check_done();
+	}
+	else {
+		_prg.flag_stop = 1;
+		ev_timer_stop(loop, &(_prg.ev_rate));
+		ev_timer_set(ev, BENCH_DRAIN_TIMEOUT, 0.0);
+		ev_timer_start(loop, ev);
+		bench_check_done();
+	}
+}
+
+
+/***
+ * NAME
+ *   bench_signal_cb -
+ *
+ * ARGUMENTS
+ *   loop    -
+ *   ev      -
+ *   revents -
+ *
+ * DESCRIPTION
+ *   Ends the benchmark early, the results so far are still reported.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_signal_cb(struct ev_loop *loop, struct ev_signal *ev __maybe_unused, int revents __maybe_unused)
+{
+	if (_prg.start_time <= 0) {
+		ev_break(loop, EVBREAK_ONE);
+	}
+	else if (!_prg.flag_stop) {
+		ev_timer_stop(loop, &(_prg.ev_stop));
+		bench_stop_cb(loop, &(_prg.ev_stop), 0);
+	}
+	else {
+		ev_break(loop, EVBREAK_ONE);
+	}
+}
+
+
+/***
+ * NAME
+ *   bench_conn_init -
+ *
+ * ARGUMENTS
+ *   conn -
+ *   ai   -
+ *
+ * DESCRIPTION
+ *   Connects to the agent and sends the HAPROXY-HELLO frame.
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_conn_init(struct bench_conn *conn, const struct addrinfo *ai)
+{
+	uint i;
+	int  flag = 1;
+
+	conn->rd_buf.size = BENCH_RD_BUFSIZE(_prg.max_frame_size);
+	conn->slots_free  = calloc(_prg.window, sizeof(*(conn->slots_free)));
+	conn->slots_time  = calloc(_prg.window, sizeof(*(conn->slots_time)));
+	conn->rd_buf.ptr  = malloc(conn->rd_buf.size);
+	if (_NULL(conn->slots_free) || _NULL(conn->slots_time) || _NULL(conn->rd_buf.ptr)) {
+		(void)fprintf(stderr, "ERROR: failed to allocate memory for connection %d\n", conn->id);
+
+		return FUNC_RET_ERROR;
+	}
+
+	/* The lowest frame-id is used first. */
+	for (i = 0; i < _prg.window; i++) {
+		conn->slots_free[i] = _prg.window - 1 - i;
+		conn->slots_time[i] = -1;
+	}
+	conn->nbfree = _prg.window;
+
+	conn->fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+	if (_ERROR(conn->fd)) {
+		(void)fprintf(stderr, "ERROR: failed to create socket: %m\n");
+
+		return FUNC_RET_ERROR;
+	}
+	else if (_ERROR(connect(conn->fd, ai->ai_addr, ai->ai_addrlen))) {
+		(void)fprintf(stderr, "ERROR: failed to connect to %s:%d: %m\n", _prg.address, _prg.port);
+
+		return FUNC_RET_ERROR;
+	}
+
+	(void)setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+	(void)fcntl(conn->fd, F_SETFL, fcntl(conn->fd, F_GETFL) | O_NONBLOCK);
+
+	ev_io_init(&(conn->ev_rd), bench_read_cb, conn->fd, EV_READ);
+	ev_io_init(&(conn->ev_wr), bench_write_cb, conn->fd, EV_WRITE);
+	conn->ev_rd.data = conn;
+	conn->ev_wr.data = conn;
+	ev_io_start(_prg.ev_base, &(conn->ev_rd));
+
+	conn->state = BENCH_ST_HELLO;
+
+	if (_ERROR(bench_hello(conn))) {
+		(void)fprintf(stderr, "ERROR: failed to encode HELLO frame\n");
+
+		return FUNC_RET_ERROR;
+	}
+
+	bench_conn_flush(conn);
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   bench_lat_cmp -
+ *
+ * ARGUMENTS
+ *   a -
+ *   b -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+static int bench_lat_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+
+/***
+ * NAME
+ *   bench_report -
+ *
+ * ARGUMENTS
+ *   This function takes no arguments.
+ *
+ * DESCRIPTION
+ *   Shows the benchmark results.
+ *
+ * RETURN VALUE
+ *   This function does not return a value.
+ */
+static void bench_report(void)
+{
+	static const double pct[] = { 50.0, 90.0, 99.0, 99.9 };
+	double              elapsed = _prg.last_ack - _prg.start_time;
+	int                 i;
+
+	(void)printf("connections: %d, window: %u, mode: ", _prg.connections, _prg.window);
+	if (_prg.rate > 0)
+		(void)printf("open-loop at %g frames/s", _prg.rate);
+	else
+		(void)printf("closed-loop");
+	(void)printf(", message: %zu bytes\n", _prg.msg_len);
+
+	(void)printf("frames: %"PRIu64" sent, %"PRIu64" acknowledged, %"PRIu64" lost, %"PRIu64" error(s)\n",
+	             _prg.sent, _prg.acked, _prg.lost, _prg.errors);
+
+	if ((_prg.lat_cnt == 0) || (elapsed <= 0))
+		return;
+
+	(void)printf("time: %.3f s, throughput: %.1f frames/s\n", elapsed, _prg.acked / elapsed);
+
+	qsort(_prg.lat, _prg.lat_cnt, sizeof(*(_prg.lat)), bench_lat_cmp);
+
+	(void)printf("ACK latency (us): min %u", _prg.lat[0]);
+	for (i = 0; i < TABLESIZE(pct); i++)
+		(void)printf(", p%g %u", pct[i], _prg.lat[MIN((size_t)(_prg.lat_cnt * pct[i] / 100.0), _prg.lat_cnt - 1)]);
+	(void)printf(", max %u\n", _prg.lat[_prg.lat_cnt - 1]);
+}
+
+
+/***
+ * NAME
+ *   main -
+ *
+ * ARGUMENTS
+ *   argv -
+ *   argc -
+ *
+ * DESCRIPTION
+ *   -
+ *
+ * RETURN VALUE
+ *   -
+ */
+int main(int argc, char **argv)
+{
+	static const struct option longopts[] = {
+		{ "address",        required_argument, NULL, 'a' },
+		{ "body-size",      required_argument, NULL, 'b' },
+		{ "capability",     required_argument, NULL, 'c' },
+		{ "duration",       required_argument, NULL, 'd' },
+		{ "frames",         required_argument, NULL, 'f' },
+		{ "host",           required_argument, NULL, 'H' },
+		{ "help",           no_argument,       NULL, 'h' },
+		{ "max-frame-size", required_argument, NULL, 'm' },
+		{ "connections",    required_argument, NULL, 'n' },
+		{ "port",           required_argument, NULL, 'p' },
+		{ "rate",           required_argument, NULL, 'r' },
+		{ "path",           required_argument, NULL, 'u' },
+		{ "version",        no_argument,       NULL, 'V' },
+		{ "window",         required_argument, NULL, 'w' },
+		{ NULL,             0,                 NULL, 0   }
+	};
+	struct addrinfo  hints, *ai = NULL;
+	char             port[8];
+	bool_t           flag_error = 0;
+	int              c, i, rc, retval = EX_OK;
+
+	_prg.name = basename(argv[0]);
+
+	while ((c = getopt_long(argc, argv, ":a:b:c:d:f:H:hm:n:p:r:u:Vw:", longopts, NULL)) != EOF) {
+		if (c == 'a')
+			_prg.address = optarg;
+		else if (c == 'b')
+			_prg.body_size = atoi(optarg);
+		else if (c == 'c')
+			flag_error |= _OK(getopt_set_capability(optarg)) ? 0 : 1;
+		else if (c == 'd')
+			flag_error |= _OK(getopt_set_double("duration", optarg, &(_prg.duration), 0, 1e6)) ? 0 : 1;
+		else if (c == 'f')
+			_prg.frames = strtoull(optarg, NULL, 10);
+		else if (c == 'H')
+			_prg.host = optarg;
+		else if (c == 'h')
+			_prg.opt_flags |= FLAG_OPT_HELP;
+		else if (c == 'm')
+			_prg.max_frame_size = atoi(optarg);
+		else if (c == 'n')
+			_prg.connections = atoi(optarg);
+		else if (c == 'p')
+			_prg.port = atoi(optarg);
+		else if (c == 'r')
+			flag_error |= _OK(getopt_set_double("rate", optarg, &(_prg.rate), 0, 1e9)) ? 0 : 1;
+		else if (c == 'u')
+			_prg.path = optarg;
+		else if (c == 'V')
+			_prg.opt_flags |= FLAG_OPT_VERSION;
+		else if (c == 'w')
+			_prg.window = atoi(optarg);
+		else
+			flag_error = 1;
+	}
+
+	if (_prg.opt_flags & FLAG_OPT_HELP) {
+		usage(_prg.name, 1);
+	}
+	else if (_prg.opt_flags & FLAG_OPT_VERSION) {
+		(void)printf("\n%s v%s [build %d] by %s, %s\n\n", _prg.name, PACKAGE_VERSION, PACKAGE_BUILD, PACKAGE_AUTHOR, __DATE__);
+	}
+	else if (flag_error) {
+		usage(_prg.name, 0);
+	}
+	else if (!IN_RANGE(_prg.connections, 1, 65536)) {
+		(void)fprintf(stderr, "ERROR: invalid number of connections: %d\n", _prg.connections);
+
+		flag_error = 1;
+	}
+	else if (!IN_RANGE(_prg.window, 1, 65536)) {
+		(void)fprintf(stderr, "ERROR: invalid window: %u\n", _prg.window);
+
+		flag_error = 1;
+	}
+	else if (!IN_RANGE(_prg.max_frame_size, 256, 16 * 1024 * 1024)) {
+		(void)fprintf(stderr, "ERROR: invalid maximum frame size: %u\n", _prg.max_frame_size);
+
+		flag_error = 1;
+	}
+	else if (!IN_RANGE(_prg.port, 1, 65535)) {
+		(void)fprintf(stderr, "ERROR: invalid port: %d\n", _prg.port);
+
+		flag_error = 1;
+	}
+	else if ((_prg.duration <= 0) && (_prg.frames == 0)) {
+		(void)fprintf(stderr, "ERROR: either the duration or the number of frames must be set\n");
+
+		flag_error = 1;
+	}
+	else if ((_prg.window > 1) && !(_prg.caps & (BENCH_CAP_PIPELINING | BENCH_CAP_ASYNC))) {
+		(void)fprintf(stderr, "ERROR: a window larger than 1 requires the pipelining or async capability\n");
+
+		flag_error = 1;
+	}
+
+	if (flag_error || (_prg.opt_flags & (FLAG_OPT_HELP | FLAG_OPT_VERSION)))
+		return flag_error ? EX_USAGE : EX_OK;
+
+	(void)memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	(void)snprintf(port, sizeof(port), "%d", _prg.port);
+
+	if ((rc = getaddrinfo(_prg.address, port, &hints, &ai)) != 0) {
+		(void)fprintf(stderr, "ERROR: failed to resolve '%s': %s\n", _prg.address, gai_strerror(rc));
+
+		return EX_NOHOST;
+	}
+	else if (_NULL(_prg.enc = bench_frame_alloc(BENCH_ENC_SIZE))) {
+		retval = EX_OSERR;
+	}
+	else if (_ERROR(bench_msg_init())) {
+		retval = EX_SOFTWARE;
+	}
+	else if (_NULL(_prg.conns = calloc(_prg.connections, sizeof(*(_prg.conns))))) {
+		retval = EX_OSERR;
+	}
+	else if (_NULL(_prg.ev_base = ev_default_loop(EVFLAG_AUTO))) {
+		(void)fprintf(stderr, "ERROR: failed to initialize libev\n");
+
+		retval = EX_SOFTWARE;
+	}
+	else {
+		ev_init(&(_prg.ev_rate), bench_rate_cb);
+		ev_init(&(_prg.ev_stop), bench_stop_cb);
+		ev_signal_init(&(_prg.ev_sigint), bench_signal_cb, SIGINT);
+		ev_signal_start(_prg.ev_base, &(_prg.ev_sigint));
+
+		for (i = 0; i < _prg.connections; i++) {
+			_prg.conns[i].id    = i + 1;
+			_prg.conns[i].fd    = -1;
+			_prg.conns[i].state = BENCH_ST_CLOSED;
+		}
+
+		for (i = 0; (retval == EX_OK) && (i < _prg.connections); i++)
+			if (_ERROR(bench_conn_init(_prg.conns + i, ai)))
+				retval = EX_UNAVAILABLE;
+
+		if (retval == EX_OK) {
+			(void)ev_run(_prg.ev_base, 0);
+
+			bench_report();
+
+			if ((_prg.errors > 0) || (_prg.acked == 0))
+				retval = EX_SOFTWARE;
+		}
+	}
+
+	if (_nNULL(_prg.conns))
+		for (i = 0; i < _prg.connections; i++) {
+			if (_prg.conns[i].fd >= 0)
+				(void)close(_prg.conns[i].fd);
+
+			PTR_FREE(_prg.conns[i].rd_buf.ptr);
+			PTR_FREE(_prg.conns[i].wr_buf.ptr);
+			PTR_FREE(_prg.conns[i].slots_free);
+			PTR_FREE(_prg.conns[i].slots_time);
+		}
+
+	PTR_FREE(_prg.conns);
+	PTR_FREE(_prg.lat);
+	PTR_FREE(_prg.msg);
+	PTR_FREE(_prg.enc);
+	freeaddrinfo(ai);
+
+	return retval;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -0,0 +1,129 @@
+/***
+ * Copyright 2026 HAProxy Technologies
+ *
+ * This file is part of spoa-mirror.
+ *
+ * spoa-mirror is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * spoa-mirror is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef _SPOP_BENCH_H
+#define _SPOP_BENCH_H
+
+#define BENCH_DEFAULT_ADDRESS      "127.0.0.1"
+#define BENCH_DEFAULT_CONNECTIONS  1
+#define BENCH_DEFAULT_WINDOW       1
+#define BENCH_DEFAULT_DURATION     10.0
+#define BENCH_DEFAULT_HOST         "localhost"
+#define BENCH_DEFAULT_PATH         "/index.html"
+
+#define BENCH_HDR_SIZE             32     /* Room for the NOTIFY frame header. */
+#define BENCH_ENC_SIZE             1024   /* Size of the HELLO, DISCONNECT and NOTIFY header encoding buffer. */
+#define BENCH_RATE_TICK            0.001  /* Open-loop mode frame release interval. */
+#define BENCH_DRAIN_TIMEOUT        5.0    /* Time to wait for the outstanding ACK frames. */
+#define BENCH_RD_BUFSIZE(n)        (2 * ((n) + SPOA_FRM_LEN))
+
+#define BENCH_CAP_DEFINES                                 \
+	BENCH_CAP_DEF(PIPELINING,    "pipelining",    0x01) \
+	BENCH_CAP_DEF(ASYNC,         "async",         0x02) \
+	BENCH_CAP_DEF(FRAGMENTATION, "fragmentation", 0x04)
+
+#define BENCH_CAP_DEF(a,b,c)   BENCH_CAP_##a = c,
+enum BENCH_CAP_enum {
+	BENCH_CAP_DEFINES
+};
+#undef BENCH_CAP_DEF
+
+enum bench_state {
+	BENCH_ST_HELLO = 0,
+	BENCH_ST_READY,
+	BENCH_ST_DISCONNECTING,
+	BENCH_ST_CLOSED,
+};
+
+struct bench_conn {
+	int              id;
+	int              fd;
+	enum bench_state state;
+	struct ev_io     ev_rd;
+	struct ev_io     ev_wr;
+	struct buffer    rd_buf;
+	struct buffer    wr_buf;
+	size_t           wr_head;         /* Start of the unsent data in wr_buf. */
+
+	uint8_t          caps;            /* Capabilities granted by the agent. */
+	uint             max_frame_size;  /* Negotiated maximum frame size. */
+	uint             window;          /* Maximum number of frames in flight. */
+	uint             inflight;
+	uint             stream_id;
+	uint            *slots_free;      /* Stack of the free frame-id slots. */
+	uint             nbfree;
+	double          *slots_time;      /* Send (or scheduled) time of each slot. */
+};
+
+struct _prg_data {
+	const char         *name;
+	uint8_t             opt_flags;
+
+	const char         *address;
+	int                 port;
+	uint8_t             caps;
+	int                 connections;
+	uint                window;
+	double              rate;            /* Frames per second, 0 for the closed-loop mode. */
+	double              duration;
+	uint64_t            frames;          /* Number of frames to send, 0 for unlimited. */
+	size_t              body_size;
+	uint                max_frame_size;
+	const char         *host;
+	const char         *path;
+
+	struct ev_loop     *ev_base;
+	struct ev_timer     ev_rate;
+	struct ev_timer     ev_stop;
+	struct ev_signal    ev_sigint;
+	struct bench_conn  *conns;
+	int                 nbready;
+	int                 nbclosed;
+	int                 rr;              /* Next connection to get a released frame. */
+	bool_t              flag_stop;
+	bool_t              flag_disconnect;
+
+	struct client       client;          /* Receives the decoder status codes. */
+	struct bench_conn  *dec_conn;        /* Connection whose frame is being decoded. */
+	struct spoe_frame  *enc;             /* Frame used to encode the frame headers. */
+	char               *msg;             /* Encoded 'mirror' message. */
+	size_t              msg_len;
+
+	double              start_time;
+	uint64_t            released;        /* Frames released in the open-loop mode. */
+	uint64_t            sent;
+	uint64_t            acked;
+	uint64_t            lost;            /* Frames in flight on the failed connections. */
+	uint64_t            errors;
+	double              last_ack;
+	uint32_t           *lat;             /* ACK latencies in microseconds. */
+	size_t              lat_cnt;
+	size_t              lat_size;
+};
+
+#endif /* _SPOP_BENCH_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 8
+ *  c-basic-offset: 8
+ * End:
+ *
+ * vi: noexpandtab shiftwidth=8 tabstop=8
+ */
@@ -1,18 +1,8 @@
 #!/bin/sh
 #
-for _loop_frame in \
-	0100000001000012737570706f727465642d76657273696f6e730803322e300e6d61782d6672616d652d73697a6503fcf0060c6361706162696c69746965730810706970656c696e696e672c6173796e6309656e67696e652d6964082435306466343431662d333863652d343632362d623733322d336461333932353138626264 \
-	0100000001000012737570706f727465642d76657273696f6e730803322e300e6d61782d6672616d652d73697a6503fcf0060c6361706162696c69746965730810706970656c696e696e672c6173796e6309656e67696e652d6964082432336265313135322d616231392d343635622d626337632d393437303736626138646332 \
-	020000000100000b7374617475732d636f64650302076d6573736167650812612074696d656f7574206f63637572726564 \
-	030000000100010f636865636b2d636c69656e742d697001026970067f000001 \
-	030000000100020474657374130461726731081a6c6f63616c686f73743a31303038302f696e6465782e68746d6c046172673204f3b882af4e046172673309089ec01c737f00000104617267340900046172673508034745540461726736080b2f696e6465782e68746d6c0461726737000461726738080b2f696e6465782e68746d6c046172673900056172673130000561726731310005617267313204f3b882af4e05617267313309089ec01c737f00000105617267313400056172673135083f686f73743a206c6f63616c686f73743a31303038300d0a757365722d6167656e743a206375726c2f372e37342e300d0a6163636570743a202a2f2a0d0a0d0a056172673136093904686f73740f6c6f63616c686f73743a31303038300a757365722d6167656e740b6375726c2f372e37342e3006616363657074032a2f2a00000561726731370816686f737400757365722d6167656e74006163636570740561726731380105617267313904f0e703066d6972726f72050a6172675f6d6574686f640803474554086172675f70617468080b2f696e6465782e68746d6c076172675f7665720803312e31086172675f68647273093904686f73740f6c6f63616c686f73743a31303038300a757365722d6167656e740b6375726c2f372e37342e3006616363657074032a2f2a0000086172675f626f64790900 \
-	030000000100020474657374130461726731081a6c6f63616c686f73743a31303038302f696e6465782e68746d6c046172673204f3b882af4e046172673309089ec01c737f00000104617267340900046172673508034745540461726736080b2f696e6465782e68746d6c0461726737000461726738080b2f696e6465782e68746d6c046172673900056172673130000561726731310005617267313204f3b882af4e05617267313309089ec01c737f00000105617267313400056172673135083f686f73743a206c6f63616c686f73743a31303038300d0a757365722d6167656e743a206375726c2f372e37342e300d0a6163636570743a202a2f2a0d0a0d0a056172673136093904686f73740f6c6f63616c686f73743a31303038300a757365722d6167656e740b6375726c2f372e37342e3006616363657074032a2f2a00000561726731370816686f737400757365722d6167656e74006163636570740561726731380105617267313904f0e703066d6972726f72050a6172675f6d6574686f640803474554086172675f70617468080b2f696e6465782e68746d6c076172675f7665720803312e31086172675f686472730852686f73743a206c6f63616c686f73743a31303038300d0a757365722d6167656e743a206375726c2f372e37342e300d0a6163636570743a202a2f2a0d0a0d782d6865616465723a20736f6d6520746578740a086172675f626f64790900 \
-	650000000100000776657273696f6e0803322e300e6d61782d6672616d652d73697a6503fcf0060c6361706162696c69746965730800 \
-	660000000100000b7374617475732d636f64650300076d65737361676508066e6f726d616c \
-	670000000100010103010869705f73636f72650320 \
-	67000000010002 \
-; do
+grep -v -e '^#' -e '^$' "$(dirname "${0}")/test-frames.txt" | while read -r _loop_name _loop_frame; do
 	echo "------------------------------------------------------------------------------"
+	echo "${_loop_name}"
 	"$(dirname "${0}")/decode-data" -f "${_loop_frame}"
 	echo
 done
@@ -144,6 +144,74 @@ const char *str_ctrl(const void *data, size_t size)
 	return retbuf;
 }
 
+
+/***
+ * NAME
+ *   getopt_set_double -
+ *
+ * ARGUMENTS
+ *   name  -
+ *   arg   -
+ *   value -
+ *   min   -
+ *   max   -
+ *
+ * DESCRIPTION
+ *   Converts the option argument to a number in the range [min, max].
+ *
+ * RETURN VALUE
+ *   -
+ */
+int getopt_set_double(const char *name, const char *arg, double *value, double min, double max)
+{
+	char *endptr;
+
+	errno  = 0;
+	*value = strtod(arg, &endptr);
+	if ((errno != 0) || (endptr == arg) || (*endptr != '\0') || !IN_RANGE(*value, min, max)) {
+		(void)fprintf(stderr, "ERROR: invalid %s '%s'\n", name, arg);
+
+		return FUNC_RET_ERROR;
+	}
+
+	return FUNC_RET_OK;
+}
+
+
+/***
+ * NAME
+ *   buffer_append -
+ *
+ * ARGUMENTS
+ *   buf  -
+ *   data -
+ *   len  -
+ *
+ * DESCRIPTION
+ *   Appends the data to the buffer, growing the buffer if necessary.
+ *
+ * RETURN VALUE
+ *   -
+ */
+int buffer_append(struct buffer *buf, const void *data, size_t len)
+{
+	if ((buf->len + len) > buf->size) {
+		size_t   size = MAX(buf->size * 2, buf->len + len);
+		uint8_t *ptr;
+
+		if (_NULL(ptr = realloc(buf->ptr, size)))
+			return FUNC_RET_ERROR;
+
+		buf->ptr  = ptr;
+		buf->size = size;
+	}
+
+	(void)memcpy(buf->ptr + buf->len, data, len);
+	buf->len += len;
+
+	return FUNC_RET_OK;
+}
+
 /*
  * Local variables:
  *  c-indent-level: 8
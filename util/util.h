@@ -24,6 +24,8 @@ void        f_log(const struct spoe_frame *frame, const char *format, ...) __fmt
 void        w_log(const struct worker *worker, const char *format, ...) __fmt(printf, 2, 3);
 const char *str_hex(const void *data, size_t size);
 const char *str_ctrl(const void *data, size_t size);
+int         getopt_set_double(const char *name, const char *arg, double *value, double min, double max);
+int         buffer_append(struct buffer *buf, const void *data, size_t len);
 
 extern bool_t flag_log_nl;
 